@@ -5,13 +5,14 @@
 
 #include "MatrixUBO.h"
 
+#include "Utils/FrameContext.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/pipeline/GraphicsPipeline.h"
 #include "Utils/pipeline/PipelineStates.h"
 #include "Utils/resource/Buffer.h"
 #include "Utils/resource/Image.h"
-#include "Utils/sync/Fences.h"
-#include "Utils/sync/Semaphores.h"
+#include "Utils/resource/UniformRingBuffer.h"
 
 namespace vulkan {
 class ShaderStages;
@@ -71,7 +72,7 @@ protected:
     initCommandBuffers();
 
     void
-    initSemaphoresAndFences();
+    initFrameContext();
 
     vulkan::SwapChain mSwapChain;
     
@@ -82,21 +83,27 @@ protected:
 
     std::vector<vk::UniqueCommandBuffer> mCommandBuffers;
 
-    std::unique_ptr<vulkan::GraphicsPipeline> mGraphicsPipeline;
+    // Owned by the PipelineSystem
+    const vulkan::GraphicsPipeline* mGraphicsPipeline = nullptr;
     vulkan::PipelineStates mPipelineStates;
 
-    std::unique_ptr<vulkan::Semaphores> mImageAvailableSemaphores;
-    std::unique_ptr<vulkan::Semaphores> mRenderFinishedSemaphores;
-    std::unique_ptr<vulkan::Fences> mFences;
+    // Synchronization of the frames in flight.
+    std::unique_ptr<vulkan::FrameContext> mFrameContext;
+
+    // Uploads recorded during the initialization.
+    // Read submitCommandBufferAndPresent()
+    vulkan::TransferTicket mTransferTicket;
+    vk::UniqueSemaphore mTransferSemaphore;
+    vk::UniqueSemaphore mWaitedTransferSemaphore;
 
     std::unique_ptr<vulkan::Buffer> mGpuVertexBuffer;
     std::unique_ptr<vulkan::Buffer> mGpuIndexBuffer;
 
-    std::vector<vulkan::Buffer> mUniformBuffers;
+    std::unique_ptr<vulkan::UniformRingBuffer> mUniformRingBuffer;
     vk::UniqueDescriptorPool mDescriptorPool;
     MatrixUBO mMatrixUBO;
     vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
-    std::vector<vk::DescriptorSet> mDescriptorSets;
+    vk::DescriptorSet mDescriptorSet;
 
     vk::UniqueSampler mTextureSampler;
     vk::UniqueImageView mImageView;
@@ -1,23 +1,52 @@
 #include "App.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include "Utils/CommandPools.h"
+#include "Utils/Profiler.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/Window.h"
 #include "Utils/device/LogicalDevice.h"
 #include "Utils/device/PhysicalDevice.h"
+#include "Utils/pipeline/ExtendedDynamicState.h"
 #include "Utils/pipeline/PipelineStates.h"
+#include "Utils/pipeline/PipelineSystem.h"
 #include "Utils/resource/Image.h"
 #include "Utils/resource/ImageSystem.h"
 #include "Utils/resource/ModelSystem.h"
+#include "Utils/resource/TransientImagePool.h"
 #include "Utils/shader/ShaderModule.h"
 #include "Utils/shader/ShaderModuleSystem.h"
 #include "Utils/shader/ShaderStages.h"
-#include "Utils/vertex/PosTexCoordVertex.h"
+#include "Utils/vertex/QuantizedPosTexCoordVertex.h"
+#include "Utils/vertex/VertexQuantization.h"
 
 using namespace vulkan;
 
+namespace {
+// Components of the vertex attribute formats that the vertex shader can read
+// as floats (0 for other formats).
+uint32_t
+floatFormatComponentCount(const vk::Format format) {
+    switch (format) {
+    case vk::Format::eR32Sfloat:
+        return 1;
+    case vk::Format::eR32G32Sfloat:
+    case vk::Format::eR16G16Unorm:
+        return 2;
+    case vk::Format::eR32G32B32Sfloat:
+        return 3;
+    case vk::Format::eR32G32B32A32Sfloat:
+    case vk::Format::eR16G16B16A16Unorm:
+        return 4;
+    default:
+        return 0;
+    }
+}
+}
+
 App::App() {
     initImages();
     initUniformBuffers();
@@ -27,18 +56,49 @@ App::App() {
     initRenderPass();
     initFrameBuffers();
     initCommandBuffers();
-    initSemaphoresAndFences();
+    initFrameContext();
     initGraphicsPipeline();    
-    recordCommandBuffers();
+
+    // Submit the uploads recorded during the initialization.
+    // The first frame waits for them on the device.
+    mTransferTicket = TransferEngine::flush();
+    mTransferSemaphore = TransferEngine::takeSemaphore(mTransferTicket);
+}
+
+App::~App() {
+    // The pipeline compile jobs (including the ones of the hot reload
+    // and the prewarm) use mRenderPass, so they must not outlive it.
+    PipelineSystem::cancelRequestedGraphicsPipelines();
 }
 
 void
 App::run() {
     while (Window::shouldCloseWindow() == false) {
-        glfwPollEvents();
-
-        vk::Semaphore imageAvailableSemaphore = mImageAvailableSemaphores->nextAvailableSemaphore();
-        mSwapChain.acquireNextImage(imageAvailableSemaphore);
+        Window::pollEvents();
+
+        const uint32_t swapChainImageIndex = mFrameContext->beginFrame();
+
+        // The previous submission of this swap chain image command buffer
+        // is completed, so its GPU scopes can be read back.
+        if (mIsCommandBufferSubmitted[swapChainImageIndex]) {
+            mGpuScopes[swapChainImageIndex]->collect();
+        }
+        mIsCommandBufferSubmitted[swapChainImageIndex] = true;
+
+        // The pipeline is compiled by the PipelineCompiler (or fast linked from
+        // pipeline libraries), and it is replaced once its optimized link is ready, or
+        // if its shaders were reloaded (--hot-reload). The command buffers are
+        // recorded again when the pipeline changes.
+        PipelineSystem::updateHotReload();
+        const GraphicsPipeline* graphicsPipeline = PipelineSystem::graphicsPipelineIfReady(mGraphicsPipelineHash);
+        if (graphicsPipeline != mGraphicsPipeline) {
+            // Command buffers of other swap chain images can be in use, so
+            // we wait for them before recording them again (the first time,
+            // they only cleared the screen).
+            LogicalDevice::device().waitIdle();
+            mGraphicsPipeline = graphicsPipeline;
+            recordCommandBuffers();
+        }
 
         updateUniformBuffers();
 
@@ -51,95 +111,88 @@ App::run() {
     // the queues owned yb the device a and waiting with an infinite 
     // timeout for these fences to signal.
     LogicalDevice::device().waitIdle();
+
+    Profiler::exportChromeTrace("LoadModel.trace.json");
 }
 
 void
 App::updateUniformBuffers() {
-    // Update uniform buffers
+    // Update uniform buffers.
+    // Each swap chain image has its own partition of the ring buffer,
+    // so the data lands at the dynamic offset recorded in recordRenderPass().
     const uint32_t currentSwapChainImageIndex = mSwapChain.currentImageIndex();
     mMatrixUBO.update(currentSwapChainImageIndex,
-                      mSwapChain.imageAspectRatio());
-    Buffer& uniformBuffer = mUniformBuffers[currentSwapChainImageIndex];
-    uniformBuffer.copyToHostMemory(&mMatrixUBO);
+                      mSwapChain.imageAspectRatio(),
+                      mDequantizationMatrix);
+    mUniformRingBuffer->beginFrame(currentSwapChainImageIndex);
+    mUniformRingBuffer->push(mMatrixUBO);
+    mUniformRingBuffer->endFrame();
 }
 
 void
 App::initDescriptorSets() {
     assert(mDescriptorPool.get() == VK_NULL_HANDLE);
-    assert(mDescriptorSetLayout.get() == VK_NULL_HANDLE);
-
-    const uint32_t imageViewCount = mSwapChain.imageViewCount();
+    assert(mDescriptorSetLayout == VK_NULL_HANDLE);
+    assert(mUniformRingBuffer != nullptr);
 
     vk::DescriptorPoolSize descPoolSizes[2];
-    descPoolSizes[0].setDescriptorCount(imageViewCount);
-    descPoolSizes[0].setType(vk::DescriptorType::eUniformBuffer);
-    descPoolSizes[1].setDescriptorCount(imageViewCount);
+    descPoolSizes[0].setDescriptorCount(1);
+    descPoolSizes[0].setType(vk::DescriptorType::eUniformBufferDynamic);
+    descPoolSizes[1].setDescriptorCount(1);
     descPoolSizes[1].setType(vk::DescriptorType::eCombinedImageSampler);
 
     vk::DescriptorPoolCreateInfo descPoolInfo;
-    descPoolInfo.setMaxSets(imageViewCount);
+    descPoolInfo.setMaxSets(1);
     descPoolInfo.setPoolSizeCount(2);
     descPoolInfo.setPPoolSizes(descPoolSizes);
     mDescriptorPool = LogicalDevice::device().createDescriptorPoolUnique(descPoolInfo);
     
-    vk::DescriptorSetLayoutBinding descSetLayoutBinding[2];
-    descSetLayoutBinding[0].setBinding(0);
-    descSetLayoutBinding[0].setDescriptorType(vk::DescriptorType::eUniformBuffer);
-    descSetLayoutBinding[0].setDescriptorCount(1);
-    descSetLayoutBinding[0].setStageFlags(vk::ShaderStageFlagBits::eVertex);
-    descSetLayoutBinding[1].setBinding(1);
-    descSetLayoutBinding[1].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    descSetLayoutBinding[1].setDescriptorCount(1);
-    descSetLayoutBinding[1].setStageFlags(vk::ShaderStageFlagBits::eFragment);
-
-    vk::DescriptorSetLayoutCreateInfo descSetLayoutInfo;
-    descSetLayoutInfo.setBindingCount(2);
-    descSetLayoutInfo.setPBindings(descSetLayoutBinding);
-    mDescriptorSetLayout =
-        LogicalDevice::device().createDescriptorSetLayoutUnique(descSetLayoutInfo);
-
-
-    // Create a descriptor set for each swap chain image, all with the same layout.
-    const std::vector<vk::DescriptorSetLayout> descSetLayouts(imageViewCount,
-                                                              mDescriptorSetLayout.get());
+    // The layout is reflected from the shaders. The uniform buffer
+    // is dynamic (Read the comment below).
+    ShaderStages shaderStages;
+    initShaderStages(shaderStages);
+    const std::vector<vk::DescriptorSetLayout> descriptorSetLayouts =
+        PipelineSystem::getOrCreateDescriptorSetLayouts(shaderStages,
+                                                        true);
+    assert(descriptorSetLayouts.size() == 1);
+    mDescriptorSetLayout = descriptorSetLayouts.front();
+
+    // A single descriptor set is shared by all the swap chain images.
+    // The dynamic offset given to vkCmdBindDescriptorSets selects
+    // the partition of the uniform ring buffer.
     vk::DescriptorSetAllocateInfo allocateInfo;
     allocateInfo.setDescriptorPool(mDescriptorPool.get());
-    allocateInfo.setDescriptorSetCount(imageViewCount);
-    allocateInfo.setPSetLayouts(descSetLayouts.data());    
-    mDescriptorSets = LogicalDevice::device().allocateDescriptorSets(allocateInfo);
+    allocateInfo.setDescriptorSetCount(1);
+    allocateInfo.setPSetLayouts(&mDescriptorSetLayout);
+    mDescriptorSet = LogicalDevice::device().allocateDescriptorSets(allocateInfo).front();
 
-    // The descriptor sets have been allocated now, but the descriptors within still
+    // The descriptor set has been allocated now, but the descriptors within still
     // need to be configured.
-    vk::DescriptorBufferInfo bufferInfo;
-    bufferInfo.setRange(sizeof(MatrixUBO));
+    const vk::DescriptorBufferInfo bufferInfo = mUniformRingBuffer->descriptorBufferInfo(sizeof(MatrixUBO));
 
     assert(mImageView.get() != VK_NULL_HANDLE);
     vk::DescriptorImageInfo imageInfo;
     imageInfo.setImageView(mImageView.get());
     imageInfo.setSampler(mTextureSampler.get());
     imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-                                                  
-    for (uint32_t i = 0; i < imageViewCount; ++i) {
-        bufferInfo.setBuffer(mUniformBuffers[i].vkBuffer());
-
-        vk::WriteDescriptorSet bufferWrite;
-        bufferWrite.setDescriptorCount(1);
-        bufferWrite.setDstSet(mDescriptorSets[i]);
-        bufferWrite.setDescriptorType(vk::DescriptorType::eUniformBuffer);
-        bufferWrite.setPBufferInfo(&bufferInfo);
-        bufferWrite.setDstBinding(0);
-
-        vk::WriteDescriptorSet imageWrite;
-        imageWrite.setDescriptorCount(1);
-        imageWrite.setDstSet(mDescriptorSets[i]);
-        imageWrite.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-        imageWrite.setPImageInfo(&imageInfo);
-        imageWrite.setDstBinding(1);
-
-        LogicalDevice::device().updateDescriptorSets({bufferWrite,
-                                                      imageWrite},
-                                                     {});
-    }
+
+    vk::WriteDescriptorSet bufferWrite;
+    bufferWrite.setDescriptorCount(1);
+    bufferWrite.setDstSet(mDescriptorSet);
+    bufferWrite.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
+    bufferWrite.setPBufferInfo(&bufferInfo);
+    bufferWrite.setDstBinding(0);
+
+    vk::WriteDescriptorSet imageWrite;
+    imageWrite.setDescriptorCount(1);
+    imageWrite.setDstSet(mDescriptorSet);
+    imageWrite.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    imageWrite.setPImageInfo(&imageInfo);
+    imageWrite.setDstBinding(1);
+
+    LogicalDevice::device().updateDescriptorSets({bufferWrite,
+                                                  imageWrite},
+                                                 {});
 }
 
 void
@@ -157,16 +210,26 @@ App::initImages() {
 
 void
 App::initDepthBuffer() {
-    assert(mDepthBuffer == nullptr);
-    mDepthBuffer.reset(new Image(mSwapChain.imageWidth(),
-                                 mSwapChain.imageHeight(),
-                                 vk::Format::eD32Sfloat,
-                                 vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                                 vk::MemoryPropertyFlagBits::eDeviceLocal));
-
-    mDepthBufferView = mDepthBuffer->createImageView(vk::ImageAspectFlagBits::eDepth);
-
-    mDepthBuffer->transitionImageLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    assert(mTransientImagePool == nullptr);
+
+    // Depth is not stored after the render pass, so tiled GPUs do not need
+    // to back it with real memory (the pool requests lazily allocated memory).
+    // It is the only transient image of the single render pass.
+    mTransientImagePool.reset(new TransientImagePool());
+    const uint32_t depthBufferIndex = mTransientImagePool->addImage(mSwapChain.imageWidth(),
+                                                                    mSwapChain.imageHeight(),
+                                                                    vk::Format::eD32Sfloat,
+                                                                    vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                                                    vk::ImageUsageFlagBits::eTransientAttachment,
+                                                                    0,
+                                                                    0);
+    mTransientImagePool->allocate();
+
+    Image& depthBuffer = mTransientImagePool->image(depthBufferIndex);
+    mDepthBufferView = depthBuffer.createImageView(vk::ImageAspectFlagBits::eDepth);
+
+    // The render pass transitions it from an undefined layout
+    // (its contents are not loaded), so no barrier is needed here.
 }
 
 void 
@@ -174,8 +237,12 @@ App::initBuffers() {
     assert(mGpuVertexBuffer == nullptr);
     assert(mGpuIndexBuffer == nullptr);
 
-    const vulkan::Model<PosTexCoordVertex>& model = 
-        ModelSystem::getOrLoadModelWithPosTexCoordVertex("../../../external/resources/models/chalet.obj");
+    // The quantized vertices take 12 bytes instead of 20.
+    const vulkan::Model<QuantizedPosTexCoordVertex>& model = 
+        ModelSystem::getOrLoadModelWithQuantizedPosTexCoordVertex("../../../external/resources/models/chalet.obj",
+                                                                  0);
+    mDequantizationMatrix = vertex_quantization::dequantizationMatrix(model.mBoundsMin,
+                                                                      model.mBoundsMax);
     
     mGpuVertexBuffer.reset(model.createVertexBuffer());
 
@@ -184,44 +251,64 @@ App::initBuffers() {
 
 void
 App::initUniformBuffers() {
-    assert(mUniformBuffers.empty());
-
-    for (uint32_t i = 0; i < mSwapChain.imageViewCount(); ++i) {
-        Buffer buffer(sizeof(MatrixUBO),
-                      vk::BufferUsageFlagBits::eUniformBuffer,
-                      vk::MemoryPropertyFlagBits::eHostVisible |
-                      vk::MemoryPropertyFlagBits::eHostCoherent);
+    assert(mUniformRingBuffer == nullptr);
 
-        mUniformBuffers.emplace_back(std::move(buffer));
-    }
+    // One partition for each swap chain image, as each one
+    // has its own pre-recorded command buffer.
+    mUniformRingBuffer.reset(new UniformRingBuffer(sizeof(MatrixUBO),
+                                                   mSwapChain.imageViewCount()));
 }
 
 void
 App::recordCommandBuffers() {
     assert(mCommandBuffers.empty() == false);
-    assert(mFrameBuffers.empty() == false);
+    assert(mGraphicsPipeline != nullptr);
     for (uint32_t i = 0; i < mCommandBuffers.size(); ++i) {
         vk::CommandBuffer& commandBuffer = mCommandBuffers[i].get();
 
         commandBuffer.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eSimultaneousUse});
 
-        // Clear values
-        std::array<vk::ClearValue, 2> clearValues;
-        clearValues[0].setColor(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
-        clearValues[1].setDepthStencil(vk::ClearDepthStencilValue(1.0f));
+        recordRenderPass(commandBuffer,
+                         i);
 
-        vk::RenderPassBeginInfo info;
-        info.setRenderArea(vk::Rect2D(vk::Offset2D {0, 0}, mSwapChain.imageExtent()));
-        info.setFramebuffer(mFrameBuffers[i].get());
-        info.setClearValueCount(static_cast<uint32_t>(clearValues.size()));
-        info.setPClearValues(clearValues.data());
-        info.setRenderPass(mRenderPass.get());
-        commandBuffer.beginRenderPass(info,
-                                      vk::SubpassContents::eInline);
+        commandBuffer.end();
+    }
+}
 
+void
+App::recordRenderPass(const vk::CommandBuffer commandBuffer,
+                      const uint32_t swapChainImageIndex) {
+    assert(mFrameBuffers.empty() == false);
+    assert(swapChainImageIndex < static_cast<uint32_t>(mFrameBuffers.size()));
+
+    GpuScopes& gpuScopes = *mGpuScopes[swapChainImageIndex];
+    gpuScopes.reset(commandBuffer);
+    const uint32_t renderPassScope = gpuScopes.beginScope(commandBuffer,
+                                                          "Render pass",
+                                                          true); // with pipeline statistics
+
+    // Clear values
+    std::array<vk::ClearValue, 2> clearValues;
+    clearValues[0].setColor(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
+    clearValues[1].setDepthStencil(vk::ClearDepthStencilValue(1.0f));
+
+    vk::RenderPassBeginInfo info;
+    info.setRenderArea(vk::Rect2D(vk::Offset2D {0, 0}, mSwapChain.imageExtent()));
+    info.setFramebuffer(mFrameBuffers[swapChainImageIndex].get());
+    info.setClearValueCount(static_cast<uint32_t>(clearValues.size()));
+    info.setPClearValues(clearValues.data());
+    info.setRenderPass(mRenderPass.get());
+    commandBuffer.beginRenderPass(info,
+                                  vk::SubpassContents::eInline);
+
+    // The draw is skipped while the pipeline is being compiled.
+    if (mGraphicsPipeline != nullptr) {
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
                                    mGraphicsPipeline->pipeline());
 
+        ExtendedDynamicState::setDynamicStates(commandBuffer,
+                                               mPipelineStates);
+
         commandBuffer.bindVertexBuffers(0, // first vertex buffer to bind
                                         {mGpuVertexBuffer->vkBuffer()},
                                         {0}); // offsets 
@@ -233,52 +320,90 @@ App::recordCommandBuffers() {
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                                          mGraphicsPipeline->pipelineLayout(),
                                          0, // first descriptor set
-                                         {mDescriptorSets[i]},
-                                         {}); // dynamic arrays
+                                         {mDescriptorSet},
+                                         {mUniformRingBuffer->frameOffset(swapChainImageIndex)}); // dynamic offsets
 
         commandBuffer.drawIndexed(static_cast<uint32_t>(mGpuIndexBuffer->size() / sizeof(uint32_t)),
                                   1,
                                   0,
                                   0,
                                   0);
+    }
 
-        commandBuffer.endRenderPass();
+    commandBuffer.endRenderPass();
 
-        commandBuffer.end();
-    }
+    gpuScopes.endScope(commandBuffer,
+                       renderPassScope);
 }
 
 void
 App::initGraphicsPipeline() {
     assert(mGraphicsPipeline == nullptr);
-    assert(mDescriptorSetLayout.get() != VK_NULL_HANDLE);
-
-    PipelineStates pipelineStates;
-    initPipelineStates(pipelineStates);
+    assert(mDescriptorSetLayout != VK_NULL_HANDLE);
 
     ShaderStages shaderStages;
     initShaderStages(shaderStages);
 
-    vk::PipelineLayoutCreateInfo info;
-    info.setSetLayoutCount(1);
-    info.setPSetLayouts(&mDescriptorSetLayout.get());
-
-    vk::UniquePipelineLayout pipelineLayout =
-        LogicalDevice::device().createPipelineLayoutUnique(info);
-
-    mGraphicsPipeline.reset(new GraphicsPipeline(pipelineLayout,
-                                                 pipelineStates,
-                                                 shaderStages,
-                                                 mRenderPass.get()));
+    // The states are kept to set the dynamic ones in the command buffers.
+    initPipelineStates(shaderStages,
+                       mPipelineStates);
+
+    // Same descriptor set layout than mDescriptorSetLayout (Read initDescriptorSets())
+    const vk::PipelineLayout pipelineLayout = PipelineSystem::getOrCreatePipelineLayout(shaderStages,
+                                                                                        true);
+
+    // The pipelines used in the previous run are compiled in parallel.
+    const size_t prewarmedPipelineCount = PipelineSystem::prewarmGraphicsPipelines("LoadModel",
+                                                                                   pipelineLayout,
+                                                                                   mRenderPass.get());
+
+    // The pipeline is compiled in a worker thread, so the
+    // initialization does not wait for it (Read run()).
+    // If graphics pipeline libraries are supported, then it is fast linked now,
+    // and the optimized link (compiled in a worker thread) replaces it later.
+    mGraphicsPipelineHash = PipelineSystem::requestLinkedGraphicsPipeline(pipelineLayout,
+                                                                          mPipelineStates,
+                                                                          shaderStages,
+                                                                          mRenderPass.get());
+
+    // If the manifest knows the pipelines, then they are ready before the first frame
+    // (and they should be in the PipelineCache). Otherwise, the first frames
+    // only clear the screen until the pipeline is compiled.
+    if (prewarmedPipelineCount > 0) {
+        PipelineSystem::waitForRequestedGraphicsPipelines();
+        mGraphicsPipeline = PipelineSystem::graphicsPipelineIfReady(mGraphicsPipelineHash);
+        assert(mGraphicsPipeline != nullptr);
+        recordCommandBuffers();
+    }
 }
 
 void
-App::initPipelineStates(PipelineStates& pipelineStates) const {
+App::initPipelineStates(const ShaderStages& shaderStages,
+                        PipelineStates& pipelineStates) const {
+    // The vertex shader inputs are floats (reflected from the vertex shader),
+    // but the vertices are quantized, so their formats are not the reflected ones.
     std::vector<vk::VertexInputBindingDescription> vertexInputBindingDescriptions;
-    PosTexCoordVertex::vertexInputBindingDescriptions(vertexInputBindingDescriptions);
-
     std::vector<vk::VertexInputAttributeDescription> vertexInputAttributeDescriptions;
-    PosTexCoordVertex::vertexInputAttributeDescriptions(vertexInputAttributeDescriptions);
+    QuantizedPosTexCoordVertex::vertexInputBindingDescriptions(vertexInputBindingDescriptions);
+    QuantizedPosTexCoordVertex::vertexInputAttributeDescriptions(vertexInputAttributeDescriptions);
+
+    // Each shader input must have a quantized attribute at its location,
+    // with at least the components it reads.
+    std::vector<vk::VertexInputBindingDescription> reflectedBindingDescriptions;
+    std::vector<vk::VertexInputAttributeDescription> reflectedAttributeDescriptions;
+    shaderStages.vertexInputDescriptions(reflectedBindingDescriptions,
+                                         reflectedAttributeDescriptions);
+    assert(reflectedAttributeDescriptions.size() == vertexInputAttributeDescriptions.size());
+    for (const vk::VertexInputAttributeDescription& reflectedDescription : reflectedAttributeDescriptions) {
+        assert(floatFormatComponentCount(reflectedDescription.format) > 0);
+        assert(std::any_of(vertexInputAttributeDescriptions.begin(),
+                           vertexInputAttributeDescriptions.end(),
+                           [&reflectedDescription](const vk::VertexInputAttributeDescription& description) {
+                               return description.location == reflectedDescription.location &&
+                                      floatFormatComponentCount(description.format) >=
+                                      floatFormatComponentCount(reflectedDescription.format);
+                           }) && "The vertex shader inputs do not match QuantizedPosTexCoordVertex");
+    }
 
     pipelineStates.setVertexInputState({vertexInputBindingDescriptions,
                                         vertexInputAttributeDescriptions});
@@ -297,6 +422,10 @@ App::initPipelineStates(PipelineStates& pipelineStates) const {
 
     const ColorBlendAttachmentState colorBlendAttachmentState;
     pipelineStates.setColorBlendState({colorBlendAttachmentState});
+
+    // The viewport and the states supported by the device are set
+    // in the command buffer (Read recordRenderPass()).
+    pipelineStates.enableExtendedDynamicState();
 }
 
 void
@@ -328,7 +457,7 @@ App::initRenderPass() {
     attachmentDesc.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare);
     attachmentDesc.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
     attachmentDesc.setInitialLayout(vk::ImageLayout::eUndefined);
-    attachmentDesc.setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+    attachmentDesc.setFinalLayout(mSwapChain.presentationImageLayout());
     attachmentDescriptions.emplace_back(attachmentDesc);
 
     // Depth buffer
@@ -376,14 +505,21 @@ App::initRenderPass() {
     // These settings will prevent the transition from happening until it is
     // actually necessary (and allowed): when we want to start writing colors
     // to it.
+    //
+    // The depth buffer is shared by all the frames, and its layout transition
+    // is done by the render pass, so it must also wait for the depth writes
+    // of the previous frame before the depth tests of this one.
     vk::SubpassDependency subpassDependency;
     subpassDependency.setSrcSubpass(VK_SUBPASS_EXTERNAL);
     subpassDependency.setDstSubpass(0);
-    subpassDependency.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-    subpassDependency.setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-    subpassDependency.setSrcAccessMask(vk::AccessFlags());
+    subpassDependency.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                      vk::PipelineStageFlagBits::eLateFragmentTests);
+    subpassDependency.setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                      vk::PipelineStageFlagBits::eEarlyFragmentTests);
+    subpassDependency.setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite);
     subpassDependency.setDstAccessMask(vk::AccessFlagBits::eColorAttachmentRead |
-                                       vk::AccessFlagBits::eColorAttachmentWrite);
+                                       vk::AccessFlagBits::eColorAttachmentWrite |
+                                       vk::AccessFlagBits::eDepthStencilAttachmentWrite);
     info.setDependencyCount(1);
     info.setPDependencies(&subpassDependency);
 
@@ -394,36 +530,44 @@ void
 App::submitCommandBufferAndPresent() {
     assert(mCommandBuffers.empty() == false);
 
-    const vk::Fence& fence = mFences->nextAvailableFence();
-    vk::Device device(LogicalDevice::device());
-    device.waitForFences({fence},
-                         VK_TRUE,
-                         std::numeric_limits<uint64_t>::max());
-    device.resetFences({fence});
+    // The next image was already acquired by FrameContext::beginFrame() in run()
+    const uint32_t swapChainImageIndex = mSwapChain.currentImageIndex();
+    assert(swapChainImageIndex < static_cast<uint32_t>(mCommandBuffers.size()));
+
+    // The first submission waits on the device for the uploads of the 
+    // initialization. The next submissions are not ordered after that wait,
+    // so they wait on the host until the uploads are completed 
+    // (usually, they already are).
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<vk::PipelineStageFlags> waitStageFlags;
+    if (mTransferSemaphore.get() != VK_NULL_HANDLE) {
+        waitSemaphores.push_back(mTransferSemaphore.get());
+        waitStageFlags.push_back(vk::PipelineStageFlagBits::eVertexInput);
+        // It must be alive until the submission is completed.
+        mWaitedTransferSemaphore = std::move(mTransferSemaphore);
+    } else if (mTransferTicket.isValid()) {
+        TransferEngine::wait(mTransferTicket);
+        mTransferTicket = TransferTicket();
+    }
 
-    // This semaphore was already obtained in run()
-    vk::Semaphore imageAvailableSemaphore = mImageAvailableSemaphores->currentSemaphore();
-    vk::Semaphore renderFinishedSemaphore = mRenderFinishedSemaphores->nextAvailableSemaphore();
+    // While the pipeline is being compiled, the frame only clears the
+    // swap chain image with a command buffer recorded in this frame.
+    vk::CommandBuffer commandBuffer;
+    if (mGraphicsPipeline == nullptr) {
+        commandBuffer = mFrameContext->allocateCommandBuffer();
+        commandBuffer.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        recordRenderPass(commandBuffer,
+                         swapChainImageIndex);
+        commandBuffer.end();
+    } else {
+        // The command buffer of the swap chain image is not in use,
+        // because FrameContext waited for the frame that used the image.
+        commandBuffer = mCommandBuffers[swapChainImageIndex].get();
+    }
 
-    // The next image was already obtained in run()
-    const uint32_t swapChainImageIndex = mSwapChain.currentImageIndex();
-    assert(swapChainImageIndex < mCommandBuffers.size());
-
-    vk::CommandBuffer& commandBuffer = mCommandBuffers[swapChainImageIndex].get();
-    vk::SubmitInfo info;
-    info.setWaitSemaphoreCount(1);
-    info.setPWaitSemaphores(&imageAvailableSemaphore);
-    info.setSignalSemaphoreCount(1);
-    info.setPSignalSemaphores(&renderFinishedSemaphore);
-    info.setCommandBufferCount(1);
-    info.setPCommandBuffers(&commandBuffer);
-    const vk::PipelineStageFlags flags(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-    info.setPWaitDstStageMask(&flags);
-    LogicalDevice::graphicsQueue().submit({info},
-                                          fence);
-
-    mSwapChain.present(renderFinishedSemaphore,
-                       swapChainImageIndex);
+    mFrameContext->submitAndPresent({commandBuffer},
+                                    waitSemaphores,
+                                    waitStageFlags);
 }
 
 void
@@ -461,15 +605,20 @@ App::initCommandBuffers() {
     info.setLevel(vk::CommandBufferLevel::ePrimary);
     info.setCommandPool(CommandPools::graphicsCommandPool());
     mCommandBuffers = LogicalDevice::device().allocateCommandBuffersUnique(info);
+
+    for (size_t i = 0; i < mCommandBuffers.size(); ++i) {
+        mGpuScopes.emplace_back(new GpuScopes(PhysicalDevice::graphicsQueueFamilyIndex()));
+    }
+    mIsCommandBufferSubmitted.resize(mCommandBuffers.size(), false);
 }
 
 void
-App::initSemaphoresAndFences() {
-    assert(mImageAvailableSemaphores == nullptr);
-    assert(mRenderFinishedSemaphores == nullptr);
-    assert(mFences == nullptr);
-
-    mImageAvailableSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mRenderFinishedSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mFences.reset(new Fences(mFrameBuffers.size()));
+App::initFrameContext() {
+    assert(mFrameContext == nullptr);
+
+    // Command buffers are pre-recorded for each swap chain image, and
+    // FrameContext waits until the acquired image is not in flight, so
+    // the number of frames in flight does not depend on the swap chain.
+    mFrameContext.reset(new FrameContext(mSwapChain,
+                                         2)); // frames in flight
 }
\ No newline at end of file
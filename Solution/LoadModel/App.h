@@ -5,21 +5,25 @@
 
 #include "MatrixUBO.h"
 
+#include "Utils/FrameContext.h"
+#include "Utils/Profiler.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/pipeline/GraphicsPipeline.h"
 #include "Utils/pipeline/PipelineStates.h"
 #include "Utils/resource/Buffer.h"
 #include "Utils/resource/Image.h"
-#include "Utils/sync/Fences.h"
-#include "Utils/sync/Semaphores.h"
+#include "Utils/resource/UniformRingBuffer.h"
 
 namespace vulkan {
 class ShaderStages;
+class TransientImagePool;
 }
 
 class App {
 public:
     App();
+    ~App();
 
     void
     run();
@@ -43,14 +47,22 @@ protected:
     void 
     initUniformBuffers();
 
+    // Precondition: The graphics pipeline must be ready.
     void 
     recordCommandBuffers();
 
+    // Records the render pass of the swap chain image framebuffer.
+    // The draw is skipped if the graphics pipeline is not ready.
+    void
+    recordRenderPass(const vk::CommandBuffer commandBuffer,
+                     const uint32_t swapChainImageIndex);
+
     void
     initGraphicsPipeline();
 
     void
-    initPipelineStates(vulkan::PipelineStates& pipelineStates) const;
+    initPipelineStates(const vulkan::ShaderStages& shaderStages,
+                       vulkan::PipelineStates& pipelineStates) const;
 
     void
     initShaderStages(vulkan::ShaderStages& shaderStages);
@@ -68,32 +80,49 @@ protected:
     initCommandBuffers();
 
     void
-    initSemaphoresAndFences();
+    initFrameContext();
 
     vulkan::SwapChain mSwapChain;
     
     vk::UniqueRenderPass mRenderPass;
     std::vector<vk::UniqueFramebuffer> mFrameBuffers;
-    std::unique_ptr<vulkan::Image> mDepthBuffer;
+    // Owns the depth buffer.
+    std::unique_ptr<vulkan::TransientImagePool> mTransientImagePool;
     vk::UniqueImageView mDepthBufferView;
 
     std::vector<vk::UniqueCommandBuffer> mCommandBuffers;
 
-    std::unique_ptr<vulkan::GraphicsPipeline> mGraphicsPipeline;
+    // GPU scopes of each command buffer, collected when the
+    // swap chain image is acquired again.
+    std::vector<std::unique_ptr<vulkan::GpuScopes>> mGpuScopes;
+    std::vector<bool> mIsCommandBufferSubmitted;
+
+    // Owned by the PipelineSystem.
+    // It is nullptr until the PipelineCompiler compiles it, and
+    // it changes when the pipeline is replaced (Read run()).
+    const vulkan::GraphicsPipeline* mGraphicsPipeline = nullptr;
+    uint64_t mGraphicsPipelineHash = 0;
     vulkan::PipelineStates mPipelineStates;
 
-    std::unique_ptr<vulkan::Semaphores> mImageAvailableSemaphores;
-    std::unique_ptr<vulkan::Semaphores> mRenderFinishedSemaphores;
-    std::unique_ptr<vulkan::Fences> mFences;
+    // Synchronization of the frames in flight.
+    std::unique_ptr<vulkan::FrameContext> mFrameContext;
+
+    // Uploads recorded during the initialization.
+    // Read submitCommandBufferAndPresent()
+    vulkan::TransferTicket mTransferTicket;
+    vk::UniqueSemaphore mTransferSemaphore;
+    vk::UniqueSemaphore mWaitedTransferSemaphore;
 
     std::unique_ptr<vulkan::Buffer> mGpuVertexBuffer;
     std::unique_ptr<vulkan::Buffer> mGpuIndexBuffer;
 
-    std::vector<vulkan::Buffer> mUniformBuffers;
+    std::unique_ptr<vulkan::UniformRingBuffer> mUniformRingBuffer;
     vk::UniqueDescriptorPool mDescriptorPool;
     MatrixUBO mMatrixUBO;
-    vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
-    std::vector<vk::DescriptorSet> mDescriptorSets;
+    // The vertex positions are quantized relative to the model bounds.
+    glm::mat4 mDequantizationMatrix = glm::mat4(1.0f);
+    vk::DescriptorSetLayout mDescriptorSetLayout; // Owned by the PipelineSystem
+    vk::DescriptorSet mDescriptorSet;
 
     vk::UniqueSampler mTextureSampler;
     vk::UniqueImageView mImageView;
@@ -11,7 +11,8 @@ using namespace std::chrono;
 
 void 
 MatrixUBO::update(const uint32_t swapChainImageIndex,
-                  const float swapChainImageAspectRatio) {
+                  const float swapChainImageAspectRatio,
+                  const mat4& dequantizationMatrix) {
     // Calculate time in seconds since rendering has started with floating point accuracy.
     static time_point<high_resolution_clock> startTime = high_resolution_clock::now();
     const time_point<high_resolution_clock> currentTime = high_resolution_clock::now();
@@ -24,7 +25,7 @@ MatrixUBO::update(const uint32_t swapChainImageIndex,
     const vec3 axis(0.0f, 0.0f, 1.0f);
     mModelMatrix = rotate(identityMat4,
                           angle,
-                          axis);
+                          axis) * dequantizationMatrix;
 
     // For the view transformation, we will look at the geometry from
     // above at a 45 degree angle.
@@ -17,9 +17,12 @@ struct MatrixUBO {
     alignas(16) glm::mat4 mViewMatrix;
     alignas(16) glm::mat4 mProjectionMatrix;
 
+    // * dequantizationMatrix of the vertex positions, that is
+    //   applied before the model rotation.
     void 
     update(const uint32_t swapChainImageIndex,
-           const float swapChainImageAspectRatio);
+           const float swapChainImageAspectRatio,
+           const glm::mat4& dequantizationMatrix);
 };
 
 #endif 
\ No newline at end of file
@@ -1,13 +1,26 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
 #include "App.h"
 #include "Utils/SystemInitializer.h"
 
-int main() {
-    vulkan::system_initializer::initialize();
+int main(int argc, char* argv[]) {
+    vulkan::system_initializer::initialize(argc, 
+                                           argv);
 
-    {
+    // The exception is caught, so App is destroyed (and its
+    // pipeline compile jobs cancelled) before the systems are finalized.
+    int exitCode = EXIT_SUCCESS;
+    try {
         App app;
         app.run();
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        exitCode = EXIT_FAILURE;
     }
 
     vulkan::system_initializer::finalize();
+
+    return exitCode;
 }
\ No newline at end of file
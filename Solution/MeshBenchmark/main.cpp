@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "Utils/resource/ModelSystem.h"
+#include "Utils/resource/VertexWelder.h"
+
+using namespace vulkan;
+
+namespace {
+// Usage: MeshBenchmark [model file path] [run count]
+const char* sDefaultModelFilePath = "../../../external/resources/models/chalet.obj";
+const uint32_t sDefaultRunCount = 5;
+// Quads per side of the grid of the vertex welding benchmark
+// (6 indices per quad, so 6 million indices).
+const uint32_t sGridQuadsPerSide = 1000;
+
+// Returns the best time (in milliseconds) of runCount loads
+// of the model, and sets model with the last one.
+double
+benchmarkModelLoading(const std::string& modelFilePath,
+                      const uint32_t parserThreadCount,
+                      const uint32_t runCount,
+                      Model<PosTexCoordVertex>& model) {
+    double bestTime = 0.0;
+    for (uint32_t i = 0; i < runCount; ++i) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ModelSystem::loadModelWithPosTexCoordVertex(modelFilePath,
+                                                    parserThreadCount,
+                                                    model);
+        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        bestTime = i == 0 ? time.count() : std::min(bestTime, time.count());
+    }
+
+    return bestTime;
+}
+
+void
+benchmarkObjParsing(const std::string& modelFilePath,
+                    const uint32_t runCount) {
+    const uint32_t hardwareThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    Model<PosTexCoordVertex> model;
+    const double serialTime = benchmarkModelLoading(modelFilePath,
+                                                    1,
+                                                    runCount,
+                                                    model);
+
+    Model<PosTexCoordVertex> parallelModel;
+    const double parallelTime = benchmarkModelLoading(modelFilePath,
+                                                      0,
+                                                      runCount,
+                                                      parallelModel);
+
+    const bool isSameModel = model.mVertices == parallelModel.mVertices &&
+                             model.mIndices == parallelModel.mIndices;
+
+    std::cout << "OBJ parsing of " << modelFilePath << std::endl;
+    std::cout << "  " << model.mVertices.size() << " vertices, " << model.mIndices.size() << " indices" << std::endl;
+    std::cout << "  1 thread: " << serialTime << " ms" << std::endl;
+    std::cout << "  " << hardwareThreadCount << " threads (memory mapped): " << parallelTime << " ms" << std::endl;
+    std::cout << "  Speedup: " << serialTime / parallelTime << "x" << std::endl;
+    std::cout << "  Same model: " << (isSameModel ? "yes" : "NO") << std::endl;
+}
+
+void
+benchmarkModelCache(const std::string& modelFilePath,
+                    const uint32_t runCount) {
+    // The first load writes the cache (if it does not exist).
+    Model<PosTexCoordVertex> parsedModel;
+    const double parseTime = benchmarkModelLoading(modelFilePath,
+                                                   0,
+                                                   runCount,
+                                                   parsedModel);
+    ModelSystem::getOrLoadModelWithPosTexCoordVertex(modelFilePath);
+    ModelSystem::clear();
+    // The cached model is optimized.
+    parsedModel.optimize();
+
+    // The pages of the cache are read when its vertices and indices are
+    // copied to the staging memory, so this does not include reading the file.
+    double bestCacheTime = 0.0;
+    bool isSameModel = false;
+    for (uint32_t i = 0; i < runCount; ++i) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const Model<PosTexCoordVertex>& model = ModelSystem::getOrLoadModelWithPosTexCoordVertex(modelFilePath);
+        const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        bestCacheTime = i == 0 ? time.count() : std::min(bestCacheTime, time.count());
+
+        isSameModel = model.mMappedFile != nullptr &&
+                      model.vertexCount() == parsedModel.mVertices.size() &&
+                      model.indexCount() == parsedModel.mIndices.size() &&
+                      std::equal(parsedModel.mVertices.begin(), parsedModel.mVertices.end(), model.vertexData()) &&
+                      std::equal(parsedModel.mIndices.begin(), parsedModel.mIndices.end(), model.indexData());
+        ModelSystem::clear();
+    }
+
+    std::cout << "Binary cache of " << modelFilePath << std::endl;
+    std::cout << "  Parsing: " << parseTime << " ms" << std::endl;
+    std::cout << "  Mapped cache: " << bestCacheTime << " ms" << std::endl;
+    std::cout << "  Speedup: " << parseTime / bestCacheTime << "x" << std::endl;
+    std::cout << "  Same model: " << (isSameModel ? "yes" : "NO") << std::endl;
+}
+
+// Triangle soup (a vertex per index) of a grid of quads,
+// with 6 indices per vertex as a regular triangle mesh.
+std::vector<PosTexCoordVertex>
+createGridSoup(const uint32_t quadsPerSide) {
+    std::vector<PosTexCoordVertex> vertices;
+    vertices.reserve(6 * static_cast<size_t>(quadsPerSide) * quadsPerSide);
+
+    const uint32_t corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    for (uint32_t y = 0; y < quadsPerSide; ++y) {
+        for (uint32_t x = 0; x < quadsPerSide; ++x) {
+            for (const uint32_t* corner : corners) {
+                PosTexCoordVertex vertex;
+                vertex.mPosition = glm::vec3(static_cast<float>(x + corner[0]),
+                                             static_cast<float>(y + corner[1]),
+                                             0.0f);
+                vertex.mTexCoord = glm::vec2(vertex.mPosition.x / quadsPerSide,
+                                             vertex.mPosition.y / quadsPerSide);
+                vertices.push_back(vertex);
+            }
+        }
+    }
+
+    return vertices;
+}
+
+// The vertex welding of ModelSystem before VertexWelder.
+void
+weldVerticesWithUnorderedMap(const std::vector<PosTexCoordVertex>& unweldedVertices,
+                             std::vector<PosTexCoordVertex>& vertices,
+                             std::vector<uint32_t>& indices) {
+    std::unordered_map<PosTexCoordVertex, uint32_t> uniqueVertices;
+    for (const PosTexCoordVertex& vertex : unweldedVertices) {
+        if (uniqueVertices.count(vertex) == 0) {
+            uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertex);
+        }
+        indices.push_back(uniqueVertices[vertex]);
+    }
+}
+
+void
+benchmarkVertexWelding(const uint32_t runCount) {
+    const std::vector<PosTexCoordVertex> unweldedVertices = createGridSoup(sGridQuadsPerSide);
+    const uint32_t hardwareThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    double unorderedMapTime = 0.0;
+    double welderTime = 0.0;
+    double shardedWelderTime = 0.0;
+    bool isSameResult = true;
+    for (uint32_t i = 0; i < runCount; ++i) {
+        std::vector<PosTexCoordVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        weldVerticesWithUnorderedMap(unweldedVertices,
+                                     vertices,
+                                     indices);
+        std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        unorderedMapTime = i == 0 ? time.count() : std::min(unorderedMapTime, time.count());
+
+        std::vector<PosTexCoordVertex> welderVertices;
+        std::vector<uint32_t> welderIndices;
+        start = std::chrono::steady_clock::now();
+        VertexWelder<PosTexCoordVertex>::weldVertices(unweldedVertices,
+                                                      1,
+                                                      welderVertices,
+                                                      welderIndices);
+        time = std::chrono::steady_clock::now() - start;
+        welderTime = i == 0 ? time.count() : std::min(welderTime, time.count());
+        isSameResult = isSameResult && welderVertices == vertices && welderIndices == indices;
+
+        start = std::chrono::steady_clock::now();
+        VertexWelder<PosTexCoordVertex>::weldVertices(unweldedVertices,
+                                                      0,
+                                                      welderVertices,
+                                                      welderIndices);
+        time = std::chrono::steady_clock::now() - start;
+        shardedWelderTime = i == 0 ? time.count() : std::min(shardedWelderTime, time.count());
+        isSameResult = isSameResult && welderVertices == vertices && welderIndices == indices;
+    }
+
+    std::cout << "Vertex welding of a grid of " << unweldedVertices.size() << " indices" << std::endl;
+    std::cout << "  std::unordered_map: " << unorderedMapTime << " ms" << std::endl;
+    std::cout << "  VertexWelder, 1 thread: " << welderTime << " ms" << std::endl;
+    std::cout << "  VertexWelder, " << hardwareThreadCount << " threads: " << shardedWelderTime << " ms" << std::endl;
+    std::cout << "  Speedup: " << unorderedMapTime / std::min(welderTime, shardedWelderTime) << "x" << std::endl;
+    std::cout << "  Same result: " << (isSameResult ? "yes" : "NO") << std::endl;
+}
+
+void
+printVertexCacheStatistics(const char* name,
+                           const VertexCacheStatistics& statistics) {
+    std::cout << "  " << name << ": ACMR " << statistics.mAcmr << ", ATVR " << statistics.mAtvr << std::endl;
+}
+
+void
+benchmarkMeshOptimization(const std::string& name,
+                          const Model<PosTexCoordVertex>& model) {
+    Model<PosTexCoordVertex> optimizedModel = model;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const MeshOptimizationStatistics statistics = optimizedModel.optimize();
+    const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Mesh optimization of " << name << " (" << model.mIndices.size() / 3 << " triangles)" << std::endl;
+    printVertexCacheStatistics("Before",
+                               statistics.mBefore);
+    printVertexCacheStatistics("After",
+                               statistics.mAfter);
+    std::cout << "  Time: " << time.count() << " ms" << std::endl;
+}
+
+void
+benchmarkMeshOptimization(const std::string& modelFilePath) {
+    Model<PosTexCoordVertex> model;
+    ModelSystem::loadModelWithPosTexCoordVertex(modelFilePath,
+                                                0,
+                                                model);
+    benchmarkMeshOptimization(modelFilePath,
+                              model);
+
+    // The grid, with its triangles in random order.
+    Model<PosTexCoordVertex> gridModel;
+    VertexWelder<PosTexCoordVertex>::weldVertices(createGridSoup(sGridQuadsPerSide),
+                                                  0,
+                                                  gridModel.mVertices,
+                                                  gridModel.mIndices);
+    std::vector<uint32_t> triangles(gridModel.mIndices.size() / 3);
+    for (uint32_t i = 0; i < triangles.size(); ++i) {
+        triangles[i] = i;
+    }
+    std::shuffle(triangles.begin(),
+                 triangles.end(),
+                 std::mt19937(0));
+    std::vector<uint32_t> shuffledIndices;
+    shuffledIndices.reserve(gridModel.mIndices.size());
+    for (const uint32_t triangle : triangles) {
+        shuffledIndices.insert(shuffledIndices.end(),
+                               gridModel.mIndices.begin() + 3 * triangle,
+                               gridModel.mIndices.begin() + 3 * triangle + 3);
+    }
+    gridModel.mIndices.swap(shuffledIndices);
+    benchmarkMeshOptimization("a shuffled grid",
+                              gridModel);
+}
+}
+
+int main(int argc, char* argv[]) {
+    const std::string modelFilePath = argc > 1 ? argv[1] : sDefaultModelFilePath;
+    const uint32_t runCount = argc > 2 ? static_cast<uint32_t>(std::max(std::atoi(argv[2]), 1)) : sDefaultRunCount;
+
+    try {
+        benchmarkObjParsing(modelFilePath,
+                            runCount);
+        benchmarkModelCache(modelFilePath,
+                            runCount);
+        benchmarkVertexWelding(runCount);
+        benchmarkMeshOptimization(modelFilePath);
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
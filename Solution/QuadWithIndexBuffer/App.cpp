@@ -4,10 +4,12 @@
 
 #include "Utils/CommandPools.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/Window.h"
 #include "Utils/device/LogicalDevice.h"
 #include "Utils/device/PhysicalDevice.h"
 #include "Utils/pipeline/PipelineStates.h"
+#include "Utils/pipeline/PipelineSystem.h"
 #include "Utils/shader/ShaderModule.h"
 #include "Utils/shader/ShaderModuleSystem.h"
 #include "Utils/shader/ShaderStages.h"
@@ -19,17 +21,24 @@ App::App() {
     initRenderPass();
     initFrameBuffers();
     initCommandBuffers();
-    initSemaphoresAndFences();
+    initFrameContext();
     initGraphicsPipeline();
     initBuffers();
     recordCommandBuffers();
+
+    // Submit the uploads recorded during the initialization.
+    // The first frame waits for them on the device.
+    mTransferTicket = TransferEngine::flush();
+    mTransferSemaphore = TransferEngine::takeSemaphore(mTransferTicket);
 }
 
 void
 App::run() {
     while (Window::shouldCloseWindow() == false) {
-        glfwPollEvents();
-        
+        Window::pollEvents();
+
+        mFrameContext->beginFrame();
+
         submitCommandBufferAndPresent();
     }
 
@@ -145,13 +154,12 @@ App::initGraphicsPipeline()  {
     ShaderStages shaderStages;
     initShaderStages(shaderStages);
 
-    vk::UniquePipelineLayout pipelineLayout = 
-        LogicalDevice::device().createPipelineLayoutUnique({});
+    const vk::PipelineLayout pipelineLayout = PipelineSystem::getOrCreatePipelineLayout({});
 
-    mGraphicsPipeline.reset(new GraphicsPipeline(pipelineLayout,
-                                                 pipelineStates,
-                                                 shaderStages,
-                                                 mRenderPass.get()));
+    mGraphicsPipeline = &PipelineSystem::getOrCreateGraphicsPipeline(pipelineLayout,
+                                                                    pipelineStates,
+                                                                    shaderStages,
+                                                                    mRenderPass.get());
 }
 
 void 
@@ -168,7 +176,7 @@ App::initRenderPass() {
     attachmentDesc.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare);
     attachmentDesc.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
     attachmentDesc.setInitialLayout(vk::ImageLayout::eUndefined);
-    attachmentDesc.setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+    attachmentDesc.setFinalLayout(mSwapChain.presentationImageLayout());
     info.setAttachmentCount(1);
     info.setPAttachments(&attachmentDesc);
     
@@ -213,34 +221,31 @@ void
 App::submitCommandBufferAndPresent() {
     assert(mCommandBuffers.empty() == false);
 
-    const vk::Fence& fence = mFences->nextAvailableFence();
-    vk::Device device(LogicalDevice::device());
-    device.waitForFences({fence},
-                         VK_TRUE,
-                         std::numeric_limits<uint64_t>::max());
-    device.resetFences({fence});
-
-    vk::Semaphore imageAvailableSemaphore = mImageAvailableSemaphores->nextAvailableSemaphore();
-    vk::Semaphore renderFinishedSemaphore = mRenderFinishedSemaphores->nextAvailableSemaphore();
-
-    const uint32_t swapChainImageIndex = mSwapChain.acquireNextImage(imageAvailableSemaphore);
-    assert(swapChainImageIndex < mCommandBuffers.size());
-
-    vk::CommandBuffer& commandBuffer = mCommandBuffers[swapChainImageIndex].get();
-    vk::SubmitInfo info;
-    info.setWaitSemaphoreCount(1);
-    info.setPWaitSemaphores(&imageAvailableSemaphore);
-    info.setSignalSemaphoreCount(1);
-    info.setPSignalSemaphores(&renderFinishedSemaphore);
-    info.setCommandBufferCount(1);
-    info.setPCommandBuffers(&commandBuffer);
-    const vk::PipelineStageFlags flags(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-    info.setPWaitDstStageMask(&flags);
-    LogicalDevice::graphicsQueue().submit({info},
-                                          fence);
-
-    mSwapChain.present(renderFinishedSemaphore,
-                       swapChainImageIndex);
+    // The next image was already acquired by FrameContext::beginFrame() in run()
+    const uint32_t swapChainImageIndex = mSwapChain.currentImageIndex();
+    assert(swapChainImageIndex < static_cast<uint32_t>(mCommandBuffers.size()));
+
+    // The first submission waits on the device for the uploads of the 
+    // initialization. The next submissions are not ordered after that wait,
+    // so they wait on the host until the uploads are completed 
+    // (usually, they already are).
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<vk::PipelineStageFlags> waitStageFlags;
+    if (mTransferSemaphore.get() != VK_NULL_HANDLE) {
+        waitSemaphores.push_back(mTransferSemaphore.get());
+        waitStageFlags.push_back(vk::PipelineStageFlagBits::eVertexInput);
+        // It must be alive until the submission is completed.
+        mWaitedTransferSemaphore = std::move(mTransferSemaphore);
+    } else if (mTransferTicket.isValid()) {
+        TransferEngine::wait(mTransferTicket);
+        mTransferTicket = TransferTicket();
+    }
+
+    // The command buffer of the swap chain image is not in use,
+    // because FrameContext waited for the frame that used the image.
+    mFrameContext->submitAndPresent({mCommandBuffers[swapChainImageIndex].get()},
+                                    waitSemaphores,
+                                    waitStageFlags);
 }
 
 void
@@ -280,14 +285,14 @@ App::initCommandBuffers() {
 }
 
 void
-App::initSemaphoresAndFences() {
-    assert(mImageAvailableSemaphores == nullptr);
-    assert(mRenderFinishedSemaphores == nullptr);
-    assert(mFences == nullptr);
-
-    mImageAvailableSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mRenderFinishedSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mFences.reset(new Fences(mFrameBuffers.size()));
+App::initFrameContext() {
+    assert(mFrameContext == nullptr);
+
+    // Command buffers are pre-recorded for each swap chain image, and
+    // FrameContext waits until the acquired image is not in flight, so
+    // the number of frames in flight does not depend on the swap chain.
+    mFrameContext.reset(new FrameContext(mSwapChain,
+                                         2)); // frames in flight
 }
 
 void 
@@ -3,12 +3,12 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include "Utils/FrameContext.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/pipeline/GraphicsPipeline.h"
 #include "Utils/pipeline/PipelineStates.h"
 #include "Utils/resource/Buffer.h"
-#include "Utils/sync/Fences.h"
-#include "Utils/sync/Semaphores.h"
 
 namespace vulkan {
 class ShaderStages;
@@ -50,7 +50,7 @@ protected:
     initCommandBuffers();
 
     void
-    initSemaphoresAndFences();
+    initFrameContext();
 
     void 
     initPipelineStates(vulkan::PipelineStates& pipelineStates) const;
@@ -65,12 +65,18 @@ protected:
 
     std::vector<vk::UniqueCommandBuffer> mCommandBuffers;
 
-    std::unique_ptr<vulkan::GraphicsPipeline> mGraphicsPipeline;
+    // Owned by the PipelineSystem
+    const vulkan::GraphicsPipeline* mGraphicsPipeline = nullptr;
     vulkan::PipelineStates mPipelineStates;
 
-    std::unique_ptr<vulkan::Semaphores> mImageAvailableSemaphores;
-    std::unique_ptr<vulkan::Semaphores> mRenderFinishedSemaphores;
-    std::unique_ptr<vulkan::Fences> mFences;
+    // Synchronization of the frames in flight.
+    std::unique_ptr<vulkan::FrameContext> mFrameContext;
+
+    // Uploads recorded during the initialization.
+    // Read submitCommandBufferAndPresent()
+    vulkan::TransferTicket mTransferTicket;
+    vk::UniqueSemaphore mTransferSemaphore;
+    vk::UniqueSemaphore mWaitedTransferSemaphore;
 
     std::unique_ptr<vulkan::Buffer> mGpuVertexBuffer;
     std::unique_ptr<vulkan::Buffer> mGpuIndexBuffer;
@@ -5,10 +5,12 @@
 
 #include "Utils/CommandPools.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/Window.h"
 #include "Utils/device/LogicalDevice.h"
 #include "Utils/device/PhysicalDevice.h"
 #include "Utils/pipeline/PipelineStates.h"
+#include "Utils/pipeline/PipelineSystem.h"
 #include "Utils/shader/ShaderModule.h"
 #include "Utils/shader/ShaderModuleSystem.h"
 #include "Utils/shader/ShaderStages.h"
@@ -22,18 +24,22 @@ App::App() {
     initRenderPass();
     initFrameBuffers();
     initCommandBuffers();
-    initSemaphoresAndFences();
+    initFrameContext();
     initGraphicsPipeline();    
     recordCommandBuffers();
+
+    // Submit the uploads recorded during the initialization.
+    // The first frame waits for them on the device.
+    mTransferTicket = TransferEngine::flush();
+    mTransferSemaphore = TransferEngine::takeSemaphore(mTransferTicket);
 }
 
 void
 App::run() {
     while (Window::shouldCloseWindow() == false) {
-        glfwPollEvents();
+        Window::pollEvents();
 
-        vk::Semaphore imageAvailableSemaphore = mImageAvailableSemaphores->nextAvailableSemaphore();
-        mSwapChain.acquireNextImage(imageAvailableSemaphore);
+        mFrameContext->beginFrame();
 
         processCurrentFrame();
 
@@ -50,29 +56,30 @@ App::run() {
 
 void
 App::processCurrentFrame() {
-    // Update uniform buffers
+    // Update uniform buffers.
+    // Each swap chain image has its own partition of the ring buffer,
+    // so the data lands at the dynamic offset recorded in recordCommandBuffers().
     const uint32_t currentSwapChainImageIndex = mSwapChain.currentImageIndex();
-    mMatrixUBO.update(currentSwapChainImageIndex, 
+    mMatrixUBO.update(currentSwapChainImageIndex,
                       mSwapChain.imageAspectRatio());
-    Buffer& uniformBuffer = mUniformBuffers[currentSwapChainImageIndex];
-    uniformBuffer.copyToHostMemory(&mMatrixUBO);
+    mUniformRingBuffer->beginFrame(currentSwapChainImageIndex);
+    mUniformRingBuffer->push(mMatrixUBO);
+    mUniformRingBuffer->endFrame();
 }
 
 void
 App::initDescriptorSets() {
     assert(mDescriptorPool.get() == VK_NULL_HANDLE);
-    const uint32_t imageViewCount = mSwapChain.imageViewCount();
+    assert(mUniformRingBuffer != nullptr);
 
-    vk::DescriptorPoolSize descPoolSizes[2];
-    descPoolSizes[0].setDescriptorCount(imageViewCount);
-    descPoolSizes[0].setType(vk::DescriptorType::eUniformBuffer);
-    descPoolSizes[1].setDescriptorCount(imageViewCount);
-    descPoolSizes[1].setType(vk::DescriptorType::eCombinedImageSampler);
+    vk::DescriptorPoolSize descPoolSize;
+    descPoolSize.setDescriptorCount(1);
+    descPoolSize.setType(vk::DescriptorType::eUniformBufferDynamic);
 
     vk::DescriptorPoolCreateInfo descPoolInfo;
-    descPoolInfo.setMaxSets(imageViewCount);
-    descPoolInfo.setPoolSizeCount(2);
-    descPoolInfo.setPPoolSizes(descPoolSizes);
+    descPoolInfo.setMaxSets(1);
+    descPoolInfo.setPoolSizeCount(1);
+    descPoolInfo.setPPoolSizes(&descPoolSize);
 
     mDescriptorPool = LogicalDevice::device().createDescriptorPoolUnique(descPoolInfo);
 
@@ -80,7 +87,7 @@ App::initDescriptorSets() {
 
     vk::DescriptorSetLayoutBinding descSetLayoutBinding;
     descSetLayoutBinding.setBinding(0);
-    descSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBuffer);
+    descSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
     descSetLayoutBinding.setDescriptorCount(1);
     descSetLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eVertex);
 
@@ -91,33 +98,28 @@ App::initDescriptorSets() {
     mDescriptorSetLayout = 
         LogicalDevice::device().createDescriptorSetLayoutUnique(descSetLayoutInfo);
 
-    const std::vector<vk::DescriptorSetLayout> descSetLayouts(imageViewCount, 
-                                                              mDescriptorSetLayout.get());
-
     vk::DescriptorSetAllocateInfo allocateInfo;
     allocateInfo.setDescriptorPool(mDescriptorPool.get());
-    allocateInfo.setDescriptorSetCount(imageViewCount);
-    allocateInfo.setPSetLayouts(descSetLayouts.data());
+    allocateInfo.setDescriptorSetCount(1);
+    allocateInfo.setPSetLayouts(&mDescriptorSetLayout.get());
 
-    // Create a descriptor set for each swap chain image, all with the same layout.
-    mDescriptorSets = LogicalDevice::device().allocateDescriptorSets(allocateInfo);
+    // A single descriptor set is shared by all the swap chain images.
+    // The dynamic offset given to vkCmdBindDescriptorSets selects
+    // the partition of the uniform ring buffer.
+    mDescriptorSet = LogicalDevice::device().allocateDescriptorSets(allocateInfo).front();
 
-    // The descriptor sets have been allocated now, but the descriptors within still
+    // The descriptor set has been allocated now, but the descriptors within still
     // need to be configured.
-    vk::DescriptorBufferInfo bufferInfo;
-    bufferInfo.setRange(sizeof(MatrixUBO));
-    for (uint32_t i = 0; i < imageViewCount; ++i) {
-        bufferInfo.buffer = mUniformBuffers[i].vkBuffer();
-        vk::WriteDescriptorSet writeDescriptorSet;
-        writeDescriptorSet.setDstBinding(0);
-        writeDescriptorSet.setDescriptorCount(1);
-        writeDescriptorSet.setDescriptorType(vk::DescriptorType::eUniformBuffer);
-        writeDescriptorSet.setPBufferInfo(&bufferInfo);
-        writeDescriptorSet.setDstSet(mDescriptorSets[i]);
-
-        LogicalDevice::device().updateDescriptorSets({writeDescriptorSet},
-                                                     {});
-    }
+    const vk::DescriptorBufferInfo bufferInfo = mUniformRingBuffer->descriptorBufferInfo(sizeof(MatrixUBO));
+    vk::WriteDescriptorSet writeDescriptorSet;
+    writeDescriptorSet.setDstBinding(0);
+    writeDescriptorSet.setDescriptorCount(1);
+    writeDescriptorSet.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
+    writeDescriptorSet.setPBufferInfo(&bufferInfo);
+    writeDescriptorSet.setDstSet(mDescriptorSet);
+
+    LogicalDevice::device().updateDescriptorSets({writeDescriptorSet},
+                                                 {});
 }
 
 void 
@@ -173,16 +175,12 @@ App::initIndexBuffer() {
 
 void
 App::initUniformBuffers() {
-    assert(mUniformBuffers.empty());
+    assert(mUniformRingBuffer == nullptr);
 
-    for (uint32_t i = 0; i < mSwapChain.imageViewCount(); ++i) {
-        Buffer buffer(sizeof(MatrixUBO),
-                      vk::BufferUsageFlagBits::eUniformBuffer,
-                      vk::MemoryPropertyFlagBits::eHostVisible |
-                      vk::MemoryPropertyFlagBits::eHostCoherent);
-
-        mUniformBuffers.emplace_back(std::move(buffer));
-    }
+    // One partition for each swap chain image, as each one
+    // has its own pre-recorded command buffer.
+    mUniformRingBuffer.reset(new UniformRingBuffer(sizeof(MatrixUBO),
+                                                   mSwapChain.imageViewCount()));
 }
 
 void
@@ -219,8 +217,8 @@ App::recordCommandBuffers() {
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                                          mGraphicsPipeline->pipelineLayout(),
                                          0, // first descriptor set
-                                         {mDescriptorSets[i]},
-                                         {}); // dynamic arrays
+                                         {mDescriptorSet},
+                                         {mUniformRingBuffer->frameOffset(i)}); // dynamic offsets
 
         commandBuffer.drawIndexed(static_cast<uint32_t>(mGpuIndexBuffer->size() / sizeof(uint32_t)),
                                   1,
@@ -245,17 +243,12 @@ App::initGraphicsPipeline() {
     ShaderStages shaderStages;
     initShaderStages(shaderStages);
 
-    vk::PipelineLayoutCreateInfo info;
-    info.setSetLayoutCount(1);
-    info.setPSetLayouts(&mDescriptorSetLayout.get());
-    
-    vk::UniquePipelineLayout pipelineLayout = 
-        LogicalDevice::device().createPipelineLayoutUnique(info);
-
-    mGraphicsPipeline.reset(new GraphicsPipeline(pipelineLayout,
-                                                 pipelineStates,
-                                                 shaderStages,
-                                                 mRenderPass.get()));
+    const vk::PipelineLayout pipelineLayout = PipelineSystem::getOrCreatePipelineLayout({mDescriptorSetLayout.get()});
+
+    mGraphicsPipeline = &PipelineSystem::getOrCreateGraphicsPipeline(pipelineLayout,
+                                                                    pipelineStates,
+                                                                    shaderStages,
+                                                                    mRenderPass.get());
 }
 
 void
@@ -309,7 +302,7 @@ App::initRenderPass() {
     attachmentDesc.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare);
     attachmentDesc.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare);
     attachmentDesc.setInitialLayout(vk::ImageLayout::eUndefined);
-    attachmentDesc.setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+    attachmentDesc.setFinalLayout(mSwapChain.presentationImageLayout());
     info.setAttachmentCount(1);
     info.setPAttachments(&attachmentDesc);
 
@@ -354,37 +347,31 @@ void
 App::submitCommandBufferAndPresent() {
     assert(mCommandBuffers.empty() == false);
 
-    const vk::Fence& fence = mFences->nextAvailableFence();
-    vk::Device device(LogicalDevice::device());
-    device.waitForFences({fence},
-                         VK_TRUE,
-                         std::numeric_limits<uint64_t>::max());
-    device.resetFences({fence});
-
-    // This semaphore was already obtained in run()
-    vk::Semaphore imageAvailableSemaphore = mImageAvailableSemaphores->currentSemaphore();
-    vk::Semaphore renderFinishedSemaphore = mRenderFinishedSemaphores->nextAvailableSemaphore();
-
-    // The next image was already obtained in run()
+    // The next image was already acquired by FrameContext::beginFrame() in run()
     const uint32_t swapChainImageIndex = mSwapChain.currentImageIndex();
-    assert(swapChainImageIndex < mCommandBuffers.size());
-
-    vk::CommandBuffer& commandBuffer = mCommandBuffers[swapChainImageIndex].get();
-
-    vk::SubmitInfo info;
-    info.setWaitSemaphoreCount(1);
-    info.setPWaitSemaphores(&imageAvailableSemaphore);
-    info.setSignalSemaphoreCount(1);
-    info.setPSignalSemaphores(&renderFinishedSemaphore);
-    info.setCommandBufferCount(1);
-    info.setPCommandBuffers(&commandBuffer);
-    const vk::PipelineStageFlags flags(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-    info.setPWaitDstStageMask(&flags);
-    LogicalDevice::graphicsQueue().submit({info},
-                                          fence);
-
-    mSwapChain.present(renderFinishedSemaphore,
-                       swapChainImageIndex);
+    assert(swapChainImageIndex < static_cast<uint32_t>(mCommandBuffers.size()));
+
+    // The first submission waits on the device for the uploads of the 
+    // initialization. The next submissions are not ordered after that wait,
+    // so they wait on the host until the uploads are completed 
+    // (usually, they already are).
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<vk::PipelineStageFlags> waitStageFlags;
+    if (mTransferSemaphore.get() != VK_NULL_HANDLE) {
+        waitSemaphores.push_back(mTransferSemaphore.get());
+        waitStageFlags.push_back(vk::PipelineStageFlagBits::eVertexInput);
+        // It must be alive until the submission is completed.
+        mWaitedTransferSemaphore = std::move(mTransferSemaphore);
+    } else if (mTransferTicket.isValid()) {
+        TransferEngine::wait(mTransferTicket);
+        mTransferTicket = TransferTicket();
+    }
+
+    // The command buffer of the swap chain image is not in use,
+    // because FrameContext waited for the frame that used the image.
+    mFrameContext->submitAndPresent({mCommandBuffers[swapChainImageIndex].get()},
+                                    waitSemaphores,
+                                    waitStageFlags);
 }
 
 void
@@ -424,12 +411,12 @@ App::initCommandBuffers() {
 }
 
 void
-App::initSemaphoresAndFences() {
-    assert(mImageAvailableSemaphores == nullptr);
-    assert(mRenderFinishedSemaphores == nullptr);
-    assert(mFences == nullptr);
-
-    mImageAvailableSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mRenderFinishedSemaphores.reset(new Semaphores(mFrameBuffers.size()));
-    mFences.reset(new Fences(mFrameBuffers.size()));
+App::initFrameContext() {
+    assert(mFrameContext == nullptr);
+
+    // Command buffers are pre-recorded for each swap chain image, and
+    // FrameContext waits until the acquired image is not in flight, so
+    // the number of frames in flight does not depend on the swap chain.
+    mFrameContext.reset(new FrameContext(mSwapChain,
+                                         2)); // frames in flight
 }
\ No newline at end of file
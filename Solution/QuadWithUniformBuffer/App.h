@@ -3,12 +3,13 @@
 
 #include "MatrixUBO.h"
 
+#include "Utils/FrameContext.h"
 #include "Utils/SwapChain.h"
+#include "Utils/TransferEngine.h"
 #include "Utils/pipeline/GraphicsPipeline.h"
 #include "Utils/pipeline/PipelineStates.h"
 #include "Utils/resource/Buffer.h"
-#include "Utils/sync/Fences.h"
-#include "Utils/sync/Semaphores.h"
+#include "Utils/resource/UniformRingBuffer.h"
 
 namespace vulkan {
 class ShaderStages;
@@ -65,7 +66,7 @@ protected:
     initCommandBuffers();
 
     void
-    initSemaphoresAndFences();
+    initFrameContext();
 
     vulkan::SwapChain mSwapChain;
     
@@ -73,22 +74,28 @@ protected:
     std::vector<vk::UniqueFramebuffer> mFrameBuffers;
 
     std::vector<vk::UniqueCommandBuffer> mCommandBuffers;
-    std::unique_ptr<vulkan::GraphicsPipeline> mGraphicsPipeline;
+    // Owned by the PipelineSystem
+    const vulkan::GraphicsPipeline* mGraphicsPipeline = nullptr;
 
     vulkan::PipelineStates mPipelineStates;
 
-    std::unique_ptr<vulkan::Semaphores> mImageAvailableSemaphores;
-    std::unique_ptr<vulkan::Semaphores> mRenderFinishedSemaphores;
-    std::unique_ptr<vulkan::Fences> mFences;
+    // Synchronization of the frames in flight.
+    std::unique_ptr<vulkan::FrameContext> mFrameContext;
+
+    // Uploads recorded during the initialization.
+    // Read submitCommandBufferAndPresent()
+    vulkan::TransferTicket mTransferTicket;
+    vk::UniqueSemaphore mTransferSemaphore;
+    vk::UniqueSemaphore mWaitedTransferSemaphore;
 
     std::unique_ptr<vulkan::Buffer> mGpuVertexBuffer;
     std::unique_ptr<vulkan::Buffer> mGpuIndexBuffer;
 
-    std::vector<vulkan::Buffer> mUniformBuffers;
+    std::unique_ptr<vulkan::UniformRingBuffer> mUniformRingBuffer;
     vk::UniqueDescriptorPool mDescriptorPool;
     MatrixUBO mMatrixUBO;
     vk::UniqueDescriptorSetLayout mDescriptorSetLayout;
-    std::vector<vk::DescriptorSet> mDescriptorSets;
+    vk::DescriptorSet mDescriptorSet;
     
 };
 
@@ -1,8 +1,9 @@
 #include "App.h"
 #include "Utils/SystemInitializer.h"
 
-int main() {
-    vulkan::system_initializer::initialize();
+int main(int argc, char* argv[]) {
+    vulkan::system_initializer::initialize(argc, 
+                                           argv);
 
     {
         App app;
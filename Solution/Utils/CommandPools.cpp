@@ -43,12 +43,12 @@ CommandPools::transferCommandPool() {
 }
 
 vk::UniqueCommandBuffer
-CommandPools::beginOneTimeSubmitCommandBuffer() {
-    assert(mTransferCommandPool.get() != VK_NULL_HANDLE);
+CommandPools::beginOneTimeSubmitCommandBuffer(const vk::CommandPool commandPool) {
+    assert(commandPool != VK_NULL_HANDLE);
 
     vk::CommandBufferAllocateInfo allocInfo;
     allocInfo.setCommandBufferCount(1);
-    allocInfo.setCommandPool(mTransferCommandPool.get());
+    allocInfo.setCommandPool(commandPool);
     allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
 
     vk::UniqueCommandBuffer commandBuffer = std::move(LogicalDevice::device().allocateCommandBuffersUnique(allocInfo).front());
@@ -56,29 +56,4 @@ CommandPools::beginOneTimeSubmitCommandBuffer() {
 
     return commandBuffer;
 }
-
-void
-CommandPools::endAndWaitOneTimeSubmitCommandBuffer(vk::CommandBuffer commandBuffer) {
-    assert(commandBuffer != VK_NULL_HANDLE);
-
-    commandBuffer.end();
-
-    vk::UniqueFence fence = LogicalDevice::device().createFenceUnique({vk::FenceCreateFlagBits::eSignaled});
-    LogicalDevice::device().waitForFences({fence.get()},
-                                          VK_TRUE,
-                                          std::numeric_limits<uint64_t>::max());
-    LogicalDevice::device().resetFences({fence.get()});
-
-    vk::SubmitInfo info;
-    info.setCommandBufferCount(1);
-    info.setPCommandBuffers(&commandBuffer);
-    const vk::PipelineStageFlags flags(vk::PipelineStageFlagBits::eTransfer);
-    info.setPWaitDstStageMask(&flags);
-    LogicalDevice::transferQueue().submit({info},
-                                          fence.get());
-
-    LogicalDevice::device().waitForFences({fence.get()},
-                                          VK_TRUE,
-                                          std::numeric_limits<uint64_t>::max());
-}
 }
\ No newline at end of file
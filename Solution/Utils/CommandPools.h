@@ -18,11 +18,11 @@ public:
     static vk::CommandPool
     transferCommandPool();
 
-    // These methods are used for transfer operations.
+    // Allocates a command buffer from commandPool
+    // and begins it for a single submission.
+    // Read TransferEngine to submit transfer operations.
     static vk::UniqueCommandBuffer
-    beginOneTimeSubmitCommandBuffer();
-    static void
-    endAndWaitOneTimeSubmitCommandBuffer(vk::CommandBuffer commandBuffer);
+    beginOneTimeSubmitCommandBuffer(const vk::CommandPool commandPool);
 
 private:
     static vk::UniqueCommandPool mGraphicsCommandPool;
@@ -0,0 +1,79 @@
+#include "FileSystem.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace vulkan {
+namespace file_system {
+bool
+readFileStatus(const std::string& filePath,
+               uint64_t& size,
+               int64_t& modificationTime) {
+    struct stat fileStatus;
+    if (stat(filePath.c_str(), &fileStatus) != 0) {
+        return false;
+    }
+
+    size = static_cast<uint64_t>(fileStatus.st_size);
+    modificationTime = static_cast<int64_t>(fileStatus.st_mtime);
+    return true;
+}
+
+std::vector<uint8_t>
+readFile(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+    if (file.is_open() == false) {
+        return {};
+    }
+
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    std::vector<uint8_t> buffer(fileSize);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+    if (file.good() == false) {
+        return {};
+    }
+
+    return buffer;
+}
+
+bool
+writeFileAtomically(const std::string& filePath,
+                    const void* data,
+                    const size_t size) {
+    const std::string temporaryFilePath = filePath + ".tmp";
+    {
+        std::ofstream file(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        if (file.is_open() == false) {
+            return false;
+        }
+
+        file.write(static_cast<const char*>(data),
+                   size);
+        if (file.good() == false) {
+            file.close();
+            std::remove(temporaryFilePath.c_str());
+            return false;
+        }
+    }
+
+    // The rename replaces the previous file in a single step.
+#ifdef _WIN32
+    return MoveFileExA(temporaryFilePath.c_str(),
+                       filePath.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+    return std::rename(temporaryFilePath.c_str(),
+                       filePath.c_str()) == 0;
+#endif
+}
+}
+}
@@ -0,0 +1,33 @@
+#ifndef UTILS_FILE_SYSTEM
+#define UTILS_FILE_SYSTEM
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan {
+namespace file_system {
+// Returns false if the file does not exist.
+//
+// * modificationTime in seconds.
+bool
+readFileStatus(const std::string& filePath,
+               uint64_t& size,
+               int64_t& modificationTime);
+
+// Returns an empty vector if the file does not exist.
+std::vector<uint8_t>
+readFile(const std::string& filePath);
+
+// The data is written to a temporary file that then replaces the previous one,
+// so a crash during the write never leaves a truncated file.
+//
+// Returns false if the file could not be written.
+bool
+writeFileAtomically(const std::string& filePath,
+                    const void* data,
+                    const size_t size);
+}
+}
+
+#endif
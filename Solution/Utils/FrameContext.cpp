@@ -0,0 +1,224 @@
+#include "FrameContext.h"
+
+#include <cassert>
+#include <limits>
+
+#include "Profiler.h"
+#include "SwapChain.h"
+#include "device/LogicalDevice.h"
+#include "device/PhysicalDevice.h"
+#include "resource/UniformRingBuffer.h"
+
+namespace vulkan {
+FrameContext::FrameContext(SwapChain& swapChain,
+                           const uint32_t frameCount,
+                           const vk::DeviceSize transientUniformBufferSize,
+                           const std::vector<vk::DescriptorPoolSize>& descriptorPoolSizes,
+                           const uint32_t maxDescriptorSetCount)
+    : mSwapChain(swapChain)
+    , mFrames(frameCount)
+    , mImageFences(swapChain.imageViewCount())
+{
+    assert(frameCount > 0);
+    assert(maxDescriptorSetCount == 0 || descriptorPoolSizes.empty() == false);
+
+    vk::Device device(LogicalDevice::device());
+
+    for (Frame& frame : mFrames) {
+        // The fence is signaled, so the first beginFrame() does not block.
+        frame.mFence = device.createFenceUnique({vk::FenceCreateFlagBits::eSignaled});
+        frame.mImageAvailableSemaphore = device.createSemaphoreUnique({});
+        frame.mRenderFinishedSemaphore = device.createSemaphoreUnique({});
+
+        // Command buffers are not reset one by one, but all together
+        // with the command pool.
+        vk::CommandPoolCreateInfo commandPoolInfo;
+        commandPoolInfo.setQueueFamilyIndex(PhysicalDevice::graphicsQueueFamilyIndex());
+        commandPoolInfo.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+        frame.mCommandPool = device.createCommandPoolUnique(commandPoolInfo);
+
+        if (maxDescriptorSetCount > 0) {
+            vk::DescriptorPoolCreateInfo descriptorPoolInfo;
+            descriptorPoolInfo.setMaxSets(maxDescriptorSetCount);
+            descriptorPoolInfo.setPoolSizeCount(static_cast<uint32_t>(descriptorPoolSizes.size()));
+            descriptorPoolInfo.setPPoolSizes(descriptorPoolSizes.data());
+            frame.mDescriptorPool = device.createDescriptorPoolUnique(descriptorPoolInfo);
+        }
+    }
+
+    if (transientUniformBufferSize > 0) {
+        mTransientUniformBuffer.reset(new UniformRingBuffer(transientUniformBufferSize,
+                                                            frameCount));
+    }
+}
+
+FrameContext::~FrameContext() {
+    // The frames in flight must be completed before
+    // their resources are destroyed.
+    std::vector<vk::Fence> fences;
+    for (const Frame& frame : mFrames) {
+        fences.push_back(frame.mFence.get());
+    }
+
+    LogicalDevice::device().waitForFences(fences,
+                                          VK_TRUE,
+                                          std::numeric_limits<uint64_t>::max());
+
+    // Command buffers are freed with their command pool.
+}
+
+uint32_t
+FrameContext::frameCount() const {
+    return static_cast<uint32_t>(mFrames.size());
+}
+
+uint32_t
+FrameContext::currentFrameIndex() const {
+    return mCurrentFrameIndex;
+}
+
+uint32_t
+FrameContext::beginFrame() {
+    assert(mIsFrameBegun == false);
+
+    vk::Device device(LogicalDevice::device());
+    Frame& frame = mFrames[mCurrentFrameIndex];
+
+    // Wait until the device finished the previous use of this frame.
+    // If the CPU waits here for a long time, then the frames are GPU bound.
+    mFrameBeginTime = Profiler::cpuTime();
+    device.waitForFences({frame.mFence.get()},
+                         VK_TRUE,
+                         std::numeric_limits<uint64_t>::max());
+    Profiler::addCpuSpan("Wait for frame",
+                         mFrameBeginTime,
+                         Profiler::cpuTime());
+
+    device.resetCommandPool(frame.mCommandPool.get(),
+                            vk::CommandPoolResetFlags());
+    frame.mUsedCommandBufferCount = 0;
+
+    if (frame.mDescriptorPool.get() != VK_NULL_HANDLE) {
+        device.resetDescriptorPool(frame.mDescriptorPool.get());
+    }
+
+    if (mTransientUniformBuffer != nullptr) {
+        mTransientUniformBuffer->beginFrame(mCurrentFrameIndex);
+    }
+
+    const uint32_t imageIndex = mSwapChain.acquireNextImage(frame.mImageAvailableSemaphore.get());
+    assert(imageIndex < mImageFences.size());
+
+    // The acquired image can still be used by another frame in flight
+    // (if there are more frames than swap chain images, or if the images
+    // are acquired out of order).
+    vk::Fence& imageFence = mImageFences[imageIndex];
+    if (imageFence != VK_NULL_HANDLE &&
+        imageFence != frame.mFence.get()) {
+        device.waitForFences({imageFence},
+                             VK_TRUE,
+                             std::numeric_limits<uint64_t>::max());
+    }
+    imageFence = frame.mFence.get();
+
+    mIsFrameBegun = true;
+
+    return imageIndex;
+}
+
+vk::CommandBuffer
+FrameContext::allocateCommandBuffer() {
+    assert(mIsFrameBegun);
+
+    Frame& frame = mFrames[mCurrentFrameIndex];
+    if (frame.mUsedCommandBufferCount == frame.mCommandBuffers.size()) {
+        vk::CommandBufferAllocateInfo info;
+        info.setCommandBufferCount(1);
+        info.setLevel(vk::CommandBufferLevel::ePrimary);
+        info.setCommandPool(frame.mCommandPool.get());
+        frame.mCommandBuffers.push_back(LogicalDevice::device().allocateCommandBuffers(info).front());
+    }
+
+    return frame.mCommandBuffers[frame.mUsedCommandBufferCount++];
+}
+
+vk::DescriptorSet
+FrameContext::allocateDescriptorSet(const vk::DescriptorSetLayout descriptorSetLayout) {
+    assert(mIsFrameBegun);
+    assert(descriptorSetLayout != VK_NULL_HANDLE);
+
+    Frame& frame = mFrames[mCurrentFrameIndex];
+    assert(frame.mDescriptorPool.get() != VK_NULL_HANDLE);
+
+    vk::DescriptorSetAllocateInfo info;
+    info.setDescriptorPool(frame.mDescriptorPool.get());
+    info.setDescriptorSetCount(1);
+    info.setPSetLayouts(&descriptorSetLayout);
+
+    return LogicalDevice::device().allocateDescriptorSets(info).front();
+}
+
+UniformRingBuffer&
+FrameContext::transientUniformBuffer() {
+    assert(mIsFrameBegun);
+    assert(mTransientUniformBuffer != nullptr);
+    return *mTransientUniformBuffer;
+}
+
+void
+FrameContext::submitAndPresent(const std::vector<vk::CommandBuffer>& commandBuffers,
+                               const std::vector<vk::Semaphore>& waitSemaphores,
+                               const std::vector<vk::PipelineStageFlags>& waitStageFlags) {
+    assert(mIsFrameBegun);
+    assert(commandBuffers.empty() == false);
+    assert(waitSemaphores.size() == waitStageFlags.size());
+
+    Frame& frame = mFrames[mCurrentFrameIndex];
+
+    if (mTransientUniformBuffer != nullptr) {
+        mTransientUniformBuffer->endFrame();
+    }
+
+    // In headless mode, the image available semaphore is not signaled
+    // and the render finished semaphore is not waited (Read SwapChain).
+    const bool isHeadless = mSwapChain.isHeadless();
+
+    std::vector<vk::Semaphore> semaphores;
+    std::vector<vk::PipelineStageFlags> stageFlags;
+    if (isHeadless == false) {
+        semaphores.push_back(frame.mImageAvailableSemaphore.get());
+        stageFlags.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    }
+    semaphores.insert(semaphores.end(),
+                      waitSemaphores.begin(),
+                      waitSemaphores.end());
+    stageFlags.insert(stageFlags.end(),
+                      waitStageFlags.begin(),
+                      waitStageFlags.end());
+
+    vk::SubmitInfo info;
+    info.setWaitSemaphoreCount(static_cast<uint32_t>(semaphores.size()));
+    info.setPWaitSemaphores(semaphores.empty() ? nullptr : semaphores.data());
+    info.setPWaitDstStageMask(stageFlags.empty() ? nullptr : stageFlags.data());
+    info.setSignalSemaphoreCount(isHeadless ? 0 : 1);
+    info.setPSignalSemaphores(&frame.mRenderFinishedSemaphore.get());
+    info.setCommandBufferCount(static_cast<uint32_t>(commandBuffers.size()));
+    info.setPCommandBuffers(commandBuffers.data());
+
+    // The fence is reset just before the submission, so it is
+    // never left unsignaled without a pending submission.
+    LogicalDevice::device().resetFences({frame.mFence.get()});
+    LogicalDevice::graphicsQueue().submit({info},
+                                          frame.mFence.get());
+
+    mSwapChain.present(frame.mRenderFinishedSemaphore.get(),
+                       mSwapChain.currentImageIndex());
+
+    Profiler::addCpuSpan("Frame",
+                         mFrameBeginTime,
+                         Profiler::cpuTime());
+
+    mIsFrameBegun = false;
+    mCurrentFrameIndex = (mCurrentFrameIndex + 1) % static_cast<uint32_t>(mFrames.size());
+}
+}
@@ -0,0 +1,145 @@
+#ifndef UTILS_FRAME_CONTEXT
+#define UTILS_FRAME_CONTEXT
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+class SwapChain;
+class UniformRingBuffer;
+
+//
+// Frames in flight.
+//
+// The CPU records (or updates) frame N while the device is still executing
+// the previous frames. The number of frames in flight is independent of the
+// number of swap chain images:
+// - 2 frames in flight have less input latency.
+// - 3 frames in flight have more CPU/GPU overlap.
+//
+// Each frame has its own synchronization objects and transient resources,
+// that are recycled once the device finished the previous use of the frame:
+// - A fence signaled when the frame submission is completed.
+// - The semaphores to acquire and to present the swap chain image.
+// - A command pool, that is reset at the beginning of the frame.
+// - A descriptor pool (optional), that is reset at the beginning of the frame.
+// - A partition of a UniformRingBuffer (optional), for uniform data that
+//   only lives during the frame.
+//
+// As the acquired swap chain image does not need to follow the frame order,
+// we also track which frame fence guards each swap chain image
+// (images in flight), and we wait for it before the image is reused.
+// That makes safe to use resources indexed by swap chain image
+// (like pre-recorded command buffers).
+//
+// The CPU time of each frame, and the time it waits for the device,
+// are added to the Profiler.
+//
+// Usage (each frame):
+// - beginFrame() returns the acquired swap chain image index.
+// - Record or update the commands of the frame.
+// - submitAndPresent()
+//
+// Preconditions:
+// - The global logical device must be initialized first.
+// - The swap chain must outlive the FrameContext.
+//
+class FrameContext {
+public:
+    // * frameCount is the number of frames in flight.
+    //
+    // * transientUniformBufferSize in bytes that can be pushed
+    //   to the transient UniformRingBuffer in each frame.
+    //   If it is 0, then there is no transient UniformRingBuffer.
+    //
+    // * descriptorPoolSizes and maxDescriptorSetCount of the descriptor pool
+    //   of each frame. If maxDescriptorSetCount is 0, then there are no
+    //   descriptor pools.
+    FrameContext(SwapChain& swapChain,
+                 const uint32_t frameCount = 2,
+                 const vk::DeviceSize transientUniformBufferSize = 0,
+                 const std::vector<vk::DescriptorPoolSize>& descriptorPoolSizes = {},
+                 const uint32_t maxDescriptorSetCount = 0);
+    ~FrameContext();
+    FrameContext(const FrameContext&) = delete;
+    const FrameContext& operator=(const FrameContext&) = delete;
+
+    uint32_t
+    frameCount() const;
+
+    // Index of the current frame, in [0, frameCount())
+    uint32_t
+    currentFrameIndex() const;
+
+    // Waits until the device finished the previous use of the current frame,
+    // resets its resources and acquires the next swap chain image.
+    // If the acquired image is still being used by another frame, then
+    // it also waits for that frame.
+    //
+    // Returns the swap chain image index.
+    uint32_t
+    beginFrame();
+
+    // Returns a primary command buffer of the current frame.
+    // It is valid until the frame is recycled, so it must be recorded
+    // every time it is used.
+    vk::CommandBuffer
+    allocateCommandBuffer();
+
+    // Returns a descriptor set of the current frame descriptor pool.
+    // It is valid until the frame is recycled.
+    vk::DescriptorSet
+    allocateDescriptorSet(const vk::DescriptorSetLayout descriptorSetLayout);
+
+    // Transient UniformRingBuffer, whose current frame is the current frame
+    // of this FrameContext. submitAndPresent() ends its frame.
+    UniformRingBuffer&
+    transientUniformBuffer();
+
+    // Submits the command buffers to the graphics queue and presents
+    // the acquired swap chain image. Then, it moves to the next frame.
+    //
+    // The submission always waits on the image available semaphore
+    // (at the color attachment output stage), except in headless mode.
+    //
+    // * waitSemaphores and waitStageFlags are additional semaphores to
+    //   wait on (for example, the ones of TransferEngine::takeSemaphore()).
+    void
+    submitAndPresent(const std::vector<vk::CommandBuffer>& commandBuffers,
+                     const std::vector<vk::Semaphore>& waitSemaphores = {},
+                     const std::vector<vk::PipelineStageFlags>& waitStageFlags = {});
+
+private:
+    struct Frame {
+        vk::UniqueFence mFence;
+        vk::UniqueSemaphore mImageAvailableSemaphore;
+        vk::UniqueSemaphore mRenderFinishedSemaphore;
+
+        vk::UniqueCommandPool mCommandPool;
+
+        // Command buffers allocated from mCommandPool. They are reused
+        // after the command pool is reset.
+        std::vector<vk::CommandBuffer> mCommandBuffers;
+        uint32_t mUsedCommandBufferCount = 0;
+
+        vk::UniqueDescriptorPool mDescriptorPool;
+    };
+
+    SwapChain& mSwapChain;
+
+    std::vector<Frame> mFrames;
+    uint32_t mCurrentFrameIndex = 0;
+    bool mIsFrameBegun = false;
+    uint64_t mFrameBeginTime = 0;
+
+    // Fence of the last frame that used each swap chain image.
+    // It is null if the image was not used yet.
+    std::vector<vk::Fence> mImageFences;
+
+    std::unique_ptr<UniformRingBuffer> mTransientUniformBuffer;
+};
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "Instance.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "DebugMessenger.h"
 
@@ -8,6 +9,12 @@ namespace vulkan {
 vk::Instance 
 Instance::mInstance;
 
+uint32_t
+Instance::mApiVersion = VK_API_VERSION_1_0;
+
+std::vector<std::string>
+Instance::mEnabledExtensionNames = {};
+
 #ifdef _DEBUG
 DebugMessenger* 
 Instance::mMessenger = nullptr;
@@ -23,13 +30,36 @@ Instance::initialize(const std::vector<const char*>& instanceExtensionNames,
 
     assert(areInstanceLayersSupported(instanceLayerNames));
 
+    // Vulkan 1.1 is needed to query the features of extensions
+    // (vkGetPhysicalDeviceFeatures2) without VK_KHR_get_physical_device_properties2.
+    // A Vulkan 1.0 implementation can refuse an instance of another version,
+    // so 1.1 is only requested if the loader supports it.
+    // vkEnumerateInstanceVersion does not exist in Vulkan 1.0 loaders.
+    mApiVersion = VK_API_VERSION_1_0;
+    const PFN_vkEnumerateInstanceVersion enumerateInstanceVersion =
+        reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(VK_NULL_HANDLE,
+                                                                               "vkEnumerateInstanceVersion"));
+    uint32_t loaderApiVersion = VK_API_VERSION_1_0;
+    if (enumerateInstanceVersion != nullptr &&
+        enumerateInstanceVersion(&loaderApiVersion) == VK_SUCCESS &&
+        loaderApiVersion >= VK_API_VERSION_1_1) {
+        mApiVersion = VK_API_VERSION_1_1;
+    }
+
+    vk::ApplicationInfo applicationInfo;
+    applicationInfo.setApiVersion(mApiVersion);
+
     vk::InstanceCreateInfo info;
+    info.setPApplicationInfo(&applicationInfo);
     info.setEnabledExtensionCount(static_cast<uint32_t>(instanceExtensionNames.size()));
     info.setPpEnabledExtensionNames(instanceExtensionNames.empty() ? nullptr : instanceExtensionNames.data());
     info.setEnabledLayerCount(static_cast<uint32_t>(instanceLayerNames.size()));
     info.setPpEnabledLayerNames(instanceLayerNames.empty() ? nullptr : instanceLayerNames.data());
     mInstance = vk::createInstance(info);
 
+    mEnabledExtensionNames.assign(instanceExtensionNames.begin(),
+                                  instanceExtensionNames.end());
+
 #ifdef _DEBUG
     mMessenger = new DebugMessenger();
 #endif
@@ -42,6 +72,8 @@ Instance::finalize() {
 #endif
 
     mInstance.destroy();
+    mEnabledExtensionNames.clear();
+    mApiVersion = VK_API_VERSION_1_0;
 }
 
 const vk::Instance& 
@@ -50,6 +82,40 @@ Instance::instance() {
     return mInstance;
 }
 
+uint32_t
+Instance::apiVersion() {
+    assert(mInstance != VK_NULL_HANDLE);
+    return mApiVersion;
+}
+
+bool
+Instance::isExtensionSupported(const char* extensionName) {
+    assert(extensionName != nullptr);
+
+    for (const vk::ExtensionProperties& property :
+         vk::enumerateInstanceExtensionProperties()) {
+        if (std::strcmp(property.extensionName, extensionName) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+Instance::isExtensionEnabled(const char* extensionName) {
+    assert(mInstance != VK_NULL_HANDLE);
+    assert(extensionName != nullptr);
+
+    for (const std::string& enabledExtensionName : mEnabledExtensionNames) {
+        if (enabledExtensionName == extensionName) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 std::vector<PhysicalDeviceData>
 Instance::getSupportedPhysicalDevices(const std::vector<const char*>& deviceExtensionNames) {
     assert(mInstance != VK_NULL_HANDLE);
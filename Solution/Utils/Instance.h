@@ -1,6 +1,7 @@
 #ifndef UTILS_INSTANCE
 #define UTILS_INSTANCE
 
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
@@ -48,6 +49,19 @@ public:
     static const vk::Instance&
     instance();
 
+    // VK_API_VERSION_1_1 if the loader supports it, VK_API_VERSION_1_0 otherwise.
+    // Physical devices can support a lower version.
+    static uint32_t
+    apiVersion();
+
+    // Used to check optional instance extensions before
+    // the instance is created.
+    static bool
+    isExtensionSupported(const char* extensionName);
+
+    static bool
+    isExtensionEnabled(const char* extensionName);
+
     // Return a list of candidate physical devices
     // based on window's surface support and device extension support.
     static std::vector<PhysicalDeviceData>
@@ -65,6 +79,8 @@ private:
     areInstanceLayersSupported(const std::vector<const char*>& instanceLayers);
     
     static vk::Instance mInstance;
+    static uint32_t mApiVersion;
+    static std::vector<std::string> mEnabledExtensionNames;
 
 #ifdef _DEBUG
     static DebugMessenger* mMessenger;
@@ -0,0 +1,115 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vulkan {
+MappedFile::MappedFile(const std::string& filePath) {
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(filePath.c_str(),
+                                    GENERIC_READ,
+                                    FILE_SHARE_READ,
+                                    nullptr,
+                                    OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    const HANDLE mapping = CreateFileMappingA(file,
+                                              nullptr,
+                                              PAGE_READONLY,
+                                              0,
+                                              0,
+                                              nullptr);
+    // The view keeps the mapping and the file alive.
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return;
+    }
+
+    const void* data = MapViewOfFile(mapping,
+                                     FILE_MAP_READ,
+                                     0,
+                                     0,
+                                     0);
+    CloseHandle(mapping);
+    if (data == nullptr) {
+        return;
+    }
+
+    mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int file = open(filePath.c_str(),
+                          O_RDONLY);
+    if (file == -1) {
+        return;
+    }
+
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        close(file);
+        return;
+    }
+
+    const void* data = mmap(nullptr,
+                            static_cast<size_t>(fileStatus.st_size),
+                            PROT_READ,
+                            MAP_PRIVATE,
+                            file,
+                            0);
+    // The mapping keeps the file alive.
+    close(file);
+    if (data == MAP_FAILED) {
+        return;
+    }
+
+    mSize = static_cast<size_t>(fileStatus.st_size);
+#endif
+
+    mData = static_cast<const uint8_t*>(data);
+}
+
+MappedFile::~MappedFile() {
+    if (mData == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+#else
+    munmap(const_cast<uint8_t*>(mData),
+           mSize);
+#endif
+}
+
+bool
+MappedFile::isMapped() const {
+    return mData != nullptr;
+}
+
+const uint8_t*
+MappedFile::data() const {
+    return mData;
+}
+
+size_t
+MappedFile::size() const {
+    return mSize;
+}
+}
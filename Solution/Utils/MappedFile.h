@@ -0,0 +1,41 @@
+#ifndef UTILS_MAPPED_FILE
+#define UTILS_MAPPED_FILE
+
+#include <cstdint>
+#include <string>
+
+namespace vulkan {
+//
+// Read only memory mapping of a whole file.
+//
+// The file is not read nor copied: its pages are loaded by the operating system
+// when they are accessed, and they can be shared with other processes.
+// The mapping is page aligned.
+//
+class MappedFile {
+public:
+    // If the file does not exist or it is empty, then
+    // it is not mapped (Read isMapped()).
+    explicit MappedFile(const std::string& filePath);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    const MappedFile& operator=(const MappedFile&) = delete;
+
+    bool
+    isMapped() const;
+
+    // nullptr if the file is not mapped.
+    const uint8_t*
+    data() const;
+
+    // In bytes
+    size_t
+    size() const;
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+};
+}
+
+#endif
@@ -0,0 +1,619 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "CommandPools.h"
+#include "Instance.h"
+#include "device/LogicalDevice.h"
+#include "device/PhysicalDevice.h"
+
+namespace {
+// Counters of the pipeline statistics queries, in the order
+// they are written by vkGetQueryPoolResults.
+const vk::QueryPipelineStatisticFlags sPipelineStatisticFlags =
+    vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+    vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+    vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+    vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+const std::array<const char*, 5> sPipelineStatisticNames {
+    "inputAssemblyVertices",
+    "inputAssemblyPrimitives",
+    "vertexShaderInvocations",
+    "clippingPrimitives",
+    "fragmentShaderInvocations"
+};
+
+// With calibrated timestamps, the clocks are calibrated again
+// after this time (in nanoseconds).
+const uint64_t sRecalibrationPeriod = 1000000000;
+
+// The thread can be preempted while the timestamps are sampled,
+// so the calibration with the lowest deviation of these attempts is used.
+const uint32_t sCalibrationAttemptCount = 3;
+
+// Time domain of std::chrono::steady_clock.
+#ifdef _WIN32
+const VkTimeDomainEXT sHostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+const VkTimeDomainEXT sHostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+// Converts a timestamp of sHostTimeDomain to nanoseconds, the same way
+// std::chrono::steady_clock does (Read Profiler::cpuTime()).
+uint64_t
+hostTimestampToCpuTime(const uint64_t hostTimestamp) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    const uint64_t ticksPerSecond = static_cast<uint64_t>(frequency.QuadPart);
+    return hostTimestamp / ticksPerSecond * 1000000000 +
+           hostTimestamp % ticksPerSecond * 1000000000 / ticksPerSecond;
+#else
+    return hostTimestamp;
+#endif
+}
+
+std::string
+escapeJsonString(const std::string& string) {
+    std::string escapedString;
+    for (const char character : string) {
+        if (character == '"' || character == '\\') {
+            escapedString.push_back('\\');
+        }
+        escapedString.push_back(character);
+    }
+
+    return escapedString;
+}
+}
+
+namespace vulkan {
+vk::UniqueQueryPool
+Profiler::mTimestampQueryPool = vk::UniqueQueryPool();
+
+vk::UniqueQueryPool
+Profiler::mPipelineStatisticsQueryPool = vk::UniqueQueryPool();
+
+std::vector<uint32_t>
+Profiler::mFreeQueryBlocks = {};
+
+float
+Profiler::mTimestampPeriod = 1.0f;
+
+uint64_t
+Profiler::mCalibrationCpuTime = 0;
+
+uint64_t
+Profiler::mCalibrationGpuTimestamp = 0;
+
+uint64_t
+Profiler::mCalibrationTimestampMask = 0;
+
+uint64_t
+Profiler::mCalibrationError = 0;
+
+PFN_vkGetCalibratedTimestampsEXT
+Profiler::mGetCalibratedTimestamps = nullptr;
+
+bool
+Profiler::mIsHostTimeDomainSupported = false;
+
+std::deque<Profiler::Span>
+Profiler::mSpans = {};
+
+size_t
+Profiler::mMaxSpanCount = 0;
+
+void
+Profiler::initialize(const uint32_t maxGpuScopesCount,
+                     const size_t maxSpanCount) {
+    assert(mTimestampQueryPool.get() == VK_NULL_HANDLE);
+    assert(maxGpuScopesCount > 0);
+    assert(maxSpanCount > 0);
+
+    mMaxSpanCount = maxSpanCount;
+    mTimestampPeriod = PhysicalDevice::device().getProperties().limits.timestampPeriod;
+
+    vk::QueryPoolCreateInfo info;
+    info.setQueryType(vk::QueryType::eTimestamp);
+    info.setQueryCount(maxGpuScopesCount * GpuScopes::sMaxScopeCount * 2);
+    mTimestampQueryPool = LogicalDevice::device().createQueryPoolUnique(info);
+
+    if (LogicalDevice::enabledFeatures().pipelineStatisticsQuery) {
+        info.setQueryType(vk::QueryType::ePipelineStatistics);
+        info.setQueryCount(maxGpuScopesCount * GpuScopes::sMaxScopeCount);
+        info.setPipelineStatistics(sPipelineStatisticFlags);
+        mPipelineStatisticsQueryPool = LogicalDevice::device().createQueryPoolUnique(info);
+    }
+
+    // Blocks are allocated from the back.
+    mFreeQueryBlocks.clear();
+    for (uint32_t i = maxGpuScopesCount; i > 0; --i) {
+        mFreeQueryBlocks.push_back(i - 1);
+    }
+
+    if (LogicalDevice::isExtensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+        initializeCalibratedTimestamps();
+    }
+
+    if (isTimestampSupported(PhysicalDevice::graphicsQueueFamilyIndex())) {
+        mCalibrationTimestampMask = timestampMask(PhysicalDevice::graphicsQueueFamilyIndex());
+        calibrate();
+    }
+}
+
+void
+Profiler::finalize() {
+    mTimestampQueryPool.reset();
+    mPipelineStatisticsQueryPool.reset();
+    mFreeQueryBlocks.clear();
+    mGetCalibratedTimestamps = nullptr;
+    mIsHostTimeDomainSupported = false;
+    mSpans.clear();
+}
+
+uint64_t
+Profiler::cpuTime() {
+    const std::chrono::steady_clock::duration time = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+void
+Profiler::addCpuSpan(const std::string& name,
+                     const uint64_t beginTime,
+                     const uint64_t endTime) {
+    assert(beginTime <= endTime);
+
+    Span span;
+    span.mName = name;
+    span.mBeginTime = beginTime;
+    span.mEndTime = endTime;
+    addSpan(std::move(span));
+}
+
+void
+Profiler::exportChromeTrace(const std::string& filePath) {
+    std::ofstream file(filePath);
+    assert(file.is_open());
+
+    // Times are in microseconds, relative to the first span.
+    uint64_t firstTime = std::numeric_limits<uint64_t>::max();
+    for (const Span& span : mSpans) {
+        firstTime = std::min(firstTime, span.mBeginTime);
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\","
+         << "\"otherData\":{\"gpuCalibrationErrorNs\":\"" << mCalibrationError << "\"},"
+         << "\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+    for (const Span& span : mSpans) {
+        file << ",\n{\"name\":\"" << escapeJsonString(span.mName) << "\""
+             << ",\"ph\":\"X\",\"pid\":0"
+             << ",\"tid\":" << (span.mIsGpuSpan ? 1 : 0)
+             << ",\"ts\":" << static_cast<double>(span.mBeginTime - firstTime) / 1000.0
+             << ",\"dur\":" << static_cast<double>(span.mEndTime - span.mBeginTime) / 1000.0;
+
+        if (span.mPipelineStatistics.empty() == false) {
+            assert(span.mPipelineStatistics.size() == sPipelineStatisticNames.size());
+            file << ",\"args\":{";
+            for (size_t i = 0; i < span.mPipelineStatistics.size(); ++i) {
+                file << (i == 0 ? "" : ",")
+                     << "\"" << sPipelineStatisticNames[i] << "\":" << span.mPipelineStatistics[i];
+            }
+            file << "}";
+        }
+
+        file << "}";
+    }
+
+    file << "\n]}\n";
+}
+
+void
+Profiler::clear() {
+    mSpans.clear();
+}
+
+uint32_t
+Profiler::allocateQueryBlock() {
+    if (mFreeQueryBlocks.empty()) {
+        return std::numeric_limits<uint32_t>::max();
+    }
+
+    const uint32_t blockIndex = mFreeQueryBlocks.back();
+    mFreeQueryBlocks.pop_back();
+
+    return blockIndex;
+}
+
+void
+Profiler::freeQueryBlock(const uint32_t blockIndex) {
+    mFreeQueryBlocks.push_back(blockIndex);
+}
+
+void
+Profiler::addSpan(Span&& span) {
+    assert(mMaxSpanCount > 0);
+
+    if (mSpans.size() == mMaxSpanCount) {
+        mSpans.pop_front();
+    }
+    mSpans.emplace_back(std::move(span));
+}
+
+uint64_t
+Profiler::gpuToCpuTime(const uint64_t gpuTimestamp,
+                       const uint64_t timestampMask) {
+    if (mGetCalibratedTimestamps != nullptr &&
+        cpuTime() - mCalibrationCpuTime > sRecalibrationPeriod) {
+        calibrate();
+    }
+
+    // Ticks since the calibration. The timestamps before it
+    // (or half of the timestamp range after it) are negative.
+    const uint64_t mask = timestampMask & mCalibrationTimestampMask;
+    const uint64_t ticks = (gpuTimestamp - mCalibrationGpuTimestamp) & mask;
+    const double signedTicks = ticks > mask / 2 ?
+        -static_cast<double>(mask - ticks + 1) :
+        static_cast<double>(ticks);
+
+    return static_cast<uint64_t>(static_cast<double>(mCalibrationCpuTime) + signedTicks * mTimestampPeriod);
+}
+
+bool
+Profiler::isTimestampSupported(const uint32_t queueFamilyIndex) {
+    const std::vector<vk::QueueFamilyProperties> properties =
+        PhysicalDevice::device().getQueueFamilyProperties();
+    assert(queueFamilyIndex < properties.size());
+
+    return properties[queueFamilyIndex].timestampValidBits > 0;
+}
+
+uint64_t
+Profiler::timestampMask(const uint32_t queueFamilyIndex) {
+    const std::vector<vk::QueueFamilyProperties> properties =
+        PhysicalDevice::device().getQueueFamilyProperties();
+    assert(queueFamilyIndex < properties.size());
+
+    const uint32_t validBits = properties[queueFamilyIndex].timestampValidBits;
+    assert(validBits > 0);
+    return validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << validBits) - 1;
+}
+
+void
+Profiler::initializeCalibratedTimestamps() {
+    // They are extension functions, so they are not automatically loaded.
+    PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT getCalibrateableTimeDomains =
+        reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+            vkGetInstanceProcAddr(static_cast<VkInstance>(Instance::instance()),
+                                  "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    if (getCalibrateableTimeDomains == nullptr) {
+        return;
+    }
+
+    const VkPhysicalDevice physicalDevice = static_cast<VkPhysicalDevice>(PhysicalDevice::device());
+    uint32_t timeDomainCount = 0;
+    getCalibrateableTimeDomains(physicalDevice,
+                                &timeDomainCount,
+                                nullptr);
+    std::vector<VkTimeDomainEXT> timeDomains(timeDomainCount);
+    getCalibrateableTimeDomains(physicalDevice,
+                                &timeDomainCount,
+                                timeDomains.data());
+
+    if (std::find(timeDomains.begin(),
+                  timeDomains.end(),
+                  VK_TIME_DOMAIN_DEVICE_EXT) == timeDomains.end()) {
+        return;
+    }
+
+    mIsHostTimeDomainSupported = std::find(timeDomains.begin(),
+                                           timeDomains.end(),
+                                           sHostTimeDomain) != timeDomains.end();
+    mGetCalibratedTimestamps =
+        reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+            vkGetDeviceProcAddr(LogicalDevice::device(),
+                                "vkGetCalibratedTimestampsEXT"));
+}
+
+void
+Profiler::calibrate() {
+    if (mGetCalibratedTimestamps == nullptr) {
+        calibrateWithSubmission();
+        return;
+    }
+
+    std::array<VkCalibratedTimestampInfoEXT, 2> infos = {};
+    infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[1].timeDomain = sHostTimeDomain;
+    const uint32_t infoCount = mIsHostTimeDomainSupported ? 2 : 1;
+
+    // If no attempt succeeds, then the previous calibration is kept.
+    uint64_t bestError = std::numeric_limits<uint64_t>::max();
+    for (uint32_t i = 0; i < sCalibrationAttemptCount; ++i) {
+        std::array<uint64_t, 2> timestamps = {};
+        uint64_t maxDeviation = 0;
+
+        const uint64_t cpuBeginTime = cpuTime();
+        const VkResult result = mGetCalibratedTimestamps(LogicalDevice::device(),
+                                                         infoCount,
+                                                         infos.data(),
+                                                         timestamps.data(),
+                                                         &maxDeviation);
+        const uint64_t cpuEndTime = cpuTime();
+        if (result != VK_SUCCESS) {
+            continue;
+        }
+
+        // Both timestamps are sampled at the same moment, with an error of maxDeviation.
+        // Without the host time domain, the device time domain is read by the host,
+        // so the error also includes half the time between both CPU reads.
+        uint64_t calibrationCpuTime = 0;
+        uint64_t error = maxDeviation;
+        if (mIsHostTimeDomainSupported) {
+            calibrationCpuTime = hostTimestampToCpuTime(timestamps[1]);
+        } else {
+            calibrationCpuTime = cpuBeginTime + (cpuEndTime - cpuBeginTime) / 2;
+            error += (cpuEndTime - cpuBeginTime) / 2;
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            mCalibrationCpuTime = calibrationCpuTime;
+            mCalibrationGpuTimestamp = timestamps[0] & mCalibrationTimestampMask;
+            mCalibrationError = error;
+        }
+    }
+}
+
+void
+Profiler::calibrateWithSubmission() {
+    vk::Device device(LogicalDevice::device());
+
+    vk::QueryPoolCreateInfo queryPoolInfo;
+    queryPoolInfo.setQueryType(vk::QueryType::eTimestamp);
+    queryPoolInfo.setQueryCount(1);
+    vk::UniqueQueryPool queryPool = device.createQueryPoolUnique(queryPoolInfo);
+
+    vk::UniqueCommandBuffer commandBuffer =
+        CommandPools::beginOneTimeSubmitCommandBuffer(CommandPools::graphicsCommandPool());
+    commandBuffer->resetQueryPool(queryPool.get(),
+                                  0,
+                                  1);
+    commandBuffer->writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe,
+                                  queryPool.get(),
+                                  0);
+    commandBuffer->end();
+
+    vk::UniqueFence fence = device.createFenceUnique({});
+
+    vk::SubmitInfo info;
+    info.setCommandBufferCount(1);
+    info.setPCommandBuffers(&commandBuffer.get());
+
+    // The timestamp is written between the submission and the fence signal,
+    // so the calibration error is, at most, half of that time.
+    const uint64_t cpuBeginTime = cpuTime();
+    LogicalDevice::graphicsQueue().submit({info},
+                                          fence.get());
+    device.waitForFences({fence.get()},
+                         VK_TRUE,
+                         std::numeric_limits<uint64_t>::max());
+    const uint64_t cpuEndTime = cpuTime();
+
+    uint64_t gpuTimestamp = 0;
+    const vk::Result result = device.getQueryPoolResults(queryPool.get(),
+                                                         0,
+                                                         1,
+                                                         sizeof(gpuTimestamp),
+                                                         &gpuTimestamp,
+                                                         sizeof(gpuTimestamp),
+                                                         vk::QueryResultFlagBits::e64 |
+                                                         vk::QueryResultFlagBits::eWait);
+    assert(result == vk::Result::eSuccess);
+
+    mCalibrationCpuTime = cpuBeginTime + (cpuEndTime - cpuBeginTime) / 2;
+    mCalibrationGpuTimestamp = gpuTimestamp & mCalibrationTimestampMask;
+    mCalibrationError = (cpuEndTime - cpuBeginTime) / 2;
+}
+
+CpuScope::CpuScope(const std::string& name)
+    : mName(name)
+    , mBeginTime(Profiler::cpuTime())
+{
+
+}
+
+CpuScope::~CpuScope() {
+    Profiler::addCpuSpan(mName,
+                         mBeginTime,
+                         Profiler::cpuTime());
+}
+
+GpuScopes::GpuScopes(const uint32_t queueFamilyIndex) {
+    assert(Profiler::mTimestampQueryPool.get() != VK_NULL_HANDLE);
+
+    if (Profiler::isTimestampSupported(queueFamilyIndex) == false) {
+        return;
+    }
+
+    mQueryBlockIndex = Profiler::allocateQueryBlock();
+    if (mQueryBlockIndex == std::numeric_limits<uint32_t>::max()) {
+        return;
+    }
+
+    mIsTimestampSupported = true;
+    mTimestampMask = Profiler::timestampMask(queueFamilyIndex);
+
+    // Pipeline statistics need a graphics queue.
+    const vk::QueueFamilyProperties properties =
+        PhysicalDevice::device().getQueueFamilyProperties()[queueFamilyIndex];
+    mIsPipelineStatisticsSupported =
+        Profiler::mPipelineStatisticsQueryPool.get() != VK_NULL_HANDLE &&
+        (properties.queueFlags & vk::QueueFlagBits::eGraphics) == vk::QueueFlagBits::eGraphics;
+}
+
+GpuScopes::~GpuScopes() {
+    if (isEnabled()) {
+        Profiler::freeQueryBlock(mQueryBlockIndex);
+    }
+}
+
+void
+GpuScopes::reset(const vk::CommandBuffer commandBuffer) {
+    assert(commandBuffer != VK_NULL_HANDLE);
+    assert(mIsPipelineStatisticsScopeActive == false);
+
+    mScopes.clear();
+
+    if (isEnabled() == false) {
+        return;
+    }
+
+    commandBuffer.resetQueryPool(Profiler::mTimestampQueryPool.get(),
+                                 mQueryBlockIndex * sMaxScopeCount * 2,
+                                 sMaxScopeCount * 2);
+
+    if (mIsPipelineStatisticsSupported) {
+        commandBuffer.resetQueryPool(Profiler::mPipelineStatisticsQueryPool.get(),
+                                     mQueryBlockIndex * sMaxScopeCount,
+                                     sMaxScopeCount);
+    }
+}
+
+uint32_t
+GpuScopes::beginScope(const vk::CommandBuffer commandBuffer,
+                      const std::string& name,
+                      const bool withPipelineStatistics) {
+    assert(commandBuffer != VK_NULL_HANDLE);
+    assert(mScopes.size() < sMaxScopeCount);
+
+    const uint32_t scopeIndex = static_cast<uint32_t>(mScopes.size());
+
+    Scope scope;
+    scope.mName = name;
+    scope.mHasPipelineStatistics = withPipelineStatistics && mIsPipelineStatisticsSupported;
+    mScopes.emplace_back(scope);
+
+    if (isEnabled() == false) {
+        return scopeIndex;
+    }
+
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe,
+                                 Profiler::mTimestampQueryPool.get(),
+                                 (mQueryBlockIndex * sMaxScopeCount + scopeIndex) * 2);
+
+    if (scope.mHasPipelineStatistics) {
+        assert(mIsPipelineStatisticsScopeActive == false);
+        mIsPipelineStatisticsScopeActive = true;
+        commandBuffer.beginQuery(Profiler::mPipelineStatisticsQueryPool.get(),
+                                 mQueryBlockIndex * sMaxScopeCount + scopeIndex,
+                                 vk::QueryControlFlags());
+    }
+
+    return scopeIndex;
+}
+
+void
+GpuScopes::endScope(const vk::CommandBuffer commandBuffer,
+                    const uint32_t scopeIndex) {
+    assert(commandBuffer != VK_NULL_HANDLE);
+    assert(scopeIndex < mScopes.size());
+
+    Scope& scope = mScopes[scopeIndex];
+    assert(scope.mIsEnded == false);
+    scope.mIsEnded = true;
+
+    if (isEnabled() == false) {
+        return;
+    }
+
+    if (scope.mHasPipelineStatistics) {
+        commandBuffer.endQuery(Profiler::mPipelineStatisticsQueryPool.get(),
+                               mQueryBlockIndex * sMaxScopeCount + scopeIndex);
+        mIsPipelineStatisticsScopeActive = false;
+    }
+
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                 Profiler::mTimestampQueryPool.get(),
+                                 (mQueryBlockIndex * sMaxScopeCount + scopeIndex) * 2 + 1);
+}
+
+bool
+GpuScopes::collect() {
+    if (isEnabled() == false || mScopes.empty()) {
+        return true;
+    }
+
+    vk::Device device(LogicalDevice::device());
+
+    // vkGetQueryPoolResults returns VK_NOT_READY, instead of blocking,
+    // if any of the queries is not available yet.
+    std::array<uint64_t, sMaxScopeCount * 2> timestamps;
+    const uint32_t timestampCount = static_cast<uint32_t>(mScopes.size()) * 2;
+    vk::Result result = device.getQueryPoolResults(Profiler::mTimestampQueryPool.get(),
+                                                   mQueryBlockIndex * sMaxScopeCount * 2,
+                                                   timestampCount,
+                                                   timestampCount * sizeof(uint64_t),
+                                                   timestamps.data(),
+                                                   sizeof(uint64_t),
+                                                   vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < mScopes.size(); ++i) {
+        const Scope& scope = mScopes[i];
+        assert(scope.mIsEnded);
+
+        Profiler::Span span;
+        span.mName = scope.mName;
+        span.mIsGpuSpan = true;
+        span.mBeginTime = Profiler::gpuToCpuTime(timestamps[i * 2],
+                                                 mTimestampMask);
+        span.mEndTime = std::max(span.mBeginTime,
+                                 Profiler::gpuToCpuTime(timestamps[i * 2 + 1],
+                                                        mTimestampMask));
+
+        if (scope.mHasPipelineStatistics) {
+            span.mPipelineStatistics.resize(sPipelineStatisticNames.size());
+            result = device.getQueryPoolResults(Profiler::mPipelineStatisticsQueryPool.get(),
+                                                mQueryBlockIndex * sMaxScopeCount + i,
+                                                1,
+                                                span.mPipelineStatistics.size() * sizeof(uint64_t),
+                                                span.mPipelineStatistics.data(),
+                                                span.mPipelineStatistics.size() * sizeof(uint64_t),
+                                                vk::QueryResultFlagBits::e64);
+            if (result != vk::Result::eSuccess) {
+                span.mPipelineStatistics.clear();
+            }
+        }
+
+        Profiler::addSpan(std::move(span));
+    }
+
+    return true;
+}
+
+bool
+GpuScopes::isEnabled() const {
+    return mIsTimestampSupported;
+}
+}
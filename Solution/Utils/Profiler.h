@@ -0,0 +1,242 @@
+#ifndef UTILS_PROFILER
+#define UTILS_PROFILER
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+//
+// Global CPU and GPU profiler.
+//
+// CPU spans are measured with std::chrono::steady_clock (Read CpuScope).
+//
+// GPU scopes are measured with timestamp queries (and optionally pipeline
+// statistics queries) written inside the command buffers (Read GpuScopes).
+// Their results are read back once the command buffer is completed,
+// without waiting, so the profiler never stalls the CPU.
+//
+// GPU timestamps are converted to the CPU timeline with a calibration
+// (a pair of CPU and GPU times taken at the same moment):
+// - With VK_EXT_calibrated_timestamps, the GPU time and the host time
+//   (CLOCK_MONOTONIC or QueryPerformanceCounter, the clock of std::chrono::steady_clock)
+//   are sampled together by vkGetCalibratedTimestampsEXT, and they are
+//   recalibrated periodically to compensate the drift between both clocks.
+//   The sample with the lowest maxDeviation of a few attempts is used.
+// - Without it, a timestamp is written by a small submission, so the
+//   calibration is done only once, in initialize().
+// The calibration error is reported in the exported trace.
+//
+// Timestamps only have timestampValidBits bits (Read VkQueueFamilyProperties),
+// so they are masked, and the ones that wrapped around since the
+// calibration are still converted.
+//
+// Only the last maxSpanCount spans are kept (the oldest ones are dropped), so
+// the memory does not grow if the spans are never cleared.
+//
+// All the spans can be exported in Chrome trace event format, that
+// can be opened with chrome://tracing or https://ui.perfetto.dev.
+// CPU spans and GPU scopes are shown in different rows, so a frame whose
+// CPU spans are longer than its GPU scopes is CPU bound, and a frame where
+// the CPU waits for the frame fence (FrameContext) is GPU bound.
+//
+// It is not thread safe.
+//
+// Preconditions:
+// - The global logical device and CommandPools must be initialized first.
+//
+class Profiler {
+public:
+    // * maxGpuScopesCount is the number of GpuScopes objects that can exist
+    //   at the same time. If there are more, the extra ones do not measure anything.
+    //
+    // * maxSpanCount is the number of CPU and GPU spans that are kept.
+    static void
+    initialize(const uint32_t maxGpuScopesCount = 64,
+               const size_t maxSpanCount = 65536);
+
+    static void
+    finalize();
+
+    // Nanoseconds in the CPU timeline.
+    static uint64_t
+    cpuTime();
+
+    static void
+    addCpuSpan(const std::string& name,
+               const uint64_t beginTime,
+               const uint64_t endTime);
+
+    // Writes all the spans collected since the last clear().
+    static void
+    exportChromeTrace(const std::string& filePath);
+
+    static void
+    clear();
+
+private:
+    friend class GpuScopes;
+
+    Profiler() = delete;
+    ~Profiler() = delete;
+    Profiler(Profiler&&) noexcept = delete;
+    Profiler(const Profiler&) = delete;
+    const Profiler& operator=(const Profiler&) = delete;
+
+    struct Span {
+        std::string mName;
+        uint64_t mBeginTime = 0;
+        uint64_t mEndTime = 0;
+        bool mIsGpuSpan = false;
+
+        // Only for GPU scopes with pipeline statistics.
+        std::vector<uint64_t> mPipelineStatistics;
+    };
+
+    // Returns the index of a free block of queries, or
+    // std::numeric_limits<uint32_t>::max() if there is none.
+    static uint32_t
+    allocateQueryBlock();
+
+    static void
+    freeQueryBlock(const uint32_t blockIndex);
+
+    // Drops the oldest span if there are maxSpanCount spans.
+    static void
+    addSpan(Span&& span);
+
+    // Converts a GPU timestamp (in ticks) to the CPU timeline.
+    //
+    // * timestampMask of the queue family where the timestamp was written.
+    static uint64_t
+    gpuToCpuTime(const uint64_t gpuTimestamp,
+                 const uint64_t timestampMask);
+
+    static bool
+    isTimestampSupported(const uint32_t queueFamilyIndex);
+
+    // Mask of the valid bits of the timestamps of the queue family.
+    static uint64_t
+    timestampMask(const uint32_t queueFamilyIndex);
+
+    // Checks the time domains that vkGetCalibratedTimestampsEXT supports.
+    static void
+    initializeCalibratedTimestamps();
+
+    static void
+    calibrate();
+
+    static void
+    calibrateWithSubmission();
+
+    static vk::UniqueQueryPool mTimestampQueryPool;
+    static vk::UniqueQueryPool mPipelineStatisticsQueryPool;
+    static std::vector<uint32_t> mFreeQueryBlocks;
+
+    // Nanoseconds per GPU timestamp tick.
+    static float mTimestampPeriod;
+
+    // CPU time (in nanoseconds) and GPU timestamp (in ticks) of the calibration.
+    static uint64_t mCalibrationCpuTime;
+    static uint64_t mCalibrationGpuTimestamp;
+    // Valid bits of the timestamps of the graphics queue family, used for the calibration.
+    static uint64_t mCalibrationTimestampMask;
+    // Maximum error of the calibration, in nanoseconds.
+    static uint64_t mCalibrationError;
+
+    // nullptr if VK_EXT_calibrated_timestamps is not enabled, or
+    // the device time domain is not calibrateable.
+    static PFN_vkGetCalibratedTimestampsEXT mGetCalibratedTimestamps;
+    static bool mIsHostTimeDomainSupported;
+
+    static std::deque<Span> mSpans;
+    static size_t mMaxSpanCount;
+};
+
+//
+// Measures the CPU time between its construction and its destruction.
+//
+class CpuScope {
+public:
+    explicit CpuScope(const std::string& name);
+    ~CpuScope();
+    CpuScope(const CpuScope&) = delete;
+    const CpuScope& operator=(const CpuScope&) = delete;
+
+private:
+    std::string mName;
+    uint64_t mBeginTime = 0;
+};
+
+//
+// Named GPU scopes of a command buffer.
+//
+// It owns a block of timestamp and pipeline statistics queries of the Profiler,
+// so it can be used by a pre-recorded command buffer that is submitted many times.
+//
+// Usage:
+// - reset() at the beginning of the command buffer.
+// - beginScope() and endScope() around the commands to measure.
+// - collect() once the command buffer execution is completed.
+//
+class GpuScopes {
+public:
+    // Maximum number of scopes that can be recorded after each reset()
+    static const uint32_t sMaxScopeCount = 16;
+
+    // * queueFamilyIndex of the queue the command buffer is submitted to.
+    //   If it does not support timestamps, then nothing is measured.
+    explicit GpuScopes(const uint32_t queueFamilyIndex);
+    ~GpuScopes();
+    GpuScopes(const GpuScopes&) = delete;
+    const GpuScopes& operator=(const GpuScopes&) = delete;
+
+    // Resets the queries of the scopes. It must be recorded before
+    // the scopes, outside of a render pass.
+    void
+    reset(const vk::CommandBuffer commandBuffer);
+
+    // Returns the scope index for endScope().
+    //
+    // * withPipelineStatistics also counts vertices, primitives and
+    //   shader invocations (only in graphics queues and if the device supports it).
+    //   Scopes with pipeline statistics cannot be nested.
+    uint32_t
+    beginScope(const vk::CommandBuffer commandBuffer,
+               const std::string& name,
+               const bool withPipelineStatistics = false);
+
+    void
+    endScope(const vk::CommandBuffer commandBuffer,
+             const uint32_t scopeIndex);
+
+    // Reads the results of the last execution of the command buffer and
+    // adds them to the Profiler. It does not block.
+    // Returns false if the results are not available yet.
+    //
+    // Precondition: The command buffer must have been submitted.
+    bool
+    collect();
+
+private:
+    bool
+    isEnabled() const;
+
+    struct Scope {
+        std::string mName;
+        bool mHasPipelineStatistics = false;
+        bool mIsEnded = false;
+    };
+
+    bool mIsTimestampSupported = false;
+    uint64_t mTimestampMask = 0;
+    bool mIsPipelineStatisticsSupported = false;
+    uint32_t mQueryBlockIndex = 0;
+    std::vector<Scope> mScopes;
+    bool mIsPipelineStatisticsScopeActive = false;
+};
+}
+
+#endif
@@ -6,17 +6,44 @@
 #include "Window.h"
 #include "device/LogicalDevice.h"
 #include "device/PhysicalDevice.h"
+#include "resource/Image.h"
+
+namespace {
+// Number of offscreen render targets in headless mode.
+const uint32_t sHeadlessImageCount = 3;
+}
 
 namespace vulkan {
 SwapChain::SwapChain() {       
-    initSwapChain();
-    initImagesAndViews();
+    if (Window::isHeadless()) {
+        initHeadlessImagesAndViews();
+    } else {
+        initSwapChain();
+        initImagesAndViews();
+    }
     initViewportAndScissorRect();
 }
 
+SwapChain::~SwapChain() {
+
+}
+
+bool
+SwapChain::isHeadless() const {
+    return mRenderTargets.empty() == false;
+}
+
 uint32_t 
 SwapChain::acquireNextImage(const vk::Semaphore semaphore) {
     assert(semaphore != VK_NULL_HANDLE);
+
+    if (isHeadless()) {
+        // The images are used in order (the first one is 0).
+        // The caller waits until the image is not in flight.
+        mCurrentImageIndex = (mCurrentImageIndex + 1) % static_cast<uint32_t>(mRenderTargets.size());
+        return mCurrentImageIndex;
+    }
+
     assert(mSwapChain.get() != VK_NULL_HANDLE);
 
     LogicalDevice::device().acquireNextImageKHR(mSwapChain.get(),
@@ -38,6 +65,11 @@ void
 SwapChain::present(const vk::Semaphore waitSemaphore,
                    const uint32_t imageIndex) {
     assert(waitSemaphore != VK_NULL_HANDLE);
+
+    if (isHeadless()) {
+        return;
+    }
+
     assert(mSwapChain.get() != VK_NULL_HANDLE);
 
     vk::PresentInfoKHR info;
@@ -49,57 +81,62 @@ SwapChain::present(const vk::Semaphore waitSemaphore,
     LogicalDevice::presentationQueue().presentKHR(info);
 }
 
+vk::ImageLayout
+SwapChain::presentationImageLayout() const {
+    return isHeadless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+}
+
 const vk::Viewport& 
 SwapChain::viewport() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mViewport;
 }
 
 const vk::Rect2D& 
 SwapChain::scissorRect() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mScissorRect;
 }
 
 vk::Format
 SwapChain::imageFormat() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mImageFormat;
 }
 
 uint32_t 
 SwapChain::imageViewCount() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return static_cast<uint32_t>(mSwapChainImageViews.size());
 }
 
 const std::vector<vk::UniqueImageView>&
 SwapChain::imageViews() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mSwapChainImageViews;
 }
 
 uint32_t
 SwapChain::imageWidth() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mExtent.width;
 }
 
 uint32_t
 SwapChain::imageHeight() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mExtent.height;
 }
 
 float 
 SwapChain::imageAspectRatio() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mExtent.width / static_cast<float>(mExtent.height);
 }
 
 const vk::Extent2D&
 SwapChain::imageExtent() const {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
     return mExtent;
 }
 
@@ -207,9 +244,32 @@ SwapChain::initImagesAndViews() {
     }
 }
 
+void
+SwapChain::initHeadlessImagesAndViews() {
+    assert(mRenderTargets.empty());
+
+    mExtent = vk::Extent2D {Window::width(), Window::height()};
+
+    // Same format that is preferred for the surfaces.
+    // It supports color attachment usage in every implementation.
+    mImageFormat = vk::Format::eB8G8R8A8Unorm;
+
+    // The render targets can also be the source of a copy to read them back.
+    for (uint32_t i = 0; i < sHeadlessImageCount; ++i) {
+        mRenderTargets.emplace_back(new Image(mExtent.width,
+                                              mExtent.height,
+                                              mImageFormat,
+                                              vk::ImageUsageFlagBits::eColorAttachment |
+                                              vk::ImageUsageFlagBits::eTransferSrc,
+                                              vk::MemoryPropertyFlagBits::eDeviceLocal));
+        mSwapChainImages.push_back(mRenderTargets.back()->vkImage());
+        mSwapChainImageViews.emplace_back(mRenderTargets.back()->createImageView(vk::ImageAspectFlagBits::eColor));
+    }
+}
+
 void
 SwapChain::initViewportAndScissorRect() {
-    assert(mSwapChain.get() != VK_NULL_HANDLE);
+    assert(mSwapChainImageViews.empty() == false);
 
     mViewport.setWidth(static_cast<float>(mExtent.width));
     mViewport.setHeight(static_cast<float>(mExtent.height));
@@ -246,46 +306,23 @@ SwapChain::initSwapChain() {
     info.setPresentMode(bestFitPresentMode(PhysicalDevice::device().getSurfacePresentModesKHR(Window::surface())));
     info.setClipped(VK_TRUE);
 
+    // Swap chain images are only used by the graphics and presentation queues.
+    // The transfer queue never accesses them.
     const uint32_t graphicsQueueFamilyIndex = PhysicalDevice::graphicsQueueFamilyIndex();
     const uint32_t presentationQueueFamilyIndex = PhysicalDevice::presentationQueueFamilyIndex();
-    const uint32_t transferQueueFamilyIndex = PhysicalDevice::transferQueueFamilyIndex();
 
     std::vector<uint32_t> queueFamilyIndices;
     if (graphicsQueueFamilyIndex == presentationQueueFamilyIndex) {
-        if (presentationQueueFamilyIndex == transferQueueFamilyIndex) {
-            // Single queue family
-            info.setImageSharingMode(vk::SharingMode::eExclusive);
-            info.setQueueFamilyIndexCount(0);
-            info.setPQueueFamilyIndices(nullptr);
-        } else {
-            // Graphics and presentation queue family + transfer queue family
-            queueFamilyIndices.push_back(graphicsQueueFamilyIndex);
-            queueFamilyIndices.push_back(transferQueueFamilyIndex);
-            info.setImageSharingMode(vk::SharingMode::eConcurrent);
-            info.setQueueFamilyIndexCount(2);
-            info.setPQueueFamilyIndices(queueFamilyIndices.data());
-        }
-    } else if (presentationQueueFamilyIndex == transferQueueFamilyIndex) {
-        // Presentation and transfer queue family + graphics queue family
-        queueFamilyIndices.push_back(graphicsQueueFamilyIndex);
-        queueFamilyIndices.push_back(transferQueueFamilyIndex);
-        info.setImageSharingMode(vk::SharingMode::eConcurrent);
-        info.setQueueFamilyIndexCount(2);
-        info.setPQueueFamilyIndices(queueFamilyIndices.data());
-    } else if (graphicsQueueFamilyIndex == transferQueueFamilyIndex) {
-        // Graphics and transfer queue family + presentation queue family
-        queueFamilyIndices.push_back(graphicsQueueFamilyIndex);
-        queueFamilyIndices.push_back(presentationQueueFamilyIndex);
-        info.setImageSharingMode(vk::SharingMode::eConcurrent);
-        info.setQueueFamilyIndexCount(2);
-        info.setPQueueFamilyIndices(queueFamilyIndices.data());
+        // Single queue family
+        info.setImageSharingMode(vk::SharingMode::eExclusive);
+        info.setQueueFamilyIndexCount(0);
+        info.setPQueueFamilyIndices(nullptr);
     } else {
-        // One queue family for each.
+        // Graphics queue family + presentation queue family
         queueFamilyIndices.push_back(graphicsQueueFamilyIndex);
         queueFamilyIndices.push_back(presentationQueueFamilyIndex);
-        queueFamilyIndices.push_back(transferQueueFamilyIndex);
         info.setImageSharingMode(vk::SharingMode::eConcurrent);
-        info.setQueueFamilyIndexCount(3);
+        info.setQueueFamilyIndexCount(2);
         info.setPQueueFamilyIndices(queueFamilyIndices.data());
     }
 
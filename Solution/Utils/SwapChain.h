@@ -2,10 +2,13 @@
 #define UTILS_SWAP_CHAIN
 
 #include <limits>
+#include <memory>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
 namespace vulkan {
+class Image;
+
 //
 // SwapChain wrapper.
 //
@@ -37,6 +40,14 @@ namespace vulkan {
 // To create/use the SwapChain you need:
 // - SurfaceKHR
 //
+// Headless mode (Read Window):
+// There is no SwapchainKHR. The images are offscreen render targets
+// (vulkan::Image) that are acquired in order, and presentation does nothing.
+// As there is no presentation engine, acquireNextImage() does not
+// signal the semaphore, and present() does not wait for it 
+// (Read FrameContext). The render targets are left in 
+// presentationImageLayout(), so they can be copied to read the result back.
+//
 class SwapChain {
 public:
     // Note: The global physical and logical device are used.
@@ -45,13 +56,17 @@ public:
     //   like surface capabilities, formats, and present modes,
     //   needed for swap chain creation.
     SwapChain();
+    ~SwapChain();
     SwapChain(const SwapChain&) = delete;
     const SwapChain& operator=(const SwapChain&) = delete;
 
+    bool
+    isHeadless() const;
+
     // Retrieve the index of the next available presentable image.
     //
     // * semaphore will become signaled when the presentation engine
-    // has released ownership of the image.
+    // has released ownership of the image (not in headless mode).
     uint32_t 
     acquireNextImage(const vk::Semaphore semaphore);
 
@@ -61,10 +76,16 @@ public:
     currentImageIndex() const;
 
     // * waitSemaphore to wait for before issuing the present request.
+    //   It is ignored in headless mode.
     void 
     present(const vk::Semaphore waitSemaphore,
             const uint32_t imageIndex);
 
+    // Layout the images must be in when they are presented.
+    // It is the final layout of the render passes that write them.
+    vk::ImageLayout
+    presentationImageLayout() const;
+
     // The viewport describes the region of the framebuffer that the output
     // will be rendered too.
     // It defines the transformation from the image to the framebuffer.
@@ -135,12 +156,19 @@ private:
 
     void 
     initImagesAndViews();
+
+    void
+    initHeadlessImagesAndViews();
     
     void 
     initViewportAndScissorRect();
         
     vk::UniqueSwapchainKHR mSwapChain;
 
+    // Offscreen render targets in headless mode.
+    // They are declared before their views, so they are destroyed after them.
+    std::vector<std::unique_ptr<Image>> mRenderTargets;
+
     std::vector<vk::Image> mSwapChainImages;
     std::vector<vk::UniqueImageView> mSwapChainImageViews;
 
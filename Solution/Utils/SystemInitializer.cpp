@@ -2,20 +2,94 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <vector>
 
 #include "CommandPools.h"
 #include "Instance.h"
+#include "Profiler.h"
+#include "TransferEngine.h"
 #include "Window.h"
 #include "device/LogicalDevice.h"
 #include "device/PhysicalDevice.h"
+#include "pipeline/ExtendedDynamicState.h"
+#include "memory/DeviceMemoryAllocator.h"
+#include "memory/StagingRing.h"
+#include "pipeline/PipelineCache.h"
+#include "pipeline/PipelineCompiler.h"
+#include "pipeline/PipelineManifest.h"
+#include "pipeline/PipelineSystem.h"
 #include "resource/ImageSystem.h"
 #include "resource/ModelSystem.h"
+#include "shader/ShaderArchive.h"
 #include "shader/ShaderModuleSystem.h"
+#include "shader/ShaderWatcher.h"
 
 namespace {
+const uint32_t sWindowWidth = 1024;
+const uint32_t sWindowHeight = 768;
+const uint32_t sDefaultHeadlessFrameCount = 1000;
+
+struct Options {
+    bool mIsHeadless = false;
+    uint32_t mHeadlessFrameCount = sDefaultHeadlessFrameCount;
+    bool mIsHotReloadEnabled = false;
+};
+
+// Returns false if string is not an integer in [1, UINT32_MAX].
+bool
+parseFrameCount(const char* string,
+                uint32_t& frameCount) {
+    assert(string != nullptr);
+
+    // strtoull accepts (and negates) negative numbers.
+    if (*string < '0' || *string > '9') {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = std::strtoull(string,
+                                                   &end,
+                                                   10);
+    if (errno != 0 || *end != '\0' || value == 0 || value > UINT32_MAX) {
+        return false;
+    }
+
+    frameCount = static_cast<uint32_t>(value);
+    return true;
+}
+
+// Invalid options stop the application, before any system is initialized.
+Options
+parseOptions(const int argc,
+             const char* const argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        assert(argv != nullptr);
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            options.mIsHeadless = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0) {
+            if (i + 1 >= argc ||
+                parseFrameCount(argv[i + 1], options.mHeadlessFrameCount) == false) {
+                std::cerr << "Invalid --frames value: " << (i + 1 < argc ? argv[i + 1] : "(none)")
+                          << ". It must be an integer between 1 and " << UINT32_MAX << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--hot-reload") == 0) {
+            options.mIsHotReloadEnabled = true;
+        }
+    }
+
+    return options;
+}
+
 std::vector<const char*>
-getInstanceLayerNames() {
+getInstanceLayerNames(const bool isHeadless) {
     std::vector<const char*> instanceLayers;
 #ifdef _DEBUG
     // Validation: the main, comprehensive Khronos validation layer.
@@ -37,75 +111,209 @@ getInstanceLayerNames() {
 #endif
 
     // Utility: outputs the frames-per-second of the target application in 
-    // the applications title bar
-    instanceLayers.emplace_back("VK_LAYER_LUNARG_monitor");
+    // the applications title bar.
+    // There is no title bar in headless mode (and the layer is usually
+    // not installed in machines without a display).
+    if (isHeadless == false) {
+        instanceLayers.emplace_back("VK_LAYER_LUNARG_monitor");
+    }
 
     return instanceLayers;
 }
 
 std::vector<const char*>
-getInstanceExtensionNames() {
+getInstanceExtensionNames(const bool isHeadless) {
+    std::vector<const char*> instanceExtensions;
+
     // Vulkan is a platform agnostic API, which means that you need an extension
     // to interface with the window system.
     // GLFW has a handy built-in function that returns the extension(s)
     // it needs to do that which we can pass to the struct.
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    assert(glfwExtensions != nullptr);
+    // In headless mode, there is no window system.
+    if (isHeadless == false) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        assert(glfwExtensions != nullptr);
 
-    std::vector<const char*> instanceExtensions(glfwExtensions,
-                                                glfwExtensions + glfwExtensionCount);
+        instanceExtensions.assign(glfwExtensions,
+                                  glfwExtensions + glfwExtensionCount);
+    }
 #ifdef _DEBUG
     instanceExtensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif
 
+    // The optional device extensions require it if the instance or
+    // the physical device only support Vulkan 1.0 (Read PhysicalDevice::isFeatures2Supported()).
+    if (vulkan::Instance::isExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+        instanceExtensions.emplace_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
+
     return instanceExtensions;
 }
+
+std::vector<const char*>
+getDeviceExtensionNames(const std::vector<const char*>& requiredDeviceExtensions) {
+    std::vector<const char*> deviceExtensions(requiredDeviceExtensions);
+
+    // All the optional extensions require VK_KHR_get_physical_device_properties2
+    // (or Vulkan 1.1).
+    if (vulkan::PhysicalDevice::isFeatures2Supported() == false) {
+        return deviceExtensions;
+    }
+
+    // Optional extensions, that are only enabled 
+    // if the physical device supports them.
+    const std::vector<const char*> optionalDeviceExtensions {
+        // Used by the Profiler to correlate CPU and GPU times.
+        VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+
+        // Used by the ExtendedDynamicState to set pipeline states
+        // from the command buffer.
+#ifdef VK_EXT_extended_dynamic_state
+        VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+        VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+        VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
+#endif
+    };
+
+    for (const char* extensionName : optionalDeviceExtensions) {
+        if (vulkan::PhysicalDevice::isExtensionSupported(extensionName)) {
+            deviceExtensions.emplace_back(extensionName);
+        }
+    }
+
+#ifdef VK_EXT_graphics_pipeline_library
+    // Used by the PipelineSystem to link pipeline variants.
+    // VK_EXT_graphics_pipeline_library requires VK_KHR_pipeline_library.
+    if (vulkan::PhysicalDevice::isExtensionSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+        vulkan::PhysicalDevice::isExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        deviceExtensions.emplace_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        deviceExtensions.emplace_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    }
+#endif
+
+    return deviceExtensions;
+}
 }
 
 namespace vulkan {
 namespace system_initializer {
 void
-initialize() {
+initialize(const int argc,
+           const char* const argv[]) {
+    const Options options = parseOptions(argc, 
+                                         argv);
+
+    if (options.mIsHeadless == false) {
 #ifdef _DEBUG
-    assert(glfwInit() == GLFW_TRUE);
+        assert(glfwInit() == GLFW_TRUE);
 #else
-    glfwInit();
+        glfwInit();
 #endif
+    }
+
+    Instance::initialize(getInstanceExtensionNames(options.mIsHeadless),
+                         getInstanceLayerNames(options.mIsHeadless));
 
-    Instance::initialize(getInstanceExtensionNames(),
-                         getInstanceLayerNames());
+    if (options.mIsHeadless) {
+        Window::initializeHeadless(sWindowWidth,
+                                   sWindowHeight,
+                                   options.mHeadlessFrameCount);
+    } else {
+        Window::initialize(sWindowWidth,
+                           sWindowHeight,
+                           "Vulkan App");
+    }
 
-    Window::initialize(1024,
-                       768,
-                       "Vulkan App");
+    // The swap chain extension is not needed to render offscreen.
+    std::vector<const char*> requiredDeviceExtensions;
+    if (options.mIsHeadless == false) {
+        requiredDeviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
     
-    PhysicalDevice::initialize({VK_KHR_SWAPCHAIN_EXTENSION_NAME});
+    PhysicalDevice::initialize(requiredDeviceExtensions);
+
+    LogicalDevice::initialize(getDeviceExtensionNames(requiredDeviceExtensions));
+
+    DeviceMemoryAllocator::initialize();
+
+    ExtendedDynamicState::initialize();
+
+    PipelineCache::initialize("pipeline_cache.bin");
 
-    LogicalDevice::initialize({VK_KHR_SWAPCHAIN_EXTENSION_NAME});   
+    PipelineCompiler::initialize();
+
+    PipelineManifest::initialize("pipeline_manifest.bin");
+
+    // Shader files are expected to change only with hot reload.
+    ShaderArchive::initialize("shader_archive.bin",
+                              options.mIsHotReloadEnabled);
+
+    if (options.mIsHotReloadEnabled) {
+        ShaderWatcher::initialize();
+    }
 
     CommandPools::initialize();
+
+    Profiler::initialize();
+
+    TransferEngine::initialize();
+
+    StagingRing::initialize();
 }
 
 void
 finalize() {
+    // Resources cannot be destroyed while they are being uploaded.
+    TransferEngine::finalize();
+
+    // Pipelines cannot be destroyed while they are being compiled.
+    PipelineCompiler::finalize();
+
+    // Shader modules cannot be destroyed while they are being reloaded.
+    ShaderWatcher::finalize();
+
     ModelSystem::clear();
 
     ImageSystem::clear();
 
+    PipelineSystem::clear();
+
+    PipelineManifest::finalize();
+
     ShaderModuleSystem::clear();
 
+    ShaderArchive::finalize();
+
+    StagingRing::finalize();
+
+    Profiler::finalize();
+
     CommandPools::finalize();
 
+    PipelineCache::finalize();
+
+    ExtendedDynamicState::finalize();
+
+    DeviceMemoryAllocator::finalize();
+
     LogicalDevice::finalize();
 
     PhysicalDevice::finalize();
 
+    const bool isHeadless = Window::isHeadless();
+
     Window::finalize();
 
     Instance::finalize();
 
-    glfwTerminate();
+    if (isHeadless == false) {
+        glfwTerminate();
+    }
 }
 }
 }
\ No newline at end of file
@@ -1,10 +1,21 @@
 #ifndef UTILS_SYSTEM_INITIALIZER
 #define UTILS_SYSTEM_INITIALIZER
 
+#include <cstdint>
+
 namespace vulkan {
 namespace system_initializer {
+// Command line options:
+// --headless       There is no window, the frames are rendered into 
+//                  offscreen images (Read Window and SwapChain).
+// --frames count   Number of frames rendered in headless mode.
+//                  The application exits if it is not an integer greater than 0.
+// --hot-reload     Shaders are reloaded when their SPIR-V files change
+//                  (Read ShaderWatcher), and archived shaders whose files
+//                  changed are not used (Read ShaderArchive).
 void 
-initialize();
+initialize(const int argc = 0,
+           const char* const argv[] = nullptr);
 
 void
 finalize();
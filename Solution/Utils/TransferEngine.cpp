@@ -0,0 +1,338 @@
+#include "TransferEngine.h"
+
+#include <cassert>
+#include <limits>
+
+#include "CommandPools.h"
+#include "Profiler.h"
+#include "device/LogicalDevice.h"
+#include "device/PhysicalDevice.h"
+
+namespace vulkan {
+bool
+TransferTicket::isValid() const {
+    return mBatchId != 0;
+}
+
+vk::UniqueCommandBuffer
+TransferEngine::mCommandBuffer = vk::UniqueCommandBuffer();
+
+vk::UniqueCommandBuffer
+TransferEngine::mGraphicsCommandBuffer = vk::UniqueCommandBuffer();
+
+std::unique_ptr<GpuScopes>
+TransferEngine::mGpuScopes = nullptr;
+
+std::unique_ptr<GpuScopes>
+TransferEngine::mGraphicsGpuScopes = nullptr;
+
+uint64_t
+TransferEngine::mNextBatchId = 1;
+
+uint64_t
+TransferEngine::mCompletedBatchId = 0;
+
+std::deque<TransferEngine::Batch>
+TransferEngine::mBatches = {};
+
+std::vector<vk::UniqueFence>
+TransferEngine::mFreeFences = {};
+
+void
+TransferEngine::initialize() {
+    assert(mCommandBuffer.get() == VK_NULL_HANDLE);
+    assert(mGraphicsCommandBuffer.get() == VK_NULL_HANDLE);
+    assert(mBatches.empty());
+
+    mNextBatchId = 1;
+    mCompletedBatchId = 0;
+}
+
+void
+TransferEngine::finalize() {
+    waitIdle();
+
+    mFreeFences.clear();
+}
+
+vk::CommandBuffer
+TransferEngine::commandBuffer() {
+    if (mCommandBuffer.get() == VK_NULL_HANDLE) {
+        mCommandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer(CommandPools::transferCommandPool());
+
+        // The scope ends in flush()
+        mGpuScopes.reset(new GpuScopes(PhysicalDevice::transferQueueFamilyIndex()));
+        mGpuScopes->reset(mCommandBuffer.get());
+        mGpuScopes->beginScope(mCommandBuffer.get(),
+                               "Uploads");
+    }
+
+    return mCommandBuffer.get();
+}
+
+vk::CommandBuffer
+TransferEngine::graphicsCommandBuffer() {
+    if (isOwnershipTransferNeeded() == false) {
+        return commandBuffer();
+    }
+
+    if (mGraphicsCommandBuffer.get() == VK_NULL_HANDLE) {
+        mGraphicsCommandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer(CommandPools::graphicsCommandPool());
+
+        // The scope ends in flush()
+        mGraphicsGpuScopes.reset(new GpuScopes(PhysicalDevice::graphicsQueueFamilyIndex()));
+        mGraphicsGpuScopes->reset(mGraphicsCommandBuffer.get());
+        mGraphicsGpuScopes->beginScope(mGraphicsCommandBuffer.get(),
+                                       "Upload acquires and mip maps");
+    }
+
+    return mGraphicsCommandBuffer.get();
+}
+
+bool
+TransferEngine::isOwnershipTransferNeeded() {
+    return PhysicalDevice::transferQueueFamilyIndex() != PhysicalDevice::graphicsQueueFamilyIndex();
+}
+
+void
+TransferEngine::transferBufferOwnership(const vk::Buffer buffer,
+                                        const vk::PipelineStageFlags destPipelineStages,
+                                        const vk::AccessFlags destAccesses) {
+    assert(buffer != VK_NULL_HANDLE);
+
+    if (isOwnershipTransferNeeded() == false) {
+        return;
+    }
+
+    // The release barrier only needs the source accesses and the acquire 
+    // barrier only needs the destination accesses. The queue family indices
+    // must match in both.
+    vk::BufferMemoryBarrier barrier;
+    barrier.setBuffer(buffer);
+    barrier.setOffset(0);
+    barrier.setSize(VK_WHOLE_SIZE);
+    barrier.setSrcQueueFamilyIndex(PhysicalDevice::transferQueueFamilyIndex());
+    barrier.setDstQueueFamilyIndex(PhysicalDevice::graphicsQueueFamilyIndex());
+
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    commandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                    vk::PipelineStageFlagBits::eBottomOfPipe,
+                                    vk::DependencyFlags(),
+                                    {}, // memory barriers
+                                    {barrier},
+                                    {}); // image memory barriers
+
+    barrier.setSrcAccessMask(vk::AccessFlags());
+    barrier.setDstAccessMask(destAccesses);
+    graphicsCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                            destPipelineStages,
+                                            vk::DependencyFlags(),
+                                            {}, // memory barriers
+                                            {barrier},
+                                            {}); // image memory barriers
+}
+
+void
+TransferEngine::transferImageOwnership(const vk::Image image,
+                                       const vk::ImageSubresourceRange& subresourceRange,
+                                       const vk::ImageLayout imageLayout,
+                                       const vk::PipelineStageFlags destPipelineStages,
+                                       const vk::AccessFlags destAccesses) {
+    assert(image != VK_NULL_HANDLE);
+
+    if (isOwnershipTransferNeeded() == false) {
+        return;
+    }
+
+    vk::ImageMemoryBarrier barrier;
+    barrier.setImage(image);
+    barrier.setSubresourceRange(subresourceRange);
+    barrier.setOldLayout(imageLayout);
+    barrier.setNewLayout(imageLayout);
+    barrier.setSrcQueueFamilyIndex(PhysicalDevice::transferQueueFamilyIndex());
+    barrier.setDstQueueFamilyIndex(PhysicalDevice::graphicsQueueFamilyIndex());
+
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    commandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                    vk::PipelineStageFlagBits::eBottomOfPipe,
+                                    vk::DependencyFlags(),
+                                    {}, // memory barriers
+                                    {}, // buffer memory barriers
+                                    {barrier});
+
+    barrier.setSrcAccessMask(vk::AccessFlags());
+    barrier.setDstAccessMask(destAccesses);
+    graphicsCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                            destPipelineStages,
+                                            vk::DependencyFlags(),
+                                            {}, // memory barriers
+                                            {}, // buffer memory barriers
+                                            {barrier});
+}
+
+TransferTicket
+TransferEngine::currentTicket() {
+    return TransferTicket {mNextBatchId};
+}
+
+TransferTicket
+TransferEngine::flush() {
+    if (mCommandBuffer.get() == VK_NULL_HANDLE &&
+        mGraphicsCommandBuffer.get() == VK_NULL_HANDLE) {
+        return TransferTicket {mNextBatchId - 1};
+    }
+
+    // Recycle what we can before creating new objects.
+    retireBatches(mNextBatchId - 1,
+                  false);
+
+    Batch batch;
+    batch.mId = mNextBatchId++;
+    batch.mCommandBuffer = std::move(mCommandBuffer);
+    batch.mGraphicsCommandBuffer = std::move(mGraphicsCommandBuffer);
+    batch.mGpuScopes = std::move(mGpuScopes);
+    batch.mGraphicsGpuScopes = std::move(mGraphicsGpuScopes);
+    batch.mSemaphore = LogicalDevice::device().createSemaphoreUnique({});
+    if (mFreeFences.empty()) {
+        batch.mFence = LogicalDevice::device().createFenceUnique({});
+    } else {
+        batch.mFence = std::move(mFreeFences.back());
+        mFreeFences.pop_back();
+    }
+
+    const bool hasGraphicsSubmission = batch.mGraphicsCommandBuffer.get() != VK_NULL_HANDLE;
+
+    if (batch.mCommandBuffer.get() != VK_NULL_HANDLE) {
+        batch.mGpuScopes->endScope(batch.mCommandBuffer.get(),
+                                   0);
+        batch.mCommandBuffer->end();
+
+        // If there is a graphics submission, it is the one that
+        // signals the semaphore and the fence of the batch.
+        vk::Semaphore signalSemaphore = batch.mSemaphore.get();
+        vk::Fence fence = batch.mFence.get();
+        if (hasGraphicsSubmission) {
+            batch.mTransferSemaphore = LogicalDevice::device().createSemaphoreUnique({});
+            signalSemaphore = batch.mTransferSemaphore.get();
+            fence = vk::Fence();
+        }
+
+        vk::SubmitInfo info;
+        info.setCommandBufferCount(1);
+        info.setPCommandBuffers(&batch.mCommandBuffer.get());
+        info.setSignalSemaphoreCount(1);
+        info.setPSignalSemaphores(&signalSemaphore);
+        LogicalDevice::transferQueue().submit({info},
+                                              fence);
+    }
+
+    if (hasGraphicsSubmission) {
+        batch.mGraphicsGpuScopes->endScope(batch.mGraphicsCommandBuffer.get(),
+                                           0);
+        batch.mGraphicsCommandBuffer->end();
+
+        // Acquire barriers must be executed after the release barriers.
+        const vk::PipelineStageFlags waitStageFlags = vk::PipelineStageFlagBits::eAllCommands;
+
+        vk::SubmitInfo info;
+        if (batch.mTransferSemaphore.get() != VK_NULL_HANDLE) {
+            info.setWaitSemaphoreCount(1);
+            info.setPWaitSemaphores(&batch.mTransferSemaphore.get());
+            info.setPWaitDstStageMask(&waitStageFlags);
+        }
+        info.setCommandBufferCount(1);
+        info.setPCommandBuffers(&batch.mGraphicsCommandBuffer.get());
+        info.setSignalSemaphoreCount(1);
+        info.setPSignalSemaphores(&batch.mSemaphore.get());
+        LogicalDevice::graphicsQueue().submit({info},
+                                              batch.mFence.get());
+    }
+
+    const TransferTicket ticket {batch.mId};
+    mBatches.emplace_back(std::move(batch));
+
+    return ticket;
+}
+
+bool
+TransferEngine::isCompleted(const TransferTicket ticket) {
+    if (ticket.mBatchId >= mNextBatchId) {
+        // The batch is being recorded.
+        return false;
+    }
+
+    retireBatches(ticket.mBatchId,
+                  false);
+
+    return ticket.mBatchId <= mCompletedBatchId;
+}
+
+void
+TransferEngine::wait(const TransferTicket ticket) {
+    assert(ticket.mBatchId <= mNextBatchId);
+
+    if (ticket.mBatchId == mNextBatchId) {
+        flush();
+    }
+
+    retireBatches(ticket.mBatchId,
+                  true);
+}
+
+void
+TransferEngine::waitIdle() {
+    wait(flush());
+}
+
+vk::UniqueSemaphore
+TransferEngine::takeSemaphore(const TransferTicket ticket) {
+    assert(ticket.mBatchId <= mNextBatchId);
+
+    if (ticket.mBatchId == mNextBatchId) {
+        flush();
+    }
+
+    retireBatches(ticket.mBatchId,
+                  false);
+
+    for (Batch& batch : mBatches) {
+        if (batch.mId == ticket.mBatchId) {
+            return std::move(batch.mSemaphore);
+        }
+    }
+
+    // The batch is already completed.
+    return vk::UniqueSemaphore();
+}
+
+void
+TransferEngine::retireBatches(const uint64_t batchId,
+                              const bool wait) {
+    while (mBatches.empty() == false && 
+           mBatches.front().mId <= batchId) {
+        Batch& batch = mBatches.front();
+        if (wait) {
+            LogicalDevice::device().waitForFences({batch.mFence.get()},
+                                                  VK_TRUE,
+                                                  std::numeric_limits<uint64_t>::max());
+        } else if (LogicalDevice::device().getFenceStatus(batch.mFence.get()) != vk::Result::eSuccess) {
+            return;
+        }
+
+        LogicalDevice::device().resetFences({batch.mFence.get()});
+
+        if (batch.mGpuScopes != nullptr) {
+            batch.mGpuScopes->collect();
+        }
+        if (batch.mGraphicsGpuScopes != nullptr) {
+            batch.mGraphicsGpuScopes->collect();
+        }
+
+        // The signal operation of the semaphore is completed, so
+        // it can be destroyed even if nobody waited on it.
+        mCompletedBatchId = batch.mId;
+        mFreeFences.emplace_back(std::move(batch.mFence));
+        mBatches.pop_front();
+    }
+}
+}
@@ -0,0 +1,187 @@
+#ifndef UTILS_TRANSFER_ENGINE
+#define UTILS_TRANSFER_ENGINE
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+class GpuScopes;
+
+//
+// Identifies the batch of transfer commands where an upload was recorded.
+// Batch ids grow monotonically, so a ticket is completed once its batch
+// (and all the previous ones) are completed.
+//
+struct TransferTicket {
+    bool
+    isValid() const;
+
+    // 0 means no batch (nothing to wait for).
+    uint64_t mBatchId = 0;
+};
+
+//
+// Global asynchronous transfer engine.
+//
+// Copies and layout transitions of the uploads are recorded into a single
+// command buffer (the current batch) of the transfer command pool. 
+// Batches are submitted to the transfer queue when flush() is called,
+// when the StagingRing runs out of chunks, or when a ticket of the batch
+// is waited. The CPU does not block on each copy.
+//
+// Each submitted batch signals:
+// - A fence, used by the CPU to wait (wait()) or to recycle 
+//   staging memory and command buffers.
+// - A semaphore, that the first submission that uses the uploaded
+//   resources must wait on (takeSemaphore()). That way, the device only
+//   waits when the resource is used for the first time, and asset loading
+//   overlaps with rendering.
+//
+// The transfer queue family is usually a dedicated one (Read PhysicalDeviceData),
+// so resources are created with VK_SHARING_MODE_EXCLUSIVE and their ownership
+// must be transferred to the graphics queue family after they are written:
+// a release barrier is recorded in commandBuffer() and the matching acquire 
+// barrier in graphicsCommandBuffer(). The graphics command buffer of the batch
+// is submitted to the graphics queue after the transfer one, and it also
+// records the commands that the transfer queue cannot execute (like blits).
+//
+// The GPU time of each batch is measured with the Profiler.
+//
+// It is not thread safe.
+//
+// Preconditions:
+// - The global logical device, CommandPools and Profiler must be initialized first.
+//
+class TransferEngine {
+public:
+    static void
+    initialize();
+
+    // Waits for all the batches before destroying them.
+    static void
+    finalize();
+
+    // Command buffer of the current batch. Copies and barriers of the 
+    // uploads must be recorded here.
+    static vk::CommandBuffer
+    commandBuffer();
+
+    // Command buffer of the current batch that is executed by the graphics
+    // queue once the commands of commandBuffer() are completed.
+    // Acquire barriers and commands that need a graphics queue (blits, 
+    // barriers with graphics pipeline stages) must be recorded here.
+    // It is commandBuffer() if the transfer and graphics queue families are the same.
+    static vk::CommandBuffer
+    graphicsCommandBuffer();
+
+    // True if the transfer and graphics queue families are different, so 
+    // the ownership of exclusive resources must be transferred after they are written.
+    static bool
+    isOwnershipTransferNeeded();
+
+    // Records the release barrier of the buffer (written by transfer commands) 
+    // in commandBuffer(), and the acquire barrier in graphicsCommandBuffer().
+    // It does nothing if isOwnershipTransferNeeded() is false.
+    //
+    // * destPipelineStages and destAccesses of the first use of the buffer.
+    static void
+    transferBufferOwnership(const vk::Buffer buffer,
+                            const vk::PipelineStageFlags destPipelineStages,
+                            const vk::AccessFlags destAccesses);
+
+    // Same as transferBufferOwnership(), for the image subresources, 
+    // that keep imageLayout.
+    static void
+    transferImageOwnership(const vk::Image image,
+                           const vk::ImageSubresourceRange& subresourceRange,
+                           const vk::ImageLayout imageLayout,
+                           const vk::PipelineStageFlags destPipelineStages,
+                           const vk::AccessFlags destAccesses);
+
+    // Ticket of the current batch (the commands that are being recorded).
+    static TransferTicket
+    currentTicket();
+
+    // Submits the current batch (if it has commands) and returns
+    // the ticket of the last submitted batch.
+    static TransferTicket
+    flush();
+
+    // It does not block.
+    static bool
+    isCompleted(const TransferTicket ticket);
+
+    // Blocks until the batch of the ticket is completed.
+    // The batch is submitted first, if it was not yet.
+    static void
+    wait(const TransferTicket ticket);
+
+    static void
+    waitIdle();
+
+    // Returns the semaphore signaled by the batch of the ticket, that must
+    // be waited by the first submission that uses its resources.
+    // The batch is submitted first, if it was not yet.
+    //
+    // It returns an empty handle if the batch is already completed,
+    // or if the semaphore was already taken (in that case, the submission 
+    // must be ordered after the one that waits on it).
+    //
+    // The caller owns the semaphore and must keep it alive until
+    // the submission that waits on it is completed.
+    static vk::UniqueSemaphore
+    takeSemaphore(const TransferTicket ticket);
+
+private:
+    TransferEngine() = delete;
+    ~TransferEngine() = delete;
+    TransferEngine(TransferEngine&&) noexcept = delete;
+    TransferEngine(const TransferEngine&) = delete;
+    const TransferEngine& operator=(const TransferEngine&) = delete;
+
+    // Batch submitted to the transfer queue that is not
+    // known to be completed yet.
+    struct Batch {
+        uint64_t mId = 0;
+        vk::UniqueCommandBuffer mCommandBuffer;
+        vk::UniqueCommandBuffer mGraphicsCommandBuffer;
+
+        // Signaled by the transfer submission and waited by the graphics
+        // submission, if the batch has both.
+        vk::UniqueSemaphore mTransferSemaphore;
+
+        // Signaled by the last submission of the batch.
+        vk::UniqueFence mFence;
+
+        // GPU scopes of the command buffers, collected
+        // when the batch is completed.
+        std::unique_ptr<GpuScopes> mGpuScopes;
+        std::unique_ptr<GpuScopes> mGraphicsGpuScopes;
+
+        // Empty once it is taken by takeSemaphore()
+        vk::UniqueSemaphore mSemaphore;
+    };
+
+    // Waits for the batches (in submission order) until batchId.
+    // If wait is false, it only retires the batches that are already completed.
+    static void
+    retireBatches(const uint64_t batchId,
+                  const bool wait);
+
+    static vk::UniqueCommandBuffer mCommandBuffer;
+    static vk::UniqueCommandBuffer mGraphicsCommandBuffer;
+    static std::unique_ptr<GpuScopes> mGpuScopes;
+    static std::unique_ptr<GpuScopes> mGraphicsGpuScopes;
+    static uint64_t mNextBatchId;
+    static uint64_t mCompletedBatchId;
+
+    // Submitted batches sorted by id.
+    static std::deque<Batch> mBatches;
+    static std::vector<vk::UniqueFence> mFreeFences;
+};
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Window.h"
 
+#include <iostream>
+
 #include "Instance.h"
 
 namespace vulkan {
@@ -9,6 +11,24 @@ Window::mWindow = nullptr;
 vk::SurfaceKHR 
 Window::mSurface;
 
+bool
+Window::mIsHeadless = false;
+
+uint32_t
+Window::mHeadlessWidth = 0;
+
+uint32_t
+Window::mHeadlessHeight = 0;
+
+uint32_t
+Window::mHeadlessFrameCount = 0;
+
+uint32_t
+Window::mRenderedFrameCount = 0;
+
+std::chrono::steady_clock::time_point
+Window::mFirstFrameTime;
+
 void
 Window::initialize(const uint32_t width, 
                    const uint32_t height,
@@ -40,8 +60,30 @@ Window::initialize(const uint32_t width,
                                    reinterpret_cast<VkSurfaceKHR*>(&mSurface)) == VK_SUCCESS);
 }
 
+void
+Window::initializeHeadless(const uint32_t width,
+                           const uint32_t height,
+                           const uint32_t frameCount) {
+    assert(width > 0);
+    assert(height > 0);
+    assert(frameCount > 0);
+    assert(mWindow == nullptr);
+    assert(mIsHeadless == false);
+
+    mIsHeadless = true;
+    mHeadlessWidth = width;
+    mHeadlessHeight = height;
+    mHeadlessFrameCount = frameCount;
+    mRenderedFrameCount = 0;
+}
+
 void
 Window::finalize() {
+    if (mIsHeadless) {
+        mIsHeadless = false;
+        return;
+    }
+
     assert(mSurface != VK_NULL_HANDLE);
     Instance::instance().destroySurfaceKHR(mSurface);
 
@@ -49,22 +91,62 @@ Window::finalize() {
     glfwTerminate();
 }
 
+bool
+Window::isHeadless() {
+    return mIsHeadless;
+}
+
 vk::SurfaceKHR
 Window::surface() {
+    assert(mIsHeadless == false);
     assert(mSurface != VK_NULL_HANDLE);
     return mSurface;
 }
 
 bool 
 Window::shouldCloseWindow() {
+    if (mIsHeadless) {
+        // The first frame is not measured, because it usually 
+        // waits for the uploads of the initialization.
+        if (mRenderedFrameCount == 1) {
+            mFirstFrameTime = std::chrono::steady_clock::now();
+        }
+
+        if (mRenderedFrameCount == mHeadlessFrameCount) {
+            const std::chrono::duration<double> time = std::chrono::steady_clock::now() - mFirstFrameTime;
+            const uint32_t measuredFrameCount = mHeadlessFrameCount - 1;
+            std::cout << "Headless: " << measuredFrameCount << " frames in " 
+                      << time.count() << " seconds (" 
+                      << (time.count() > 0.0 ? measuredFrameCount / time.count() : 0.0)
+                      << " frames per second)" << std::endl;
+            return true;
+        }
+
+        ++mRenderedFrameCount;
+        return false;
+    }
+
     assert(mWindow != nullptr);
 
     return glfwWindowShouldClose(mWindow) != 0;
 }
 
+void
+Window::pollEvents() {
+    if (mIsHeadless == false) {
+        glfwPollEvents();
+    }
+}
+
 void
 Window::widthAndHeight(uint32_t& width, 
                        uint32_t& height) {
+    if (mIsHeadless) {
+        width = mHeadlessWidth;
+        height = mHeadlessHeight;
+        return;
+    }
+
     assert(mWindow != nullptr);
     int w;
     int h;
@@ -77,6 +159,10 @@ Window::widthAndHeight(uint32_t& width,
 
 uint32_t
 Window::width() {
+    if (mIsHeadless) {
+        return mHeadlessWidth;
+    }
+
     assert(mWindow != nullptr);
     int w;
     int h;
@@ -88,6 +174,10 @@ Window::width() {
 
 uint32_t
 Window::height() {
+    if (mIsHeadless) {
+        return mHeadlessHeight;
+    }
+
     assert(mWindow != nullptr);
     int w;
     int h;
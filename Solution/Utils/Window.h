@@ -3,6 +3,7 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
@@ -34,6 +35,14 @@ namespace vulkan {
 // - Create the surface
 // - Create the SwapChain
 //
+// Headless mode:
+// There is no GLFWwindow nor surface (and GLFW is not needed at all),
+// so it can run on machines without a display, with any Vulkan
+// implementation (including software ones like lavapipe).
+// The SwapChain renders into offscreen images instead, and the window 
+// "closes" once a fixed number of frames was rendered. Then, the number of 
+// frames per second is printed, to be used as a throughput benchmark.
+//
 class Window {
 public:
     Window() = delete;
@@ -49,15 +58,30 @@ public:
                const uint32_t height,
                const char* title);
 
+    // * frameCount is the number of frames to render before
+    //   shouldCloseWindow() returns true.
+    static void
+    initializeHeadless(const uint32_t width,
+                       const uint32_t height,
+                       const uint32_t frameCount);
+
     static void
     finalize();
 
+    static bool
+    isHeadless();
+
     static vk::SurfaceKHR
     surface();
     
+    // In headless mode, each call counts as a rendered frame.
     static bool 
     shouldCloseWindow();
 
+    // Processes the window events. It does nothing in headless mode.
+    static void
+    pollEvents();
+
     static void
     widthAndHeight(uint32_t& width, 
                    uint32_t& height);
@@ -71,6 +95,14 @@ public:
 private:
     static GLFWwindow* mWindow;
     static vk::SurfaceKHR mSurface;
+
+    // Headless mode
+    static bool mIsHeadless;
+    static uint32_t mHeadlessWidth;
+    static uint32_t mHeadlessHeight;
+    static uint32_t mHeadlessFrameCount;
+    static uint32_t mRenderedFrameCount;
+    static std::chrono::steady_clock::time_point mFirstFrameTime;
 };
 }
 
@@ -1,9 +1,41 @@
 #include "LogicalDevice.h"
 
 #include <cassert>
+#include <cstring>
+#include <set>
 
 #include "PhysicalDevice.h"
 
+namespace {
+bool
+isExtensionRequested(const std::vector<const char*>& deviceExtensionNames,
+                     const char* extensionName) {
+    for (const char* deviceExtensionName : deviceExtensionNames) {
+        if (std::strcmp(deviceExtensionName, extensionName) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Fills the features struct of an extension with
+// the values supported by the physical device.
+// If they cannot be queried, then they are left as not supported.
+template<typename ExtensionFeatures>
+void
+querySupportedFeatures(ExtensionFeatures& extensionFeatures) {
+    extensionFeatures.setPNext(nullptr);
+    if (vulkan::PhysicalDevice::isFeatures2Supported() == false) {
+        return;
+    }
+
+    vk::PhysicalDeviceFeatures2 features;
+    features.setPNext(&extensionFeatures);
+    vulkan::PhysicalDevice::getFeatures2(features);
+}
+}
+
 namespace vulkan {
 vk::Device 
 LogicalDevice::mLogicalDevice;
@@ -17,6 +49,24 @@ LogicalDevice::mTransferQueue;
 vk::Queue
 LogicalDevice::mPresentationQueue;
 
+std::vector<std::string>
+LogicalDevice::mEnabledExtensionNames = {};
+
+vk::PhysicalDeviceFeatures
+LogicalDevice::mEnabledFeatures;
+
+bool
+LogicalDevice::mIsGraphicsPipelineLibraryEnabled = false;
+
+bool
+LogicalDevice::mIsExtendedDynamicStateEnabled = false;
+
+bool
+LogicalDevice::mIsExtendedDynamicState2Enabled = false;
+
+bool
+LogicalDevice::mIsExtendedDynamicState3Enabled = false;
+
 void
 LogicalDevice::initialize(const std::vector<const char*>& deviceExtensionNames) {
     assert(mLogicalDevice == VK_NULL_HANDLE);
@@ -30,6 +80,11 @@ void
 LogicalDevice::finalize() {
     assert(mLogicalDevice != VK_NULL_HANDLE);
     mLogicalDevice.destroy();
+    mEnabledExtensionNames.clear();
+    mIsGraphicsPipelineLibraryEnabled = false;
+    mIsExtendedDynamicStateEnabled = false;
+    mIsExtendedDynamicState2Enabled = false;
+    mIsExtendedDynamicState3Enabled = false;
 }
 
 vk::Device
@@ -56,57 +111,163 @@ LogicalDevice::presentationQueue() {
     return mPresentationQueue;
 }
 
+bool
+LogicalDevice::isExtensionEnabled(const char* extensionName) {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    assert(extensionName != nullptr);
+
+    for (const std::string& enabledExtensionName : mEnabledExtensionNames) {
+        if (enabledExtensionName == extensionName) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const vk::PhysicalDeviceFeatures&
+LogicalDevice::enabledFeatures() {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    return mEnabledFeatures;
+}
+
+bool
+LogicalDevice::isGraphicsPipelineLibraryEnabled() {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    return mIsGraphicsPipelineLibraryEnabled;
+}
+
+bool
+LogicalDevice::isExtendedDynamicStateEnabled() {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    return mIsExtendedDynamicStateEnabled;
+}
+
+bool
+LogicalDevice::isExtendedDynamicState2Enabled() {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    return mIsExtendedDynamicState2Enabled;
+}
+
+bool
+LogicalDevice::isExtendedDynamicState3Enabled() {
+    assert(mLogicalDevice != VK_NULL_HANDLE);
+    return mIsExtendedDynamicState3Enabled;
+}
+
 void
 LogicalDevice::initLogicalDevice(const std::vector<const char*>& deviceExtensionNames) {
     assert(mLogicalDevice == VK_NULL_HANDLE);
-    assert(deviceExtensionNames.empty() == false);
 
     const float queuePriority = 1.0f;
     const std::vector<vk::DeviceQueueCreateInfo> infoVector = queuesCreateInfo(queuePriority);
     assert(infoVector.empty() == false);
     
-    vk::PhysicalDeviceFeatures physicalDeviceFeatures;
-    physicalDeviceFeatures.setSamplerAnisotropy(VK_TRUE);
+    const vk::PhysicalDeviceFeatures supportedFeatures = PhysicalDevice::device().getFeatures();
+
+    mEnabledFeatures = vk::PhysicalDeviceFeatures();
+    mEnabledFeatures.setSamplerAnisotropy(VK_TRUE);
+
+    // Optional: used by the Profiler
+    mEnabledFeatures.setPipelineStatisticsQuery(supportedFeatures.pipelineStatisticsQuery);
 
     vk::DeviceCreateInfo info;
-    info.setPEnabledFeatures(&physicalDeviceFeatures);
+    info.setPEnabledFeatures(&mEnabledFeatures);
+
+    // Features of the optional extensions are chained in info.pNext.
+    // An extension can only be used if its features are supported too.
+    void* enabledFeaturesChain = nullptr;
+
+    // Optional: used by the PipelineSystem to link pipeline variants.
+    mIsGraphicsPipelineLibraryEnabled = false;
+#ifdef VK_EXT_graphics_pipeline_library
+    vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures;
+    if (isExtensionRequested(deviceExtensionNames, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        querySupportedFeatures(graphicsPipelineLibraryFeatures);
+        if (graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE) {
+            graphicsPipelineLibraryFeatures.setPNext(enabledFeaturesChain);
+            enabledFeaturesChain = &graphicsPipelineLibraryFeatures;
+            mIsGraphicsPipelineLibraryEnabled = true;
+        }
+    }
+#endif
+
+    // Optional: used by the ExtendedDynamicState
+    mIsExtendedDynamicStateEnabled = false;
+    mIsExtendedDynamicState2Enabled = false;
+    mIsExtendedDynamicState3Enabled = false;
+#ifdef VK_EXT_extended_dynamic_state
+    vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures;
+    if (isExtensionRequested(deviceExtensionNames, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        querySupportedFeatures(extendedDynamicStateFeatures);
+        if (extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE) {
+            extendedDynamicStateFeatures.setPNext(enabledFeaturesChain);
+            enabledFeaturesChain = &extendedDynamicStateFeatures;
+            mIsExtendedDynamicStateEnabled = true;
+        }
+    }
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+    vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2Features;
+    if (isExtensionRequested(deviceExtensionNames, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+        querySupportedFeatures(extendedDynamicState2Features);
+        if (extendedDynamicState2Features.extendedDynamicState2 == VK_TRUE) {
+            // The optional logic op and patch control points states are not used.
+            extendedDynamicState2Features.setExtendedDynamicState2LogicOp(VK_FALSE);
+            extendedDynamicState2Features.setExtendedDynamicState2PatchControlPoints(VK_FALSE);
+            extendedDynamicState2Features.setPNext(enabledFeaturesChain);
+            enabledFeaturesChain = &extendedDynamicState2Features;
+            mIsExtendedDynamicState2Enabled = true;
+        }
+    }
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+    // Only the polygon mode and depth clamp states are used.
+    vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features;
+    if (isExtensionRequested(deviceExtensionNames, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+        querySupportedFeatures(extendedDynamicState3Features);
+        if (extendedDynamicState3Features.extendedDynamicState3PolygonMode == VK_TRUE &&
+            extendedDynamicState3Features.extendedDynamicState3DepthClampEnable == VK_TRUE) {
+            vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT enabledFeatures;
+            enabledFeatures.setExtendedDynamicState3PolygonMode(VK_TRUE);
+            enabledFeatures.setExtendedDynamicState3DepthClampEnable(VK_TRUE);
+            extendedDynamicState3Features = enabledFeatures;
+            extendedDynamicState3Features.setPNext(enabledFeaturesChain);
+            enabledFeaturesChain = &extendedDynamicState3Features;
+            mIsExtendedDynamicState3Enabled = true;
+        }
+    }
+#endif
+
+    info.setPNext(enabledFeaturesChain);
+
     info.setEnabledExtensionCount(static_cast<uint32_t>(deviceExtensionNames.size()));
-    info.setPpEnabledExtensionNames(deviceExtensionNames.data());
+    info.setPpEnabledExtensionNames(deviceExtensionNames.empty() ? nullptr : deviceExtensionNames.data());
     info.setQueueCreateInfoCount(static_cast<uint32_t>(infoVector.size()));
     info.setPQueueCreateInfos(infoVector.data());
     
     mLogicalDevice = PhysicalDevice::device().createDevice(info);
+
+    mEnabledExtensionNames.assign(deviceExtensionNames.begin(),
+                                  deviceExtensionNames.end());
 }
 
 std::vector<vk::DeviceQueueCreateInfo>
 LogicalDevice::queuesCreateInfo(const float& queuePriority) {
-    std::vector<vk::DeviceQueueCreateInfo> infoVector;
+    // A queue family can only have one create info, and the graphics,
+    // presentation and transfer queues can share queue families in any combination.
+    const std::set<uint32_t> queueFamilyIndices = {
+        PhysicalDevice::graphicsQueueFamilyIndex(),
+        PhysicalDevice::presentationQueueFamilyIndex(),
+        PhysicalDevice::transferQueueFamilyIndex(),
+    };
 
-    vk::DeviceQueueCreateInfo info;
-    info.setQueueFamilyIndex(PhysicalDevice::graphicsQueueFamilyIndex());
-    info.setQueueCount(1);
-    info.setPQueuePriorities(&queuePriority);
-    infoVector.emplace_back(info);
-
-    // If graphics and presentation queue family indices are different, 
-    // we add a new create info for presentation queue.
-    if (PhysicalDevice::graphicsQueueFamilyIndex() !=
-        PhysicalDevice::presentationQueueFamilyIndex()) {
-        info.setQueueFamilyIndex(PhysicalDevice::presentationQueueFamilyIndex());
-        infoVector.emplace_back(info);
-
-        // If presentation and transfer queue family indices are different,
-        // then we add a new create info for transfer queue.
-        if (PhysicalDevice::presentationQueueFamilyIndex() !=
-            PhysicalDevice::transferQueueFamilyIndex()) {
-            info.setQueueFamilyIndex(PhysicalDevice::transferQueueFamilyIndex());
-            infoVector.emplace_back(info);
-        }
-    } else if (PhysicalDevice::graphicsQueueFamilyIndex() !=
-               PhysicalDevice::transferQueueFamilyIndex()) {
-        // If graphics and transfer queue family indices are different,
-        // then we add a new create info for transfer queue.
-        info.setQueueFamilyIndex(PhysicalDevice::transferQueueFamilyIndex());
+    std::vector<vk::DeviceQueueCreateInfo> infoVector;
+    for (const uint32_t queueFamilyIndex : queueFamilyIndices) {
+        vk::DeviceQueueCreateInfo info;
+        info.setQueueFamilyIndex(queueFamilyIndex);
+        info.setQueueCount(1);
+        info.setPQueuePriorities(&queuePriority);
         infoVector.emplace_back(info);
     }
 
@@ -1,6 +1,7 @@
 #ifndef UTILS_DEVICE_LOGICAL_DEVICE
 #define UTILS_DEVICE_LOGICAL_DEVICE
 
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
@@ -65,6 +66,32 @@ public:
     static vk::Queue
     presentationQueue();   
 
+    // Extensions given to initialize()
+    static bool
+    isExtensionEnabled(const char* extensionName);
+
+    // Optional features are enabled if the physical device supports them.
+    static const vk::PhysicalDeviceFeatures&
+    enabledFeatures();
+
+    // True if VK_EXT_graphics_pipeline_library and its feature are enabled.
+    // It is always false if the Vulkan headers do not define the extension.
+    static bool
+    isGraphicsPipelineLibraryEnabled();
+
+    // True if the extension and the features used by the ExtendedDynamicState
+    // are enabled. They are always false if the Vulkan headers do not
+    // define the extension.
+    static bool
+    isExtendedDynamicStateEnabled();
+
+    static bool
+    isExtendedDynamicState2Enabled();
+
+    // Only the polygon mode and depth clamp enable states.
+    static bool
+    isExtendedDynamicState3Enabled();
+
 private:
     LogicalDevice() = delete;
     ~LogicalDevice() = delete;
@@ -91,6 +118,13 @@ private:
     static vk::Queue mGraphicsQueue;
     static vk::Queue mTransferQueue;
     static vk::Queue mPresentationQueue;
+
+    static std::vector<std::string> mEnabledExtensionNames;
+    static vk::PhysicalDeviceFeatures mEnabledFeatures;
+    static bool mIsGraphicsPipelineLibraryEnabled;
+    static bool mIsExtendedDynamicStateEnabled;
+    static bool mIsExtendedDynamicState2Enabled;
+    static bool mIsExtendedDynamicState3Enabled;
 };
 }
 
@@ -1,6 +1,7 @@
 #include "PhysicalDevice.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "../Instance.h"
 
@@ -21,8 +22,6 @@ std::vector<const char*> mDeviceExtensions;
 
 void
 PhysicalDevice::initialize(const std::vector<const char*>& deviceExtensionNames) {
-    assert(deviceExtensionNames.empty() == false);
-
     const std::vector<PhysicalDeviceData> candidatePhysicalDevices = 
         Instance::getSupportedPhysicalDevices(deviceExtensionNames);
 
@@ -121,4 +120,51 @@ bool
 PhysicalDevice::isValidMemoryTypeIndex(const uint32_t memoryTypeIndex) {
     return memoryTypeIndex != std::numeric_limits<uint32_t>::max();
 }
+
+bool
+PhysicalDevice::isFeatures2Supported() {
+    assert(mPhysicalDevice != VK_NULL_HANDLE);
+
+    return isVulkan11Supported() ||
+           Instance::isExtensionEnabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+}
+
+void
+PhysicalDevice::getFeatures2(vk::PhysicalDeviceFeatures2& features) {
+    assert(isFeatures2Supported());
+
+    if (isVulkan11Supported()) {
+        mPhysicalDevice.getFeatures2(&features);
+    } else {
+        // Extension functions are not loaded by the default dispatcher.
+        vk::DispatchLoaderDynamic dispatcher;
+        dispatcher.init(static_cast<VkInstance>(Instance::instance()),
+                        vkGetInstanceProcAddr);
+        mPhysicalDevice.getFeatures2KHR(&features,
+                                        dispatcher);
+    }
+}
+
+bool
+PhysicalDevice::isVulkan11Supported() {
+    assert(mPhysicalDevice != VK_NULL_HANDLE);
+
+    return Instance::apiVersion() >= VK_API_VERSION_1_1 &&
+           mPhysicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_1;
+}
+
+bool
+PhysicalDevice::isExtensionSupported(const char* extensionName) {
+    assert(mPhysicalDevice != VK_NULL_HANDLE);
+    assert(extensionName != nullptr);
+
+    for (const vk::ExtensionProperties& property :
+         mPhysicalDevice.enumerateDeviceExtensionProperties()) {
+        if (std::strcmp(property.extensionName, extensionName) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
 }
\ No newline at end of file
@@ -91,12 +91,33 @@ public:
     static bool
     isValidMemoryTypeIndex(const uint32_t memoryTypeIndex);
 
+    // Used to check optional device extensions before
+    // the logical device is created.
+    static bool
+    isExtensionSupported(const char* extensionName);
+
+    // True if the features of extensions can be queried (getFeatures2()), which
+    // the optional device extensions require: both the instance and the physical
+    // device support Vulkan 1.1, or VK_KHR_get_physical_device_properties2 is enabled.
+    static bool
+    isFeatures2Supported();
+
+    // vkGetPhysicalDeviceFeatures2, or vkGetPhysicalDeviceFeatures2KHR
+    // if the physical device only supports Vulkan 1.0.
+    // Precondition: isFeatures2Supported()
+    static void
+    getFeatures2(vk::PhysicalDeviceFeatures2& features);
+
 private:           
     PhysicalDevice() = delete;
     PhysicalDevice(PhysicalDevice&& other) = delete;
     PhysicalDevice(const PhysicalDevice&) = delete;
     const PhysicalDevice& operator=(const PhysicalDevice&) = delete;
 
+    // Core functions of Vulkan 1.1 can be used with the physical device.
+    static bool
+    isVulkan11Supported();
+
     static vk::PhysicalDevice mPhysicalDevice;
 
     static uint32_t mGraphicsQueueFamilyIndex;
@@ -72,24 +72,66 @@ bool
 PhysicalDeviceData::isTransferQueueFamilySupported() {
     assert(mPhysicalDevice != VK_NULL_HANDLE);
     
-    mTransferQueueFamilyIndex = 0;
+    // The graphics queue family always supports transfer operations,
+    // so it is the fallback if there is no better queue family.
+    mTransferQueueFamilyIndex = mGraphicsQueueFamilyIndex;
+    uint32_t bestScore = 0;
+
+    uint32_t queueFamilyIndex = 0;
     for (const vk::QueueFamilyProperties& property : 
          mPhysicalDevice.getQueueFamilyProperties()) {
-        if (property.queueCount > 0 &&
-            property.queueFlags & vk::QueueFlagBits::eTransfer) {
-            return true;
+        const uint32_t score = transferQueueFamilyScore(property);
+        if (score > bestScore) {
+            bestScore = score;
+            mTransferQueueFamilyIndex = queueFamilyIndex;
         }
 
-        ++mTransferQueueFamilyIndex;
+        ++queueFamilyIndex;
     }
 
-    return false;
+    return true;
+}
+
+uint32_t
+PhysicalDeviceData::transferQueueFamilyScore(const vk::QueueFamilyProperties& property) {
+    // Staging uploads copy groups of rows of an image (Read StagingRing),
+    // so the queue family must support any image offset and extent.
+    if (property.queueCount == 0 ||
+        property.minImageTransferGranularity != vk::Extent3D(1, 1, 1)) {
+        return 0;
+    }
+
+    const bool hasGraphics = (property.queueFlags & vk::QueueFlagBits::eGraphics) == vk::QueueFlagBits::eGraphics;
+    const bool hasCompute = (property.queueFlags & vk::QueueFlagBits::eCompute) == vk::QueueFlagBits::eCompute;
+    const bool hasTransfer = (property.queueFlags & vk::QueueFlagBits::eTransfer) == vk::QueueFlagBits::eTransfer;
+
+    // Transfer only queue families are usually backed by the DMA engines, 
+    // that can copy while the graphics queue is rendering.
+    if (hasTransfer && hasGraphics == false && hasCompute == false) {
+        return 2;
+    }
+
+    // Async compute queue families also run in parallel with the graphics queue.
+    // They support transfer operations even if the bit is not reported.
+    if (hasCompute && hasGraphics == false) {
+        return 1;
+    }
+
+    return 0;
 }
 
 bool
 PhysicalDeviceData::isPresentationSupported() {
     assert(mPhysicalDevice != VK_NULL_HANDLE);
 
+    // In headless mode, there is no surface to present to.
+    // The presentation queue is the graphics queue, that is never
+    // used to present.
+    if (Window::isHeadless()) {
+        mPresentationQueueFamilyIndex = mGraphicsQueueFamilyIndex;
+        return true;
+    }
+
     mPresentationQueueFamilyIndex = 0;
     for (const vk::QueueFamilyProperties& property : 
          mPhysicalDevice.getQueueFamilyProperties()) {
@@ -130,6 +172,12 @@ PhysicalDeviceData::areDeviceExtensionsSupported(const std::vector<const char*>&
 bool
 PhysicalDeviceData::isSwapChainSupported() const {
     assert(mPhysicalDevice != VK_NULL_HANDLE);
+
+    // In headless mode, the SwapChain renders into offscreen images.
+    if (Window::isHeadless()) {
+        return true;
+    }
+
     return mPhysicalDevice.getSurfaceFormatsKHR(Window::surface()).empty() == false &&
            mPhysicalDevice.getSurfacePresentModesKHR(Window::surface()).empty() == false;
 }
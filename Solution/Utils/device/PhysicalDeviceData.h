@@ -12,6 +12,7 @@ namespace vulkan {
 // The responsibility of this class is to check if the
 // physical device supports the surface, device extensions,
 // and the different queue families.
+// In headless mode (Read Window), the surface is not checked.
 //
 // This class is used internally by PhysicalDevice to 
 // get information about all the candidate physical devices
@@ -44,9 +45,18 @@ private:
     bool
     isGraphicQueueFamilySupported();
 
+    // It must be called after isGraphicQueueFamilySupported().
+    // It prefers transfer only queue families, then async compute
+    // queue families, and then the graphics queue family.
     bool
     isTransferQueueFamilySupported();
 
+    // 0 if the queue family is not better than the graphics queue family
+    // for transfer operations. The higher, the better.
+    static uint32_t
+    transferQueueFamilyScore(const vk::QueueFamilyProperties& property);
+
+    // It must be called after isGraphicQueueFamilySupported().
     bool
     isPresentationSupported();
 
@@ -0,0 +1,437 @@
+#include "DeviceMemoryAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "TlsfAllocator.h"
+#include "../device/LogicalDevice.h"
+#include "../device/PhysicalDevice.h"
+
+namespace {
+// Blocks of heaps bigger than this use DefaultBlockSize.
+// Smaller heaps use an eighth of their size, so a few
+// blocks cannot exhaust the whole heap.
+const vk::DeviceSize SmallHeapMaxSize = 1024ull * 1024 * 1024;
+const vk::DeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+vk::DeviceSize
+alignUp(const vk::DeviceSize value,
+        const vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+vk::DeviceSize
+alignDown(const vk::DeviceSize value,
+          const vk::DeviceSize alignment) {
+    return value / alignment * alignment;
+}
+}
+
+namespace vulkan {
+//
+// Big DeviceMemory that is sub-allocated to many resources.
+//
+struct DeviceMemoryBlock {
+    DeviceMemoryBlock(const vk::DeviceMemory deviceMemory,
+                      const vk::DeviceSize size,
+                      const uint32_t memoryTypeIndex,
+                      const uint32_t blockListIndex,
+                      void* mappedData)
+        : mDeviceMemory(deviceMemory)
+        , mMemoryTypeIndex(memoryTypeIndex)
+        , mBlockListIndex(blockListIndex)
+        , mMappedData(mappedData)
+        , mAllocator(size)
+    {
+
+    }
+
+    vk::DeviceMemory mDeviceMemory;
+    uint32_t mMemoryTypeIndex = 0;
+    uint32_t mBlockListIndex = 0;
+    void* mMappedData = nullptr;
+    TlsfAllocator mAllocator;
+};
+
+bool
+DeviceMemoryAllocation::isValid() const {
+    return mDeviceMemory != VK_NULL_HANDLE;
+}
+
+float
+MemoryHeapStatistics::fragmentation() const {
+    const vk::DeviceSize freeBytes = mBlockBytes - mUsedBlockBytes;
+    if (freeBytes == 0) {
+        return 0.0f;
+    }
+
+    return 1.0f - static_cast<float>(mLargestFreeRange) / static_cast<float>(freeBytes);
+}
+
+vk::PhysicalDeviceMemoryProperties
+DeviceMemoryAllocator::mMemoryProperties = {};
+
+vk::DeviceSize
+DeviceMemoryAllocator::mNonCoherentAtomSize = 1;
+
+uint32_t
+DeviceMemoryAllocator::mMaxDeviceMemoryCount = 0;
+
+uint32_t
+DeviceMemoryAllocator::mDeviceMemoryCount = 0;
+
+std::vector<DeviceMemoryAllocator::Blocks>
+DeviceMemoryAllocator::mBlockLists = {};
+
+std::vector<uint32_t>
+DeviceMemoryAllocator::mDedicatedCountByMemoryType = {};
+
+std::vector<vk::DeviceSize>
+DeviceMemoryAllocator::mDedicatedBytesByMemoryType = {};
+
+std::mutex
+DeviceMemoryAllocator::mMutex;
+
+void
+DeviceMemoryAllocator::initialize() {
+    assert(mBlockLists.empty());
+
+    mMemoryProperties = PhysicalDevice::device().getMemoryProperties();
+
+    const vk::PhysicalDeviceProperties properties = PhysicalDevice::device().getProperties();
+    mNonCoherentAtomSize = std::max(properties.limits.nonCoherentAtomSize,
+                                    vk::DeviceSize(1));
+    mMaxDeviceMemoryCount = properties.limits.maxMemoryAllocationCount;
+    mDeviceMemoryCount = 0;
+
+    mBlockLists.resize(mMemoryProperties.memoryTypeCount * 2);
+    mDedicatedCountByMemoryType.resize(mMemoryProperties.memoryTypeCount, 0);
+    mDedicatedBytesByMemoryType.resize(mMemoryProperties.memoryTypeCount, 0);
+}
+
+void
+DeviceMemoryAllocator::finalize() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (Blocks& blocks : mBlockLists) {
+        for (std::unique_ptr<DeviceMemoryBlock>& block : blocks) {
+            // Every resource must be destroyed before the allocator.
+            assert(block->mAllocator.isEmpty());
+            freeDeviceMemory(block->mDeviceMemory,
+                             block->mMappedData);
+        }
+    }
+
+    assert(std::all_of(mDedicatedCountByMemoryType.begin(),
+                       mDedicatedCountByMemoryType.end(),
+                       [](const uint32_t count) { return count == 0; }));
+
+    mBlockLists.clear();
+    mDedicatedCountByMemoryType.clear();
+    mDedicatedBytesByMemoryType.clear();
+}
+
+DeviceMemoryAllocation
+DeviceMemoryAllocator::allocate(const vk::MemoryRequirements& memoryRequirements,
+                                const vk::MemoryPropertyFlags memoryPropertyFlags,
+                                const ResourceTiling resourceTiling) {
+    assert(memoryRequirements.size > 0);
+    assert(mBlockLists.empty() == false);
+
+    uint32_t memoryTypeIndex = PhysicalDevice::memoryTypeIndex(memoryRequirements.memoryTypeBits,
+                                                               memoryPropertyFlags);
+
+    // Lazily allocated memory is only a preference. Tile-based GPUs
+    // can keep transient attachments in on-chip memory, but other
+    // GPUs do not expose this memory type.
+    if (PhysicalDevice::isValidMemoryTypeIndex(memoryTypeIndex) == false &&
+        memoryPropertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated) {
+        memoryTypeIndex = PhysicalDevice::memoryTypeIndex(memoryRequirements.memoryTypeBits,
+                                                          memoryPropertyFlags & 
+                                                          ~vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eLazilyAllocated));
+    }
+    assert(PhysicalDevice::isValidMemoryTypeIndex(memoryTypeIndex));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const vk::DeviceSize size = memoryRequirements.size;
+    if (size > blockSize(memoryTypeIndex) / 2) {
+        return allocateDedicated(size,
+                                 memoryTypeIndex);
+    }
+
+    // Allocations in non coherent memory are aligned to nonCoherentAtomSize,
+    // so flush() of an allocation never needs to touch its neighbours.
+    vk::DeviceSize alignment = std::max(memoryRequirements.alignment,
+                                        vk::DeviceSize(1));
+    if (isHostCoherent(memoryTypeIndex) == false) {
+        alignment = std::max(alignment,
+                             mNonCoherentAtomSize);
+    }
+
+    DeviceMemoryAllocation allocation;
+    allocation.mMemoryTypeIndex = memoryTypeIndex;
+    allocation.mSize = size;
+
+    Blocks& blocks = mBlockLists[blockListIndex(memoryTypeIndex,
+                                                resourceTiling)];
+    for (std::unique_ptr<DeviceMemoryBlock>& block : blocks) {
+        allocation.mRangeHandle = block->mAllocator.allocate(size,
+                                                             alignment,
+                                                             allocation.mOffset);
+        if (allocation.mRangeHandle != TlsfAllocator::InvalidHandle) {
+            allocation.mBlock = block.get();
+            break;
+        }
+    }
+
+    // There is no block with enough contiguous free space.
+    if (allocation.mBlock == nullptr) {
+        DeviceMemoryBlock* block = createBlock(memoryTypeIndex,
+                                               resourceTiling);
+        allocation.mRangeHandle = block->mAllocator.allocate(size,
+                                                             alignment,
+                                                             allocation.mOffset);
+        assert(allocation.mRangeHandle != TlsfAllocator::InvalidHandle);
+        allocation.mBlock = block;
+    }
+
+    allocation.mDeviceMemory = allocation.mBlock->mDeviceMemory;
+    if (allocation.mBlock->mMappedData != nullptr) {
+        allocation.mMappedData = static_cast<char*>(allocation.mBlock->mMappedData) + allocation.mOffset;
+    }
+
+    return allocation;
+}
+
+void
+DeviceMemoryAllocator::free(DeviceMemoryAllocation& allocation) {
+    if (allocation.isValid() == false) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (allocation.mBlock == nullptr) {
+        freeDeviceMemory(allocation.mDeviceMemory,
+                         allocation.mMappedData);
+        assert(mDedicatedCountByMemoryType[allocation.mMemoryTypeIndex] > 0);
+        --mDedicatedCountByMemoryType[allocation.mMemoryTypeIndex];
+        mDedicatedBytesByMemoryType[allocation.mMemoryTypeIndex] -= allocation.mSize;
+    } else {
+        DeviceMemoryBlock* block = allocation.mBlock;
+        block->mAllocator.free(allocation.mRangeHandle);
+
+        // We keep one empty block per memory type, to avoid
+        // allocating and freeing DeviceMemory again and again when
+        // a resource is created and destroyed every frame.
+        Blocks& blocks = mBlockLists[block->mBlockListIndex];
+        if (block->mAllocator.isEmpty() && blocks.size() > 1) {
+            Blocks::iterator findIt = std::find_if(blocks.begin(),
+                                                   blocks.end(),
+                                                   [block](const std::unique_ptr<DeviceMemoryBlock>& candidate) {
+                                                       return candidate.get() == block;
+                                                   });
+            assert(findIt != blocks.end());
+            freeDeviceMemory(block->mDeviceMemory,
+                             block->mMappedData);
+            blocks.erase(findIt);
+        }
+    }
+
+    allocation = DeviceMemoryAllocation();
+}
+
+void
+DeviceMemoryAllocator::flush(const DeviceMemoryAllocation& allocation,
+                             const vk::DeviceSize offset,
+                             const vk::DeviceSize size) {
+    assert(allocation.isValid());
+    assert(allocation.mMappedData != nullptr);
+    assert(offset + size <= allocation.mSize);
+
+    if (isHostCoherent(allocation.mMemoryTypeIndex)) {
+        return;
+    }
+
+    // The flushed range must be a multiple of nonCoherentAtomSize,
+    // and it cannot go beyond the end of the DeviceMemory.
+    const vk::DeviceSize deviceMemorySize = allocation.mBlock != nullptr ?
+                                            allocation.mBlock->mAllocator.size() :
+                                            allocation.mSize;
+    const vk::DeviceSize beginOffset = alignDown(allocation.mOffset + offset,
+                                                 mNonCoherentAtomSize);
+    const vk::DeviceSize endOffset = std::min(alignUp(allocation.mOffset + offset + size,
+                                                      mNonCoherentAtomSize),
+                                              deviceMemorySize);
+
+    vk::MappedMemoryRange range;
+    range.setMemory(allocation.mDeviceMemory);
+    range.setOffset(beginOffset);
+    range.setSize(endOffset == deviceMemorySize ? VK_WHOLE_SIZE : endOffset - beginOffset);
+    LogicalDevice::device().flushMappedMemoryRanges({range});
+}
+
+bool
+DeviceMemoryAllocator::isHostCoherent(const uint32_t memoryTypeIndex) {
+    assert(memoryTypeIndex < mMemoryProperties.memoryTypeCount);
+    return static_cast<bool>(mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+                             vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+
+std::vector<MemoryHeapStatistics>
+DeviceMemoryAllocator::heapStatistics() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<MemoryHeapStatistics> statistics(mMemoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+        statistics[i].mHeapIndex = i;
+        statistics[i].mHeapSize = mMemoryProperties.memoryHeaps[i].size;
+    }
+
+    for (const Blocks& blocks : mBlockLists) {
+        for (const std::unique_ptr<DeviceMemoryBlock>& block : blocks) {
+            const uint32_t heapIndex = mMemoryProperties.memoryTypes[block->mMemoryTypeIndex].heapIndex;
+            MemoryHeapStatistics& heapStatistics = statistics[heapIndex];
+
+            const TlsfAllocator& allocator = block->mAllocator;
+            ++heapStatistics.mBlockCount;
+            heapStatistics.mAllocationCount += allocator.allocationCount();
+            heapStatistics.mBlockBytes += allocator.size();
+            heapStatistics.mUsedBlockBytes += allocator.usedSize();
+            heapStatistics.mFreeRangeCount += allocator.freeRangeCount();
+            heapStatistics.mLargestFreeRange = std::max(heapStatistics.mLargestFreeRange,
+                                                        allocator.largestFreeRangeSize());
+        }
+    }
+
+    for (uint32_t memoryTypeIndex = 0;
+         memoryTypeIndex < mMemoryProperties.memoryTypeCount;
+         ++memoryTypeIndex) {
+        const uint32_t heapIndex = mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        MemoryHeapStatistics& heapStatistics = statistics[heapIndex];
+        heapStatistics.mDedicatedAllocationCount += mDedicatedCountByMemoryType[memoryTypeIndex];
+        heapStatistics.mDedicatedBytes += mDedicatedBytesByMemoryType[memoryTypeIndex];
+    }
+
+    for (MemoryHeapStatistics& heapStatistics : statistics) {
+        heapStatistics.mDeviceMemoryCount = heapStatistics.mBlockCount +
+                                            heapStatistics.mDedicatedAllocationCount;
+    }
+
+    return statistics;
+}
+
+void
+DeviceMemoryAllocator::printStatistics(std::ostream& stream) {
+    const std::vector<MemoryHeapStatistics> statistics = heapStatistics();
+
+    for (const MemoryHeapStatistics& heapStatistics : statistics) {
+        stream << "Memory heap " << heapStatistics.mHeapIndex
+               << " (" << heapStatistics.mHeapSize / (1024 * 1024) << " MiB)" << std::endl
+               << "  DeviceMemory count: " << heapStatistics.mDeviceMemoryCount
+               << " (blocks: " << heapStatistics.mBlockCount
+               << ", dedicated: " << heapStatistics.mDedicatedAllocationCount << ")" << std::endl
+               << "  Sub-allocations: " << heapStatistics.mAllocationCount << std::endl
+               << "  Block bytes: " << heapStatistics.mBlockBytes
+               << " (used: " << heapStatistics.mUsedBlockBytes << ")" << std::endl
+               << "  Dedicated bytes: " << heapStatistics.mDedicatedBytes << std::endl
+               << "  Free ranges: " << heapStatistics.mFreeRangeCount
+               << " (largest: " << heapStatistics.mLargestFreeRange << ")" << std::endl
+               << "  Fragmentation: " << heapStatistics.fragmentation() << std::endl;
+    }
+}
+
+vk::DeviceSize
+DeviceMemoryAllocator::blockSize(const uint32_t memoryTypeIndex) {
+    assert(memoryTypeIndex < mMemoryProperties.memoryTypeCount);
+
+    const uint32_t heapIndex = mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    const vk::DeviceSize heapSize = mMemoryProperties.memoryHeaps[heapIndex].size;
+
+    return heapSize <= SmallHeapMaxSize ? heapSize / 8 : DefaultBlockSize;
+}
+
+DeviceMemoryAllocation
+DeviceMemoryAllocator::allocateDedicated(const vk::DeviceSize size,
+                                         const uint32_t memoryTypeIndex) {
+    DeviceMemoryAllocation allocation;
+    allocation.mDeviceMemory = allocateDeviceMemory(size,
+                                                    memoryTypeIndex,
+                                                    allocation.mMappedData);
+    allocation.mSize = size;
+    allocation.mMemoryTypeIndex = memoryTypeIndex;
+
+    ++mDedicatedCountByMemoryType[memoryTypeIndex];
+    mDedicatedBytesByMemoryType[memoryTypeIndex] += size;
+
+    return allocation;
+}
+
+DeviceMemoryBlock*
+DeviceMemoryAllocator::createBlock(const uint32_t memoryTypeIndex,
+                                   const ResourceTiling resourceTiling) {
+    const vk::DeviceSize size = blockSize(memoryTypeIndex);
+
+    void* mappedData = nullptr;
+    const vk::DeviceMemory deviceMemory = allocateDeviceMemory(size,
+                                                               memoryTypeIndex,
+                                                               mappedData);
+
+    const uint32_t listIndex = blockListIndex(memoryTypeIndex,
+                                              resourceTiling);
+    Blocks& blocks = mBlockLists[listIndex];
+    blocks.emplace_back(new DeviceMemoryBlock(deviceMemory,
+                                              size,
+                                              memoryTypeIndex,
+                                              listIndex,
+                                              mappedData));
+    return blocks.back().get();
+}
+
+uint32_t
+DeviceMemoryAllocator::blockListIndex(const uint32_t memoryTypeIndex,
+                                      const ResourceTiling resourceTiling) {
+    assert(memoryTypeIndex < mMemoryProperties.memoryTypeCount);
+    return memoryTypeIndex * 2 + (resourceTiling == ResourceTiling::Optimal ? 1 : 0);
+}
+
+vk::DeviceMemory
+DeviceMemoryAllocator::allocateDeviceMemory(const vk::DeviceSize size,
+                                            const uint32_t memoryTypeIndex,
+                                            void*& mappedData) {
+    assert(mDeviceMemoryCount < mMaxDeviceMemoryCount);
+
+    vk::MemoryAllocateInfo info;
+    info.setAllocationSize(size);
+    info.setMemoryTypeIndex(memoryTypeIndex);
+    const vk::DeviceMemory deviceMemory = LogicalDevice::device().allocateMemory(info);
+    ++mDeviceMemoryCount;
+
+    // Host visible memory is mapped once for the whole lifetime
+    // of the DeviceMemory.
+    mappedData = nullptr;
+    if (mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+        vk::MemoryPropertyFlagBits::eHostVisible) {
+        mappedData = LogicalDevice::device().mapMemory(deviceMemory,
+                                                       0,
+                                                       VK_WHOLE_SIZE);
+    }
+
+    return deviceMemory;
+}
+
+void
+DeviceMemoryAllocator::freeDeviceMemory(const vk::DeviceMemory deviceMemory,
+                                        const void* mappedData) {
+    assert(deviceMemory != VK_NULL_HANDLE);
+    assert(mDeviceMemoryCount > 0);
+
+    if (mappedData != nullptr) {
+        LogicalDevice::device().unmapMemory(deviceMemory);
+    }
+
+    LogicalDevice::device().freeMemory(deviceMemory);
+    --mDeviceMemoryCount;
+}
+}
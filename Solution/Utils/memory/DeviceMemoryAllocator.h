@@ -0,0 +1,192 @@
+#ifndef UTILS_MEMORY_DEVICE_MEMORY_ALLOCATOR
+#define UTILS_MEMORY_DEVICE_MEMORY_ALLOCATOR
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+struct DeviceMemoryBlock;
+
+//
+// Resources with linear layout (buffers and linear tiling images) and
+// resources with optimal layout (optimal tiling images) are placed in
+// different blocks, so neighbour resources never need to be separated by
+// vk::PhysicalDeviceLimits::bufferImageGranularity.
+//
+enum class ResourceTiling {
+    Linear,
+    Optimal
+};
+
+//
+// Piece of DeviceMemory returned by the DeviceMemoryAllocator.
+//
+// Resources must be bound to mDeviceMemory at mOffset.
+//
+struct DeviceMemoryAllocation {
+    bool
+    isValid() const;
+
+    vk::DeviceMemory mDeviceMemory;
+    vk::DeviceSize mOffset = 0;
+    vk::DeviceSize mSize = 0;
+
+    // Host address of mOffset.
+    // It is nullptr if the memory type is not host visible.
+    void* mMappedData = nullptr;
+
+    uint32_t mMemoryTypeIndex = std::numeric_limits<uint32_t>::max();
+
+    // Block that owns this allocation and the handle of the range
+    // inside it. mBlock is nullptr for dedicated allocations.
+    DeviceMemoryBlock* mBlock = nullptr;
+    uint32_t mRangeHandle = std::numeric_limits<uint32_t>::max();
+};
+
+//
+// Statistics of a memory heap of the global physical device.
+//
+struct MemoryHeapStatistics {
+    // Ratio (between 0 and 1) of the free memory that cannot be used
+    // by a single allocation because it is not contiguous.
+    float
+    fragmentation() const;
+
+    uint32_t mHeapIndex = 0;
+    vk::DeviceSize mHeapSize = 0;
+
+    // vkAllocateMemory calls alive (blocks + dedicated allocations)
+    uint32_t mDeviceMemoryCount = 0;
+    uint32_t mBlockCount = 0;
+    uint32_t mDedicatedAllocationCount = 0;
+
+    // Sub-allocations alive inside the blocks.
+    uint32_t mAllocationCount = 0;
+
+    vk::DeviceSize mBlockBytes = 0;
+    vk::DeviceSize mUsedBlockBytes = 0;
+    vk::DeviceSize mDedicatedBytes = 0;
+
+    vk::DeviceSize mLargestFreeRange = 0;
+    uint32_t mFreeRangeCount = 0;
+};
+
+//
+// Global DeviceMemory allocator.
+//
+// Allocation is a costly operation and there is a limit on maximum number
+// of allocations (vk::PhysicalDeviceLimits::maxMemoryAllocationCount,
+// that can be as low as 4096).
+// That is why we do not allocate a DeviceMemory for each resource.
+//
+// Instead, we allocate big DeviceMemory blocks for each memory type, and we
+// sub-allocate them (with TlsfAllocator) to the resources,
+// which are bound at a non-zero offset.
+//
+// Resources that are too big for a block get their own (dedicated) DeviceMemory.
+//
+// Blocks of host visible memory types are persistently mapped, so resources
+// do not need to call vkMapMemory/vkUnmapMemory to write them.
+//
+// Preconditions:
+// - The global logical device must be initialized first.
+//
+class DeviceMemoryAllocator {
+public:
+    static void
+    initialize();
+
+    static void
+    finalize();
+
+    // * memoryRequirements of the resource
+    //   (vkGetBufferMemoryRequirements or vkGetImageMemoryRequirements)
+    //
+    // * memoryPropertyFlags the memory type must have.
+    //   VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT is treated as a preference:
+    //   if there is no lazily allocated memory type (most desktop GPUs),
+    //   then the flag is ignored.
+    //
+    // * resourceTiling of the resource that will be bound to the memory.
+    static DeviceMemoryAllocation
+    allocate(const vk::MemoryRequirements& memoryRequirements,
+             const vk::MemoryPropertyFlags memoryPropertyFlags,
+             const ResourceTiling resourceTiling = ResourceTiling::Linear);
+
+    // The allocation is reset to an invalid allocation.
+    static void
+    free(DeviceMemoryAllocation& allocation);
+
+    // Makes host writes to the mapped memory visible to the device.
+    // It does nothing if the memory type is host coherent.
+    //
+    // * offset is relative to the allocation offset.
+    static void
+    flush(const DeviceMemoryAllocation& allocation,
+          const vk::DeviceSize offset,
+          const vk::DeviceSize size);
+
+    static bool
+    isHostCoherent(const uint32_t memoryTypeIndex);
+
+    static std::vector<MemoryHeapStatistics>
+    heapStatistics();
+
+    static void
+    printStatistics(std::ostream& stream);
+
+private:
+    DeviceMemoryAllocator() = delete;
+    ~DeviceMemoryAllocator() = delete;
+    DeviceMemoryAllocator(DeviceMemoryAllocator&&) noexcept = delete;
+    DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+    const DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+    static vk::DeviceSize
+    blockSize(const uint32_t memoryTypeIndex);
+
+    static DeviceMemoryAllocation
+    allocateDedicated(const vk::DeviceSize size,
+                      const uint32_t memoryTypeIndex);
+
+    static DeviceMemoryBlock*
+    createBlock(const uint32_t memoryTypeIndex,
+                const ResourceTiling resourceTiling);
+
+    static uint32_t
+    blockListIndex(const uint32_t memoryTypeIndex,
+                   const ResourceTiling resourceTiling);
+
+    static vk::DeviceMemory
+    allocateDeviceMemory(const vk::DeviceSize size,
+                         const uint32_t memoryTypeIndex,
+                         void*& mappedData);
+
+    static void
+    freeDeviceMemory(const vk::DeviceMemory deviceMemory,
+                     const void* mappedData);
+
+    static vk::PhysicalDeviceMemoryProperties mMemoryProperties;
+    static vk::DeviceSize mNonCoherentAtomSize;
+    static uint32_t mMaxDeviceMemoryCount;
+    static uint32_t mDeviceMemoryCount;
+
+    // Blocks of each memory type and resource tiling
+    // (Read blockListIndex())
+    using Blocks = std::vector<std::unique_ptr<DeviceMemoryBlock>>;
+    static std::vector<Blocks> mBlockLists;
+
+    // Dedicated allocations count and bytes of each memory type.
+    static std::vector<uint32_t> mDedicatedCountByMemoryType;
+    static std::vector<vk::DeviceSize> mDedicatedBytesByMemoryType;
+
+    static std::mutex mMutex;
+};
+}
+
+#endif
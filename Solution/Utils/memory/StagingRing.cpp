@@ -0,0 +1,228 @@
+#include "StagingRing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "../resource/Buffer.h"
+
+namespace {
+// The alignment does not need to be a power of two.
+vk::DeviceSize
+alignUp(const vk::DeviceSize value,
+        const vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+vk::DeviceSize
+greatestCommonDivisor(vk::DeviceSize a,
+                      vk::DeviceSize b) {
+    while (b != 0) {
+        const vk::DeviceSize remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+vk::DeviceSize
+leastCommonMultiple(const vk::DeviceSize a,
+                    const vk::DeviceSize b) {
+    return a / greatestCommonDivisor(a, b) * b;
+}
+}
+
+namespace vulkan {
+std::unique_ptr<Buffer>
+StagingRing::mBuffer = nullptr;
+
+char*
+StagingRing::mMappedData = nullptr;
+
+vk::DeviceSize
+StagingRing::mChunkSize = 0;
+
+std::vector<TransferTicket>
+StagingRing::mTicketByChunk = {};
+
+uint32_t
+StagingRing::mCurrentChunkIndex = 0;
+
+vk::DeviceSize
+StagingRing::mCurrentChunkOffset = 0;
+
+void
+StagingRing::initialize(const vk::DeviceSize chunkSize,
+                        const uint32_t chunkCount) {
+    assert(mBuffer == nullptr);
+    assert(chunkSize > 0);
+    assert(chunkCount > 1);
+
+    mChunkSize = chunkSize;
+    mBuffer.reset(new Buffer(chunkSize * chunkCount,
+                             vk::BufferUsageFlagBits::eTransferSrc,
+                             vk::MemoryPropertyFlagBits::eHostVisible |
+                             vk::MemoryPropertyFlagBits::eHostCoherent));
+    mMappedData = static_cast<char*>(mBuffer->mappedData());
+    assert(mMappedData != nullptr);
+
+    mTicketByChunk.assign(chunkCount, TransferTicket());
+    mCurrentChunkIndex = 0;
+    mCurrentChunkOffset = 0;
+}
+
+void
+StagingRing::finalize() {
+    if (mBuffer == nullptr) {
+        return;
+    }
+
+    TransferEngine::waitIdle();
+
+    mTicketByChunk.clear();
+    mMappedData = nullptr;
+    mBuffer.reset();
+}
+
+vk::DeviceSize
+StagingRing::chunkSize() {
+    assert(mBuffer != nullptr);
+    return mChunkSize;
+}
+
+StagingRegion
+StagingRing::allocate(const vk::DeviceSize size,
+                      const vk::DeviceSize alignment) {
+    assert(mBuffer != nullptr);
+    assert(size > 0);
+    assert(size <= mChunkSize);
+    assert(alignment > 0);
+
+    // The offset is aligned in the whole buffer, because the chunk size
+    // does not need to be a multiple of the alignment.
+    vk::DeviceSize chunkBegin = mCurrentChunkIndex * mChunkSize;
+    vk::DeviceSize offset = alignUp(chunkBegin + mCurrentChunkOffset,
+                                    alignment) - chunkBegin;
+    if (offset + size > mChunkSize) {
+        moveToNextChunk();
+        chunkBegin = mCurrentChunkIndex * mChunkSize;
+        offset = alignUp(chunkBegin,
+                         alignment) - chunkBegin;
+    }
+    assert(offset + size <= mChunkSize);
+
+    mTicketByChunk[mCurrentChunkIndex] = TransferEngine::currentTicket();
+    mCurrentChunkOffset = offset + size;
+
+    StagingRegion region;
+    region.mBuffer = mBuffer->vkBuffer();
+    region.mOffset = chunkBegin + offset;
+    region.mSize = size;
+    region.mMappedData = mMappedData + region.mOffset;
+
+    return region;
+}
+
+TransferTicket
+StagingRing::uploadToBuffer(const void* sourceData,
+                            const vk::DeviceSize size,
+                            const vk::Buffer destinationBuffer,
+                            const vk::DeviceSize destinationOffset) {
+    assert(sourceData != nullptr);
+    assert(size > 0);
+    assert(destinationBuffer != VK_NULL_HANDLE);
+
+    const char* source = static_cast<const char*>(sourceData);
+    vk::DeviceSize copiedSize = 0;
+    while (copiedSize < size) {
+        const vk::DeviceSize regionSize = std::min(size - copiedSize,
+                                                   mChunkSize);
+        const StagingRegion region = allocate(regionSize);
+        memcpy(region.mMappedData,
+               source + copiedSize,
+               static_cast<size_t>(regionSize));
+
+        vk::BufferCopy bufferCopy;
+        bufferCopy.setSrcOffset(region.mOffset);
+        bufferCopy.setDstOffset(destinationOffset + copiedSize);
+        bufferCopy.setSize(regionSize);
+        TransferEngine::commandBuffer().copyBuffer(region.mBuffer,
+                                                   destinationBuffer,
+                                                   {bufferCopy});
+
+        copiedSize += regionSize;
+    }
+
+    return TransferEngine::currentTicket();
+}
+
+TransferTicket
+StagingRing::uploadToImage(const void* sourceData,
+                           const vk::Image destinationImage,
+                           const uint32_t imageWidth,
+                           const uint32_t imageHeight,
+                           const vk::DeviceSize texelSize) {
+    assert(sourceData != nullptr);
+    assert(destinationImage != VK_NULL_HANDLE);
+    assert(imageWidth > 0 && imageHeight > 0);
+    assert(texelSize > 0);
+
+    // vkCmdCopyBufferToImage needs a buffer offset multiple of 4 and of the texel size
+    // (that can be any size, like 12 bytes of VK_FORMAT_R32G32B32_SFLOAT).
+    const vk::DeviceSize alignment = leastCommonMultiple(4,
+                                                         texelSize);
+
+    // Images are split in groups of complete rows, 
+    // so each group is a rectangle of the image.
+    // The region can need alignment - 1 bytes of padding in its chunk.
+    const vk::DeviceSize rowSize = imageWidth * texelSize;
+    assert(rowSize + alignment - 1 <= mChunkSize && "A single image row does not fit in a chunk");
+    const uint32_t maxRowsPerRegion = static_cast<uint32_t>((mChunkSize - (alignment - 1)) / rowSize);
+
+    vk::ImageSubresourceLayers layer;
+    layer.setAspectMask(vk::ImageAspectFlagBits::eColor);
+    layer.setMipLevel(0);
+    layer.setBaseArrayLayer(0);
+    layer.setLayerCount(1);
+
+    const char* source = static_cast<const char*>(sourceData);
+    uint32_t copiedRows = 0;
+    while (copiedRows < imageHeight) {
+        const uint32_t rowCount = std::min(imageHeight - copiedRows,
+                                           maxRowsPerRegion);
+        const vk::DeviceSize regionSize = rowCount * rowSize;
+        const StagingRegion region = allocate(regionSize,
+                                              alignment);
+        memcpy(region.mMappedData,
+               source + copiedRows * rowSize,
+               static_cast<size_t>(regionSize));
+
+        vk::BufferImageCopy bufferImageCopy;
+        bufferImageCopy.setBufferOffset(region.mOffset);
+        bufferImageCopy.setImageSubresource(layer);
+        bufferImageCopy.setImageOffset({0, static_cast<int32_t>(copiedRows), 0});
+        bufferImageCopy.setImageExtent({imageWidth, rowCount, 1});
+        TransferEngine::commandBuffer().copyBufferToImage(region.mBuffer,
+                                                          destinationImage,
+                                                          vk::ImageLayout::eTransferDstOptimal,
+                                                          {bufferImageCopy});
+
+        copiedRows += rowCount;
+    }
+
+    return TransferEngine::currentTicket();
+}
+
+void
+StagingRing::moveToNextChunk() {
+    const uint32_t nextChunkIndex = (mCurrentChunkIndex + 1) % static_cast<uint32_t>(mTicketByChunk.size());
+
+    // If the current batch reads the next chunk, 
+    // wait() submits it first.
+    TransferEngine::wait(mTicketByChunk[nextChunkIndex]);
+
+    mTicketByChunk[nextChunkIndex] = TransferTicket();
+    mCurrentChunkIndex = nextChunkIndex;
+    mCurrentChunkOffset = 0;
+}
+}
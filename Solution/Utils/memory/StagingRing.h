@@ -0,0 +1,125 @@
+#ifndef UTILS_MEMORY_STAGING_RING
+#define UTILS_MEMORY_STAGING_RING
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "../TransferEngine.h"
+
+namespace vulkan {
+class Buffer;
+
+//
+// Piece of the StagingRing where the host writes the data to upload.
+//
+struct StagingRegion {
+    vk::Buffer mBuffer;
+    vk::DeviceSize mOffset = 0;
+    vk::DeviceSize mSize = 0;
+
+    // Host address of mOffset.
+    void* mMappedData = nullptr;
+};
+
+//
+// Global ring of staging memory used to upload data to device local resources.
+//
+// Instead of creating (and allocating memory for) a new staging Buffer
+// for each upload, all the uploads stream through a single host visible
+// Buffer that is split in chunkCount chunks of chunkSize bytes.
+//
+// Regions are sub-allocated linearly from the current chunk. When a region
+// does not fit, the ring moves to the next chunk, waiting (with a fence)
+// for the TransferEngine batch that last read it, if it is still in flight.
+// If the next chunk is read by the batch that is being recorded
+// (the upload is bigger than the ring), the batch is submitted first.
+//
+// Uploads bigger than chunkSize must be split in several regions
+// (uploadToBuffer() and uploadToImage() already do it).
+//
+// It is not thread safe.
+//
+// Usage:
+// - allocate() a region and write the data to its mMappedData,
+// - record the copy from the region in TransferEngine::commandBuffer().
+//   It must be called after allocate(), as allocate() may 
+//   submit the current batch.
+//
+// Preconditions:
+// - The global logical device, DeviceMemoryAllocator and TransferEngine
+//   must be initialized first.
+//
+class StagingRing {
+public:
+    // * chunkSize in bytes. It is the maximum size of a region.
+    //
+    // * chunkCount is the number of chunks in the ring.
+    static void
+    initialize(const vk::DeviceSize chunkSize = 16 * 1024 * 1024,
+               const uint32_t chunkCount = 4);
+
+    // Waits for all the batches before destroying the ring.
+    static void
+    finalize();
+
+    static vk::DeviceSize
+    chunkSize();
+
+    // * size of the region in bytes. It cannot be bigger than chunkSize()
+    //   (minus alignment - 1, if chunkSize() is not a multiple of the alignment).
+    //
+    // * alignment of the offset of the region. It does not need to be a power of two.
+    static StagingRegion
+    allocate(const vk::DeviceSize size,
+             const vk::DeviceSize alignment = 16);
+
+    // Copies "size" bytes from sourceData to the destinationBuffer
+    // (at destinationOffset) through the ring, split in chunks if needed.
+    // The copy is recorded in the current TransferEngine batch.
+    // Returns the ticket of the batch that copies the last region.
+    static TransferTicket
+    uploadToBuffer(const void* sourceData,
+                   const vk::DeviceSize size,
+                   const vk::Buffer destinationBuffer,
+                   const vk::DeviceSize destinationOffset = 0);
+
+    // Copies a tightly packed 2D image from sourceData to the mip level 0
+    // of the destinationImage through the ring, split in groups of rows if needed.
+    // The copy is recorded in the current TransferEngine batch.
+    // Returns the ticket of the batch that copies the last region.
+    //
+    // * destinationImage must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    //   when the copy is executed.
+    //
+    // * texelSize in bytes.
+    static TransferTicket
+    uploadToImage(const void* sourceData,
+                  const vk::Image destinationImage,
+                  const uint32_t imageWidth,
+                  const uint32_t imageHeight,
+                  const vk::DeviceSize texelSize);
+
+private:
+    StagingRing() = delete;
+    ~StagingRing() = delete;
+    StagingRing(StagingRing&&) noexcept = delete;
+    StagingRing(const StagingRing&) = delete;
+    const StagingRing& operator=(const StagingRing&) = delete;
+
+    static void
+    moveToNextChunk();
+
+    static std::unique_ptr<Buffer> mBuffer;
+    static char* mMappedData;
+    static vk::DeviceSize mChunkSize;
+
+    // Ticket of the last batch that reads each chunk.
+    static std::vector<TransferTicket> mTicketByChunk;
+    static uint32_t mCurrentChunkIndex;
+    static vk::DeviceSize mCurrentChunkOffset;
+};
+}
+
+#endif
@@ -0,0 +1,384 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+// Index of the most significant bit set. value must not be 0.
+uint32_t
+mostSignificantBit(const uint64_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+// Index of the least significant bit set. value must not be 0.
+uint32_t
+leastSignificantBit(const uint64_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+vk::DeviceSize
+alignUp(const vk::DeviceSize value,
+        const vk::DeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+namespace vulkan {
+TlsfAllocator::TlsfAllocator(const vk::DeviceSize size)
+    : mSize(size)
+{
+    assert(size > 0);
+
+    for (uint32_t firstLevel = 0; firstLevel < FirstLevelCount; ++firstLevel) {
+        for (uint32_t secondLevel = 0; secondLevel < SecondLevelCount; ++secondLevel) {
+            mFreeListHeads[firstLevel][secondLevel] = NullRange;
+        }
+    }
+
+    // At the beginning, the whole range is a single free range.
+    const uint32_t rangeIndex = createRange(0, size);
+    insertFreeRange(rangeIndex);
+}
+
+uint32_t
+TlsfAllocator::allocate(const vk::DeviceSize size,
+                        const vk::DeviceSize alignment,
+                        vk::DeviceSize& offset) {
+    assert(size > 0);
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    // We look for a range that can hold the size plus the worst
+    // case padding needed to align its offset.
+    const vk::DeviceSize searchSize = size + alignment - 1;
+    if (searchSize > mSize) {
+        return InvalidHandle;
+    }
+
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    mappingSearch(searchSize,
+                  firstLevel,
+                  secondLevel);
+
+    uint32_t rangeIndex = findSuitableRange(firstLevel,
+                                            secondLevel);
+    if (rangeIndex == NullRange) {
+        return InvalidHandle;
+    }
+
+    removeFreeRange(rangeIndex);
+
+    // The padding before the aligned offset becomes a new free range
+    // so it can be reused by smaller or less aligned allocations.
+    const vk::DeviceSize alignedOffset = alignUp(mRanges[rangeIndex].mOffset,
+                                                 alignment);
+    const vk::DeviceSize padding = alignedOffset - mRanges[rangeIndex].mOffset;
+    if (padding > 0) {
+        const uint32_t paddingRangeIndex = rangeIndex;
+        rangeIndex = splitRange(paddingRangeIndex,
+                                padding);
+        insertFreeRange(paddingRangeIndex);
+    }
+
+    // The remaining part after the allocation is given back too.
+    assert(mRanges[rangeIndex].mSize >= size);
+    if (mRanges[rangeIndex].mSize > size) {
+        const uint32_t remainingRangeIndex = splitRange(rangeIndex,
+                                                        size);
+        insertFreeRange(remainingRangeIndex);
+    }
+
+    Range& range = mRanges[rangeIndex];
+    range.mIsFree = false;
+    mUsedSize += range.mSize;
+    ++mAllocationCount;
+
+    offset = range.mOffset;
+    return rangeIndex;
+}
+
+void
+TlsfAllocator::free(const uint32_t rangeHandle) {
+    assert(rangeHandle < mRanges.size());
+    assert(mRanges[rangeHandle].mIsFree == false);
+    assert(mAllocationCount > 0);
+
+    uint32_t rangeIndex = rangeHandle;
+    mUsedSize -= mRanges[rangeIndex].mSize;
+    --mAllocationCount;
+
+    // Merge with the next physical range if it is free.
+    const uint32_t nextRangeIndex = mRanges[rangeIndex].mNextPhysical;
+    if (nextRangeIndex != NullRange && mRanges[nextRangeIndex].mIsFree) {
+        removeFreeRange(nextRangeIndex);
+        mergeWithNextRange(rangeIndex);
+    }
+
+    // Merge with the previous physical range if it is free.
+    const uint32_t previousRangeIndex = mRanges[rangeIndex].mPreviousPhysical;
+    if (previousRangeIndex != NullRange && mRanges[previousRangeIndex].mIsFree) {
+        removeFreeRange(previousRangeIndex);
+        mergeWithNextRange(previousRangeIndex);
+        rangeIndex = previousRangeIndex;
+    }
+
+    insertFreeRange(rangeIndex);
+}
+
+vk::DeviceSize
+TlsfAllocator::size() const {
+    return mSize;
+}
+
+vk::DeviceSize
+TlsfAllocator::usedSize() const {
+    return mUsedSize;
+}
+
+vk::DeviceSize
+TlsfAllocator::largestFreeRangeSize() const {
+    if (mFirstLevelBitmap == 0) {
+        return 0;
+    }
+
+    // The largest free range is in the biggest non empty size class,
+    // but ranges of the same class can have different sizes.
+    const uint32_t firstLevel = mostSignificantBit(mFirstLevelBitmap);
+    const uint32_t secondLevel = mostSignificantBit(mSecondLevelBitmaps[firstLevel]);
+
+    vk::DeviceSize largestSize = 0;
+    for (uint32_t rangeIndex = mFreeListHeads[firstLevel][secondLevel];
+         rangeIndex != NullRange;
+         rangeIndex = mRanges[rangeIndex].mNextFree) {
+        largestSize = std::max(largestSize,
+                               mRanges[rangeIndex].mSize);
+    }
+
+    return largestSize;
+}
+
+uint32_t
+TlsfAllocator::freeRangeCount() const {
+    return mFreeRangeCount;
+}
+
+uint32_t
+TlsfAllocator::allocationCount() const {
+    return mAllocationCount;
+}
+
+bool
+TlsfAllocator::isEmpty() const {
+    return mAllocationCount == 0;
+}
+
+void
+TlsfAllocator::mappingInsert(const vk::DeviceSize size,
+                             uint32_t& firstLevel,
+                             uint32_t& secondLevel) {
+    assert(size > 0);
+
+    // Small sizes are stored linearly in the first list.
+    if (size < SecondLevelCount) {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(size);
+    } else {
+        const uint32_t mostSignificantBitIndex = mostSignificantBit(size);
+        firstLevel = mostSignificantBitIndex - SecondLevelLog2 + 1;
+        secondLevel = static_cast<uint32_t>(size >> (mostSignificantBitIndex - SecondLevelLog2)) ^
+                      SecondLevelCount;
+    }
+
+    assert(firstLevel < FirstLevelCount);
+    assert(secondLevel < SecondLevelCount);
+}
+
+void
+TlsfAllocator::mappingSearch(const vk::DeviceSize size,
+                             uint32_t& firstLevel,
+                             uint32_t& secondLevel) {
+    vk::DeviceSize roundedSize = size;
+    if (size >= SecondLevelCount) {
+        const uint32_t mostSignificantBitIndex = mostSignificantBit(size);
+        roundedSize += (vk::DeviceSize(1) << (mostSignificantBitIndex - SecondLevelLog2)) - 1;
+    }
+
+    mappingInsert(roundedSize,
+                  firstLevel,
+                  secondLevel);
+}
+
+uint32_t
+TlsfAllocator::findSuitableRange(uint32_t firstLevel,
+                                 uint32_t secondLevel) const {
+    // First, we look for a non empty list in the same first level
+    // with an equal or bigger second level.
+    uint32_t secondLevelMap = mSecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0) {
+        // Otherwise, we take the smallest non empty list
+        // of the next first levels.
+        const uint64_t firstLevelMap = firstLevel + 1 < 64 ?
+                                       mFirstLevelBitmap & (~0ull << (firstLevel + 1)) :
+                                       0;
+        if (firstLevelMap == 0) {
+            return NullRange;
+        }
+
+        firstLevel = leastSignificantBit(firstLevelMap);
+        secondLevelMap = mSecondLevelBitmaps[firstLevel];
+        assert(secondLevelMap != 0);
+    }
+
+    secondLevel = leastSignificantBit(secondLevelMap);
+    return mFreeListHeads[firstLevel][secondLevel];
+}
+
+uint32_t
+TlsfAllocator::createRange(const vk::DeviceSize offset,
+                           const vk::DeviceSize size) {
+    uint32_t rangeIndex = NullRange;
+    if (mUnusedRangeIndices.empty()) {
+        rangeIndex = static_cast<uint32_t>(mRanges.size());
+        mRanges.emplace_back();
+    } else {
+        rangeIndex = mUnusedRangeIndices.back();
+        mUnusedRangeIndices.pop_back();
+        mRanges[rangeIndex] = Range();
+    }
+
+    mRanges[rangeIndex].mOffset = offset;
+    mRanges[rangeIndex].mSize = size;
+
+    return rangeIndex;
+}
+
+void
+TlsfAllocator::destroyRange(const uint32_t rangeIndex) {
+    assert(rangeIndex < mRanges.size());
+    mRanges[rangeIndex] = Range();
+    mUnusedRangeIndices.push_back(rangeIndex);
+}
+
+void
+TlsfAllocator::insertFreeRange(const uint32_t rangeIndex) {
+    Range& range = mRanges[rangeIndex];
+
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    mappingInsert(range.mSize,
+                  firstLevel,
+                  secondLevel);
+
+    const uint32_t headIndex = mFreeListHeads[firstLevel][secondLevel];
+    range.mIsFree = true;
+    range.mPreviousFree = NullRange;
+    range.mNextFree = headIndex;
+    if (headIndex != NullRange) {
+        mRanges[headIndex].mPreviousFree = rangeIndex;
+    }
+    mFreeListHeads[firstLevel][secondLevel] = rangeIndex;
+
+    mFirstLevelBitmap |= uint64_t(1) << firstLevel;
+    mSecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+
+    ++mFreeRangeCount;
+}
+
+void
+TlsfAllocator::removeFreeRange(const uint32_t rangeIndex) {
+    Range& range = mRanges[rangeIndex];
+    assert(range.mIsFree);
+
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    mappingInsert(range.mSize,
+                  firstLevel,
+                  secondLevel);
+
+    if (range.mPreviousFree != NullRange) {
+        mRanges[range.mPreviousFree].mNextFree = range.mNextFree;
+    } else {
+        assert(mFreeListHeads[firstLevel][secondLevel] == rangeIndex);
+        mFreeListHeads[firstLevel][secondLevel] = range.mNextFree;
+    }
+
+    if (range.mNextFree != NullRange) {
+        mRanges[range.mNextFree].mPreviousFree = range.mPreviousFree;
+    }
+
+    // Update the bitmaps if the list became empty.
+    if (mFreeListHeads[firstLevel][secondLevel] == NullRange) {
+        mSecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (mSecondLevelBitmaps[firstLevel] == 0) {
+            mFirstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+        }
+    }
+
+    range.mIsFree = false;
+    range.mPreviousFree = NullRange;
+    range.mNextFree = NullRange;
+
+    assert(mFreeRangeCount > 0);
+    --mFreeRangeCount;
+}
+
+uint32_t
+TlsfAllocator::splitRange(const uint32_t rangeIndex,
+                          const vk::DeviceSize size) {
+    assert(mRanges[rangeIndex].mSize > size);
+
+    // createRange can reallocate mRanges, so we cannot keep
+    // references to its elements until it is called.
+    const uint32_t newRangeIndex = createRange(mRanges[rangeIndex].mOffset + size,
+                                               mRanges[rangeIndex].mSize - size);
+
+    Range& range = mRanges[rangeIndex];
+    Range& newRange = mRanges[newRangeIndex];
+    range.mSize = size;
+
+    newRange.mPreviousPhysical = rangeIndex;
+    newRange.mNextPhysical = range.mNextPhysical;
+    if (range.mNextPhysical != NullRange) {
+        mRanges[range.mNextPhysical].mPreviousPhysical = newRangeIndex;
+    }
+    range.mNextPhysical = newRangeIndex;
+
+    return newRangeIndex;
+}
+
+void
+TlsfAllocator::mergeWithNextRange(const uint32_t rangeIndex) {
+    Range& range = mRanges[rangeIndex];
+    const uint32_t nextRangeIndex = range.mNextPhysical;
+    assert(nextRangeIndex != NullRange);
+
+    const Range& nextRange = mRanges[nextRangeIndex];
+    assert(range.mOffset + range.mSize == nextRange.mOffset);
+
+    range.mSize += nextRange.mSize;
+    range.mNextPhysical = nextRange.mNextPhysical;
+    if (range.mNextPhysical != NullRange) {
+        mRanges[range.mNextPhysical].mPreviousPhysical = rangeIndex;
+    }
+
+    destroyRange(nextRangeIndex);
+}
+}
@@ -0,0 +1,151 @@
+#ifndef UTILS_MEMORY_TLSF_ALLOCATOR
+#define UTILS_MEMORY_TLSF_ALLOCATOR
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+//
+// Two-Level Segregated Fit (TLSF) range allocator.
+//
+// It does not own any memory. It only decides at which offset,
+// inside a range of "size" bytes, each allocation is placed.
+// DeviceMemoryAllocator uses it to sub-allocate big DeviceMemory blocks.
+//
+// Free ranges are classified in two levels:
+// - The first level is the power of two of the range size.
+// - The second level splits each power of two in SecondLevelCount
+//   linear subdivisions.
+//
+// Each (first level, second level) pair has a list of free ranges
+// and two bitmaps tell which lists are not empty, so both
+// allocate() and free() run in constant time.
+// Adjacent free ranges are merged on free() to keep fragmentation low.
+//
+class TlsfAllocator {
+public:
+    static constexpr uint32_t InvalidHandle = std::numeric_limits<uint32_t>::max();
+
+    // * size in bytes of the whole range to sub-allocate.
+    explicit TlsfAllocator(const vk::DeviceSize size);
+    TlsfAllocator(TlsfAllocator&& other) noexcept = default;
+    TlsfAllocator& operator=(TlsfAllocator&& other) noexcept = default;
+    TlsfAllocator(const TlsfAllocator&) = delete;
+    const TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+
+    // Returns the handle of the allocated range, or InvalidHandle if
+    // there is no free range that can hold "size" bytes aligned to "alignment".
+    //
+    // * alignment must be a power of two (Vulkan memory requirements
+    //   alignment always is).
+    //
+    // * offset is filled with the aligned offset of the allocated range.
+    uint32_t
+    allocate(const vk::DeviceSize size,
+             const vk::DeviceSize alignment,
+             vk::DeviceSize& offset);
+
+    // * rangeHandle must have been returned by allocate()
+    void
+    free(const uint32_t rangeHandle);
+
+    vk::DeviceSize
+    size() const;
+
+    vk::DeviceSize
+    usedSize() const;
+
+    vk::DeviceSize
+    largestFreeRangeSize() const;
+
+    uint32_t
+    freeRangeCount() const;
+
+    uint32_t
+    allocationCount() const;
+
+    bool
+    isEmpty() const;
+
+private:
+    static constexpr uint32_t SecondLevelLog2 = 5;
+    static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+    static constexpr uint32_t FirstLevelCount = 64 - SecondLevelLog2 + 1;
+    static constexpr uint32_t NullRange = std::numeric_limits<uint32_t>::max();
+
+    // Contiguous piece of the whole range.
+    // Ranges are linked in two lists:
+    // - Physical list: all the ranges sorted by offset, used to merge
+    //   neighbours on free().
+    // - Free list: free ranges of the same size class.
+    struct Range {
+        vk::DeviceSize mOffset = 0;
+        vk::DeviceSize mSize = 0;
+        uint32_t mPreviousPhysical = NullRange;
+        uint32_t mNextPhysical = NullRange;
+        uint32_t mPreviousFree = NullRange;
+        uint32_t mNextFree = NullRange;
+        bool mIsFree = false;
+    };
+
+    // Computes the first and second level indices of the
+    // free list where a range of "size" bytes must be inserted.
+    static void
+    mappingInsert(const vk::DeviceSize size,
+                  uint32_t& firstLevel,
+                  uint32_t& secondLevel);
+
+    // Same as mappingInsert, but rounds the size up to the next
+    // size class, so any range of the resulting list can hold "size" bytes.
+    static void
+    mappingSearch(const vk::DeviceSize size,
+                  uint32_t& firstLevel,
+                  uint32_t& secondLevel);
+
+    // Returns the first free range whose size class is
+    // equal or bigger than (firstLevel, secondLevel).
+    uint32_t
+    findSuitableRange(uint32_t firstLevel,
+                      uint32_t secondLevel) const;
+
+    uint32_t
+    createRange(const vk::DeviceSize offset,
+                const vk::DeviceSize size);
+
+    void
+    destroyRange(const uint32_t rangeIndex);
+
+    void
+    insertFreeRange(const uint32_t rangeIndex);
+
+    void
+    removeFreeRange(const uint32_t rangeIndex);
+
+    // Splits the range in two.
+    // The range keeps the first "size" bytes and the returned
+    // range is the remaining part, placed after it in the physical list.
+    uint32_t
+    splitRange(const uint32_t rangeIndex,
+               const vk::DeviceSize size);
+
+    // Merges the range with its next physical range, which is destroyed.
+    void
+    mergeWithNextRange(const uint32_t rangeIndex);
+
+    vk::DeviceSize mSize = 0;
+    vk::DeviceSize mUsedSize = 0;
+    uint32_t mAllocationCount = 0;
+    uint32_t mFreeRangeCount = 0;
+
+    std::vector<Range> mRanges;
+    std::vector<uint32_t> mUnusedRangeIndices;
+
+    uint64_t mFirstLevelBitmap = 0;
+    uint32_t mSecondLevelBitmaps[FirstLevelCount] = {};
+    uint32_t mFreeListHeads[FirstLevelCount][SecondLevelCount];
+};
+}
+
+#endif
@@ -0,0 +1,270 @@
+#include "ExtendedDynamicState.h"
+
+#include <cassert>
+
+#include "PipelineStates.h"
+#include "../Instance.h"
+#include "../device/LogicalDevice.h"
+
+namespace vulkan {
+DynamicStateFields::DynamicStateFields(const DynamicState* dynamicState) {
+    if (dynamicState == nullptr) {
+        return;
+    }
+
+    const vk::PipelineDynamicStateCreateInfo& info = dynamicState->state();
+    for (uint32_t i = 0; i < info.dynamicStateCount; ++i) {
+        switch (info.pDynamicStates[i]) {
+        case vk::DynamicState::eViewport: mViewport = true; break;
+        case vk::DynamicState::eScissor: mScissor = true; break;
+        case vk::DynamicState::eLineWidth: mLineWidth = true; break;
+        case vk::DynamicState::eDepthBias: mDepthBias = true; break;
+        case vk::DynamicState::eBlendConstants: mBlendConstants = true; break;
+        case vk::DynamicState::eDepthBounds: mDepthBounds = true; break;
+        case vk::DynamicState::eStencilCompareMask: mStencilCompareMask = true; break;
+        case vk::DynamicState::eStencilWriteMask: mStencilWriteMask = true; break;
+        case vk::DynamicState::eStencilReference: mStencilReference = true; break;
+#ifdef VK_EXT_extended_dynamic_state
+        case vk::DynamicState::eCullModeEXT: mCullMode = true; break;
+        case vk::DynamicState::eFrontFaceEXT: mFrontFace = true; break;
+        case vk::DynamicState::ePrimitiveTopologyEXT: mPrimitiveTopology = true; break;
+        case vk::DynamicState::eDepthTestEnableEXT: mDepthTestEnable = true; break;
+        case vk::DynamicState::eDepthWriteEnableEXT: mDepthWriteEnable = true; break;
+        case vk::DynamicState::eDepthCompareOpEXT: mDepthCompareOp = true; break;
+        case vk::DynamicState::eDepthBoundsTestEnableEXT: mDepthBoundsTestEnable = true; break;
+        case vk::DynamicState::eStencilTestEnableEXT: mStencilTestEnable = true; break;
+        case vk::DynamicState::eStencilOpEXT: mStencilOp = true; break;
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+        case vk::DynamicState::eRasterizerDiscardEnableEXT: mRasterizerDiscardEnable = true; break;
+        case vk::DynamicState::eDepthBiasEnableEXT: mDepthBiasEnable = true; break;
+        case vk::DynamicState::ePrimitiveRestartEnableEXT: mPrimitiveRestartEnable = true; break;
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+        case vk::DynamicState::ePolygonModeEXT: mPolygonMode = true; break;
+        case vk::DynamicState::eDepthClampEnableEXT: mDepthClampEnable = true; break;
+#endif
+        default: break;
+        }
+    }
+}
+
+vk::DispatchLoaderDynamic
+ExtendedDynamicState::mDispatcher;
+
+void
+ExtendedDynamicState::initialize() {
+#if defined(VK_EXT_extended_dynamic_state) || defined(VK_EXT_extended_dynamic_state2) || defined(VK_EXT_extended_dynamic_state3)
+    mDispatcher.init(static_cast<VkInstance>(Instance::instance()),
+                     vkGetInstanceProcAddr,
+                     static_cast<VkDevice>(LogicalDevice::device()));
+#endif
+}
+
+void
+ExtendedDynamicState::finalize() {
+    mDispatcher = vk::DispatchLoaderDynamic();
+}
+
+std::vector<vk::DynamicState>
+ExtendedDynamicState::supportedDynamicStates() {
+    std::vector<vk::DynamicState> dynamicStates {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor,
+        vk::DynamicState::eLineWidth,
+        vk::DynamicState::eDepthBias,
+        vk::DynamicState::eBlendConstants,
+        vk::DynamicState::eDepthBounds,
+        vk::DynamicState::eStencilCompareMask,
+        vk::DynamicState::eStencilWriteMask,
+        vk::DynamicState::eStencilReference,
+    };
+
+#ifdef VK_EXT_extended_dynamic_state
+    if (LogicalDevice::isExtendedDynamicStateEnabled()) {
+        dynamicStates.insert(dynamicStates.end(),
+                             {vk::DynamicState::eCullModeEXT,
+                              vk::DynamicState::eFrontFaceEXT,
+                              vk::DynamicState::ePrimitiveTopologyEXT,
+                              vk::DynamicState::eDepthTestEnableEXT,
+                              vk::DynamicState::eDepthWriteEnableEXT,
+                              vk::DynamicState::eDepthCompareOpEXT,
+                              vk::DynamicState::eDepthBoundsTestEnableEXT,
+                              vk::DynamicState::eStencilTestEnableEXT,
+                              vk::DynamicState::eStencilOpEXT});
+    }
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+    if (LogicalDevice::isExtendedDynamicState2Enabled()) {
+        dynamicStates.insert(dynamicStates.end(),
+                             {vk::DynamicState::eRasterizerDiscardEnableEXT,
+                              vk::DynamicState::eDepthBiasEnableEXT,
+                              vk::DynamicState::ePrimitiveRestartEnableEXT});
+    }
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+    if (LogicalDevice::isExtendedDynamicState3Enabled()) {
+        dynamicStates.insert(dynamicStates.end(),
+                             {vk::DynamicState::ePolygonModeEXT,
+                              vk::DynamicState::eDepthClampEnableEXT});
+    }
+#endif
+
+    return dynamicStates;
+}
+
+void
+ExtendedDynamicState::setDynamicStates(const vk::CommandBuffer commandBuffer,
+                                       const PipelineStates& pipelineStates) {
+    assert(commandBuffer != VK_NULL_HANDLE);
+
+    const DynamicStateFields fields(pipelineStates.dynamicState());
+
+    if (fields.mViewport || fields.mScissor) {
+        assert(pipelineStates.viewportState() != nullptr);
+        const vk::PipelineViewportStateCreateInfo& info = pipelineStates.viewportState()->state();
+        if (fields.mViewport) {
+            commandBuffer.setViewport(0,
+                                      {info.pViewports[0]});
+        }
+        if (fields.mScissor) {
+            commandBuffer.setScissor(0,
+                                     {info.pScissors[0]});
+        }
+    }
+
+    if (fields.mLineWidth || fields.mDepthBias || fields.mCullMode || fields.mFrontFace ||
+        fields.mRasterizerDiscardEnable || fields.mDepthBiasEnable ||
+        fields.mPolygonMode || fields.mDepthClampEnable) {
+        assert(pipelineStates.rasterizationState() != nullptr);
+        const vk::PipelineRasterizationStateCreateInfo& info = pipelineStates.rasterizationState()->state();
+        if (fields.mLineWidth) {
+            commandBuffer.setLineWidth(info.lineWidth);
+        }
+        if (fields.mDepthBias) {
+            commandBuffer.setDepthBias(info.depthBiasConstantFactor,
+                                       info.depthBiasClamp,
+                                       info.depthBiasSlopeFactor);
+        }
+#ifdef VK_EXT_extended_dynamic_state
+        if (fields.mCullMode) {
+            commandBuffer.setCullModeEXT(info.cullMode,
+                                         mDispatcher);
+        }
+        if (fields.mFrontFace) {
+            commandBuffer.setFrontFaceEXT(info.frontFace,
+                                          mDispatcher);
+        }
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+        if (fields.mRasterizerDiscardEnable) {
+            commandBuffer.setRasterizerDiscardEnableEXT(info.rasterizerDiscardEnable,
+                                                        mDispatcher);
+        }
+        if (fields.mDepthBiasEnable) {
+            commandBuffer.setDepthBiasEnableEXT(info.depthBiasEnable,
+                                                mDispatcher);
+        }
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+        if (fields.mPolygonMode) {
+            commandBuffer.setPolygonModeEXT(info.polygonMode,
+                                            mDispatcher);
+        }
+        if (fields.mDepthClampEnable) {
+            commandBuffer.setDepthClampEnableEXT(info.depthClampEnable,
+                                                 mDispatcher);
+        }
+#endif
+    }
+
+    if (fields.mPrimitiveTopology || fields.mPrimitiveRestartEnable) {
+        assert(pipelineStates.inputAssemblyState() != nullptr);
+        const vk::PipelineInputAssemblyStateCreateInfo& info = pipelineStates.inputAssemblyState()->state();
+        (void)info;
+#ifdef VK_EXT_extended_dynamic_state
+        if (fields.mPrimitiveTopology) {
+            commandBuffer.setPrimitiveTopologyEXT(info.topology,
+                                                  mDispatcher);
+        }
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+        if (fields.mPrimitiveRestartEnable) {
+            commandBuffer.setPrimitiveRestartEnableEXT(info.primitiveRestartEnable,
+                                                       mDispatcher);
+        }
+#endif
+    }
+
+    if (fields.mBlendConstants) {
+        assert(pipelineStates.colorBlendState() != nullptr);
+        commandBuffer.setBlendConstants(pipelineStates.colorBlendState()->state().blendConstants);
+    }
+
+    if (fields.mDepthBounds || fields.mStencilCompareMask || fields.mStencilWriteMask ||
+        fields.mStencilReference || fields.mDepthTestEnable || fields.mDepthWriteEnable ||
+        fields.mDepthCompareOp || fields.mDepthBoundsTestEnable || fields.mStencilTestEnable ||
+        fields.mStencilOp) {
+        assert(pipelineStates.depthStencilState() != nullptr);
+        const vk::PipelineDepthStencilStateCreateInfo& info = pipelineStates.depthStencilState()->state();
+        if (fields.mDepthBounds) {
+            commandBuffer.setDepthBounds(info.minDepthBounds,
+                                         info.maxDepthBounds);
+        }
+        if (fields.mStencilCompareMask) {
+            commandBuffer.setStencilCompareMask(vk::StencilFaceFlagBits::eFront,
+                                                info.front.compareMask);
+            commandBuffer.setStencilCompareMask(vk::StencilFaceFlagBits::eBack,
+                                                info.back.compareMask);
+        }
+        if (fields.mStencilWriteMask) {
+            commandBuffer.setStencilWriteMask(vk::StencilFaceFlagBits::eFront,
+                                              info.front.writeMask);
+            commandBuffer.setStencilWriteMask(vk::StencilFaceFlagBits::eBack,
+                                              info.back.writeMask);
+        }
+        if (fields.mStencilReference) {
+            commandBuffer.setStencilReference(vk::StencilFaceFlagBits::eFront,
+                                              info.front.reference);
+            commandBuffer.setStencilReference(vk::StencilFaceFlagBits::eBack,
+                                              info.back.reference);
+        }
+#ifdef VK_EXT_extended_dynamic_state
+        if (fields.mDepthTestEnable) {
+            commandBuffer.setDepthTestEnableEXT(info.depthTestEnable,
+                                                mDispatcher);
+        }
+        if (fields.mDepthWriteEnable) {
+            commandBuffer.setDepthWriteEnableEXT(info.depthWriteEnable,
+                                                 mDispatcher);
+        }
+        if (fields.mDepthCompareOp) {
+            commandBuffer.setDepthCompareOpEXT(info.depthCompareOp,
+                                               mDispatcher);
+        }
+        if (fields.mDepthBoundsTestEnable) {
+            commandBuffer.setDepthBoundsTestEnableEXT(info.depthBoundsTestEnable,
+                                                      mDispatcher);
+        }
+        if (fields.mStencilTestEnable) {
+            commandBuffer.setStencilTestEnableEXT(info.stencilTestEnable,
+                                                  mDispatcher);
+        }
+        if (fields.mStencilOp) {
+            commandBuffer.setStencilOpEXT(vk::StencilFaceFlagBits::eFront,
+                                          info.front.failOp,
+                                          info.front.passOp,
+                                          info.front.depthFailOp,
+                                          info.front.compareOp,
+                                          mDispatcher);
+            commandBuffer.setStencilOpEXT(vk::StencilFaceFlagBits::eBack,
+                                          info.back.failOp,
+                                          info.back.passOp,
+                                          info.back.depthFailOp,
+                                          info.back.compareOp,
+                                          mDispatcher);
+        }
+#endif
+    }
+}
+}
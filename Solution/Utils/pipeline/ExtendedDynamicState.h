@@ -0,0 +1,109 @@
+#ifndef UTILS_PIPELINE_EXTENDED_DYNAMIC_STATE
+#define UTILS_PIPELINE_EXTENDED_DYNAMIC_STATE
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+class DynamicState;
+class PipelineStates;
+
+//
+// Fields of the pipeline states that are dynamic, according to a DynamicState.
+//
+// Dynamic fields are ignored by the pipeline (they are set in the command buffer),
+// so they are not part of the pipeline hash (Read PipelineSystem).
+//
+struct DynamicStateFields {
+    // * dynamicState can be nullptr (no dynamic fields)
+    explicit DynamicStateFields(const DynamicState* dynamicState);
+
+    // Core Vulkan
+    bool mViewport = false;
+    bool mScissor = false;
+    bool mLineWidth = false;
+    bool mDepthBias = false;
+    bool mBlendConstants = false;
+    bool mDepthBounds = false;
+    bool mStencilCompareMask = false;
+    bool mStencilWriteMask = false;
+    bool mStencilReference = false;
+
+    // VK_EXT_extended_dynamic_state
+    bool mCullMode = false;
+    bool mFrontFace = false;
+    bool mPrimitiveTopology = false;
+    bool mDepthTestEnable = false;
+    bool mDepthWriteEnable = false;
+    bool mDepthCompareOp = false;
+    bool mDepthBoundsTestEnable = false;
+    bool mStencilTestEnable = false;
+    bool mStencilOp = false;
+
+    // VK_EXT_extended_dynamic_state2
+    bool mRasterizerDiscardEnable = false;
+    bool mDepthBiasEnable = false;
+    bool mPrimitiveRestartEnable = false;
+
+    // VK_EXT_extended_dynamic_state3
+    bool mPolygonMode = false;
+    bool mDepthClampEnable = false;
+};
+
+//
+// Extended dynamic state support (VK_EXT_extended_dynamic_state 1, 2 and 3).
+//
+// Every pipeline state that is baked into the pipeline multiplies
+// the number of pipelines: a pipeline for each viewport size, cull mode,
+// depth test/write combination, topology, etc.
+// With dynamic states, those values are set in the command buffer, so
+// a single pipeline is used for all of them.
+//
+// Opt-in: PipelineStates::enableExtendedDynamicState() makes dynamic every
+// state that the device supports. Then, setDynamicStates() must be called after
+// binding the pipeline, and it sets the values of its PipelineStates.
+// The PipelineStates of each draw can differ in the dynamic fields and
+// still share the pipeline.
+//
+// The viewport and scissor are core dynamic states, so they are
+// always dynamic in this mode (a swap chain resize does not need new pipelines).
+//
+// The extensions are only used if the Vulkan headers define them, and
+// the global logical device enabled them.
+//
+// Preconditions:
+// - The global logical device must be initialized first.
+//
+class ExtendedDynamicState {
+public:
+    static void
+    initialize();
+
+    static void
+    finalize();
+
+    // Dynamic states of core Vulkan and of the
+    // extended dynamic state extensions enabled by the device.
+    static std::vector<vk::DynamicState>
+    supportedDynamicStates();
+
+    // Sets the value of every dynamic field of pipelineStates, taken
+    // from its pipeline states (that must be set).
+    static void
+    setDynamicStates(const vk::CommandBuffer commandBuffer,
+                     const PipelineStates& pipelineStates);
+
+private:
+    ExtendedDynamicState() = delete;
+    ~ExtendedDynamicState() = delete;
+    ExtendedDynamicState(ExtendedDynamicState&&) noexcept = delete;
+    ExtendedDynamicState(const ExtendedDynamicState&) = delete;
+    const ExtendedDynamicState& operator=(const ExtendedDynamicState&) = delete;
+
+    // Extension commands are not exported by the Vulkan loader,
+    // so they are loaded for the global logical device.
+    static vk::DispatchLoaderDynamic mDispatcher;
+};
+}
+
+#endif
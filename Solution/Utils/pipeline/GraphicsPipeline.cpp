@@ -1,18 +1,116 @@
 #include "GraphicsPipeline.h"
 
 #include <cassert>
+#include <chrono>
 
+#include "PipelineCache.h"
+#include "PipelineLibrary.h"
 #include "../device/LogicalDevice.h"
 #include "../pipeline/PipelineStates.h"
 #include "../shader/ShaderStages.h"
 
+namespace {
+// Read GraphicsPipeline::createUniquePipeline()
+vk::UniquePipeline
+uniquePipeline(vk::UniquePipeline&& pipeline) {
+    return std::move(pipeline);
+}
+
+vk::UniquePipeline
+uniquePipeline(vk::ResultValue<vk::UniquePipeline>&& resultValue) {
+    assert(resultValue.result == vk::Result::eSuccess);
+    return std::move(resultValue.value);
+}
+}
+
 namespace vulkan {
 GraphicsPipeline::GraphicsPipeline(vk::UniquePipelineLayout& pipelineLayout,
                                    const PipelineStates& pipelineStates,
                                    const ShaderStages& shaderStages,
                                    const vk::RenderPass renderPass,
                                    const uint32_t subPassIndex)
-    : mPipelineLayout(std::move(pipelineLayout)) {
+    : mOwnedPipelineLayout(std::move(pipelineLayout))
+    , mPipelineLayout(mOwnedPipelineLayout.get())
+{
+    createPipeline(pipelineStates,
+                   shaderStages,
+                   renderPass,
+                   subPassIndex);
+}
+
+GraphicsPipeline::GraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                   const PipelineStates& pipelineStates,
+                                   const ShaderStages& shaderStages,
+                                   const vk::RenderPass renderPass,
+                                   const uint32_t subPassIndex)
+    : mPipelineLayout(pipelineLayout)
+{
+    createPipeline(pipelineStates,
+                   shaderStages,
+                   renderPass,
+                   subPassIndex);
+}
+
+GraphicsPipeline::GraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                   const std::vector<vk::Pipeline>& pipelineLibraries,
+                                   const bool linkTimeOptimization)
+    : mPipelineLayout(pipelineLayout)
+{
+    assert(mPipelineLayout != VK_NULL_HANDLE);
+    assert(pipelineLibraries.size() == PipelineLibrary::sPartCount);
+    assert(PipelineLibrary::isSupported());
+
+#ifdef VK_EXT_graphics_pipeline_library
+    vk::PipelineLibraryCreateInfoKHR libraryInfo;
+    libraryInfo.setLibraryCount(static_cast<uint32_t>(pipelineLibraries.size()));
+    libraryInfo.setPLibraries(pipelineLibraries.data());
+
+    vk::GraphicsPipelineCreateInfo info;
+    info.setPNext(&libraryInfo);
+    if (linkTimeOptimization) {
+        info.setFlags(vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT);
+    }
+    info.setLayout(mPipelineLayout);
+
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    mPipeline = createUniquePipeline(info);
+    const std::chrono::nanoseconds creationTime = std::chrono::steady_clock::now() - beginTime;
+    mCreationTime = static_cast<uint64_t>(creationTime.count());
+#else
+    (void)linkTimeOptimization;
+#endif
+}
+
+vk::Pipeline 
+GraphicsPipeline::pipeline() const {
+    assert(mPipeline.get() != VK_NULL_HANDLE);
+    return mPipeline.get();
+}
+
+vk::PipelineLayout
+GraphicsPipeline::pipelineLayout() const {
+    assert(mPipelineLayout != VK_NULL_HANDLE);
+    return mPipelineLayout;
+}
+
+uint64_t
+GraphicsPipeline::creationTime() const {
+    return mCreationTime;
+}
+
+vk::UniquePipeline
+GraphicsPipeline::createUniquePipeline(const vk::GraphicsPipelineCreateInfo& info) {
+    return uniquePipeline(LogicalDevice::device().createGraphicsPipelineUnique(PipelineCache::cache(),
+                                                                               info));
+}
+
+void
+GraphicsPipeline::createPipeline(const PipelineStates& pipelineStates,
+                                 const ShaderStages& shaderStages,
+                                 const vk::RenderPass renderPass,
+                                 const uint32_t subPassIndex) {
+    assert(mPipelineLayout != VK_NULL_HANDLE);
+
     vk::GraphicsPipelineCreateInfo info;
     info.setStageCount(static_cast<uint32_t>(shaderStages.stages().size()));
     info.setPStages(shaderStages.stages().empty() ? nullptr : shaderStages.stages().data());
@@ -43,24 +141,15 @@ GraphicsPipeline::GraphicsPipeline(vk::UniquePipelineLayout& pipelineLayout,
     info.setPDynamicState(pipelineStates.dynamicState() != nullptr ?
                           &pipelineStates.dynamicState()->state() :
                           nullptr);
-    info.setLayout(mPipelineLayout.get());
+    info.setLayout(mPipelineLayout);
     info.setRenderPass(renderPass);
     info.setSubpass(subPassIndex);
 
-    mPipeline = LogicalDevice::device().createGraphicsPipelineUnique(vk::PipelineCache(),
-                                                                     info);
-}
-
-vk::Pipeline 
-GraphicsPipeline::pipeline() const {
-    assert(mPipeline.get() != VK_NULL_HANDLE);
-    return mPipeline.get();
-}
-
-vk::PipelineLayout
-GraphicsPipeline::pipelineLayout() const {
-    assert(mPipelineLayout.get() != VK_NULL_HANDLE);
-    return mPipelineLayout.get();
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    mPipeline = createUniquePipeline(info);
+    const std::chrono::nanoseconds creationTime = std::chrono::steady_clock::now() - beginTime;
+    mCreationTime = static_cast<uint64_t>(creationTime.count());
+    PipelineCache::addPipelineCreationTime(mCreationTime);
 }
 
 }
\ No newline at end of file
@@ -70,12 +70,34 @@ public:
     // If any shader stage fails to compile, the compile log will be reported back 
     // to the application, and VK_ERROR_INVALID_SHADER_NV will be generated.
     //
-    // The global logical device is the device that creates the graphics pipeline.
+    // The global logical device is the device that creates the graphics pipeline,
+    // with the global PipelineCache.
     GraphicsPipeline(vk::UniquePipelineLayout& pipelineLayout,
                      const PipelineStates& pipelineStates,
                      const ShaderStages& shaderStages,
                      const vk::RenderPass renderPass,
                      const uint32_t subPassIndex = 0);
+
+    // The pipelineLayout is not owned by this instance, so it can be 
+    // shared by many pipelines (Read PipelineSystem).
+    // It must outlive this instance.
+    GraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                     const PipelineStates& pipelineStates,
+                     const ShaderStages& shaderStages,
+                     const vk::RenderPass renderPass,
+                     const uint32_t subPassIndex = 0);
+
+    // Links pipeline libraries (Read PipelineLibrary) into a complete pipeline.
+    //
+    // * pipelineLibraries must contain one library of each part,
+    //   created with the same pipelineLayout and render pass.
+    //
+    // * linkTimeOptimization. If it is false, then the libraries are only
+    //   linked (fast link), so the pipeline is created much faster
+    //   but it can be slower to execute.
+    GraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                     const std::vector<vk::Pipeline>& pipelineLibraries,
+                     const bool linkTimeOptimization);
     GraphicsPipeline(const GraphicsPipeline&) = delete;
     const GraphicsPipeline& operator=(const GraphicsPipeline&) = delete;
 
@@ -85,9 +107,33 @@ public:
     vk::PipelineLayout
     pipelineLayout() const;
 
+    // Time spent in the pipeline creation (or link), in nanoseconds.
+    uint64_t
+    creationTime() const;
+
+    // Creates the pipeline with the global logical device and PipelineCache.
+    //
+    // createGraphicsPipelineUnique() returns a vk::UniquePipeline in older vulkan.hpp
+    // versions, and a vk::ResultValue<vk::UniquePipeline> in the newer ones
+    // (pipeline creation can succeed with VK_PIPELINE_COMPILE_REQUIRED_EXT),
+    // so all the pipelines (and pipeline libraries) are created by this function.
+    static vk::UniquePipeline
+    createUniquePipeline(const vk::GraphicsPipelineCreateInfo& info);
+
 private:
+    void
+    createPipeline(const PipelineStates& pipelineStates,
+                   const ShaderStages& shaderStages,
+                   const vk::RenderPass renderPass,
+                   const uint32_t subPassIndex);
+
     vk::UniquePipeline mPipeline;
-    vk::UniquePipelineLayout mPipelineLayout;
+
+    // mOwnedPipelineLayout is null if the layout is not owned.
+    vk::UniquePipelineLayout mOwnedPipelineLayout;
+    vk::PipelineLayout mPipelineLayout;
+
+    uint64_t mCreationTime = 0;
 };
 }
 
@@ -0,0 +1,118 @@
+#include "PipelineCache.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "../FileSystem.h"
+#include "../device/LogicalDevice.h"
+#include "../device/PhysicalDevice.h"
+
+namespace {
+// Header of the pipeline cache data (VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+struct PipelineCacheHeader {
+    uint32_t mHeaderSize;
+    uint32_t mHeaderVersion;
+    uint32_t mVendorId;
+    uint32_t mDeviceId;
+    uint8_t mPipelineCacheUuid[VK_UUID_SIZE];
+};
+static_assert(sizeof(PipelineCacheHeader) == 16 + VK_UUID_SIZE, "Unexpected pipeline cache header padding");
+}
+
+namespace vulkan {
+vk::UniquePipelineCache
+PipelineCache::mPipelineCache = vk::UniquePipelineCache();
+
+std::string
+PipelineCache::mFilePath = {};
+
+bool
+PipelineCache::mIsWarmStart = false;
+
+std::atomic<uint64_t>
+PipelineCache::mPipelineCreationTime(0);
+
+std::atomic<uint32_t>
+PipelineCache::mPipelineCount(0);
+
+void
+PipelineCache::initialize(const std::string& filePath) {
+    assert(mPipelineCache.get() == VK_NULL_HANDLE);
+    assert(filePath.empty() == false);
+
+    mFilePath = filePath;
+    mPipelineCreationTime = 0;
+    mPipelineCount = 0;
+
+    const std::vector<uint8_t> cacheData = file_system::readFile(filePath);
+    mIsWarmStart = isValidCacheData(cacheData);
+
+    vk::PipelineCacheCreateInfo info;
+    if (mIsWarmStart) {
+        info.setInitialDataSize(cacheData.size());
+        info.setPInitialData(cacheData.data());
+    }
+    mPipelineCache = LogicalDevice::device().createPipelineCacheUnique(info);
+}
+
+void
+PipelineCache::finalize() {
+    assert(mPipelineCache.get() != VK_NULL_HANDLE);
+
+    std::cout << "Pipeline cache (" << (mIsWarmStart ? "warm" : "cold") << " start): "
+              << mPipelineCount << " pipelines created in "
+              << mPipelineCreationTime / 1000000.0 << " ms" << std::endl;
+
+    const std::vector<uint8_t> cacheData =
+        LogicalDevice::device().getPipelineCacheData(mPipelineCache.get());
+    file_system::writeFileAtomically(mFilePath,
+                                     cacheData.data(),
+                                     cacheData.size());
+
+    mPipelineCache.reset();
+    mFilePath.clear();
+}
+
+vk::PipelineCache
+PipelineCache::cache() {
+    assert(mPipelineCache.get() != VK_NULL_HANDLE);
+    return mPipelineCache.get();
+}
+
+bool
+PipelineCache::isWarmStart() {
+    assert(mPipelineCache.get() != VK_NULL_HANDLE);
+    return mIsWarmStart;
+}
+
+void
+PipelineCache::addPipelineCreationTime(const uint64_t nanoseconds) {
+    mPipelineCreationTime += nanoseconds;
+    ++mPipelineCount;
+}
+
+bool
+PipelineCache::isValidCacheData(const std::vector<uint8_t>& cacheData) {
+    if (cacheData.size() < sizeof(PipelineCacheHeader)) {
+        return false;
+    }
+
+    PipelineCacheHeader header;
+    std::memcpy(&header,
+                cacheData.data(),
+                sizeof(header));
+
+    // The cache data of a different device or driver version
+    // would be ignored by the driver (or worse, it could crash).
+    const vk::PhysicalDeviceProperties properties = PhysicalDevice::device().getProperties();
+    return header.mHeaderSize >= sizeof(PipelineCacheHeader) &&
+           header.mHeaderSize <= cacheData.size() &&
+           header.mHeaderVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.mVendorId == properties.vendorID &&
+           header.mDeviceId == properties.deviceID &&
+           std::memcmp(header.mPipelineCacheUuid,
+                       properties.pipelineCacheUUID,
+                       VK_UUID_SIZE) == 0;
+}
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef UTILS_PIPELINE_PIPELINE_CACHE
+#define UTILS_PIPELINE_PIPELINE_CACHE
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+//
+// Global PipelineCache, persisted on disk.
+//
+// Pipeline cache objects allow the result of pipeline construction to be reused
+// between pipelines and between runs of an application.
+// Reuse between pipelines is achieved by passing the same pipeline cache object
+// when creating multiple related pipelines.
+// Reuse across runs of an application is achieved by retrieving pipeline cache
+// contents in one run of an application, saving the contents, and using them
+// to preinitialize a pipeline cache on a subsequent run.
+//
+// The cache data starts with a header, that must match the physical device
+// (vendor ID, device ID and pipeline cache UUID). If it does not match
+// (for example, after a driver update), then the file is ignored and
+// the cache starts empty (cold start).
+//
+// The cache is written to a temporary file that then replaces the previous one,
+// so a crash during the write never leaves a corrupted cache.
+//
+// The time spent creating pipelines is reported in finalize(), to compare
+// cold starts (empty cache) and warm starts (loaded cache).
+//
+// Preconditions:
+// - The global logical device must be initialized first.
+//
+class PipelineCache {
+public:
+    // * filePath of the cache data. It does not need to exist.
+    static void
+    initialize(const std::string& filePath);
+
+    // Writes the cache data to the file.
+    static void
+    finalize();
+
+    // It can be used to create pipelines from any thread, as
+    // pipeline caches are internally synchronized.
+    static vk::PipelineCache
+    cache();
+
+    // True if valid cache data was loaded from the file.
+    static bool
+    isWarmStart();
+
+    // Accumulates the time spent creating a pipeline.
+    // It is thread safe.
+    static void
+    addPipelineCreationTime(const uint64_t nanoseconds);
+
+private:
+    PipelineCache() = delete;
+    ~PipelineCache() = delete;
+    PipelineCache(PipelineCache&&) noexcept = delete;
+    PipelineCache(const PipelineCache&) = delete;
+    const PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // Checks the header of the cache data against the global physical device.
+    static bool
+    isValidCacheData(const std::vector<uint8_t>& cacheData);
+
+    static vk::UniquePipelineCache mPipelineCache;
+    static std::string mFilePath;
+    static bool mIsWarmStart;
+
+    static std::atomic<uint64_t> mPipelineCreationTime;
+    static std::atomic<uint32_t> mPipelineCount;
+};
+}
+
+#endif
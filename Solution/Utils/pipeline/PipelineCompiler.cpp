@@ -0,0 +1,234 @@
+#include "PipelineCompiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace vulkan {
+PipelineCompileJob::PipelineCompileJob(const vk::PipelineLayout pipelineLayout,
+                                       const PipelineStates& pipelineStates,
+                                       const ShaderStages& shaderStages,
+                                       const vk::RenderPass renderPass,
+                                       const uint32_t subPassIndex)
+    : mPipelineLayout(pipelineLayout)
+    , mPipelineStates(pipelineStates)
+    , mShaderStages(shaderStages)
+    , mRenderPass(renderPass)
+    , mSubPassIndex(subPassIndex)
+    , mIsReady(false)
+{
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(renderPass != VK_NULL_HANDLE);
+}
+
+PipelineCompileJob::PipelineCompileJob(const vk::PipelineLayout pipelineLayout,
+                                       const std::vector<vk::Pipeline>& pipelineLibraries)
+    : mPipelineLayout(pipelineLayout)
+    , mPipelineLibraries(pipelineLibraries)
+    , mIsReady(false)
+{
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(pipelineLibraries.empty() == false);
+}
+
+bool
+PipelineCompileJob::isReady() const {
+    return mIsReady.load(std::memory_order_acquire);
+}
+
+void
+PipelineCompileJob::wait() {
+    std::unique_lock<std::mutex> lock(mReadyMutex);
+    mReadyCondition.wait(lock,
+                         [this] { return isReady(); });
+}
+
+std::unique_ptr<GraphicsPipeline>
+PipelineCompileJob::takePipeline() {
+    assert(isReady());
+    if (mException != nullptr) {
+        std::rethrow_exception(mException);
+    }
+
+    assert(mPipeline != nullptr);
+    return std::move(mPipeline);
+}
+
+void
+PipelineCompileJob::compile() {
+    assert(isReady() == false);
+
+    // An exception must not leave the worker thread (it would terminate
+    // the application), so it is thrown by takePipeline().
+    try {
+        if (mPipelineLibraries.empty()) {
+            mPipeline.reset(new GraphicsPipeline(mPipelineLayout,
+                                                 mPipelineStates,
+                                                 mShaderStages,
+                                                 mRenderPass,
+                                                 mSubPassIndex));
+        } else {
+            mPipeline.reset(new GraphicsPipeline(mPipelineLayout,
+                                                 mPipelineLibraries,
+                                                 true));
+        }
+    } catch (...) {
+        mException = std::current_exception();
+    }
+
+    setReady();
+}
+
+void
+PipelineCompileJob::cancel() {
+    assert(isReady() == false);
+
+    mException = std::make_exception_ptr(std::runtime_error("The pipeline compilation was cancelled"));
+    setReady();
+}
+
+void
+PipelineCompileJob::setReady() {
+    // The pipeline must be visible to the main thread
+    // before it sees that the job is ready.
+    // The flag is set with the mutex locked, so wait() cannot miss the notification.
+    {
+        std::lock_guard<std::mutex> lock(mReadyMutex);
+        mIsReady.store(true, std::memory_order_release);
+    }
+    mReadyCondition.notify_all();
+}
+
+std::vector<std::thread>
+PipelineCompiler::mWorkerThreads = {};
+
+std::deque<std::shared_ptr<PipelineCompileJob>>
+PipelineCompiler::mPendingJobs = {};
+
+std::mutex
+PipelineCompiler::mMutex;
+
+std::condition_variable
+PipelineCompiler::mJobAvailableCondition;
+
+std::condition_variable
+PipelineCompiler::mJobCompletedCondition;
+
+uint32_t
+PipelineCompiler::mRunningJobCount = 0;
+
+bool
+PipelineCompiler::mIsFinalizing = false;
+
+void
+PipelineCompiler::initialize(const uint32_t workerThreadCount) {
+    assert(mWorkerThreads.empty());
+
+    uint32_t threadCount = workerThreadCount;
+    if (threadCount == 0) {
+        // hardware_concurrency() can be 0 if it is unknown.
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    mIsFinalizing = false;
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        mWorkerThreads.emplace_back(workerThreadMain);
+    }
+}
+
+void
+PipelineCompiler::finalize() {
+    cancelJobs();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsFinalizing = true;
+    }
+    mJobAvailableCondition.notify_all();
+
+    for (std::thread& workerThread : mWorkerThreads) {
+        workerThread.join();
+    }
+    mWorkerThreads.clear();
+}
+
+void
+PipelineCompiler::cancelJobs() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (const std::shared_ptr<PipelineCompileJob>& job : mPendingJobs) {
+        job->cancel();
+    }
+    mPendingJobs.clear();
+
+    mJobCompletedCondition.wait(lock,
+                                [] { return mRunningJobCount == 0; });
+}
+
+std::shared_ptr<PipelineCompileJob>
+PipelineCompiler::compile(const vk::PipelineLayout pipelineLayout,
+                          const PipelineStates& pipelineStates,
+                          const ShaderStages& shaderStages,
+                          const vk::RenderPass renderPass,
+                          const uint32_t subPassIndex) {
+    assert(mWorkerThreads.empty() == false);
+
+    std::shared_ptr<PipelineCompileJob> job =
+        std::make_shared<PipelineCompileJob>(pipelineLayout,
+                                             pipelineStates,
+                                             shaderStages,
+                                             renderPass,
+                                             subPassIndex);
+    pushJob(job);
+
+    return job;
+}
+
+std::shared_ptr<PipelineCompileJob>
+PipelineCompiler::link(const vk::PipelineLayout pipelineLayout,
+                       const std::vector<vk::Pipeline>& pipelineLibraries) {
+    assert(mWorkerThreads.empty() == false);
+
+    std::shared_ptr<PipelineCompileJob> job =
+        std::make_shared<PipelineCompileJob>(pipelineLayout,
+                                             pipelineLibraries);
+    pushJob(job);
+
+    return job;
+}
+
+void
+PipelineCompiler::pushJob(const std::shared_ptr<PipelineCompileJob>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPendingJobs.push_back(job);
+    }
+    mJobAvailableCondition.notify_one();
+}
+
+void
+PipelineCompiler::workerThreadMain() {
+    for (;;) {
+        std::shared_ptr<PipelineCompileJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobAvailableCondition.wait(lock,
+                                        [] { return mIsFinalizing || mPendingJobs.empty() == false; });
+            if (mIsFinalizing) {
+                return;
+            }
+
+            job = mPendingJobs.front();
+            mPendingJobs.pop_front();
+            ++mRunningJobCount;
+        }
+
+        job->compile();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mRunningJobCount;
+        }
+        mJobCompletedCondition.notify_all();
+    }
+}
+}
@@ -0,0 +1,161 @@
+#ifndef UTILS_PIPELINE_PIPELINE_COMPILER
+#define UTILS_PIPELINE_PIPELINE_COMPILER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "GraphicsPipeline.h"
+#include "PipelineStates.h"
+#include "../shader/ShaderStages.h"
+
+namespace vulkan {
+//
+// Graphics pipeline compilation job.
+//
+// It keeps a copy of the creation state, so the caller does not need to
+// keep it alive until the pipeline is compiled.
+//
+// A job can also link pipeline libraries with link time optimization
+// (Read PipelineLibrary). The libraries must outlive the job.
+//
+// If the compilation throws (vk::SystemError), then the exception is kept
+// in the job, and takePipeline() throws it in the thread that calls it.
+//
+class PipelineCompileJob {
+public:
+    PipelineCompileJob(const vk::PipelineLayout pipelineLayout,
+                       const PipelineStates& pipelineStates,
+                       const ShaderStages& shaderStages,
+                       const vk::RenderPass renderPass,
+                       const uint32_t subPassIndex);
+    PipelineCompileJob(const vk::PipelineLayout pipelineLayout,
+                       const std::vector<vk::Pipeline>& pipelineLibraries);
+    PipelineCompileJob(const PipelineCompileJob&) = delete;
+    const PipelineCompileJob& operator=(const PipelineCompileJob&) = delete;
+
+    // It does not block.
+    bool
+    isReady() const;
+
+    // Blocks until the job is ready (compiled, failed or cancelled).
+    void
+    wait();
+
+    // Precondition: isReady() must be true.
+    // It can only be called once.
+    // It throws the exception of the compilation, if it failed
+    // (the job was cancelled, for example).
+    std::unique_ptr<GraphicsPipeline>
+    takePipeline();
+
+private:
+    friend class PipelineCompiler;
+
+    // Called by a worker thread.
+    void
+    compile();
+
+    // The job is ready, and takePipeline() throws.
+    void
+    cancel();
+
+    void
+    setReady();
+
+    vk::PipelineLayout mPipelineLayout;
+    PipelineStates mPipelineStates;
+    ShaderStages mShaderStages;
+    vk::RenderPass mRenderPass;
+    uint32_t mSubPassIndex = 0;
+
+    // If it is not empty, then the job links them
+    // instead of compiling the states.
+    std::vector<vk::Pipeline> mPipelineLibraries;
+
+    std::unique_ptr<GraphicsPipeline> mPipeline;
+    std::exception_ptr mException;
+    std::atomic<bool> mIsReady;
+    std::mutex mReadyMutex;
+    std::condition_variable mReadyCondition;
+};
+
+//
+// Pool of worker threads that compile graphics pipelines in parallel.
+//
+// Pipeline creation is the most expensive operation of the initialization
+// (drivers compile the shaders to the device instruction set), and
+// it does not need the main thread. vkCreateGraphicsPipelines can be called
+// from many threads at the same time, and all of them use the global
+// PipelineCache (pipeline caches are internally synchronized), so the
+// results are shared with all the workers and the next runs.
+//
+// Jobs are compiled in submission order. The main thread polls them
+// (Read PipelineSystem::requestGraphicsPipeline()), and skips the draws
+// (or uses a fallback) while they are not ready.
+//
+// Jobs use the pipeline layout and render pass handles they were given, so
+// cancelJobs() must be called before any of them is destroyed.
+//
+// Preconditions:
+// - The global logical device and PipelineCache must be initialized first.
+//
+class PipelineCompiler {
+public:
+    // * workerThreadCount. If it is 0, then there is a worker for each
+    //   hardware thread, except the main thread.
+    static void
+    initialize(const uint32_t workerThreadCount = 0);
+
+    // Waits for the jobs in progress. Pending jobs are cancelled.
+    static void
+    finalize();
+
+    // Cancels the pending jobs, and waits for the jobs in progress.
+    // The workers are still available for new jobs.
+    static void
+    cancelJobs();
+
+    static std::shared_ptr<PipelineCompileJob>
+    compile(const vk::PipelineLayout pipelineLayout,
+            const PipelineStates& pipelineStates,
+            const ShaderStages& shaderStages,
+            const vk::RenderPass renderPass,
+            const uint32_t subPassIndex = 0);
+
+    // Links the pipeline libraries with link time optimization.
+    static std::shared_ptr<PipelineCompileJob>
+    link(const vk::PipelineLayout pipelineLayout,
+         const std::vector<vk::Pipeline>& pipelineLibraries);
+
+private:
+    PipelineCompiler() = delete;
+    ~PipelineCompiler() = delete;
+    PipelineCompiler(PipelineCompiler&&) noexcept = delete;
+    PipelineCompiler(const PipelineCompiler&) = delete;
+    const PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+    static void
+    pushJob(const std::shared_ptr<PipelineCompileJob>& job);
+
+    static void
+    workerThreadMain();
+
+    static std::vector<std::thread> mWorkerThreads;
+    static std::deque<std::shared_ptr<PipelineCompileJob>> mPendingJobs;
+    static std::mutex mMutex;
+    static std::condition_variable mJobAvailableCondition;
+    static std::condition_variable mJobCompletedCondition;
+    static uint32_t mRunningJobCount;
+    static bool mIsFinalizing;
+};
+}
+
+#endif
@@ -0,0 +1,181 @@
+#include "PipelineLibrary.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "GraphicsPipeline.h"
+#include "../device/LogicalDevice.h"
+#include "../shader/ShaderModule.h"
+
+namespace vulkan {
+bool
+PipelineLibrary::isSupported() {
+    return LogicalDevice::isGraphicsPipelineLibraryEnabled();
+}
+
+PipelineStates
+PipelineLibrary::partStates(const Part part,
+                            const PipelineStates& pipelineStates) {
+    PipelineStates states;
+
+    // The dynamic states are given to every part, and each part
+    // only uses the ones related with its states.
+    if (pipelineStates.dynamicState() != nullptr) {
+        states.setDynamicState(*pipelineStates.dynamicState());
+    }
+
+    switch (part) {
+    case Part::VertexInput:
+        if (pipelineStates.vertexInputState() != nullptr) {
+            states.setVertexInputState(*pipelineStates.vertexInputState());
+        }
+        if (pipelineStates.inputAssemblyState() != nullptr) {
+            states.setInputAssemblyState(*pipelineStates.inputAssemblyState());
+        }
+        break;
+
+    case Part::PreRasterization:
+        if (pipelineStates.viewportState() != nullptr) {
+            states.setViewportState(*pipelineStates.viewportState());
+        }
+        if (pipelineStates.rasterizationState() != nullptr) {
+            states.setRasterizationState(*pipelineStates.rasterizationState());
+        }
+        if (pipelineStates.tessellationState() != nullptr) {
+            states.setTessellationState(*pipelineStates.tessellationState());
+        }
+        break;
+
+    case Part::FragmentShader:
+        if (pipelineStates.depthStencilState() != nullptr) {
+            states.setDepthStencilState(*pipelineStates.depthStencilState());
+        }
+        if (pipelineStates.multisampleState() != nullptr) {
+            states.setMultisampleState(*pipelineStates.multisampleState());
+        }
+        break;
+
+    case Part::FragmentOutput:
+        if (pipelineStates.colorBlendState() != nullptr) {
+            states.setColorBlendState(*pipelineStates.colorBlendState());
+        }
+        if (pipelineStates.multisampleState() != nullptr) {
+            states.setMultisampleState(*pipelineStates.multisampleState());
+        }
+        break;
+    }
+
+    return states;
+}
+
+ShaderStages
+PipelineLibrary::partShaderStages(const Part part,
+                                  const ShaderStages& shaderStages) {
+    // The specialization constants are kept, so they
+    // are part of the library of their stage.
+    switch (part) {
+    case Part::PreRasterization:
+        return shaderStages.stagesOf(vk::ShaderStageFlags(vk::ShaderStageFlagBits::eAllGraphics) & ~vk::ShaderStageFlags(vk::ShaderStageFlagBits::eFragment));
+    case Part::FragmentShader:
+        return shaderStages.stagesOf(vk::ShaderStageFlagBits::eFragment);
+    default:
+        return ShaderStages();
+    }
+}
+
+PipelineLibrary::PipelineLibrary(const Part part,
+                                 const vk::PipelineLayout pipelineLayout,
+                                 const PipelineStates& pipelineStates,
+                                 const ShaderStages& shaderStages,
+                                 const vk::RenderPass renderPass,
+                                 const uint32_t subPassIndex)
+    : mPart(part)
+{
+    assert(isSupported());
+    assert(renderPass != VK_NULL_HANDLE);
+    assert(pipelineLayout != VK_NULL_HANDLE ||
+           part == Part::VertexInput ||
+           part == Part::FragmentOutput);
+
+#ifdef VK_EXT_graphics_pipeline_library
+    vk::GraphicsPipelineLibraryCreateInfoEXT libraryInfo;
+    switch (part) {
+    case Part::VertexInput:
+        libraryInfo.setFlags(vk::GraphicsPipelineLibraryFlagBitsEXT::eVertexInputInterface);
+        break;
+    case Part::PreRasterization:
+        libraryInfo.setFlags(vk::GraphicsPipelineLibraryFlagBitsEXT::ePreRasterizationShaders);
+        break;
+    case Part::FragmentShader:
+        libraryInfo.setFlags(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentShader);
+        break;
+    case Part::FragmentOutput:
+        libraryInfo.setFlags(vk::GraphicsPipelineLibraryFlagBitsEXT::eFragmentOutputInterface);
+        break;
+    }
+
+    vk::GraphicsPipelineCreateInfo info;
+    info.setPNext(&libraryInfo);
+    info.setFlags(vk::PipelineCreateFlagBits::eLibraryKHR |
+                  vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT);
+    info.setStageCount(static_cast<uint32_t>(shaderStages.stages().size()));
+    info.setPStages(shaderStages.stages().empty() ? nullptr : shaderStages.stages().data());
+    info.setPVertexInputState(pipelineStates.vertexInputState() != nullptr ?
+                              &pipelineStates.vertexInputState()->state() :
+                              nullptr);
+    info.setPInputAssemblyState(pipelineStates.inputAssemblyState() != nullptr ?
+                                &pipelineStates.inputAssemblyState()->state() :
+                                nullptr);
+    info.setPTessellationState(pipelineStates.tessellationState() != nullptr ?
+                               &pipelineStates.tessellationState()->state() :
+                               nullptr);
+    info.setPViewportState(pipelineStates.viewportState() != nullptr ?
+                           &pipelineStates.viewportState()->state() :
+                           nullptr);
+    info.setPRasterizationState(pipelineStates.rasterizationState() != nullptr ?
+                                &pipelineStates.rasterizationState()->state() :
+                                nullptr);
+    info.setPMultisampleState(pipelineStates.multisampleState() != nullptr ?
+                              &pipelineStates.multisampleState()->state() :
+                              nullptr);
+    info.setPDepthStencilState(pipelineStates.depthStencilState() != nullptr ?
+                               &pipelineStates.depthStencilState()->state() :
+                               nullptr);
+    info.setPColorBlendState(pipelineStates.colorBlendState() != nullptr ?
+                             &pipelineStates.colorBlendState()->state() :
+                             nullptr);
+    info.setPDynamicState(pipelineStates.dynamicState() != nullptr ?
+                          &pipelineStates.dynamicState()->state() :
+                          nullptr);
+    info.setLayout(pipelineLayout);
+    info.setRenderPass(renderPass);
+    info.setSubpass(subPassIndex);
+
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    mPipeline = GraphicsPipeline::createUniquePipeline(info);
+    const std::chrono::nanoseconds creationTime = std::chrono::steady_clock::now() - beginTime;
+    mCreationTime = static_cast<uint64_t>(creationTime.count());
+#else
+    (void)pipelineLayout;
+    (void)pipelineStates;
+    (void)shaderStages;
+    (void)subPassIndex;
+#endif
+}
+
+vk::Pipeline
+PipelineLibrary::pipeline() const {
+    assert(mPipeline.get() != VK_NULL_HANDLE);
+    return mPipeline.get();
+}
+
+PipelineLibrary::Part
+PipelineLibrary::part() const {
+    return mPart;
+}
+
+uint64_t
+PipelineLibrary::creationTime() const {
+    return mCreationTime;
+}
+}
@@ -0,0 +1,96 @@
+#ifndef UTILS_PIPELINE_PIPELINE_LIBRARY
+#define UTILS_PIPELINE_PIPELINE_LIBRARY
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+#include "PipelineStates.h"
+#include "../shader/ShaderStages.h"
+
+namespace vulkan {
+//
+// Graphics pipeline library wrapper (VK_EXT_graphics_pipeline_library).
+//
+// A graphics pipeline can be split into 4 parts, that are compiled
+// independently and then linked into a complete pipeline:
+// - Vertex input interface: vertex input and input assembly states.
+// - Pre-rasterization shaders: vertex, tessellation and geometry shaders,
+//   viewport, rasterization and tessellation states.
+// - Fragment shader: fragment shader, depth stencil and multisample states.
+// - Fragment output interface: color blend and multisample states.
+//
+// Pipeline variants usually differ in a single part (for example, the fragment
+// shader or the blend state), so the other parts are reused and only
+// the different one is compiled. Linking without optimization (fast link) is
+// much cheaper than compiling a complete pipeline, and a second link with
+// link time optimization produces a pipeline as fast as a monolithic one
+// (Read PipelineSystem::requestLinkedGraphicsPipeline()).
+//
+// The extension is only used if the Vulkan headers define it, and
+// the global logical device enabled it (Read isSupported()).
+//
+// To create/use the PipelineLibrary you need:
+// - PipelineLayout
+// - RenderPass
+//
+class PipelineLibrary {
+public:
+    enum class Part {
+        VertexInput,
+        PreRasterization,
+        FragmentShader,
+        FragmentOutput
+    };
+
+    static const uint32_t sPartCount = 4;
+
+    // True if the global logical device supports graphics pipeline libraries.
+    static bool
+    isSupported();
+
+    // Returns the states of pipelineStates that belong to part.
+    static PipelineStates
+    partStates(const Part part,
+               const PipelineStates& pipelineStates);
+
+    // Returns the stages of shaderStages that belong to part.
+    static ShaderStages
+    partShaderStages(const Part part,
+                     const ShaderStages& shaderStages);
+
+    // * pipelineStates and shaderStages must only contain the states
+    //   of the part (Read partStates() and partShaderStages()).
+    //
+    // * pipelineLayout is not used by the vertex input and fragment output parts.
+    //
+    // The library keeps the information needed to be linked with
+    // link time optimization.
+    //
+    // Precondition: isSupported() must be true.
+    PipelineLibrary(const Part part,
+                    const vk::PipelineLayout pipelineLayout,
+                    const PipelineStates& pipelineStates,
+                    const ShaderStages& shaderStages,
+                    const vk::RenderPass renderPass,
+                    const uint32_t subPassIndex = 0);
+    PipelineLibrary(const PipelineLibrary&) = delete;
+    const PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+    vk::Pipeline
+    pipeline() const;
+
+    Part
+    part() const;
+
+    // Time spent compiling the library, in nanoseconds.
+    uint64_t
+    creationTime() const;
+
+private:
+    vk::UniquePipeline mPipeline;
+    Part mPart;
+    uint64_t mCreationTime = 0;
+};
+}
+
+#endif
@@ -0,0 +1,773 @@
+#include "PipelineManifest.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "../FileSystem.h"
+#include "../shader/ShaderArchive.h"
+#include "../shader/ShaderModule.h"
+#include "../shader/ShaderModuleSystem.h"
+
+namespace {
+const uint32_t sManifestMagic = 0x4D504B56; // "VKPM"
+const uint32_t sManifestVersion = 2;
+
+// Appends values as raw memory, so it can only be used with structs
+// without pointers (Vulkan description structs and enums).
+class BinaryWriter {
+public:
+    template<typename T>
+    void
+    add(const T& value) {
+        mData.append(reinterpret_cast<const char*>(&value),
+                     sizeof(T));
+    }
+
+    template<typename T>
+    void
+    addArray(const T* array,
+             const uint32_t count) {
+        add(count);
+        if (count > 0) {
+            assert(array != nullptr);
+            mData.append(reinterpret_cast<const char*>(array),
+                         sizeof(T) * count);
+        }
+    }
+
+    void
+    addString(const std::string& string) {
+        addArray(string.data(),
+                 static_cast<uint32_t>(string.size()));
+    }
+
+    const std::string&
+    data() const {
+        return mData;
+    }
+
+private:
+    std::string mData;
+};
+
+// Every read fails (returns false) if there are not enough bytes,
+// so a truncated or corrupted file is detected.
+class BinaryReader {
+public:
+    BinaryReader(const std::string& data)
+        : mData(data)
+    {
+
+    }
+
+    template<typename T>
+    bool
+    read(T& value) {
+        if (mData.size() - mOffset < sizeof(T)) {
+            return false;
+        }
+
+        std::memcpy(&value,
+                    mData.data() + mOffset,
+                    sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    template<typename T>
+    bool
+    readVector(std::vector<T>& vector) {
+        uint32_t count = 0;
+        if (read(count) == false || (mData.size() - mOffset) / sizeof(T) < count) {
+            return false;
+        }
+
+        vector.resize(count);
+        if (count > 0) {
+            std::memcpy(vector.data(),
+                        mData.data() + mOffset,
+                        sizeof(T) * count);
+            mOffset += sizeof(T) * count;
+        }
+        return true;
+    }
+
+    bool
+    readString(std::string& string) {
+        std::vector<char> characters;
+        if (readVector(characters) == false) {
+            return false;
+        }
+
+        string.assign(characters.begin(),
+                      characters.end());
+        return true;
+    }
+
+    bool
+    isAtEnd() const {
+        return mOffset == mData.size();
+    }
+
+private:
+    const std::string& mData;
+    size_t mOffset = 0;
+};
+
+// Enums and flags are read as raw memory, so a corrupted file can contain
+// values that are not valid. Only the core values are accepted (the entries
+// with values of other extensions are not prewarmed).
+template<typename T>
+bool
+isValidEnum(const T value,
+            const T lastValue) {
+    return static_cast<uint32_t>(value) <= static_cast<uint32_t>(lastValue);
+}
+
+bool
+isValidFlags(const uint32_t flags,
+             const uint32_t validFlags) {
+    return (flags & ~validFlags) == 0;
+}
+
+bool
+isValidFlagBit(const uint32_t flagBit,
+               const uint32_t validFlags) {
+    return flagBit != 0 &&
+           (flagBit & (flagBit - 1)) == 0 &&
+           isValidFlags(flagBit, validFlags);
+}
+
+bool
+isValidBool(const vk::Bool32 value) {
+    return value == VK_FALSE || value == VK_TRUE;
+}
+
+bool
+isValidStencilOpState(const vk::StencilOpState& state) {
+    return isValidEnum(state.failOp, vk::StencilOp::eDecrementAndWrap) &&
+           isValidEnum(state.passOp, vk::StencilOp::eDecrementAndWrap) &&
+           isValidEnum(state.depthFailOp, vk::StencilOp::eDecrementAndWrap) &&
+           isValidEnum(state.compareOp, vk::CompareOp::eAlways);
+}
+
+bool
+isValidColorBlendAttachmentState(const vk::PipelineColorBlendAttachmentState& state) {
+    const vk::ColorComponentFlags allComponents = vk::ColorComponentFlagBits::eR |
+                                                  vk::ColorComponentFlagBits::eG |
+                                                  vk::ColorComponentFlagBits::eB |
+                                                  vk::ColorComponentFlagBits::eA;
+    return isValidBool(state.blendEnable) &&
+           isValidEnum(state.srcColorBlendFactor, vk::BlendFactor::eOneMinusSrc1Alpha) &&
+           isValidEnum(state.dstColorBlendFactor, vk::BlendFactor::eOneMinusSrc1Alpha) &&
+           isValidEnum(state.colorBlendOp, vk::BlendOp::eMax) &&
+           isValidEnum(state.srcAlphaBlendFactor, vk::BlendFactor::eOneMinusSrc1Alpha) &&
+           isValidEnum(state.dstAlphaBlendFactor, vk::BlendFactor::eOneMinusSrc1Alpha) &&
+           isValidEnum(state.alphaBlendOp, vk::BlendOp::eMax) &&
+           isValidFlags(static_cast<VkColorComponentFlags>(state.colorWriteMask),
+                        static_cast<VkColorComponentFlags>(allComponents));
+}
+
+// The dynamic states of DynamicStateFields are accepted (Read ExtendedDynamicState).
+bool
+isValidDynamicState(const vk::DynamicState dynamicState) {
+    if (isValidEnum(dynamicState, vk::DynamicState::eStencilReference)) {
+        return true;
+    }
+
+    switch (dynamicState) {
+#ifdef VK_EXT_extended_dynamic_state
+    case vk::DynamicState::eCullModeEXT:
+    case vk::DynamicState::eFrontFaceEXT:
+    case vk::DynamicState::ePrimitiveTopologyEXT:
+    case vk::DynamicState::eDepthTestEnableEXT:
+    case vk::DynamicState::eDepthWriteEnableEXT:
+    case vk::DynamicState::eDepthCompareOpEXT:
+    case vk::DynamicState::eDepthBoundsTestEnableEXT:
+    case vk::DynamicState::eStencilTestEnableEXT:
+    case vk::DynamicState::eStencilOpEXT:
+        return true;
+#endif
+#ifdef VK_EXT_extended_dynamic_state2
+    case vk::DynamicState::eRasterizerDiscardEnableEXT:
+    case vk::DynamicState::eDepthBiasEnableEXT:
+    case vk::DynamicState::ePrimitiveRestartEnableEXT:
+        return true;
+#endif
+#ifdef VK_EXT_extended_dynamic_state3
+    case vk::DynamicState::ePolygonModeEXT:
+    case vk::DynamicState::eDepthClampEnableEXT:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Returns false if the pipeline cannot be described by the manifest.
+bool
+serializeShaderStages(BinaryWriter& writer,
+                      const vulkan::ShaderStages& shaderStages) {
+    const std::vector<vk::PipelineShaderStageCreateInfo>& stages = shaderStages.stages();
+    const std::vector<const vulkan::ShaderModule*>& shaderModules = shaderStages.shaderModules();
+    assert(stages.size() == shaderModules.size());
+
+    writer.add(static_cast<uint32_t>(stages.size()));
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const vulkan::ShaderModule& shaderModule = *shaderModules[i];
+        writer.addString(shaderModule.shaderByteCodePath());
+        writer.add(shaderModule.shaderStageFlag());
+        writer.addString(shaderModule.entryPointName());
+
+        // Specialization constants are 32 bits (Read ShaderStages::setSpecializationConstant())
+        const vk::SpecializationInfo* specializationInfo = stages[i].pSpecializationInfo;
+        const uint32_t constantCount = specializationInfo != nullptr ? specializationInfo->mapEntryCount : 0;
+        writer.add(constantCount);
+        for (uint32_t j = 0; j < constantCount; ++j) {
+            const vk::SpecializationMapEntry& entry = specializationInfo->pMapEntries[j];
+            if (entry.size != sizeof(uint32_t)) {
+                return false;
+            }
+
+            uint32_t value;
+            std::memcpy(&value,
+                        static_cast<const uint8_t*>(specializationInfo->pData) + entry.offset,
+                        sizeof(value));
+            writer.add(entry.constantID);
+            writer.add(value);
+        }
+    }
+
+    return true;
+}
+
+bool
+serializePipelineStates(BinaryWriter& writer,
+                        const vulkan::PipelineStates& pipelineStates) {
+    const vulkan::VertexInputState* vertexInputState = pipelineStates.vertexInputState();
+    writer.add(vertexInputState != nullptr);
+    if (vertexInputState != nullptr) {
+        const vk::PipelineVertexInputStateCreateInfo& info = vertexInputState->state();
+        writer.addArray(info.pVertexBindingDescriptions,
+                        info.vertexBindingDescriptionCount);
+        writer.addArray(info.pVertexAttributeDescriptions,
+                        info.vertexAttributeDescriptionCount);
+    }
+
+    const vulkan::InputAssemblyState* inputAssemblyState = pipelineStates.inputAssemblyState();
+    writer.add(inputAssemblyState != nullptr);
+    if (inputAssemblyState != nullptr) {
+        const vk::PipelineInputAssemblyStateCreateInfo& info = inputAssemblyState->state();
+        writer.add(info.topology);
+        writer.add(info.primitiveRestartEnable);
+    }
+
+    const vulkan::TessellationState* tessellationState = pipelineStates.tessellationState();
+    writer.add(tessellationState != nullptr);
+    if (tessellationState != nullptr) {
+        writer.add(tessellationState->state().patchControlPoints);
+    }
+
+    // ViewportState has a single viewport and scissor rectangle.
+    const vulkan::ViewportState* viewportState = pipelineStates.viewportState();
+    writer.add(viewportState != nullptr);
+    if (viewportState != nullptr) {
+        const vk::PipelineViewportStateCreateInfo& info = viewportState->state();
+        assert(info.viewportCount == 1 && info.pViewports != nullptr);
+        assert(info.scissorCount == 1 && info.pScissors != nullptr);
+        writer.add(info.pViewports[0]);
+        writer.add(info.pScissors[0]);
+    }
+
+    const vulkan::RasterizationState* rasterizationState = pipelineStates.rasterizationState();
+    writer.add(rasterizationState != nullptr);
+    if (rasterizationState != nullptr) {
+        const vk::PipelineRasterizationStateCreateInfo& info = rasterizationState->state();
+        writer.add(info.depthClampEnable);
+        writer.add(info.rasterizerDiscardEnable);
+        writer.add(info.polygonMode);
+        writer.add(info.lineWidth);
+        writer.add(info.cullMode);
+        writer.add(info.frontFace);
+        writer.add(info.depthBiasEnable);
+        writer.add(info.depthBiasConstantFactor);
+        writer.add(info.depthBiasClamp);
+        writer.add(info.depthBiasSlopeFactor);
+    }
+
+    // The sample mask is a pointer owned by the application.
+    const vulkan::MultisampleState* multisampleState = pipelineStates.multisampleState();
+    writer.add(multisampleState != nullptr);
+    if (multisampleState != nullptr) {
+        const vk::PipelineMultisampleStateCreateInfo& info = multisampleState->state();
+        if (info.pSampleMask != nullptr) {
+            return false;
+        }
+        writer.add(info.rasterizationSamples);
+        writer.add(info.sampleShadingEnable);
+        writer.add(info.minSampleShading);
+        writer.add(info.alphaToCoverageEnable);
+        writer.add(info.alphaToOneEnable);
+    }
+
+    const vulkan::DepthStencilState* depthStencilState = pipelineStates.depthStencilState();
+    writer.add(depthStencilState != nullptr);
+    if (depthStencilState != nullptr) {
+        const vk::PipelineDepthStencilStateCreateInfo& info = depthStencilState->state();
+        writer.add(info.depthTestEnable);
+        writer.add(info.depthWriteEnable);
+        writer.add(info.depthCompareOp);
+        writer.add(info.depthBoundsTestEnable);
+        writer.add(info.stencilTestEnable);
+        writer.add(info.front);
+        writer.add(info.back);
+        writer.add(info.minDepthBounds);
+        writer.add(info.maxDepthBounds);
+    }
+
+    // ColorBlendState has a single attachment.
+    const vulkan::ColorBlendState* colorBlendState = pipelineStates.colorBlendState();
+    writer.add(colorBlendState != nullptr);
+    if (colorBlendState != nullptr) {
+        const vk::PipelineColorBlendStateCreateInfo& info = colorBlendState->state();
+        assert(info.attachmentCount == 1 && info.pAttachments != nullptr);
+        writer.add(info.pAttachments[0]);
+        writer.add(info.logicOpEnable);
+        writer.add(info.logicOp);
+    }
+
+    const vulkan::DynamicState* dynamicState = pipelineStates.dynamicState();
+    writer.add(dynamicState != nullptr);
+    if (dynamicState != nullptr) {
+        const vk::PipelineDynamicStateCreateInfo& info = dynamicState->state();
+        writer.addArray(info.pDynamicStates,
+                        info.dynamicStateCount);
+    }
+
+    return true;
+}
+
+bool
+deserializeShaderStages(BinaryReader& reader,
+                        vulkan::ShaderStages& shaderStages) {
+    uint32_t stageCount = 0;
+    if (reader.read(stageCount) == false) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < stageCount; ++i) {
+        std::string shaderByteCodePath;
+        vk::ShaderStageFlagBits shaderStageFlag;
+        std::string entryPointName;
+        if (reader.readString(shaderByteCodePath) == false ||
+            reader.read(shaderStageFlag) == false ||
+            reader.readString(entryPointName) == false ||
+            isValidFlagBit(static_cast<uint32_t>(shaderStageFlag),
+                           static_cast<uint32_t>(vk::ShaderStageFlagBits::eAllGraphics)) == false) {
+            return false;
+        }
+
+        // The shader could have been removed or renamed since the previous run.
+        // It is looked up in the archive first, so the shader files
+        // are not needed if they are archived.
+        const uint32_t* byteCode = nullptr;
+        size_t byteCodeSize = 0;
+        uint64_t fileSize = 0;
+        int64_t fileModificationTime = 0;
+        if (vulkan::ShaderArchive::findByteCode(shaderByteCodePath,
+                                                byteCode,
+                                                byteCodeSize) == false &&
+            vulkan::file_system::readFileStatus(shaderByteCodePath,
+                                                fileSize,
+                                                fileModificationTime) == false) {
+            return false;
+        }
+
+        shaderStages.addShaderModule(vulkan::ShaderModuleSystem::getOrLoadShaderModule(shaderByteCodePath,
+                                                                                       shaderStageFlag,
+                                                                                       entryPointName.c_str()));
+
+        uint32_t constantCount = 0;
+        if (reader.read(constantCount) == false) {
+            return false;
+        }
+
+        for (uint32_t j = 0; j < constantCount; ++j) {
+            uint32_t constantId = 0;
+            uint32_t value = 0;
+            if (reader.read(constantId) == false ||
+                reader.read(value) == false) {
+                return false;
+            }
+
+            // The bits of the value are kept, whatever its type is.
+            shaderStages.setSpecializationConstant(shaderStageFlag,
+                                                   constantId,
+                                                   value);
+        }
+    }
+
+    return true;
+}
+
+bool
+deserializePipelineStates(BinaryReader& reader,
+                          vulkan::PipelineStates& pipelineStates) {
+    bool isUsed = false;
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        std::vector<vk::VertexInputBindingDescription> bindingDescriptions;
+        std::vector<vk::VertexInputAttributeDescription> attributeDescriptions;
+        if (reader.readVector(bindingDescriptions) == false ||
+            reader.readVector(attributeDescriptions) == false) {
+            return false;
+        }
+        for (const vk::VertexInputBindingDescription& description : bindingDescriptions) {
+            if (isValidEnum(description.inputRate, vk::VertexInputRate::eInstance) == false) {
+                return false;
+            }
+        }
+        for (const vk::VertexInputAttributeDescription& description : attributeDescriptions) {
+            if (isValidEnum(description.format, vk::Format::eAstc12x12SrgbBlock) == false) {
+                return false;
+            }
+        }
+        pipelineStates.setVertexInputState(vulkan::VertexInputState(bindingDescriptions,
+                                                                    attributeDescriptions));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::PrimitiveTopology topology;
+        vk::Bool32 primitiveRestartEnable;
+        if (reader.read(topology) == false ||
+            reader.read(primitiveRestartEnable) == false ||
+            isValidEnum(topology, vk::PrimitiveTopology::ePatchList) == false ||
+            isValidBool(primitiveRestartEnable) == false) {
+            return false;
+        }
+        pipelineStates.setInputAssemblyState(vulkan::InputAssemblyState(topology,
+                                                                        primitiveRestartEnable));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        uint32_t patchControlPoints;
+        if (reader.read(patchControlPoints) == false) {
+            return false;
+        }
+        pipelineStates.setTessellationState(vulkan::TessellationState(patchControlPoints));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::Viewport viewport;
+        vk::Rect2D scissorRectangle;
+        if (reader.read(viewport) == false ||
+            reader.read(scissorRectangle) == false) {
+            return false;
+        }
+        pipelineStates.setViewportState(vulkan::ViewportState(viewport,
+                                                              scissorRectangle));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::Bool32 depthClampEnable;
+        vk::Bool32 rasterizerDiscardEnable;
+        vk::PolygonMode polygonMode;
+        float lineWidth;
+        vk::CullModeFlags cullMode;
+        vk::FrontFace frontFace;
+        vk::Bool32 depthBiasEnable;
+        float depthBiasConstantFactor;
+        float depthBiasClamp;
+        float depthBiasSlopeFactor;
+        if (reader.read(depthClampEnable) == false ||
+            reader.read(rasterizerDiscardEnable) == false ||
+            reader.read(polygonMode) == false ||
+            reader.read(lineWidth) == false ||
+            reader.read(cullMode) == false ||
+            reader.read(frontFace) == false ||
+            reader.read(depthBiasEnable) == false ||
+            reader.read(depthBiasConstantFactor) == false ||
+            reader.read(depthBiasClamp) == false ||
+            reader.read(depthBiasSlopeFactor) == false ||
+            isValidBool(depthClampEnable) == false ||
+            isValidBool(rasterizerDiscardEnable) == false ||
+            isValidEnum(polygonMode, vk::PolygonMode::ePoint) == false ||
+            isValidFlags(static_cast<VkCullModeFlags>(cullMode),
+                         static_cast<VkCullModeFlags>(vk::CullModeFlagBits::eFrontAndBack)) == false ||
+            isValidEnum(frontFace, vk::FrontFace::eClockwise) == false ||
+            isValidBool(depthBiasEnable) == false) {
+            return false;
+        }
+        pipelineStates.setRasterizationState(vulkan::RasterizationState(depthClampEnable,
+                                                                        rasterizerDiscardEnable,
+                                                                        polygonMode,
+                                                                        lineWidth,
+                                                                        cullMode,
+                                                                        frontFace,
+                                                                        depthBiasEnable,
+                                                                        depthBiasConstantFactor,
+                                                                        depthBiasClamp,
+                                                                        depthBiasSlopeFactor));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::SampleCountFlagBits rasterizationSamples;
+        vk::Bool32 sampleShadingEnable;
+        float minSampleShading;
+        vk::Bool32 alphaToCoverageEnable;
+        vk::Bool32 alphaToOneEnable;
+        if (reader.read(rasterizationSamples) == false ||
+            reader.read(sampleShadingEnable) == false ||
+            reader.read(minSampleShading) == false ||
+            reader.read(alphaToCoverageEnable) == false ||
+            reader.read(alphaToOneEnable) == false ||
+            isValidFlagBit(static_cast<uint32_t>(rasterizationSamples),
+                           static_cast<uint32_t>(vk::SampleCountFlagBits::e64) * 2 - 1) == false ||
+            isValidBool(sampleShadingEnable) == false ||
+            isValidBool(alphaToCoverageEnable) == false ||
+            isValidBool(alphaToOneEnable) == false) {
+            return false;
+        }
+        pipelineStates.setMultisampleState(vulkan::MultisampleState(rasterizationSamples,
+                                                                    sampleShadingEnable,
+                                                                    minSampleShading,
+                                                                    nullptr,
+                                                                    alphaToCoverageEnable,
+                                                                    alphaToOneEnable));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::Bool32 depthTestEnable;
+        vk::Bool32 depthWriteEnable;
+        vk::CompareOp depthCompareOp;
+        vk::Bool32 depthBoundsTestEnable;
+        vk::Bool32 stencilTestEnable;
+        vk::StencilOpState front;
+        vk::StencilOpState back;
+        float minDepthBounds;
+        float maxDepthBounds;
+        if (reader.read(depthTestEnable) == false ||
+            reader.read(depthWriteEnable) == false ||
+            reader.read(depthCompareOp) == false ||
+            reader.read(depthBoundsTestEnable) == false ||
+            reader.read(stencilTestEnable) == false ||
+            reader.read(front) == false ||
+            reader.read(back) == false ||
+            reader.read(minDepthBounds) == false ||
+            reader.read(maxDepthBounds) == false ||
+            isValidBool(depthTestEnable) == false ||
+            isValidBool(depthWriteEnable) == false ||
+            isValidEnum(depthCompareOp, vk::CompareOp::eAlways) == false ||
+            isValidBool(depthBoundsTestEnable) == false ||
+            isValidBool(stencilTestEnable) == false ||
+            isValidStencilOpState(front) == false ||
+            isValidStencilOpState(back) == false) {
+            return false;
+        }
+        pipelineStates.setDepthStencilState(vulkan::DepthStencilState(depthTestEnable,
+                                                                      depthWriteEnable,
+                                                                      depthCompareOp,
+                                                                      depthBoundsTestEnable,
+                                                                      stencilTestEnable,
+                                                                      front,
+                                                                      back,
+                                                                      minDepthBounds,
+                                                                      maxDepthBounds));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        vk::PipelineColorBlendAttachmentState attachment;
+        vk::Bool32 logicOpEnable;
+        vk::LogicOp logicOp;
+        if (reader.read(attachment) == false ||
+            reader.read(logicOpEnable) == false ||
+            reader.read(logicOp) == false ||
+            isValidColorBlendAttachmentState(attachment) == false ||
+            isValidBool(logicOpEnable) == false ||
+            isValidEnum(logicOp, vk::LogicOp::eSet) == false) {
+            return false;
+        }
+        const vulkan::ColorBlendAttachmentState attachmentState(attachment.blendEnable,
+                                                                attachment.colorWriteMask,
+                                                                attachment.srcColorBlendFactor,
+                                                                attachment.dstColorBlendFactor,
+                                                                attachment.colorBlendOp,
+                                                                attachment.srcAlphaBlendFactor,
+                                                                attachment.dstAlphaBlendFactor,
+                                                                attachment.alphaBlendOp);
+        pipelineStates.setColorBlendState(vulkan::ColorBlendState(attachmentState,
+                                                                  logicOpEnable,
+                                                                  logicOp));
+    }
+
+    if (reader.read(isUsed) == false) {
+        return false;
+    }
+    if (isUsed) {
+        std::vector<vk::DynamicState> dynamicStates;
+        if (reader.readVector(dynamicStates) == false) {
+            return false;
+        }
+        for (const vk::DynamicState dynamicState : dynamicStates) {
+            if (isValidDynamicState(dynamicState) == false) {
+                return false;
+            }
+        }
+        pipelineStates.setDynamicState(vulkan::DynamicState(dynamicStates));
+    }
+
+    return true;
+}
+}
+
+namespace vulkan {
+std::string
+PipelineManifest::mFilePath = {};
+
+PipelineManifest::SerializedStatesByScope
+PipelineManifest::mLoadedStatesByScope = {};
+
+std::unordered_set<std::string>
+PipelineManifest::mRecordedEntries = {};
+
+void
+PipelineManifest::initialize(const std::string& filePath) {
+    assert(mFilePath.empty());
+    assert(filePath.empty() == false);
+
+    mFilePath = filePath;
+    mLoadedStatesByScope.clear();
+    mRecordedEntries.clear();
+
+    const std::vector<uint8_t> fileData = file_system::readFile(filePath);
+    if (fileData.empty()) {
+        return;
+    }
+
+    const std::string data(fileData.begin(),
+                           fileData.end());
+
+    BinaryReader reader(data);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t entryCount = 0;
+    if (reader.read(magic) == false ||
+        reader.read(version) == false ||
+        reader.read(entryCount) == false ||
+        magic != sManifestMagic ||
+        version != sManifestVersion) {
+        return;
+    }
+
+    SerializedStatesByScope loadedStatesByScope;
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        std::string scopeName;
+        std::string serializedState;
+        if (reader.readString(scopeName) == false ||
+            reader.readString(serializedState) == false) {
+            return;
+        }
+        loadedStatesByScope[scopeName].emplace_back(serializedState);
+    }
+
+    // The entries are only used if the whole file is valid.
+    if (reader.isAtEnd()) {
+        mLoadedStatesByScope = std::move(loadedStatesByScope);
+    }
+}
+
+void
+PipelineManifest::finalize() {
+    assert(mFilePath.empty() == false);
+
+    BinaryWriter writer;
+    writer.add(sManifestMagic);
+    writer.add(sManifestVersion);
+    writer.add(static_cast<uint32_t>(mRecordedEntries.size()));
+
+    std::string data = writer.data();
+    for (const std::string& entry : mRecordedEntries) {
+        data += entry;
+    }
+
+    // A crash during the write must not leave a truncated manifest.
+    if (file_system::writeFileAtomically(mFilePath,
+                                         data.data(),
+                                         data.size()) == false) {
+        std::cerr << "Pipeline manifest could not be written: " << mFilePath << std::endl;
+    }
+
+    mFilePath.clear();
+    mLoadedStatesByScope.clear();
+    mRecordedEntries.clear();
+}
+
+void
+PipelineManifest::record(const std::string& scopeName,
+                         const PipelineStates& pipelineStates,
+                         const ShaderStages& shaderStages) {
+    assert(mFilePath.empty() == false);
+    assert(scopeName.empty() == false);
+
+    BinaryWriter stateWriter;
+    if (serializeShaderStages(stateWriter, shaderStages) == false ||
+        serializePipelineStates(stateWriter, pipelineStates) == false) {
+        return;
+    }
+
+    BinaryWriter entryWriter;
+    entryWriter.addString(scopeName);
+    entryWriter.addString(stateWriter.data());
+
+    mRecordedEntries.insert(entryWriter.data());
+}
+
+std::vector<PipelineDescription>
+PipelineManifest::pipelineDescriptions(const std::string& scopeName) {
+    assert(mFilePath.empty() == false);
+
+    std::vector<PipelineDescription> descriptions;
+
+    SerializedStatesByScope::const_iterator findIt = mLoadedStatesByScope.find(scopeName);
+    if (findIt == mLoadedStatesByScope.end()) {
+        return descriptions;
+    }
+
+    for (const std::string& serializedState : findIt->second) {
+        BinaryReader reader(serializedState);
+        PipelineDescription description;
+        if (deserializeShaderStages(reader, description.mShaderStages) &&
+            deserializePipelineStates(reader, description.mPipelineStates) &&
+            reader.isAtEnd()) {
+            descriptions.emplace_back(std::move(description));
+        }
+    }
+
+    return descriptions;
+}
+}
@@ -0,0 +1,102 @@
+#ifndef UTILS_PIPELINE_PIPELINE_MANIFEST
+#define UTILS_PIPELINE_PIPELINE_MANIFEST
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "PipelineStates.h"
+#include "../shader/ShaderStages.h"
+
+namespace vulkan {
+//
+// Creation state of a graphics pipeline that was used in the previous run.
+//
+// The shader modules are loaded through the ShaderModuleSystem, so
+// they are used from the ShaderArchive like any other shader
+// (Read ShaderArchive::findByteCode()).
+//
+struct PipelineDescription {
+    PipelineStates mPipelineStates;
+    ShaderStages mShaderStages;
+};
+
+//
+// Compact file with the creation state of every graphics pipeline
+// that was used in a run.
+//
+// The pipeline cache avoids the shader compilation only when the same
+// pipeline is created again, but the pipelines are still created when
+// they are needed (usually in the middle of the first frames).
+// With the manifest, the PipelineSystem knows which pipelines the next run
+// is going to use, so it can compile all of them in parallel
+// before the first frame (Read PipelineSystem::prewarmGraphicsPipelines()).
+//
+// Entries are grouped by scope name, because pipeline layouts and
+// render passes are handles that are only valid during a run. A scope is the
+// (pipeline layout, render pass, subpass) of a part of the application
+// (for example, "LoadModel").
+//
+// Each entry contains:
+// - The shader stages: shader byte code path, stage, entry point and
+//   specialization constants.
+// - The parameters of the PipelineStates.
+//
+// Pipelines with a sample mask are not recorded.
+//
+// File format (little endian):
+// - Header: magic, version and entry count.
+// - For each entry: scope name and the serialized state (size + bytes).
+//
+// If the file does not exist or its header is not valid, then
+// the manifest starts empty. Entries with values that are not valid
+// (for example, unknown enum values) or whose shaders do not exist are ignored.
+// The file is written atomically (Read file_system::writeFileAtomically()).
+//
+// Preconditions:
+// - The global logical device must be initialized first (shader modules are
+//   loaded by pipelineDescriptions()).
+//
+class PipelineManifest {
+public:
+    static void
+    initialize(const std::string& filePath);
+
+    // Writes the entries recorded in this run (and not the ones
+    // loaded from the file, because they could not be used anymore).
+    static void
+    finalize();
+
+    // Adds the pipeline to the entries of scopeName, if it was not recorded before.
+    static void
+    record(const std::string& scopeName,
+           const PipelineStates& pipelineStates,
+           const ShaderStages& shaderStages);
+
+    // Pipelines of scopeName used in the previous run.
+    // Entries whose shader byte code does not exist anymore are skipped.
+    static std::vector<PipelineDescription>
+    pipelineDescriptions(const std::string& scopeName);
+
+private:
+    PipelineManifest() = delete;
+    ~PipelineManifest() = delete;
+    PipelineManifest(PipelineManifest&&) noexcept = delete;
+    PipelineManifest(const PipelineManifest&) = delete;
+    const PipelineManifest& operator=(const PipelineManifest&) = delete;
+
+    static std::string mFilePath;
+
+    // Serialized states of the previous run, by scope name.
+    using SerializedStatesByScope = std::unordered_map<std::string, std::vector<std::string>>;
+    static SerializedStatesByScope mLoadedStatesByScope;
+
+    // Serialized entries (scope name and state) of this run,
+    // in the file layout.
+    static std::unordered_set<std::string> mRecordedEntries;
+};
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include "PipelineStates.h"
 
+#include <algorithm>
+
+#include "ExtendedDynamicState.h"
+
 namespace vulkan {
 void
 PipelineStates::setColorBlendState(const ColorBlendState& colorBlendState) {
@@ -55,6 +59,24 @@ PipelineStates::setViewportState(const ViewportState& viewportState) {
     mViewportState = viewportState;
 }
 
+void
+PipelineStates::enableExtendedDynamicState() {
+    std::vector<vk::DynamicState> dynamicStates;
+    if (mUseDynamicState) {
+        const vk::PipelineDynamicStateCreateInfo& info = mDynamicState.state();
+        dynamicStates.assign(info.pDynamicStates,
+                             info.pDynamicStates + info.dynamicStateCount);
+    }
+
+    for (const vk::DynamicState dynamicState : ExtendedDynamicState::supportedDynamicStates()) {
+        if (std::find(dynamicStates.begin(), dynamicStates.end(), dynamicState) == dynamicStates.end()) {
+            dynamicStates.push_back(dynamicState);
+        }
+    }
+
+    setDynamicState(DynamicState(dynamicStates));
+}
+
 const ColorBlendState*
 PipelineStates::colorBlendState() const {
     if (mUseColorBlendState) {
@@ -49,6 +49,12 @@ public:
     void
     setViewportState(const ViewportState& viewportState);
 
+    // Adds to the dynamic state every dynamic state supported
+    // by the device (Read ExtendedDynamicState).
+    // The dynamic values must be set with ExtendedDynamicState::setDynamicStates().
+    void
+    enableExtendedDynamicState();
+
     const ColorBlendState* 
     colorBlendState() const;
 
@@ -0,0 +1,1091 @@
+#include "PipelineSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+#include "ExtendedDynamicState.h"
+#include "PipelineCompiler.h"
+#include "PipelineManifest.h"
+#include "PipelineStates.h"
+#include "../device/LogicalDevice.h"
+#include "../shader/ShaderModule.h"
+#include "../shader/ShaderModuleSystem.h"
+#include "../shader/ShaderWatcher.h"
+#include "../shader/ShaderStages.h"
+
+namespace {
+//
+// 64 bits FNV-1a hash of the fields of the create info structs.
+//
+// Structs are hashed field by field (and not as raw memory), because
+// they contain pointers and pNext chains that must not be part of the key.
+// Only structs without padding nor pointers are hashed as raw memory.
+//
+// If a key is given, then the hashed bytes are also appended to it, so
+// equal hashes can be told apart by comparing their keys.
+//
+class StateHasher {
+public:
+    explicit StateHasher(std::vector<uint8_t>* key = nullptr)
+        : mKey(key)
+    {}
+
+    void
+    addBytes(const void* data,
+             const size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            mHash ^= bytes[i];
+            mHash *= 1099511628211ull;
+        }
+
+        if (mKey != nullptr) {
+            mKey->insert(mKey->end(),
+                         bytes,
+                         bytes + size);
+        }
+    }
+
+    template<typename T>
+    void
+    add(const T& value) {
+        addBytes(&value,
+                 sizeof(T));
+    }
+
+    // * count of elements of array. array can be nullptr if count is 0.
+    template<typename T>
+    void
+    addArray(const T* array,
+             const uint32_t count) {
+        add(count);
+        if (count > 0) {
+            assert(array != nullptr);
+            addBytes(array,
+                     sizeof(T) * count);
+        }
+    }
+
+    void
+    addString(const char* string) {
+        assert(string != nullptr);
+        addBytes(string,
+                 std::strlen(string) + 1);
+    }
+
+    uint64_t
+    hash() const {
+        return mHash;
+    }
+
+private:
+    uint64_t mHash = 14695981039346656037ull;
+    std::vector<uint8_t>* mKey = nullptr;
+};
+
+// Fields that are dynamic (Read DynamicStateFields) are not hashed,
+// so pipelines that only differ in them are shared.
+
+// With a dynamic primitive topology, the topology set in the command
+// buffer must be of the same class as the pipeline one.
+uint32_t
+topologyClass(const vk::PrimitiveTopology topology) {
+    switch (topology) {
+    case vk::PrimitiveTopology::ePointList:
+        return 0;
+    case vk::PrimitiveTopology::eLineList:
+    case vk::PrimitiveTopology::eLineStrip:
+    case vk::PrimitiveTopology::eLineListWithAdjacency:
+    case vk::PrimitiveTopology::eLineStripWithAdjacency:
+        return 1;
+    case vk::PrimitiveTopology::ePatchList:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+void
+addVertexInputState(StateHasher& hasher,
+                    const vk::PipelineVertexInputStateCreateInfo& info,
+                    const vulkan::DynamicStateFields& /*dynamicFields*/) {
+    hasher.add(info.flags);
+    hasher.addArray(info.pVertexBindingDescriptions,
+                    info.vertexBindingDescriptionCount);
+    hasher.addArray(info.pVertexAttributeDescriptions,
+                    info.vertexAttributeDescriptionCount);
+}
+
+void
+addInputAssemblyState(StateHasher& hasher,
+                      const vk::PipelineInputAssemblyStateCreateInfo& info,
+                      const vulkan::DynamicStateFields& dynamicFields) {
+    hasher.add(info.flags);
+    if (dynamicFields.mPrimitiveTopology) {
+        hasher.add(topologyClass(info.topology));
+    } else {
+        hasher.add(info.topology);
+    }
+    if (dynamicFields.mPrimitiveRestartEnable == false) {
+        hasher.add(info.primitiveRestartEnable);
+    }
+}
+
+void
+addTessellationState(StateHasher& hasher,
+                     const vk::PipelineTessellationStateCreateInfo& info,
+                     const vulkan::DynamicStateFields& /*dynamicFields*/) {
+    hasher.add(info.flags);
+    hasher.add(info.patchControlPoints);
+}
+
+void
+addViewportState(StateHasher& hasher,
+                 const vk::PipelineViewportStateCreateInfo& info,
+                 const vulkan::DynamicStateFields& dynamicFields) {
+    hasher.add(info.flags);
+    hasher.add(info.viewportCount);
+    hasher.add(info.scissorCount);
+
+    if (info.pViewports != nullptr && dynamicFields.mViewport == false) {
+        hasher.addArray(info.pViewports,
+                        info.viewportCount);
+    }
+    if (info.pScissors != nullptr && dynamicFields.mScissor == false) {
+        hasher.addArray(info.pScissors,
+                        info.scissorCount);
+    }
+}
+
+void
+addRasterizationState(StateHasher& hasher,
+                      const vk::PipelineRasterizationStateCreateInfo& info,
+                      const vulkan::DynamicStateFields& dynamicFields) {
+    hasher.add(info.flags);
+    if (dynamicFields.mDepthClampEnable == false) {
+        hasher.add(info.depthClampEnable);
+    }
+    if (dynamicFields.mRasterizerDiscardEnable == false) {
+        hasher.add(info.rasterizerDiscardEnable);
+    }
+    if (dynamicFields.mPolygonMode == false) {
+        hasher.add(info.polygonMode);
+    }
+    if (dynamicFields.mCullMode == false) {
+        hasher.add(info.cullMode);
+    }
+    if (dynamicFields.mFrontFace == false) {
+        hasher.add(info.frontFace);
+    }
+    if (dynamicFields.mDepthBiasEnable == false) {
+        hasher.add(info.depthBiasEnable);
+    }
+    if (dynamicFields.mDepthBias == false) {
+        hasher.add(info.depthBiasConstantFactor);
+        hasher.add(info.depthBiasClamp);
+        hasher.add(info.depthBiasSlopeFactor);
+    }
+    if (dynamicFields.mLineWidth == false) {
+        hasher.add(info.lineWidth);
+    }
+}
+
+void
+addMultisampleState(StateHasher& hasher,
+                    const vk::PipelineMultisampleStateCreateInfo& info,
+                    const vulkan::DynamicStateFields& /*dynamicFields*/) {
+    hasher.add(info.flags);
+    hasher.add(info.rasterizationSamples);
+    hasher.add(info.sampleShadingEnable);
+    hasher.add(info.minSampleShading);
+    if (info.pSampleMask != nullptr) {
+        // One 32 bits mask for each 32 samples
+        const uint32_t sampleMaskCount = (static_cast<uint32_t>(info.rasterizationSamples) + 31) / 32;
+        hasher.addArray(info.pSampleMask,
+                        sampleMaskCount);
+    }
+    hasher.add(info.alphaToCoverageEnable);
+    hasher.add(info.alphaToOneEnable);
+}
+
+void
+addStencilOpState(StateHasher& hasher,
+                  const vk::StencilOpState& state,
+                  const vulkan::DynamicStateFields& dynamicFields) {
+    if (dynamicFields.mStencilOp == false) {
+        hasher.add(state.failOp);
+        hasher.add(state.passOp);
+        hasher.add(state.depthFailOp);
+        hasher.add(state.compareOp);
+    }
+    if (dynamicFields.mStencilCompareMask == false) {
+        hasher.add(state.compareMask);
+    }
+    if (dynamicFields.mStencilWriteMask == false) {
+        hasher.add(state.writeMask);
+    }
+    if (dynamicFields.mStencilReference == false) {
+        hasher.add(state.reference);
+    }
+}
+
+void
+addDepthStencilState(StateHasher& hasher,
+                     const vk::PipelineDepthStencilStateCreateInfo& info,
+                     const vulkan::DynamicStateFields& dynamicFields) {
+    hasher.add(info.flags);
+    if (dynamicFields.mDepthTestEnable == false) {
+        hasher.add(info.depthTestEnable);
+    }
+    if (dynamicFields.mDepthWriteEnable == false) {
+        hasher.add(info.depthWriteEnable);
+    }
+    if (dynamicFields.mDepthCompareOp == false) {
+        hasher.add(info.depthCompareOp);
+    }
+    if (dynamicFields.mDepthBoundsTestEnable == false) {
+        hasher.add(info.depthBoundsTestEnable);
+    }
+    if (dynamicFields.mStencilTestEnable == false) {
+        hasher.add(info.stencilTestEnable);
+    }
+    addStencilOpState(hasher,
+                      info.front,
+                      dynamicFields);
+    addStencilOpState(hasher,
+                      info.back,
+                      dynamicFields);
+    if (dynamicFields.mDepthBounds == false) {
+        hasher.add(info.minDepthBounds);
+        hasher.add(info.maxDepthBounds);
+    }
+}
+
+void
+addColorBlendState(StateHasher& hasher,
+                   const vk::PipelineColorBlendStateCreateInfo& info,
+                   const vulkan::DynamicStateFields& dynamicFields) {
+    hasher.add(info.flags);
+    hasher.add(info.logicOpEnable);
+    hasher.add(info.logicOp);
+    hasher.addArray(info.pAttachments,
+                    info.attachmentCount);
+    if (dynamicFields.mBlendConstants == false) {
+        hasher.add(info.blendConstants);
+    }
+}
+
+void
+addDynamicState(StateHasher& hasher,
+                const vk::PipelineDynamicStateCreateInfo& info,
+                const vulkan::DynamicStateFields& /*dynamicFields*/) {
+    hasher.add(info.flags);
+    hasher.addArray(info.pDynamicStates,
+                    info.dynamicStateCount);
+}
+
+// Hashes if the state is used and its fields.
+template<typename State, typename AddStateFunction>
+void
+addOptionalState(StateHasher& hasher,
+                 const State* state,
+                 const vulkan::DynamicStateFields& dynamicFields,
+                 AddStateFunction addStateFunction) {
+    const bool isUsed = state != nullptr;
+    hasher.add(isUsed);
+    if (isUsed) {
+        addStateFunction(hasher,
+                         state->state(),
+                         dynamicFields);
+    }
+}
+
+void
+addShaderStages(StateHasher& hasher,
+                const std::vector<vk::PipelineShaderStageCreateInfo>& stages) {
+    hasher.add(static_cast<uint32_t>(stages.size()));
+    for (const vk::PipelineShaderStageCreateInfo& info : stages) {
+        hasher.add(info.flags);
+        hasher.add(info.stage);
+        hasher.add(info.module);
+        hasher.addString(info.pName);
+
+        const bool hasSpecializationInfo = info.pSpecializationInfo != nullptr;
+        hasher.add(hasSpecializationInfo);
+        if (hasSpecializationInfo) {
+            const vk::SpecializationInfo& specializationInfo = *info.pSpecializationInfo;
+            hasher.addArray(specializationInfo.pMapEntries,
+                            specializationInfo.mapEntryCount);
+            hasher.add(specializationInfo.dataSize);
+            if (specializationInfo.dataSize > 0) {
+                hasher.addBytes(specializationInfo.pData,
+                                specializationInfo.dataSize);
+            }
+        }
+    }
+}
+
+// Jobs whose failure must not stop the application (the previous
+// pipeline is still used), so their error is only reported.
+// Returns nullptr if the job failed.
+const vulkan::GraphicsPipeline*
+takePipelineOrReportError(vulkan::PipelineCompileJob& job,
+                          const char* jobName) {
+    try {
+        return job.takePipeline().release();
+    } catch (const std::exception& exception) {
+        std::cerr << jobName << " failed: " << exception.what() << std::endl;
+        return nullptr;
+    }
+}
+}
+
+namespace vulkan {
+PipelineSystem::GraphicsPipelineByHash
+PipelineSystem::mGraphicsPipelineByHash = {};
+
+PipelineSystem::CompileJobByHash
+PipelineSystem::mCompileJobByHash = {};
+
+PipelineSystem::GraphicsPipelineKeyByHash
+PipelineSystem::mGraphicsPipelineKeyByHash = {};
+
+std::unordered_set<uint64_t>
+PipelineSystem::mPrewarmJobHashes = {};
+
+PipelineSystem::PipelineLayoutByHash
+PipelineSystem::mPipelineLayoutByHash = {};
+
+PipelineSystem::DescriptorSetLayoutByHash
+PipelineSystem::mDescriptorSetLayoutByHash = {};
+
+PipelineSystem::ManifestScopeByTargetHash
+PipelineSystem::mManifestScopeByTargetHash = {};
+
+std::array<PipelineSystem::PipelineLibraryByHash, PipelineLibrary::sPartCount>
+PipelineSystem::mPipelineLibrariesByPart = {};
+
+PipelineSystem::LinkedGraphicsPipelineByHash
+PipelineSystem::mLinkedGraphicsPipelineByHash = {};
+
+std::vector<const GraphicsPipeline*>
+PipelineSystem::mReplacedGraphicsPipelines = {};
+
+PipelineSystem::ReloadableGraphicsPipelineByHash
+PipelineSystem::mReloadableGraphicsPipelineByHash = {};
+
+PipelineSystem::CompileJobByHash
+PipelineSystem::mReloadJobByHash = {};
+
+const GraphicsPipeline&
+PipelineSystem::getOrCreateGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                            const PipelineStates& pipelineStates,
+                                            const ShaderStages& shaderStages,
+                                            const vk::RenderPass renderPass,
+                                            const uint32_t subPassIndex) {
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(renderPass != VK_NULL_HANDLE);
+
+    const uint64_t hash = checkedGraphicsPipelineHash(pipelineLayout,
+                                                      pipelineStates,
+                                                      shaderStages,
+                                                      renderPass,
+                                                      subPassIndex);
+
+    recordInManifest(pipelineLayout,
+                     pipelineStates,
+                     shaderStages,
+                     renderPass,
+                     subPassIndex);
+
+    // The application needs it, so its compile errors are not ignored anymore.
+    mPrewarmJobHashes.erase(hash);
+
+    // If the pipeline is being compiled asynchronously, then
+    // we wait for it instead of compiling it twice.
+    CompileJobByHash::const_iterator jobIt = mCompileJobByHash.find(hash);
+    if (jobIt != mCompileJobByHash.end()) {
+        jobIt->second->wait();
+        const GraphicsPipeline* graphicsPipeline = graphicsPipelineIfReady(hash);
+        assert(graphicsPipeline != nullptr);
+
+        return *graphicsPipeline;
+    }
+
+    const GraphicsPipeline* graphicsPipeline = nullptr;
+
+    // Check if an equal pipeline was already created.
+    GraphicsPipelineByHash::const_iterator findIt = mGraphicsPipelineByHash.find(hash);
+    if (findIt != mGraphicsPipelineByHash.end()) {
+        graphicsPipeline = findIt->second;
+    } else {
+        graphicsPipeline = new GraphicsPipeline(pipelineLayout,
+                                                pipelineStates,
+                                                shaderStages,
+                                                renderPass,
+                                                subPassIndex);
+
+        mGraphicsPipelineByHash[hash] = graphicsPipeline;
+
+        recordReloadableGraphicsPipeline(hash,
+                                         pipelineLayout,
+                                         pipelineStates,
+                                         shaderStages,
+                                         renderPass,
+                                         subPassIndex);
+    }
+
+    assert(graphicsPipeline != nullptr);
+
+    return *graphicsPipeline;
+}
+
+uint64_t
+PipelineSystem::requestGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                        const PipelineStates& pipelineStates,
+                                        const ShaderStages& shaderStages,
+                                        const vk::RenderPass renderPass,
+                                        const uint32_t subPassIndex) {
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(renderPass != VK_NULL_HANDLE);
+
+    const uint64_t hash = checkedGraphicsPipelineHash(pipelineLayout,
+                                                      pipelineStates,
+                                                      shaderStages,
+                                                      renderPass,
+                                                      subPassIndex);
+
+    recordInManifest(pipelineLayout,
+                     pipelineStates,
+                     shaderStages,
+                     renderPass,
+                     subPassIndex);
+
+    mPrewarmJobHashes.erase(hash);
+
+    compileGraphicsPipelineAsync(hash,
+                                 pipelineLayout,
+                                 pipelineStates,
+                                 shaderStages,
+                                 renderPass,
+                                 subPassIndex);
+
+    return hash;
+}
+
+uint64_t
+PipelineSystem::requestLinkedGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                              const PipelineStates& pipelineStates,
+                                              const ShaderStages& shaderStages,
+                                              const vk::RenderPass renderPass,
+                                              const uint32_t subPassIndex) {
+    if (PipelineLibrary::isSupported() == false) {
+        return requestGraphicsPipeline(pipelineLayout,
+                                       pipelineStates,
+                                       shaderStages,
+                                       renderPass,
+                                       subPassIndex);
+    }
+
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(renderPass != VK_NULL_HANDLE);
+
+    const uint64_t hash = checkedGraphicsPipelineHash(pipelineLayout,
+                                                      pipelineStates,
+                                                      shaderStages,
+                                                      renderPass,
+                                                      subPassIndex);
+
+    recordInManifest(pipelineLayout,
+                     pipelineStates,
+                     shaderStages,
+                     renderPass,
+                     subPassIndex);
+
+    mPrewarmJobHashes.erase(hash);
+
+    if (mGraphicsPipelineByHash.find(hash) != mGraphicsPipelineByHash.end() ||
+        mCompileJobByHash.find(hash) != mCompileJobByHash.end()) {
+        return hash;
+    }
+
+    // Only the parts that no other variant created before are compiled.
+    const PipelineLibrary::Part parts[PipelineLibrary::sPartCount] = {
+        PipelineLibrary::Part::VertexInput,
+        PipelineLibrary::Part::PreRasterization,
+        PipelineLibrary::Part::FragmentShader,
+        PipelineLibrary::Part::FragmentOutput,
+    };
+    uint64_t libraryCreationTime = 0;
+    std::vector<vk::Pipeline> pipelineLibraries;
+    for (const PipelineLibrary::Part part : parts) {
+        const PipelineLibrary& pipelineLibrary = getOrCreatePipelineLibrary(part,
+                                                                            pipelineLayout,
+                                                                            pipelineStates,
+                                                                            shaderStages,
+                                                                            renderPass,
+                                                                            subPassIndex,
+                                                                            libraryCreationTime);
+        pipelineLibraries.push_back(pipelineLibrary.pipeline());
+    }
+
+    const GraphicsPipeline* fastLinkedPipeline = new GraphicsPipeline(pipelineLayout,
+                                                                      pipelineLibraries,
+                                                                      false);
+    mGraphicsPipelineByHash[hash] = fastLinkedPipeline;
+
+    // A reload compiles the complete pipeline.
+    recordReloadableGraphicsPipeline(hash,
+                                     pipelineLayout,
+                                     pipelineStates,
+                                     shaderStages,
+                                     renderPass,
+                                     subPassIndex);
+
+    LinkedGraphicsPipeline& linkedPipeline = mLinkedGraphicsPipelineByHash[hash];
+    linkedPipeline.mFastLinkedPipeline = fastLinkedPipeline;
+    linkedPipeline.mLibraryCreationTime = libraryCreationTime;
+    linkedPipeline.mOptimizedLinkJob = PipelineCompiler::link(pipelineLayout,
+                                                              pipelineLibraries);
+
+    return hash;
+}
+
+size_t
+PipelineSystem::prewarmGraphicsPipelines(const std::string& scopeName,
+                                         const vk::PipelineLayout pipelineLayout,
+                                         const vk::RenderPass renderPass,
+                                         const uint32_t subPassIndex) {
+    assert(scopeName.empty() == false);
+    assert(pipelineLayout != VK_NULL_HANDLE);
+    assert(renderPass != VK_NULL_HANDLE);
+
+    mManifestScopeByTargetHash[manifestTargetHash(pipelineLayout,
+                                                  renderPass,
+                                                  subPassIndex)] = scopeName;
+
+    // The prewarmed pipelines are not recorded again. Only the ones that
+    // the application uses in this run are recorded for the next one, so
+    // entries that fail to compile are dropped from the manifest.
+    const std::vector<PipelineDescription> descriptions = PipelineManifest::pipelineDescriptions(scopeName);
+    for (const PipelineDescription& description : descriptions) {
+        const uint64_t hash = checkedGraphicsPipelineHash(pipelineLayout,
+                                                          description.mPipelineStates,
+                                                          description.mShaderStages,
+                                                          renderPass,
+                                                          subPassIndex);
+        if (compileGraphicsPipelineAsync(hash,
+                                         pipelineLayout,
+                                         description.mPipelineStates,
+                                         description.mShaderStages,
+                                         renderPass,
+                                         subPassIndex)) {
+            mPrewarmJobHashes.insert(hash);
+        }
+    }
+
+    return descriptions.size();
+}
+
+void
+PipelineSystem::waitForRequestedGraphicsPipelines() {
+    std::vector<uint64_t> pendingHashes;
+    for (const auto& hashAndCompileJob : mCompileJobByHash) {
+        pendingHashes.push_back(hashAndCompileJob.first);
+    }
+
+    for (const uint64_t hash : pendingHashes) {
+        mCompileJobByHash[hash]->wait();
+        graphicsPipelineIfReady(hash);
+    }
+}
+
+const GraphicsPipeline*
+PipelineSystem::graphicsPipelineIfReady(const uint64_t pipelineHash) {
+    replaceWithOptimizedPipelineIfReady(pipelineHash);
+
+    GraphicsPipelineByHash::const_iterator findIt = mGraphicsPipelineByHash.find(pipelineHash);
+    if (findIt != mGraphicsPipelineByHash.end()) {
+        return findIt->second;
+    }
+
+    CompileJobByHash::iterator jobIt = mCompileJobByHash.find(pipelineHash);
+    if (jobIt == mCompileJobByHash.end()) {
+        assert(false && "The pipeline was not requested, or it was cancelled");
+        return nullptr;
+    }
+    if (jobIt->second->isReady() == false) {
+        return nullptr;
+    }
+
+    // The job is completed, so the pipeline is moved to the created ones.
+    // If the compilation failed, then its exception is thrown here, in the main thread.
+    // Prewarming is best effort (the manifest entry can be stale), so the
+    // error of a prewarm job is only reported, and the pipeline is dropped.
+    const std::shared_ptr<PipelineCompileJob> job = jobIt->second;
+    mCompileJobByHash.erase(jobIt);
+    const GraphicsPipeline* graphicsPipeline = nullptr;
+    if (mPrewarmJobHashes.erase(pipelineHash) > 0) {
+        graphicsPipeline = takePipelineOrReportError(*job,
+                                                     "Pipeline prewarm");
+        if (graphicsPipeline == nullptr) {
+            mReloadableGraphicsPipelineByHash.erase(pipelineHash);
+            return nullptr;
+        }
+    } else {
+        graphicsPipeline = job->takePipeline().release();
+    }
+    mGraphicsPipelineByHash[pipelineHash] = graphicsPipeline;
+
+    return graphicsPipeline;
+}
+
+vk::PipelineLayout
+PipelineSystem::getOrCreatePipelineLayout(const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts,
+                                          const std::vector<vk::PushConstantRange>& pushConstantRanges) {
+    StateHasher hasher;
+    hasher.addArray(descriptorSetLayouts.data(),
+                    static_cast<uint32_t>(descriptorSetLayouts.size()));
+    hasher.addArray(pushConstantRanges.data(),
+                    static_cast<uint32_t>(pushConstantRanges.size()));
+
+    vk::UniquePipelineLayout& pipelineLayout = mPipelineLayoutByHash[hasher.hash()];
+    if (pipelineLayout.get() == VK_NULL_HANDLE) {
+        vk::PipelineLayoutCreateInfo info;
+        info.setSetLayoutCount(static_cast<uint32_t>(descriptorSetLayouts.size()));
+        info.setPSetLayouts(descriptorSetLayouts.empty() ? nullptr : descriptorSetLayouts.data());
+        info.setPushConstantRangeCount(static_cast<uint32_t>(pushConstantRanges.size()));
+        info.setPPushConstantRanges(pushConstantRanges.empty() ? nullptr : pushConstantRanges.data());
+        pipelineLayout = LogicalDevice::device().createPipelineLayoutUnique(info);
+    }
+
+    return pipelineLayout.get();
+}
+
+vk::PipelineLayout
+PipelineSystem::getOrCreatePipelineLayout(const ShaderStages& shaderStages,
+                                          const bool useDynamicBuffers) {
+    const std::vector<vk::DescriptorSetLayout> descriptorSetLayouts =
+        getOrCreateDescriptorSetLayouts(shaderStages,
+                                        useDynamicBuffers);
+
+    // A single range, used by all the stages with push constants,
+    // so the ranges of different stages never overlap.
+    vk::PushConstantRange pushConstantRange;
+    for (const ShaderModule* shaderModule : shaderStages.shaderModules()) {
+        const uint32_t pushConstantSize = shaderModule->reflection().pushConstantSize();
+        if (pushConstantSize > 0) {
+            pushConstantRange.setStageFlags(pushConstantRange.stageFlags | shaderModule->shaderStageFlag());
+            pushConstantRange.setSize(std::max(pushConstantRange.size, pushConstantSize));
+        }
+    }
+
+    std::vector<vk::PushConstantRange> pushConstantRanges;
+    if (pushConstantRange.size > 0) {
+        pushConstantRanges.push_back(pushConstantRange);
+    }
+
+    return getOrCreatePipelineLayout(descriptorSetLayouts,
+                                     pushConstantRanges);
+}
+
+std::vector<vk::DescriptorSetLayout>
+PipelineSystem::getOrCreateDescriptorSetLayouts(const ShaderStages& shaderStages,
+                                                const bool useDynamicBuffers) {
+    // Bindings of each set. A binding used by many stages is merged.
+    std::vector<std::vector<vk::DescriptorSetLayoutBinding>> bindingsBySet;
+    for (const ShaderModule* shaderModule : shaderStages.shaderModules()) {
+        for (const ShaderReflection::DescriptorBinding& descriptorBinding : shaderModule->reflection().descriptorBindings()) {
+            if (bindingsBySet.size() <= descriptorBinding.mSet) {
+                bindingsBySet.resize(descriptorBinding.mSet + 1);
+            }
+            std::vector<vk::DescriptorSetLayoutBinding>& bindings = bindingsBySet[descriptorBinding.mSet];
+
+            vk::DescriptorType descriptorType = descriptorBinding.mType;
+            if (useDynamicBuffers && descriptorType == vk::DescriptorType::eUniformBuffer) {
+                descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+            } else if (useDynamicBuffers && descriptorType == vk::DescriptorType::eStorageBuffer) {
+                descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+            }
+
+            std::vector<vk::DescriptorSetLayoutBinding>::iterator findIt =
+                std::find_if(bindings.begin(),
+                             bindings.end(),
+                             [&descriptorBinding](const vk::DescriptorSetLayoutBinding& binding) {
+                                 return binding.binding == descriptorBinding.mBinding;
+                             });
+            if (findIt != bindings.end()) {
+                assert(findIt->descriptorType == descriptorType && "Stages disagree on the descriptor type");
+                findIt->setStageFlags(findIt->stageFlags | shaderModule->shaderStageFlag());
+                findIt->setDescriptorCount(std::max(findIt->descriptorCount, descriptorBinding.mCount));
+            } else {
+                vk::DescriptorSetLayoutBinding binding;
+                binding.setBinding(descriptorBinding.mBinding);
+                binding.setDescriptorType(descriptorType);
+                binding.setDescriptorCount(descriptorBinding.mCount);
+                binding.setStageFlags(shaderModule->shaderStageFlag());
+                bindings.push_back(binding);
+            }
+        }
+    }
+
+    std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
+    for (std::vector<vk::DescriptorSetLayoutBinding>& bindings : bindingsBySet) {
+        // Sorted, so the same bindings in a different order share the layout.
+        std::sort(bindings.begin(),
+                  bindings.end(),
+                  [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) {
+                      return a.binding < b.binding;
+                  });
+        descriptorSetLayouts.push_back(getOrCreateDescriptorSetLayout(bindings));
+    }
+
+    return descriptorSetLayouts;
+}
+
+vk::DescriptorSetLayout
+PipelineSystem::getOrCreateDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) {
+    StateHasher hasher;
+    hasher.add(static_cast<uint32_t>(bindings.size()));
+    for (const vk::DescriptorSetLayoutBinding& binding : bindings) {
+        // Immutable samplers are not supported.
+        assert(binding.pImmutableSamplers == nullptr);
+        hasher.add(binding.binding);
+        hasher.add(binding.descriptorType);
+        hasher.add(binding.descriptorCount);
+        hasher.add(binding.stageFlags);
+    }
+
+    vk::UniqueDescriptorSetLayout& descriptorSetLayout = mDescriptorSetLayoutByHash[hasher.hash()];
+    if (descriptorSetLayout.get() == VK_NULL_HANDLE) {
+        vk::DescriptorSetLayoutCreateInfo info;
+        info.setBindingCount(static_cast<uint32_t>(bindings.size()));
+        info.setPBindings(bindings.empty() ? nullptr : bindings.data());
+        descriptorSetLayout = LogicalDevice::device().createDescriptorSetLayoutUnique(info);
+    }
+
+    return descriptorSetLayout.get();
+}
+
+uint64_t
+PipelineSystem::graphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                                     const PipelineStates& pipelineStates,
+                                     const ShaderStages& shaderStages,
+                                     const vk::RenderPass renderPass,
+                                     const uint32_t subPassIndex) {
+    return graphicsPipelineHash(pipelineLayout,
+                                pipelineStates,
+                                shaderStages,
+                                renderPass,
+                                subPassIndex,
+                                nullptr);
+}
+
+uint64_t
+PipelineSystem::graphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                                     const PipelineStates& pipelineStates,
+                                     const ShaderStages& shaderStages,
+                                     const vk::RenderPass renderPass,
+                                     const uint32_t subPassIndex,
+                                     GraphicsPipelineKey* key) {
+    StateHasher hasher(key);
+
+    const DynamicStateFields dynamicFields(pipelineStates.dynamicState());
+    addOptionalState(hasher, pipelineStates.vertexInputState(), dynamicFields, addVertexInputState);
+    addOptionalState(hasher, pipelineStates.inputAssemblyState(), dynamicFields, addInputAssemblyState);
+    addOptionalState(hasher, pipelineStates.tessellationState(), dynamicFields, addTessellationState);
+    addOptionalState(hasher, pipelineStates.viewportState(), dynamicFields, addViewportState);
+    addOptionalState(hasher, pipelineStates.rasterizationState(), dynamicFields, addRasterizationState);
+    addOptionalState(hasher, pipelineStates.multisampleState(), dynamicFields, addMultisampleState);
+    addOptionalState(hasher, pipelineStates.depthStencilState(), dynamicFields, addDepthStencilState);
+    addOptionalState(hasher, pipelineStates.colorBlendState(), dynamicFields, addColorBlendState);
+    addOptionalState(hasher, pipelineStates.dynamicState(), dynamicFields, addDynamicState);
+
+    addShaderStages(hasher,
+                    shaderStages.stages());
+
+    hasher.add(pipelineLayout);
+    hasher.add(renderPass);
+    hasher.add(subPassIndex);
+
+    return hasher.hash();
+}
+
+uint64_t
+PipelineSystem::checkedGraphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                                            const PipelineStates& pipelineStates,
+                                            const ShaderStages& shaderStages,
+                                            const vk::RenderPass renderPass,
+                                            const uint32_t subPassIndex) {
+    GraphicsPipelineKey key;
+    const uint64_t hash = graphicsPipelineHash(pipelineLayout,
+                                               pipelineStates,
+                                               shaderStages,
+                                               renderPass,
+                                               subPassIndex,
+                                               &key);
+
+    // The first state with this hash keeps its key. A different state with
+    // the same hash would get the pipeline of the first one.
+    GraphicsPipelineKeyByHash::const_iterator findIt = mGraphicsPipelineKeyByHash.find(hash);
+    if (findIt == mGraphicsPipelineKeyByHash.end()) {
+        mGraphicsPipelineKeyByHash.emplace(hash,
+                                           std::move(key));
+    } else if (findIt->second != key) {
+        throw std::runtime_error("Graphics pipeline hash collision");
+    }
+
+    return hash;
+}
+
+bool
+PipelineSystem::compileGraphicsPipelineAsync(const uint64_t pipelineHash,
+                                             const vk::PipelineLayout pipelineLayout,
+                                             const PipelineStates& pipelineStates,
+                                             const ShaderStages& shaderStages,
+                                             const vk::RenderPass renderPass,
+                                             const uint32_t subPassIndex) {
+    if (mGraphicsPipelineByHash.find(pipelineHash) == mGraphicsPipelineByHash.end() &&
+        mCompileJobByHash.find(pipelineHash) == mCompileJobByHash.end()) {
+        mCompileJobByHash[pipelineHash] = PipelineCompiler::compile(pipelineLayout,
+                                                                    pipelineStates,
+                                                                    shaderStages,
+                                                                    renderPass,
+                                                                    subPassIndex);
+
+        recordReloadableGraphicsPipeline(pipelineHash,
+                                         pipelineLayout,
+                                         pipelineStates,
+                                         shaderStages,
+                                         renderPass,
+                                         subPassIndex);
+
+        return true;
+    }
+
+    return false;
+}
+
+const PipelineLibrary&
+PipelineSystem::getOrCreatePipelineLibrary(const PipelineLibrary::Part part,
+                                           const vk::PipelineLayout pipelineLayout,
+                                           const PipelineStates& pipelineStates,
+                                           const ShaderStages& shaderStages,
+                                           const vk::RenderPass renderPass,
+                                           const uint32_t subPassIndex,
+                                           uint64_t& creationTime) {
+    const PipelineStates partStates = PipelineLibrary::partStates(part,
+                                                                  pipelineStates);
+    const ShaderStages partShaderStages = PipelineLibrary::partShaderStages(part,
+                                                                            shaderStages);
+
+    // The interface parts do not use the pipeline layout, so
+    // they are shared by the variants of any layout.
+    const vk::PipelineLayout partPipelineLayout =
+        (part == PipelineLibrary::Part::VertexInput || part == PipelineLibrary::Part::FragmentOutput) ?
+        vk::PipelineLayout() :
+        pipelineLayout;
+
+    const uint64_t partHash = graphicsPipelineHash(partPipelineLayout,
+                                                   partStates,
+                                                   partShaderStages,
+                                                   renderPass,
+                                                   subPassIndex);
+
+    std::unique_ptr<PipelineLibrary>& pipelineLibrary =
+        mPipelineLibrariesByPart[static_cast<size_t>(part)][partHash];
+    if (pipelineLibrary == nullptr) {
+        pipelineLibrary.reset(new PipelineLibrary(part,
+                                                  partPipelineLayout,
+                                                  partStates,
+                                                  partShaderStages,
+                                                  renderPass,
+                                                  subPassIndex));
+        creationTime += pipelineLibrary->creationTime();
+    }
+
+    return *pipelineLibrary;
+}
+
+void
+PipelineSystem::replaceWithOptimizedPipelineIfReady(const uint64_t pipelineHash) {
+    LinkedGraphicsPipelineByHash::iterator findIt = mLinkedGraphicsPipelineByHash.find(pipelineHash);
+    if (findIt == mLinkedGraphicsPipelineByHash.end() ||
+        findIt->second.mOptimizedLinkJob->isReady() == false) {
+        return;
+    }
+
+    // The fast linked pipeline is kept if the optimized link failed.
+    const LinkedGraphicsPipeline& linkedPipeline = findIt->second;
+    const GraphicsPipeline* optimizedPipeline = takePipelineOrReportError(*linkedPipeline.mOptimizedLinkJob,
+                                                                          "Optimized pipeline link");
+    if (optimizedPipeline == nullptr) {
+        mLinkedGraphicsPipelineByHash.erase(findIt);
+        return;
+    }
+
+    std::cout << "Pipeline variant " << std::hex << pipelineHash << std::dec
+              << ": libraries created in " << linkedPipeline.mLibraryCreationTime / 1000000.0 << " ms"
+              << ", fast link in " << linkedPipeline.mFastLinkedPipeline->creationTime() / 1000000.0 << " ms"
+              << ", optimized link in " << optimizedPipeline->creationTime() / 1000000.0 << " ms" << std::endl;
+
+    mReplacedGraphicsPipelines.push_back(linkedPipeline.mFastLinkedPipeline);
+    mGraphicsPipelineByHash[pipelineHash] = optimizedPipeline;
+    mLinkedGraphicsPipelineByHash.erase(findIt);
+}
+
+void
+PipelineSystem::recordInManifest(const vk::PipelineLayout pipelineLayout,
+                                 const PipelineStates& pipelineStates,
+                                 const ShaderStages& shaderStages,
+                                 const vk::RenderPass renderPass,
+                                 const uint32_t subPassIndex) {
+    ManifestScopeByTargetHash::const_iterator findIt =
+        mManifestScopeByTargetHash.find(manifestTargetHash(pipelineLayout,
+                                                           renderPass,
+                                                           subPassIndex));
+    if (findIt != mManifestScopeByTargetHash.end()) {
+        PipelineManifest::record(findIt->second,
+                                 pipelineStates,
+                                 shaderStages);
+    }
+}
+
+uint64_t
+PipelineSystem::manifestTargetHash(const vk::PipelineLayout pipelineLayout,
+                                   const vk::RenderPass renderPass,
+                                   const uint32_t subPassIndex) {
+    StateHasher hasher;
+    hasher.add(pipelineLayout);
+    hasher.add(renderPass);
+    hasher.add(subPassIndex);
+    return hasher.hash();
+}
+
+void
+PipelineSystem::recordReloadableGraphicsPipeline(const uint64_t pipelineHash,
+                                                 const vk::PipelineLayout pipelineLayout,
+                                                 const PipelineStates& pipelineStates,
+                                                 const ShaderStages& shaderStages,
+                                                 const vk::RenderPass renderPass,
+                                                 const uint32_t subPassIndex) {
+    if (ShaderWatcher::isEnabled() == false ||
+        mReloadableGraphicsPipelineByHash.find(pipelineHash) != mReloadableGraphicsPipelineByHash.end()) {
+        return;
+    }
+
+    ReloadableGraphicsPipeline& reloadablePipeline = mReloadableGraphicsPipelineByHash[pipelineHash];
+    reloadablePipeline.mPipelineLayout = pipelineLayout;
+    reloadablePipeline.mPipelineStates = pipelineStates;
+    reloadablePipeline.mShaderStages = shaderStages;
+    reloadablePipeline.mRenderPass = renderPass;
+    reloadablePipeline.mSubPassIndex = subPassIndex;
+}
+
+bool
+PipelineSystem::updateHotReload() {
+    for (const ShaderModuleSystem::ReloadedShaderModule& reloadedShaderModule :
+         ShaderModuleSystem::reloadChangedShaderModules()) {
+        for (auto& hashAndReloadablePipeline : mReloadableGraphicsPipelineByHash) {
+            ReloadableGraphicsPipeline& reloadablePipeline = hashAndReloadablePipeline.second;
+            if (reloadablePipeline.mShaderStages.replaceShaderModule(*reloadedShaderModule.mOldShaderModule,
+                                                                     *reloadedShaderModule.mNewShaderModule) == false) {
+                continue;
+            }
+
+            // The optimized link of the old pipeline must not replace the reloaded one.
+            const uint64_t hash = hashAndReloadablePipeline.first;
+            mLinkedGraphicsPipelineByHash.erase(hash);
+
+            // If the shader is reloaded again before the pipeline is ready,
+            // then the previous job is discarded.
+            mReloadJobByHash[hash] = PipelineCompiler::compile(reloadablePipeline.mPipelineLayout,
+                                                               reloadablePipeline.mPipelineStates,
+                                                               reloadablePipeline.mShaderStages,
+                                                               reloadablePipeline.mRenderPass,
+                                                               reloadablePipeline.mSubPassIndex);
+        }
+    }
+
+    // The old pipeline is only replaced once it was created
+    // (it could still be compiling).
+    bool isAnyPipelineReplaced = false;
+    for (CompileJobByHash::iterator jobIt = mReloadJobByHash.begin(); jobIt != mReloadJobByHash.end();) {
+        GraphicsPipelineByHash::iterator pipelineIt = mGraphicsPipelineByHash.find(jobIt->first);
+        if (pipelineIt == mGraphicsPipelineByHash.end() || jobIt->second->isReady() == false) {
+            ++jobIt;
+            continue;
+        }
+
+        // If the reloaded shaders are not valid, then the old pipeline is kept.
+        const GraphicsPipeline* reloadedPipeline = takePipelineOrReportError(*jobIt->second,
+                                                                             "Pipeline reload");
+        jobIt = mReloadJobByHash.erase(jobIt);
+        if (reloadedPipeline == nullptr) {
+            continue;
+        }
+
+        mReplacedGraphicsPipelines.push_back(pipelineIt->second);
+        pipelineIt->second = reloadedPipeline;
+        isAnyPipelineReplaced = true;
+    }
+
+    return isAnyPipelineReplaced;
+}
+
+void
+PipelineSystem::cancelRequestedGraphicsPipelines() {
+    PipelineCompiler::cancelJobs();
+
+    // The pipelines of the completed jobs are destroyed with them.
+    mCompileJobByHash.clear();
+    mPrewarmJobHashes.clear();
+    mReloadJobByHash.clear();
+
+    // The fast linked pipelines are kept.
+    mLinkedGraphicsPipelineByHash.clear();
+}
+
+size_t
+PipelineSystem::graphicsPipelineCount() {
+    return mGraphicsPipelineByHash.size();
+}
+
+void
+PipelineSystem::clear() {
+    // The PipelineCompiler must be finalized first (or
+    // cancelRequestedGraphicsPipelines() called), so no job is being compiled.
+    mCompileJobByHash.clear();
+    mPrewarmJobHashes.clear();
+    mGraphicsPipelineKeyByHash.clear();
+    mLinkedGraphicsPipelineByHash.clear();
+    mReloadJobByHash.clear();
+    mReloadableGraphicsPipelineByHash.clear();
+
+    for (const auto& hashAndGraphicsPipeline : mGraphicsPipelineByHash) {
+        delete hashAndGraphicsPipeline.second;
+    }
+    mGraphicsPipelineByHash.clear();
+
+    for (const GraphicsPipeline* graphicsPipeline : mReplacedGraphicsPipelines) {
+        delete graphicsPipeline;
+    }
+    mReplacedGraphicsPipelines.clear();
+
+    // Linked pipelines do not need their libraries.
+    for (PipelineLibraryByHash& pipelineLibraryByHash : mPipelineLibrariesByPart) {
+        pipelineLibraryByHash.clear();
+    }
+
+    // Pipeline layouts can be destroyed after the pipelines, and
+    // descriptor set layouts after the pipeline layouts.
+    mPipelineLayoutByHash.clear();
+    mDescriptorSetLayoutByHash.clear();
+
+    mManifestScopeByTargetHash.clear();
+}
+}
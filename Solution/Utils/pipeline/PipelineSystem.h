@@ -0,0 +1,324 @@
+#ifndef UTILS_PIPELINE_PIPELINE_SYSTEM
+#define UTILS_PIPELINE_PIPELINE_SYSTEM
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "GraphicsPipeline.h"
+#include "PipelineLibrary.h"
+
+namespace vulkan {
+class PipelineCompileJob;
+class PipelineStates;
+class ShaderStages;
+
+//
+// Global registry of graphics pipelines, pipeline layouts and descriptor set layouts,
+// indexed by the hash of their full creation state.
+//
+// Many materials usually share a few distinct pipeline states, so requesting
+// a pipeline for each material only creates the distinct ones.
+//
+// The hash of a graphics pipeline includes:
+// - The create info structs of all the PipelineStates (and the arrays
+//   they point to), and if each state is used or not. Fields that are
+//   dynamic states are not included (Read ExtendedDynamicState).
+// - The shader stages (shader module, entry point and specialization constants).
+// - The pipeline layout, render pass and subpass index.
+//
+// The hashed state is also kept with each hash, so a hash collision
+// throws instead of returning a pipeline created for a different state.
+//
+// Render passes are hashed by handle. Pipelines are only reused with the
+// same render pass, even if they would be compatible with another one.
+//
+// Pipelines can also be compiled asynchronously by the PipelineCompiler
+// (requestGraphicsPipeline()). Requests of the same state share the job.
+//
+// If graphics pipeline libraries are supported, then pipeline variants can be
+// linked from libraries of each part of the pipeline, that are shared by all
+// the variants (requestLinkedGraphicsPipeline()).
+//
+// Pipelines can be recorded in the PipelineManifest, to compile them
+// before the first frame of the next run (prewarmGraphicsPipelines()).
+//
+// If the ShaderWatcher is enabled, then the pipelines that use shaders whose files
+// changed are compiled again, and replace the old ones (updateHotReload()).
+//
+// Keys contain Vulkan handles (shader modules, descriptor set layouts,
+// render passes), so if any of them is destroyed, clear() must be called
+// before a new object can reuse the same handle value.
+//
+class PipelineSystem {
+public:
+    // If the pipeline was requested asynchronously, then it
+    // waits until it is compiled.
+    static const GraphicsPipeline&
+    getOrCreateGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                const PipelineStates& pipelineStates,
+                                const ShaderStages& shaderStages,
+                                const vk::RenderPass renderPass,
+                                const uint32_t subPassIndex = 0);
+
+    // Sends the pipeline to the PipelineCompiler, if it was not
+    // created nor requested before. It does not block.
+    //
+    // Returns the pipeline hash, to poll it with graphicsPipelineIfReady().
+    static uint64_t
+    requestGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                            const PipelineStates& pipelineStates,
+                            const ShaderStages& shaderStages,
+                            const vk::RenderPass renderPass,
+                            const uint32_t subPassIndex = 0);
+
+    // Creates the missing pipeline libraries of the pipeline (Read PipelineLibrary)
+    // and links them without optimization (fast link), so the pipeline can be
+    // used immediately. Then, the PipelineCompiler links them again with link
+    // time optimization, and graphicsPipelineIfReady() returns the optimized
+    // pipeline once it is ready. The fast linked pipeline is kept alive
+    // until clear(), as it can be in use.
+    //
+    // The library creation, fast link and optimized link times of each variant
+    // are reported when the optimized pipeline is ready.
+    //
+    // If graphics pipeline libraries are not supported, then it
+    // calls requestGraphicsPipeline().
+    //
+    // Returns the pipeline hash, to get it with graphicsPipelineIfReady().
+    static uint64_t
+    requestLinkedGraphicsPipeline(const vk::PipelineLayout pipelineLayout,
+                                  const PipelineStates& pipelineStates,
+                                  const ShaderStages& shaderStages,
+                                  const vk::RenderPass renderPass,
+                                  const uint32_t subPassIndex = 0);
+
+    // Associates (pipelineLayout, renderPass, subPassIndex) with scopeName, and
+    // requests all the pipelines of scopeName that the PipelineManifest
+    // recorded in the previous run.
+    //
+    // From now on, the pipelines created or requested with the same
+    // (pipelineLayout, renderPass, subPassIndex) are recorded in the
+    // PipelineManifest under scopeName.
+    //
+    // Prewarming is best effort: if a pipeline fails to compile (for example,
+    // its manifest entry is stale), then the error is reported and the
+    // pipeline is dropped. Creating or requesting the same pipeline later
+    // compiles it again, and throws its error as usual.
+    //
+    // Returns the number of requested pipelines (0 in the first run).
+    static size_t
+    prewarmGraphicsPipelines(const std::string& scopeName,
+                             const vk::PipelineLayout pipelineLayout,
+                             const vk::RenderPass renderPass,
+                             const uint32_t subPassIndex = 0);
+
+    // Blocks until all the requested pipelines are compiled.
+    // Prewarmed pipelines that failed are skipped.
+    static void
+    waitForRequestedGraphicsPipelines();
+
+    // Returns nullptr while the pipeline is being compiled, or if it was not
+    // requested (or it was cancelled by cancelRequestedGraphicsPipelines()).
+    // If the compilation failed, then it throws its exception.
+    //
+    // * pipelineHash returned by requestGraphicsPipeline()
+    static const GraphicsPipeline*
+    graphicsPipelineIfReady(const uint64_t pipelineHash);
+
+    static vk::PipelineLayout
+    getOrCreatePipelineLayout(const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts,
+                              const std::vector<vk::PushConstantRange>& pushConstantRanges = {});
+
+    // Pipeline layout of the descriptor set layouts and the push constant range
+    // reflected from the shaders (Read ShaderReflection).
+    //
+    // * useDynamicBuffers. If it is true, then uniform and storage buffers are
+    //   dynamic (SPIR-V does not distinguish them).
+    static vk::PipelineLayout
+    getOrCreatePipelineLayout(const ShaderStages& shaderStages,
+                              const bool useDynamicBuffers = false);
+
+    // A layout for each descriptor set used by the shaders (from set 0 to the
+    // last one used), with the bindings of all the stages merged.
+    // Read getOrCreatePipelineLayout(const ShaderStages&)
+    static std::vector<vk::DescriptorSetLayout>
+    getOrCreateDescriptorSetLayouts(const ShaderStages& shaderStages,
+                                    const bool useDynamicBuffers = false);
+
+    // Equal bindings share the layout, so descriptor sets of
+    // different pipelines are compatible.
+    static vk::DescriptorSetLayout
+    getOrCreateDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+
+    static uint64_t
+    graphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                         const PipelineStates& pipelineStates,
+                         const ShaderStages& shaderStages,
+                         const vk::RenderPass renderPass,
+                         const uint32_t subPassIndex);
+
+    // Shader hot reload (Read ShaderWatcher). It must be called
+    // at a frame boundary.
+    //
+    // The pipelines that use the shader modules reloaded since the previous call
+    // are sent to the PipelineCompiler, with the new shader modules.
+    // The compiled ones replace the old ones, with the same hash, so
+    // graphicsPipelineIfReady() returns them from now on. The old ones are
+    // kept alive until clear(), as they can be in use.
+    //
+    // Returns true if any pipeline was replaced, so the command buffers
+    // that use it must be recorded again.
+    static bool
+    updateHotReload();
+
+    // Cancels the requested pipelines that are not compiled yet (including the
+    // reloaded and optimized linked ones), and waits for the ones being compiled
+    // (Read PipelineCompiler::cancelJobs()).
+    //
+    // It must be called before the render passes and pipeline layouts
+    // used by the requests are destroyed.
+    static void
+    cancelRequestedGraphicsPipelines();
+
+    // Number of created pipelines (without the ones being compiled)
+    static size_t
+    graphicsPipelineCount();
+
+    static void
+    clear();
+
+private:
+    PipelineSystem() = delete;
+    ~PipelineSystem() = delete;
+    PipelineSystem(PipelineSystem&&) noexcept = delete;
+    PipelineSystem(const PipelineSystem&) = delete;
+    const PipelineSystem& operator=(const PipelineSystem&) = delete;
+
+    // Returns true if a job was created (the pipeline was
+    // not created nor requested before).
+    static bool
+    compileGraphicsPipelineAsync(const uint64_t pipelineHash,
+                                 const vk::PipelineLayout pipelineLayout,
+                                 const PipelineStates& pipelineStates,
+                                 const ShaderStages& shaderStages,
+                                 const vk::RenderPass renderPass,
+                                 const uint32_t subPassIndex);
+
+    // Bytes of the state hashed by graphicsPipelineHash()
+    using GraphicsPipelineKey = std::vector<uint8_t>;
+
+    // * key. If it is not nullptr, then the hashed bytes are appended to it.
+    static uint64_t
+    graphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                         const PipelineStates& pipelineStates,
+                         const ShaderStages& shaderStages,
+                         const vk::RenderPass renderPass,
+                         const uint32_t subPassIndex,
+                         GraphicsPipelineKey* key);
+
+    // graphicsPipelineHash(), and it throws if the hash was
+    // used before by a different state (hash collision).
+    static uint64_t
+    checkedGraphicsPipelineHash(const vk::PipelineLayout pipelineLayout,
+                                const PipelineStates& pipelineStates,
+                                const ShaderStages& shaderStages,
+                                const vk::RenderPass renderPass,
+                                const uint32_t subPassIndex);
+
+    static const PipelineLibrary&
+    getOrCreatePipelineLibrary(const PipelineLibrary::Part part,
+                               const vk::PipelineLayout pipelineLayout,
+                               const PipelineStates& pipelineStates,
+                               const ShaderStages& shaderStages,
+                               const vk::RenderPass renderPass,
+                               const uint32_t subPassIndex,
+                               uint64_t& creationTime);
+
+    static void
+    replaceWithOptimizedPipelineIfReady(const uint64_t pipelineHash);
+
+    static void
+    recordInManifest(const vk::PipelineLayout pipelineLayout,
+                     const PipelineStates& pipelineStates,
+                     const ShaderStages& shaderStages,
+                     const vk::RenderPass renderPass,
+                     const uint32_t subPassIndex);
+
+    static uint64_t
+    manifestTargetHash(const vk::PipelineLayout pipelineLayout,
+                       const vk::RenderPass renderPass,
+                       const uint32_t subPassIndex);
+
+    // Keeps the creation state of the pipeline, if the ShaderWatcher is enabled.
+    static void
+    recordReloadableGraphicsPipeline(const uint64_t pipelineHash,
+                                     const vk::PipelineLayout pipelineLayout,
+                                     const PipelineStates& pipelineStates,
+                                     const ShaderStages& shaderStages,
+                                     const vk::RenderPass renderPass,
+                                     const uint32_t subPassIndex);
+
+    using GraphicsPipelineByHash = std::unordered_map<uint64_t, const GraphicsPipeline*>;
+    static GraphicsPipelineByHash mGraphicsPipelineByHash;
+
+    using CompileJobByHash = std::unordered_map<uint64_t, std::shared_ptr<PipelineCompileJob>>;
+    static CompileJobByHash mCompileJobByHash;
+
+    // Jobs of mCompileJobByHash created by prewarmGraphicsPipelines(), and
+    // not requested by the application yet. Their errors are only reported.
+    static std::unordered_set<uint64_t> mPrewarmJobHashes;
+
+    // Key of each hash of mGraphicsPipelineByHash and mCompileJobByHash
+    using GraphicsPipelineKeyByHash = std::unordered_map<uint64_t, GraphicsPipelineKey>;
+    static GraphicsPipelineKeyByHash mGraphicsPipelineKeyByHash;
+
+    // Pipeline libraries of each part
+    using PipelineLibraryByHash = std::unordered_map<uint64_t, std::unique_ptr<PipelineLibrary>>;
+    static std::array<PipelineLibraryByHash, PipelineLibrary::sPartCount> mPipelineLibrariesByPart;
+
+    // Fast linked pipeline, whose optimized link is not ready yet.
+    struct LinkedGraphicsPipeline {
+        const GraphicsPipeline* mFastLinkedPipeline = nullptr;
+        uint64_t mLibraryCreationTime = 0;
+        std::shared_ptr<PipelineCompileJob> mOptimizedLinkJob;
+    };
+    using LinkedGraphicsPipelineByHash = std::unordered_map<uint64_t, LinkedGraphicsPipeline>;
+    static LinkedGraphicsPipelineByHash mLinkedGraphicsPipelineByHash;
+
+    // Fast linked pipelines replaced by the optimized ones
+    static std::vector<const GraphicsPipeline*> mReplacedGraphicsPipelines;
+
+    using PipelineLayoutByHash = std::unordered_map<uint64_t, vk::UniquePipelineLayout>;
+    static PipelineLayoutByHash mPipelineLayoutByHash;
+
+    using DescriptorSetLayoutByHash = std::unordered_map<uint64_t, vk::UniqueDescriptorSetLayout>;
+    static DescriptorSetLayoutByHash mDescriptorSetLayoutByHash;
+
+    // Creation state of the pipelines, to compile them again when
+    // their shaders are reloaded.
+    struct ReloadableGraphicsPipeline {
+        vk::PipelineLayout mPipelineLayout;
+        PipelineStates mPipelineStates;
+        ShaderStages mShaderStages;
+        vk::RenderPass mRenderPass;
+        uint32_t mSubPassIndex = 0;
+    };
+    using ReloadableGraphicsPipelineByHash = std::unordered_map<uint64_t, ReloadableGraphicsPipeline>;
+    static ReloadableGraphicsPipelineByHash mReloadableGraphicsPipelineByHash;
+
+    // Compile jobs of the pipelines with reloaded shaders
+    static CompileJobByHash mReloadJobByHash;
+
+    // Manifest scope name by hash of (pipeline layout, render pass, subpass)
+    using ManifestScopeByTargetHash = std::unordered_map<uint64_t, std::string>;
+    static ManifestScopeByTargetHash mManifestScopeByTargetHash;
+};
+}
+
+#endif
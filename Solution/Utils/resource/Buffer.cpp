@@ -2,9 +2,9 @@
 
 #include <cassert>
 
-#include "../CommandPools.h"
 #include "../device/LogicalDevice.h"
 #include "../device/PhysicalDevice.h"
+#include "../memory/StagingRing.h"
 
 namespace vulkan {
 Buffer::Buffer(const vk::DeviceSize bufferSize,
@@ -17,21 +17,20 @@ Buffer::Buffer(const vk::DeviceSize bufferSize,
                            sharingMode,
                            queueFamilyIndices))
     , mSizeInBytes(bufferSize)
+    , mUsage(bufferUsage)
     , mHasDeviceMemoryOwnership(true)
 {
-    const vk::MemoryRequirements memoryRequirements = LogicalDevice::device().getBufferMemoryRequirements(mBuffer);
-    vk::MemoryAllocateInfo info;
-    info.setAllocationSize(memoryRequirements.size);
-    info.setMemoryTypeIndex(PhysicalDevice::memoryTypeIndex(memoryRequirements.memoryTypeBits,
-                                                            deviceMemoryProperties));
-
-    mDeviceMemory = LogicalDevice::device().allocateMemory(info);
-
     assert(mSizeInBytes > 0);
 
+    // The alignment of the memory requirements is used by the
+    // allocator to choose the offset of the buffer inside its block.
+    const vk::MemoryRequirements memoryRequirements = LogicalDevice::device().getBufferMemoryRequirements(mBuffer);
+    mAllocation = DeviceMemoryAllocator::allocate(memoryRequirements,
+                                                  deviceMemoryProperties);
+
     LogicalDevice::device().bindBufferMemory(mBuffer,
-                                             mDeviceMemory,
-                                             0); // offset
+                                             mAllocation.mDeviceMemory,
+                                             mAllocation.mOffset);
 }
 
 Buffer::Buffer(const vk::DeviceSize bufferSize,
@@ -44,12 +43,16 @@ Buffer::Buffer(const vk::DeviceSize bufferSize,
                            sharingMode,
                            queueFamilyIndices))
     , mSizeInBytes(bufferSize)
-    , mHasDeviceMemoryOwnership(false)
-    , mDeviceMemory(deviceMemory) {
+    , mUsage(bufferUsage)
+    , mHasDeviceMemoryOwnership(false) {
     assert(mSizeInBytes > 0);
+    assert(deviceMemory != VK_NULL_HANDLE);
+
+    mAllocation.mDeviceMemory = deviceMemory;
+    mAllocation.mSize = bufferSize;
 
     LogicalDevice::device().bindBufferMemory(mBuffer,
-                                             mDeviceMemory,
+                                             mAllocation.mDeviceMemory,
                                              0); // offset
 }
 
@@ -59,7 +62,7 @@ Buffer::~Buffer() {
                     nullptr);
 
     if (mHasDeviceMemoryOwnership) {
-        LogicalDevice::device().freeMemory(mDeviceMemory);
+        DeviceMemoryAllocator::free(mAllocation);
     }
 }
 
@@ -75,13 +78,33 @@ Buffer::size() const {
     return mSizeInBytes;
 }
 
+void*
+Buffer::mappedData() const {
+    assert(mBuffer != VK_NULL_HANDLE);
+    return mAllocation.mMappedData;
+}
+
+void
+Buffer::flushMappedMemory(const vk::DeviceSize offset,
+                          const vk::DeviceSize size) const {
+    assert(mBuffer != VK_NULL_HANDLE);
+    assert(mAllocation.mMappedData != nullptr);
+    assert(offset + size <= mSizeInBytes);
+
+    DeviceMemoryAllocator::flush(mAllocation,
+                                 offset,
+                                 size);
+}
+
 Buffer::Buffer(Buffer&& other) noexcept 
     : mBuffer(other.mBuffer)
     , mSizeInBytes(other.mSizeInBytes)
-    , mDeviceMemory(other.mDeviceMemory)
+    , mUsage(other.mUsage)
+    , mHasDeviceMemoryOwnership(other.mHasDeviceMemoryOwnership)
+    , mAllocation(other.mAllocation)
 {
     other.mBuffer = vk::Buffer();
-    other.mDeviceMemory = nullptr;
+    other.mAllocation = DeviceMemoryAllocation();
 }
 
 void 
@@ -91,16 +114,30 @@ Buffer::copyToHostMemory(const void* sourceData,
     assert(mBuffer != VK_NULL_HANDLE);
     assert(sourceData != nullptr);
     assert(size > 0);
+    assert(offset + size <= mSizeInBytes);
 
-    void* destinationData = LogicalDevice::device().mapMemory(mDeviceMemory,
-                                                              offset,
+    // Memory from the DeviceMemoryAllocator is persistently mapped,
+    // so we only need to copy and flush (if it is not host coherent).
+    if (mAllocation.mMappedData != nullptr) {
+        memcpy(static_cast<char*>(mAllocation.mMappedData) + offset,
+               sourceData,
+               static_cast<size_t>(size));
+
+        DeviceMemoryAllocator::flush(mAllocation,
+                                     offset,
+                                     size);
+        return;
+    }
+
+    void* destinationData = LogicalDevice::device().mapMemory(mAllocation.mDeviceMemory,
+                                                              mAllocation.mOffset + offset,
                                                               size);
 
     memcpy(destinationData,
            sourceData,
            static_cast<size_t>(size));
 
-    LogicalDevice::device().unmapMemory(mDeviceMemory);
+    LogicalDevice::device().unmapMemory(mAllocation.mDeviceMemory);
 }
 
 void
@@ -111,29 +148,32 @@ Buffer::copyToHostMemory(const void* sourceData,
                      offset);
 }
 
-void
+TransferTicket
 Buffer::copyFromBufferToDeviceMemory(const Buffer& sourceBuffer) {    
-    vk::UniqueCommandBuffer commandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer();
-
     vk::BufferCopy bufferCopy;
     bufferCopy.size = sourceBuffer.size();
-    commandBuffer->copyBuffer(sourceBuffer.vkBuffer(),
-                              mBuffer,
-                              {bufferCopy});
-    
-    CommandPools::endAndWaitOneTimeSubmitCommandBuffer(commandBuffer.get());
+    TransferEngine::commandBuffer().copyBuffer(sourceBuffer.vkBuffer(),
+                                               mBuffer,
+                                               {bufferCopy});
+
+    transferOwnershipToGraphicsQueue();
+
+    return TransferEngine::currentTicket();
 }
 
-void
+TransferTicket
 Buffer::copyFromDataToDeviceMemory(const void* sourceData,
                                    const vk::DeviceSize size) {
     assert(sourceData != nullptr);
     assert(size > 0);
 
-    Buffer buffer = createAndFillStagingBuffer(sourceData,
-                                               size);
+    StagingRing::uploadToBuffer(sourceData,
+                                size,
+                                mBuffer);
+
+    transferOwnershipToGraphicsQueue();
 
-    copyFromBufferToDeviceMemory(buffer);
+    return TransferEngine::currentTicket();
 }
 
 Buffer
@@ -154,6 +194,52 @@ Buffer::createAndFillStagingBuffer(const void* sourceData,
     return buffer;
 }
 
+void
+Buffer::transferOwnershipToGraphicsQueue() const {
+    assert(mBuffer != VK_NULL_HANDLE);
+
+    // The acquire barrier makes the copy available to the 
+    // first use of the buffer, that we deduce from its usage.
+    vk::PipelineStageFlags destPipelineStages;
+    vk::AccessFlags destAccesses;
+    if (mUsage & vk::BufferUsageFlagBits::eVertexBuffer) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eVertexInput;
+        destAccesses |= vk::AccessFlagBits::eVertexAttributeRead;
+    }
+    if (mUsage & vk::BufferUsageFlagBits::eIndexBuffer) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eVertexInput;
+        destAccesses |= vk::AccessFlagBits::eIndexRead;
+    }
+    if (mUsage & vk::BufferUsageFlagBits::eIndirectBuffer) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eDrawIndirect;
+        destAccesses |= vk::AccessFlagBits::eIndirectCommandRead;
+    }
+    if (mUsage & vk::BufferUsageFlagBits::eUniformBuffer) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eVertexShader |
+                              vk::PipelineStageFlagBits::eFragmentShader;
+        destAccesses |= vk::AccessFlagBits::eUniformRead;
+    }
+    if (mUsage & vk::BufferUsageFlagBits::eStorageBuffer) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eVertexShader |
+                              vk::PipelineStageFlagBits::eFragmentShader |
+                              vk::PipelineStageFlagBits::eComputeShader;
+        destAccesses |= vk::AccessFlagBits::eShaderRead | 
+                        vk::AccessFlagBits::eShaderWrite;
+    }
+    if (mUsage & vk::BufferUsageFlagBits::eTransferSrc) {
+        destPipelineStages |= vk::PipelineStageFlagBits::eTransfer;
+        destAccesses |= vk::AccessFlagBits::eTransferRead;
+    }
+    if (!destPipelineStages) {
+        destPipelineStages = vk::PipelineStageFlagBits::eAllCommands;
+        destAccesses = vk::AccessFlagBits::eMemoryRead;
+    }
+
+    TransferEngine::transferBufferOwnership(mBuffer,
+                                            destPipelineStages,
+                                            destAccesses);
+}
+
 vk::Buffer
 Buffer::createBuffer(const vk::DeviceSize size,
                      const vk::BufferUsageFlags usageFlags,
@@ -5,6 +5,9 @@
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "../TransferEngine.h"
+#include "../memory/DeviceMemoryAllocator.h"
+
 namespace vulkan {
 //
 // Buffer wrapper.
@@ -28,6 +31,9 @@ namespace vulkan {
 // Allocation is a costly operation and there is a limit on maximum number of allocations as well, 
 // all of which can be queried from your PhysicalDevice.
 //
+// That is what the first constructor does: it sub-allocates the DeviceMemory
+// from the global DeviceMemoryAllocator and binds the buffer at a non-zero offset.
+//
 // You need the Buffer to:
 // - Create the BufferView.
 //
@@ -36,8 +42,8 @@ namespace vulkan {
 //
 class Buffer {
 public:
-    // This constructor must be used if you want that this buffer also creates
-    // its own DeviceMemory.
+    // This constructor must be used if you want that this buffer also gets
+    // its own DeviceMemory (sub-allocated by the global DeviceMemoryAllocator).
     //
     // * bufferSize in bytes.
     //
@@ -50,7 +56,7 @@ public:
     //
     // Notes:     
     //   - The global logical device owns the buffer and the device memory
-    //   - The global physical device is used to create the device memory
+    //   - The global DeviceMemoryAllocator is used to allocate the device memory
     Buffer(const vk::DeviceSize bufferSize,
            const vk::BufferUsageFlags bufferUsage,
            const vk::MemoryPropertyFlags deviceMemoryProperties,
@@ -77,6 +83,23 @@ public:
 
     vk::DeviceSize 
     size() const;
+
+    // Returns the host address of the beginning of the buffer,
+    // or nullptr if its memory is not persistently mapped
+    // (memory that is not host visible or that was provided
+    // by the second constructor).
+    void*
+    mappedData() const;
+
+    // Makes host writes to the mapped range [offset, offset + size)
+    // visible to the device. 
+    // It does nothing if the memory is host coherent.
+    //
+    // Preconditions:
+    // - mappedData() != nullptr
+    void
+    flushMappedMemory(const vk::DeviceSize offset,
+                      const vk::DeviceSize size) const;
     
     // The driver may not immediately copy the data
     // into the buffer memory, for example because
@@ -122,13 +145,24 @@ public:
     // These methods assumes the buffer was created with
     // VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT.
     //
-    // These methods create internal staging buffers to be able to do the copy,
-    // and use fences to be signaled once the copy operation finishes.
+    // The copies are recorded in the current TransferEngine batch and 
+    // they do not block. They return the ticket of the batch, that can be
+    // used to wait for the copy on the host (TransferEngine::wait) or on
+    // the device (TransferEngine::takeSemaphore) before the buffer is used.
     //
-    // Notes: The global physical device is used to create the staging buffer
-    void 
+    // The buffer must be exclusive. After the copy, its ownership is 
+    // transferred to the graphics queue family.
+    //
+    // copyFromBufferToDeviceMemory: the sourceBuffer must be alive
+    // until the copy is completed.
+    //
+    // copyFromDataToDeviceMemory streams the data through the
+    // global StagingRing (split in chunks if it does not fit),
+    // so it does not allocate any staging buffer, and the sourceData
+    // can be freed as soon as it returns.
+    TransferTicket
     copyFromBufferToDeviceMemory(const Buffer& sourceBuffer);
-    void
+    TransferTicket
     copyFromDataToDeviceMemory(const void* sourceData,
                                const vk::DeviceSize size);
 
@@ -149,16 +183,23 @@ private:
                  const vk::SharingMode sharingMode,
                  const std::vector<uint32_t>& queueFamilyIndices);
   
+    // Records the queue family ownership transfer of the buffer from the 
+    // transfer queue family (that wrote it) to the graphics queue family, 
+    // if they are different (Read TransferEngine).
+    void
+    transferOwnershipToGraphicsQueue() const;
+
     vk::Buffer mBuffer;
     const vk::DeviceSize mSizeInBytes = 0;
+    const vk::BufferUsageFlags mUsage;
 
     // This is only used if the Buffer is created
     // with the constructor that includes the data needed
     // for DeviceMemory creation.
     // Otherwise, we will use the DeviceMemory provided
-    // by the second constructor.
+    // by the second constructor (at offset 0 and not mapped).
     const bool mHasDeviceMemoryOwnership = true;
-    vk::DeviceMemory mDeviceMemory;
+    DeviceMemoryAllocation mAllocation;
 };
 }
 
@@ -1,9 +1,12 @@
 #include "Image.h"
 
+#include <stdexcept>
+#include <string>
+
 #include "Buffer.h"
-#include "../CommandPools.h"
 #include "../device/LogicalDevice.h"
 #include "../device/PhysicalDevice.h"
+#include "../memory/StagingRing.h"
 
 namespace vulkan {
 Image::Image(const uint32_t imageWidth,
@@ -21,8 +24,8 @@ Image::Image(const uint32_t imageWidth,
              const std::vector<uint32_t>& queueFamilyIndices)
     : mExtent {imageWidth, imageHeight, imageDepth}
     , mFormat(format)
-    , mSrcLayout(initialImageLayout)
     , mImage(createImage(imageUsageFlags,
+                         initialImageLayout,
                          imageType,
                          sampleCount,
                          imageTiling,
@@ -31,17 +34,36 @@ Image::Image(const uint32_t imageWidth,
                          queueFamilyIndices))
     , mHasDeviceMemoryOwnership(true)
 {
-    const vk::MemoryRequirements memoryRequirements = LogicalDevice::device().getImageMemoryRequirements(mImage);
-    vk::MemoryAllocateInfo info;
-    info.setAllocationSize(memoryRequirements.size);
-    info.setMemoryTypeIndex(PhysicalDevice::memoryTypeIndex(memoryRequirements.memoryTypeBits,
-                                                            deviceMemoryProperties));
-
-    mDeviceMemory = LogicalDevice::device().allocateMemory(info);
+    mAllocation = DeviceMemoryAllocator::allocate(memoryRequirements(),
+                                                  deviceMemoryProperties,
+                                                  imageTiling == vk::ImageTiling::eOptimal ?
+                                                  ResourceTiling::Optimal :
+                                                  ResourceTiling::Linear);
 
     LogicalDevice::device().bindImageMemory(mImage,
-                                            mDeviceMemory,
-                                            0);
+                                            mAllocation.mDeviceMemory,
+                                            mAllocation.mOffset);
+}
+
+Image::Image(const uint32_t imageWidth,
+             const uint32_t imageHeight,
+             const vk::Format format,
+             const vk::ImageUsageFlags imageUsageFlags,
+             const vk::SampleCountFlagBits sampleCount,
+             const vk::ImageLayout initialImageLayout)
+    : mExtent {imageWidth, imageHeight, 1}
+    , mFormat(format)
+    , mImage(createImage(imageUsageFlags,
+                         initialImageLayout,
+                         vk::ImageType::e2D,
+                         sampleCount,
+                         vk::ImageTiling::eOptimal,
+                         1,
+                         vk::SharingMode::eExclusive,
+                         {}))
+    , mHasDeviceMemoryOwnership(false)
+{
+
 }
 
 Image::~Image() {
@@ -50,21 +72,20 @@ Image::~Image() {
                    nullptr);
 
     if (mHasDeviceMemoryOwnership) {
-        LogicalDevice::device().freeMemory(mDeviceMemory);
+        DeviceMemoryAllocator::free(mAllocation);
     }
 }
 
 Image::Image(Image&& other) noexcept
     : mExtent(other.mExtent)
+    , mFormat(other.mFormat)
     , mMipLevelCount(other.mMipLevelCount)
-    , mSrcLayout(other.mSrcLayout)
-    , mSrcAccesses(other.mSrcAccesses)
-    , mSrcPipelineStages(other.mSrcPipelineStages)
+    , mMipLevelStates(std::move(other.mMipLevelStates))
     , mImage(other.mImage)
     , mHasDeviceMemoryOwnership(other.mHasDeviceMemoryOwnership)
-    , mDeviceMemory(other.mDeviceMemory) {
+    , mAllocation(other.mAllocation) {
     other.mImage = vk::Image();
-    other.mDeviceMemory = nullptr;
+    other.mAllocation = DeviceMemoryAllocation();
 }
 
 vk::Image
@@ -92,103 +113,92 @@ Image::mipLevelCount() const {
 }
 
 vk::ImageLayout
-Image::lastImageLayout() const {
+Image::lastImageLayout(const uint32_t mipLevel) const {
+    assert(mImage != VK_NULL_HANDLE);
+    assert(mipLevel < mMipLevelCount);
+    return mMipLevelStates[mipLevel].mLayout;
+}
+
+vk::MemoryRequirements
+Image::memoryRequirements() const {
     assert(mImage != VK_NULL_HANDLE);
-    return mSrcLayout;
+    return LogicalDevice::device().getImageMemoryRequirements(mImage);
 }
 
 void
+Image::bindDeviceMemory(const vk::DeviceMemory deviceMemory,
+                        const vk::DeviceSize offset) {
+    assert(mImage != VK_NULL_HANDLE);
+    assert(deviceMemory != VK_NULL_HANDLE);
+    assert(mHasDeviceMemoryOwnership == false);
+    assert(mAllocation.isValid() == false);
+
+    mAllocation.mDeviceMemory = deviceMemory;
+    mAllocation.mOffset = offset;
+    mAllocation.mSize = memoryRequirements().size;
+
+    LogicalDevice::device().bindImageMemory(mImage,
+                                            deviceMemory,
+                                            offset);
+}
+
+TransferTicket
 Image::copyFromDataToDeviceMemory(void* sourceData,
                                   const vk::DeviceSize size) {
     assert(sourceData != nullptr);
     assert(size > 0);
 
-    transitionImageLayout(vk::ImageLayout::eTransferDstOptimal);    
-
-    Buffer stagingBuffer = Buffer::createAndFillStagingBuffer(sourceData,
-                                                              size);
-    
-    vk::ImageSubresourceLayers layer;
-    layer.setAspectMask(vk::ImageAspectFlagBits::eColor);
-    layer.setLayerCount(1);
-
-    vk::BufferImageCopy bufferImageCopy;
-    bufferImageCopy.setImageSubresource(layer);
-    bufferImageCopy.setImageExtent(mExtent);
-
-    vk::UniqueCommandBuffer commandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer();
-    commandBuffer->copyBufferToImage(stagingBuffer.vkBuffer(),
-                                     mImage,
-                                     vk::ImageLayout::eTransferDstOptimal,
-                                     {bufferImageCopy});
-    CommandPools::endAndWaitOneTimeSubmitCommandBuffer(commandBuffer.get());
+    // All the mip levels are going to be written, so their
+    // previous content can be discarded. That also means that the transfer 
+    // queue family does not need to acquire them.
+    // The image must not be in use by the device.
+    for (MipLevelState& state : mMipLevelStates) {
+        state = MipLevelState();
+    }
+    transitionMipLevels(TransferEngine::commandBuffer(),
+                        0,
+                        mMipLevelCount,
+                        vk::ImageLayout::eTransferDstOptimal);
+
+    const vk::DeviceSize texelSize = size / (static_cast<vk::DeviceSize>(mExtent.width) * mExtent.height);
+    assert(texelSize * mExtent.width * mExtent.height == size);
+
+    StagingRing::uploadToImage(sourceData,
+                               mImage,
+                               mExtent.width,
+                               mExtent.height,
+                               texelSize);
+
+    // The image is exclusive, so the graphics queue family must acquire it
+    // before the mip maps are generated (blits need a graphics queue).
+    vk::ImageSubresourceRange range;
+    range.setAspectMask(aspectFlags());
+    range.setBaseMipLevel(0);
+    range.setLevelCount(mMipLevelCount);
+    range.setBaseArrayLayer(0);
+    range.setLayerCount(1);
+    TransferEngine::transferImageOwnership(mImage,
+                                           range,
+                                           vk::ImageLayout::eTransferDstOptimal,
+                                           vk::PipelineStageFlagBits::eTransfer,
+                                           vk::AccessFlagBits::eTransferRead | 
+                                           vk::AccessFlagBits::eTransferWrite);
 
     generateMipmaps();
+
+    return TransferEngine::currentTicket();
 }
 
-void
+TransferTicket
 Image::transitionImageLayout(const vk::ImageLayout destLayout) {
     assert(mImage != VK_NULL_HANDLE);
-    assert(mSrcLayout != destLayout);
-
-    // Initialize to the first value in the enum
-    vk::AccessFlags destAccesses;
-    vk::PipelineStageFlags destPipelineStages;
 
-    // Transfer writes must occur in the pipeline transfer stage. 
-    // Since the writes do not have to wait on anything,
-    // you may specify an empty access mask and the earliest possible
-    // pipeline stage VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT for the
-    // pre-barrier operations.
-    // It should be noted that VK_PIPELINE_STAGE_TRANSFER_BIT is not 
-    // a real stage within the graphics and compute pipelines.
-    // It is more of a pseudo-stage where transfers happen.
-    if (mSrcLayout == vk::ImageLayout::eUndefined &&
-        destLayout == vk::ImageLayout::eTransferDstOptimal) {
-        destPipelineStages = vk::PipelineStageFlagBits::eTransfer;
-        destAccesses = vk::AccessFlagBits::eTransferWrite;
-    } else if (mSrcLayout == vk::ImageLayout::eTransferDstOptimal &&
-               destLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-        destPipelineStages = vk::PipelineStageFlagBits::eFragmentShader;
-        destAccesses = vk::AccessFlagBits::eShaderRead;
-    } else if (mSrcLayout == vk::ImageLayout::eUndefined &&
-               destLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        destPipelineStages = vk::PipelineStageFlagBits::eEarlyFragmentTests;
-        destAccesses = vk::AccessFlagBits::eDepthStencilAttachmentRead |
-                       vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-    } else {
-        assert(false && "Unsupported image layout transition");
-    }
+    transitionMipLevels(TransferEngine::graphicsCommandBuffer(),
+                        0,
+                        mMipLevelCount,
+                        destLayout);
 
-    vk::ImageSubresourceRange range;
-    if (destLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal) {
-        range.setAspectMask(vk::ImageAspectFlagBits::eDepth);
-    } else {
-        range.setAspectMask(vk::ImageAspectFlagBits::eColor);
-    }
-    range.setLevelCount(mMipLevelCount);
-    range.setLayerCount(1);
-
-    vk::ImageMemoryBarrier barrier;
-    barrier.setImage(mImage);
-    barrier.setOldLayout(mSrcLayout);
-    barrier.setNewLayout(destLayout);
-    barrier.setSrcAccessMask(mSrcAccesses);
-    barrier.setDstAccessMask(destAccesses);
-    barrier.setSubresourceRange(range);
-    
-    vk::UniqueCommandBuffer commandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer();
-    commandBuffer->pipelineBarrier(mSrcPipelineStages,
-                                   destPipelineStages,
-                                   vk::DependencyFlagBits::eByRegion,
-                                   {}, // memory barriers
-                                   {}, // buffer memory barriers
-                                   {barrier});
-    CommandPools::endAndWaitOneTimeSubmitCommandBuffer(commandBuffer.get());
-
-    mSrcLayout = destLayout;
-    mSrcAccesses = destAccesses;
-    mSrcPipelineStages = destPipelineStages;
+    return TransferEngine::currentTicket();
 }
 
 vk::UniqueImageView
@@ -205,6 +215,7 @@ Image::createImageView(const vk::ImageAspectFlags aspectFlags) const {
 
 vk::Image
 Image::createImage(const vk::ImageUsageFlags imageUsageFlags,
+                   const vk::ImageLayout initialImageLayout,
                    const vk::ImageType imageType,
                    const vk::SampleCountFlagBits sampleCount,
                    const vk::ImageTiling imageTiling,
@@ -221,13 +232,18 @@ Image::createImage(const vk::ImageUsageFlags imageUsageFlags,
                                                                              mExtent.height)))) + 1;
     }
 
+    MipLevelState initialState;
+    initialState.mLayout = initialImageLayout;
+    mMipLevelStates.assign(mMipLevelCount,
+                           initialState);
+
     vk::ImageCreateInfo info = {};
     info.setImageType(imageType);
     info.setExtent(mExtent);
     info.setFormat(mFormat);
     info.setUsage(imageUsageFlags);
     info.setMipLevels(mMipLevelCount);
-    info.setInitialLayout(mSrcLayout);
+    info.setInitialLayout(initialImageLayout);
     info.setSamples(sampleCount);
     info.setTiling(imageTiling);
     info.setArrayLayers(arrayLayerCount);
@@ -244,97 +260,56 @@ void
 Image::generateMipmaps() {
     assert(mImage != VK_NULL_HANDLE);
 
-    if (mMipLevelCount == 1) {
-        return;
-    }
-
-    vk::ImageSubresourceRange range;
-    range.setAspectMask(vk::ImageAspectFlagBits::eColor);
-    range.setBaseArrayLayer(0);
-    range.setLayerCount(1);
-    range.setLevelCount(1);
+    const vk::CommandBuffer commandBuffer = TransferEngine::graphicsCommandBuffer();
 
     int32_t previousMipMapWidth = mExtent.width;
     int32_t previousMipMapHeight = mExtent.height;
 
-    vk::UniqueCommandBuffer commandBuffer = CommandPools::beginOneTimeSubmitCommandBuffer();
     for (uint32_t i = 1; i < mMipLevelCount; ++i) {
         // We set the previous mipmap as the transfer source that will be read, 
         // because we are going to write to the current mip map.
-        {
-            range.setBaseMipLevel(i - 1);
-
-            vk::ImageMemoryBarrier barrier;
-            barrier.setImage(mImage);
-            barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-            barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
-            barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-            barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
-            barrier.setSubresourceRange(range);
-                        
-            commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                           vk::PipelineStageFlagBits::eTransfer,
-                                           vk::DependencyFlagBits(),
-                                           {},
-                                           {},
-                                           {barrier});
-        }
+        // The current mip map is already in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+        transitionMipLevels(commandBuffer,
+                            i - 1,
+                            1,
+                            vk::ImageLayout::eTransferSrcOptimal);
 
         // Blit previous mip map to current mip map
-        {
-            std::array<vk::Offset3D, 2> srcOffsets;
-            srcOffsets[0] = {0, 0, 0};
-            srcOffsets[1] = {previousMipMapWidth, previousMipMapHeight, 1};
-
-            std::array<vk::Offset3D, 2> destOffsets;
-            destOffsets[0] = {0, 0, 0};
-            destOffsets[1] = {previousMipMapWidth > 1 ? previousMipMapWidth / 2 : 1,
-                              previousMipMapHeight > 1 ? previousMipMapHeight / 2 : 1,
-                              1};
-
-            vk::ImageSubresourceLayers srcLayer;
-            srcLayer.setAspectMask(vk::ImageAspectFlagBits::eColor);
-            srcLayer.setMipLevel(i - 1);
-            srcLayer.setBaseArrayLayer(0);
-            srcLayer.setLayerCount(1);
-
-            vk::ImageSubresourceLayers destLayer;
-            destLayer.setAspectMask(vk::ImageAspectFlagBits::eColor);
-            destLayer.setMipLevel(i);
-            destLayer.setBaseArrayLayer(0);
-            destLayer.setLayerCount(1);
-
-            vk::ImageBlit blit;
-            blit.setSrcOffsets(srcOffsets);
-            blit.setDstOffsets(destOffsets);
-            blit.setSrcSubresource(srcLayer);
-            blit.setDstSubresource(destLayer);
-
-            commandBuffer->blitImage(mImage,
-                                     vk::ImageLayout::eTransferSrcOptimal,
-                                     mImage,
-                                     vk::ImageLayout::eTransferDstOptimal,
-                                     {blit},
-                                     vk::Filter::eLinear);
-        }
-
-        // Now, set the previous mip map to be read by the fragment shader.
-        {
-            vk::ImageMemoryBarrier barrier;
-            barrier.setImage(mImage);
-            barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
-            barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-            barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
-            barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
-            barrier.setSubresourceRange(range);
-
-            commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                           vk::PipelineStageFlagBits::eFragmentShader,
-                                           vk::DependencyFlags(),
-                                           {},
-                                           {},
-                                           {barrier});
-        }
+        std::array<vk::Offset3D, 2> srcOffsets;
+        srcOffsets[0] = {0, 0, 0};
+        srcOffsets[1] = {previousMipMapWidth, previousMipMapHeight, 1};
+
+        std::array<vk::Offset3D, 2> destOffsets;
+        destOffsets[0] = {0, 0, 0};
+        destOffsets[1] = {previousMipMapWidth > 1 ? previousMipMapWidth / 2 : 1,
+                          previousMipMapHeight > 1 ? previousMipMapHeight / 2 : 1,
+                          1};
+
+        vk::ImageSubresourceLayers srcLayer;
+        srcLayer.setAspectMask(vk::ImageAspectFlagBits::eColor);
+        srcLayer.setMipLevel(i - 1);
+        srcLayer.setBaseArrayLayer(0);
+        srcLayer.setLayerCount(1);
+
+        vk::ImageSubresourceLayers destLayer;
+        destLayer.setAspectMask(vk::ImageAspectFlagBits::eColor);
+        destLayer.setMipLevel(i);
+        destLayer.setBaseArrayLayer(0);
+        destLayer.setLayerCount(1);
+
+        vk::ImageBlit blit;
+        blit.setSrcOffsets(srcOffsets);
+        blit.setDstOffsets(destOffsets);
+        blit.setSrcSubresource(srcLayer);
+        blit.setDstSubresource(destLayer);
+
+        assert(mMipLevelStates[i].mLayout == vk::ImageLayout::eTransferDstOptimal);
+        commandBuffer.blitImage(mImage,
+                                vk::ImageLayout::eTransferSrcOptimal,
+                                mImage,
+                                vk::ImageLayout::eTransferDstOptimal,
+                                {blit},
+                                vk::Filter::eLinear);
 
         // Update previous mip map dimensions
         if (previousMipMapWidth > 1) {
@@ -346,30 +321,122 @@ Image::generateMipmaps() {
         }
     }
 
-    // Now, set the last mip map to be read by the fragment shader.
-    {
-        range.setBaseMipLevel(mMipLevelCount - 1);
+    // Now, set all the mip maps to be read by the fragment shader.
+    // All the levels but the last one are in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    // so this is a single vkCmdPipelineBarrier with two image barriers.
+    transitionMipLevels(commandBuffer,
+                        0,
+                        mMipLevelCount,
+                        vk::ImageLayout::eShaderReadOnlyOptimal);
+}
+
+void
+Image::transitionMipLevels(const vk::CommandBuffer commandBuffer,
+                           const uint32_t baseMipLevel,
+                           const uint32_t mipLevelCount,
+                           const vk::ImageLayout destLayout) {
+    assert(commandBuffer != VK_NULL_HANDLE);
+    assert(mImage != VK_NULL_HANDLE);
+    assert(baseMipLevel + mipLevelCount <= mMipLevelCount);
+
+    // Transfer writes must occur in the pipeline transfer stage. 
+    // It should be noted that VK_PIPELINE_STAGE_TRANSFER_BIT is not 
+    // a real stage within the graphics and compute pipelines.
+    // It is more of a pseudo-stage where transfers happen.
+    MipLevelState destState;
+    destState.mLayout = destLayout;
+    switch (destLayout) {
+    case vk::ImageLayout::eTransferDstOptimal:
+        destState.mPipelineStages = vk::PipelineStageFlagBits::eTransfer;
+        destState.mAccesses = vk::AccessFlagBits::eTransferWrite;
+        break;
+    case vk::ImageLayout::eTransferSrcOptimal:
+        destState.mPipelineStages = vk::PipelineStageFlagBits::eTransfer;
+        destState.mAccesses = vk::AccessFlagBits::eTransferRead;
+        break;
+    case vk::ImageLayout::eShaderReadOnlyOptimal:
+        destState.mPipelineStages = vk::PipelineStageFlagBits::eFragmentShader;
+        destState.mAccesses = vk::AccessFlagBits::eShaderRead;
+        break;
+    case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+        destState.mPipelineStages = vk::PipelineStageFlagBits::eEarlyFragmentTests;
+        destState.mAccesses = vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                              vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        break;
+    default:
+        // The barrier would be recorded with wrong accesses and stages.
+        throw std::runtime_error("Unsupported image layout transition to " + vk::to_string(destLayout));
+    }
+
+    vk::ImageSubresourceRange range;
+    range.setAspectMask(aspectFlags());
+    range.setBaseArrayLayer(0);
+    range.setLayerCount(1);
+
+    // Consecutive mip levels in the same state share a single barrier.
+    std::vector<vk::ImageMemoryBarrier> barriers;
+    vk::PipelineStageFlags srcPipelineStages;
+    const uint32_t endMipLevel = baseMipLevel + mipLevelCount;
+    uint32_t mipLevel = baseMipLevel;
+    while (mipLevel < endMipLevel) {
+        const MipLevelState& srcState = mMipLevelStates[mipLevel];
+        uint32_t rangeEnd = mipLevel + 1;
+        while (rangeEnd < endMipLevel &&
+               mMipLevelStates[rangeEnd] == srcState) {
+            ++rangeEnd;
+        }
+
+        range.setBaseMipLevel(mipLevel);
+        range.setLevelCount(rangeEnd - mipLevel);
+
         vk::ImageMemoryBarrier barrier;
         barrier.setImage(mImage);
-        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-        barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        barrier.setOldLayout(srcState.mLayout);
+        barrier.setNewLayout(destLayout);
+        barrier.setSrcAccessMask(srcState.mAccesses);
+        barrier.setDstAccessMask(destState.mAccesses);
         barrier.setSubresourceRange(range);
+        barriers.push_back(barrier);
+
+        srcPipelineStages |= srcState.mPipelineStages;
+        mipLevel = rangeEnd;
+    }
+
+    commandBuffer.pipelineBarrier(srcPipelineStages,
+                                  destState.mPipelineStages,
+                                  vk::DependencyFlagBits::eByRegion,
+                                  {}, // memory barriers
+                                  {}, // buffer memory barriers
+                                  barriers);
+
+    for (uint32_t i = baseMipLevel; i < endMipLevel; ++i) {
+        mMipLevelStates[i] = destState;
+    }
+}
+
+vk::ImageAspectFlags
+Image::aspectFlags() const {
+    switch (mFormat) {
+    case vk::Format::eD16Unorm:
+    case vk::Format::eX8D24UnormPack32:
+    case vk::Format::eD32Sfloat:
+        return vk::ImageAspectFlagBits::eDepth;
+    case vk::Format::eD16UnormS8Uint:
+    case vk::Format::eD24UnormS8Uint:
+    case vk::Format::eD32SfloatS8Uint:
+        return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+    case vk::Format::eS8Uint:
+        return vk::ImageAspectFlagBits::eStencil;
+    default:
+        return vk::ImageAspectFlagBits::eColor;
+    }
+}
 
-        commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                       vk::PipelineStageFlagBits::eFragmentShader,
-                                       vk::DependencyFlags(),
-                                       {}, 
-                                       {}, 
-                                       {barrier});
-    }    
-
-    CommandPools::endAndWaitOneTimeSubmitCommandBuffer(commandBuffer.get());
-        
-    mSrcLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-    mSrcAccesses = vk::AccessFlagBits::eShaderRead;
-    mSrcPipelineStages = vk::PipelineStageFlagBits::eFragmentShader;
+bool
+Image::MipLevelState::operator==(const MipLevelState& other) const {
+    return mLayout == other.mLayout &&
+           mAccesses == other.mAccesses &&
+           mPipelineStages == other.mPipelineStages;
 }
 
 }
\ No newline at end of file
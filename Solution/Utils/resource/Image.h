@@ -5,6 +5,9 @@
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "../TransferEngine.h"
+#include "../memory/DeviceMemoryAllocator.h"
+
 namespace vulkan {
 //
 // Image wrapper
@@ -38,6 +41,11 @@ namespace vulkan {
 // Allocation is a costly operation and there is a limit on maximum number of allocations as well, 
 // all of which can be queried from your PhysicalDevice.
 //
+// That is what the first constructor does: it sub-allocates the DeviceMemory
+// from the global DeviceMemoryAllocator.
+// The second constructor does not bind any memory, so many images can be
+// placed in the same DeviceMemory (Read TransientImagePool).
+//
 // One exception to the obligation to allocate and bind DeviceMemory 
 // for every Image is the creation of a Swapchain.
 //
@@ -58,6 +66,10 @@ public:
     // * imageUsageFlags describing the intended usage of the image.
     //
     // * memoryPropertyFlags is used to create the DeviceMemory
+    //   Transient attachments (VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) like
+    //   depth or MSAA buffers that are not stored should also request
+    //   VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT. On tiled GPUs, their memory
+    //   may never be backed. On other GPUs, the flag is ignored.
     //
     // * initialImageLayout of all image subresources of the image
     //   Images are stored in implementation-dependent opaque layouts in memory.
@@ -87,7 +99,9 @@ public:
     // * queueFamilyIndices is a list of queue families that will access this 
     //   image (ignored if sharingMode is not VK_SHARING_MODE_CONCURRENT).
     //
-    // Notes: The global logical device owns the image and memory.
+    // Notes: 
+    //   - The global logical device owns the image and memory.
+    //   - The global DeviceMemoryAllocator is used to allocate the device memory
     Image(const uint32_t imageWidth,
           const uint32_t imageHeight,
           const vk::Format format,
@@ -101,6 +115,17 @@ public:
           const uint32_t arrayLayerCount = 1,
           const vk::SharingMode sharingMode = vk::SharingMode::eExclusive,
           const std::vector<uint32_t>& queueFamilyIndices = {});
+
+    // This constructor must be used if you want to provide
+    // the DeviceMemory that the image should use.
+    // The image cannot be used until bindDeviceMemory() is called.
+    // Check the first constructor for an explanation of each parameter.
+    Image(const uint32_t imageWidth,
+          const uint32_t imageHeight,
+          const vk::Format format,
+          const vk::ImageUsageFlags imageUsageFlags,
+          const vk::SampleCountFlagBits sampleCount,
+          const vk::ImageLayout initialImageLayout = vk::ImageLayout::eUndefined);
     ~Image();
     Image(Image&&) noexcept;
     Image(const Image&) = delete;
@@ -118,21 +143,48 @@ public:
     uint32_t
     mipLevelCount() const;
 
+    // Layout of the mip level after the last recorded transition.
     vk::ImageLayout
-    lastImageLayout() const;
+    lastImageLayout(const uint32_t mipLevel = 0) const;
+
+    vk::MemoryRequirements
+    memoryRequirements() const;
+
+    // Binds the image at "offset" of deviceMemory.
+    // It can only be called once, and only if the image was created 
+    // with the second constructor.
+    void
+    bindDeviceMemory(const vk::DeviceMemory deviceMemory,
+                     const vk::DeviceSize offset);
 
     // this method assumes the image was created with
     // VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT.
     //
-    // This method creates an internal staging buffer to be able to do the copy,
-    // and use fences to be signaled once the copy operation finishes.
+    // The data is streamed through the global StagingRing (split in
+    // groups of rows if it does not fit), and the layout transitions,
+    // the copy and the mip maps generation are recorded in the current 
+    // TransferEngine batch. It does not block, and several images
+    // can be uploaded in the same batch (Read ImageSystem::loadImages).
     //
-    // Notes: The global physical device is used to create the staging buffer
-    void
+    // After the upload, all the mip levels are in 
+    // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and owned by the graphics 
+    // queue family. The copy is executed by the transfer queue, and the 
+    // mip maps generation by the graphics queue.
+    //
+    // Returns the ticket of the batch, that must be waited (on the host or 
+    // with its semaphore) before the image is used.
+    //
+    // * sourceData is a tightly packed image of "size" bytes.
+    //   It can be freed as soon as the method returns.
+    TransferTicket
     copyFromDataToDeviceMemory(void* sourceData,
                                const vk::DeviceSize size);
 
-    void
+    // Transitions all the mip levels.
+    // The barrier is recorded in the graphics command buffer of 
+    // the current TransferEngine batch.
+    // Returns the ticket of the batch.
+    TransferTicket
     transitionImageLayout(const vk::ImageLayout destLayout);
 
     vk::UniqueImageView
@@ -142,6 +194,7 @@ private:
     // Read Image() constructor to understand the parameters.
     vk::Image
     createImage(const vk::ImageUsageFlags imageUsageFlags,
+                const vk::ImageLayout initialImageLayout,
                 const vk::ImageType imageType,
                 const vk::SampleCountFlagBits sampleCount,
                 const vk::ImageTiling imageTiling,
@@ -149,15 +202,40 @@ private:
                 const vk::SharingMode sharingMode,
                 const std::vector<uint32_t>& queueFamilyIndices);
 
+    // Precondition: All the mip levels must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    // owned by the graphics queue family, and the level 0 must have the image data.
+    // Commands are recorded in the graphics command buffer of the current TransferEngine batch.
     void
     generateMipmaps();
+
+    // Records a single vkCmdPipelineBarrier that transitions the mip levels 
+    // [baseMipLevel, baseMipLevel + mipLevelCount) to destLayout, from the
+    // layout, accesses and pipeline stages of the last use of each level.
+    // It throws std::runtime_error if destLayout is not supported.
+    void
+    transitionMipLevels(const vk::CommandBuffer commandBuffer,
+                        const uint32_t baseMipLevel,
+                        const uint32_t mipLevelCount,
+                        const vk::ImageLayout destLayout);
+
+    vk::ImageAspectFlags
+    aspectFlags() const;
+
+    // Last use of a mip level, that is the source 
+    // of the next barrier of that level.
+    struct MipLevelState {
+        bool
+        operator==(const MipLevelState& other) const;
+
+        vk::ImageLayout mLayout = vk::ImageLayout::eUndefined;
+        vk::AccessFlags mAccesses;
+        vk::PipelineStageFlags mPipelineStages = vk::PipelineStageFlagBits::eTopOfPipe;
+    };
                 
     vk::Extent3D mExtent;
     vk::Format mFormat;
     uint32_t mMipLevelCount = 0;
-    vk::ImageLayout mSrcLayout;
-    vk::AccessFlags mSrcAccesses;
-    vk::PipelineStageFlags mSrcPipelineStages = vk::PipelineStageFlagBits::eTopOfPipe;
+    std::vector<MipLevelState> mMipLevelStates;
 
     vk::Image mImage;    
 
@@ -165,9 +243,9 @@ private:
     // with the constructor that includes the data needed
     // for DeviceMemory creation.
     // Otherwise, we will use the DeviceMemory provided
-    // by the second constructor.
+    // in bindDeviceMemory().
     const bool mHasDeviceMemoryOwnership = true;
-    vk::DeviceMemory mDeviceMemory;
+    DeviceMemoryAllocation mAllocation;
 };
 }
 
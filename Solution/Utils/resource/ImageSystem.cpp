@@ -21,30 +21,7 @@ ImageSystem::getOrLoadImage(const std::string& imageFilePath) {
         image = findIt->second;
         assert(image != nullptr);
     } else {
-        int textureWidth = 0;
-        int textureHeight = 0;
-        int textureChannels = 0;
-        stbi_uc* imageData = stbi_load(imageFilePath.c_str(),
-                                       &textureWidth,
-                                       &textureHeight,
-                                       &textureChannels,
-                                       STBI_rgb_alpha);
-
-        assert(imageData != nullptr);
-
-        const vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(textureWidth) * textureHeight * 4;
-
-        image = new Image(textureWidth,
-                          textureHeight,
-                          vk::Format::eR8G8B8A8Unorm,
-                          vk::ImageUsageFlagBits::eTransferSrc |
-                          vk::ImageUsageFlagBits::eTransferDst | 
-                          vk::ImageUsageFlagBits::eSampled,
-                          vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-        image->copyFromDataToDeviceMemory(imageData,
-                                          imageSize);
-
+        image = loadImage(imageFilePath);
         mImageByPath[imageFilePath] = image;
     }
 
@@ -53,6 +30,47 @@ ImageSystem::getOrLoadImage(const std::string& imageFilePath) {
     return *image;
 }
 
+TransferTicket
+ImageSystem::loadImages(const std::vector<std::string>& imageFilePaths) {
+    for (const std::string& imageFilePath : imageFilePaths) {
+        getOrLoadImage(imageFilePath);
+    }
+
+    return TransferEngine::flush();
+}
+
+Image*
+ImageSystem::loadImage(const std::string& imageFilePath) {
+    int textureWidth = 0;
+    int textureHeight = 0;
+    int textureChannels = 0;
+    stbi_uc* imageData = stbi_load(imageFilePath.c_str(),
+                                   &textureWidth,
+                                   &textureHeight,
+                                   &textureChannels,
+                                   STBI_rgb_alpha);
+
+    assert(imageData != nullptr);
+
+    const vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(textureWidth) * textureHeight * 4;
+
+    Image* image = new Image(textureWidth,
+                             textureHeight,
+                             vk::Format::eR8G8B8A8Unorm,
+                             vk::ImageUsageFlagBits::eTransferSrc |
+                             vk::ImageUsageFlagBits::eTransferDst | 
+                             vk::ImageUsageFlagBits::eSampled,
+                             vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    // The data is copied to the staging ring before the method returns,
+    // so it can be freed right away.
+    image->copyFromDataToDeviceMemory(imageData,
+                                      imageSize);
+    stbi_image_free(imageData);
+
+    return image;
+}
+
 void
 ImageSystem::eraseImage(const std::string& imageFilePath) {
     ImageByPath::const_iterator findIt = mImageByPath.find(imageFilePath);
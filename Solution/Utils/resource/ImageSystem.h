@@ -3,8 +3,11 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "../TransferEngine.h"
+
 namespace vulkan {
 class Image;
 
@@ -16,9 +19,18 @@ public:
     ImageSystem(const ImageSystem&) = delete;
     const ImageSystem& operator=(const ImageSystem&) = delete;
 
+    // The upload is recorded in the current TransferEngine batch,
+    // that must be flushed and waited before the image is used.
     static Image&
     getOrLoadImage(const std::string& imageFilePath);
 
+    // Loads the images that were not loaded yet, records all their uploads
+    // (layout transitions, copies and mip maps generation) in the current
+    // TransferEngine batch, and submits it once.
+    // Returns the ticket of the batch.
+    static TransferTicket
+    loadImages(const std::vector<std::string>& imageFilePaths);
+
     static void
     eraseImage(const std::string& imageFilePath);
 
@@ -26,6 +38,9 @@ public:
     clear();
 
 private:
+    static Image*
+    loadImage(const std::string& imageFilePath);
+
     using ImageByPath = std::unordered_map<std::string, Image*>;
     static ImageByPath mImageByPath;
 };
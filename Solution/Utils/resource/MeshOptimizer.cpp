@@ -0,0 +1,344 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <glm/glm.hpp>
+
+namespace {
+// FIFO cache of vertices, simulated with the time each vertex was added:
+// a vertex is in the cache while less than cacheSize vertices were added after it.
+class VertexCache {
+public:
+    VertexCache(const size_t vertexCount,
+                const uint32_t cacheSize)
+        : mCacheSize(cacheSize)
+        , mTimestamps(vertexCount, 0)
+        , mTimestamp(cacheSize + 1)
+    {
+    }
+
+    // Returns true if the vertex was not in the cache (it is added).
+    bool
+    access(const uint32_t vertex) {
+        if (mTimestamp - mTimestamps[vertex] > mCacheSize) {
+            mTimestamps[vertex] = mTimestamp++;
+            return true;
+        }
+
+        return false;
+    }
+
+    uint32_t
+    age(const uint32_t vertex) const {
+        return mTimestamp - mTimestamps[vertex];
+    }
+
+    void
+    flush() {
+        mTimestamp += mCacheSize + 1;
+    }
+
+private:
+    const uint32_t mCacheSize;
+    std::vector<uint32_t> mTimestamps;
+    uint32_t mTimestamp;
+};
+
+glm::vec3
+position(const float* positions,
+         const size_t positionStride,
+         const uint32_t vertex) {
+    const float* vertexPosition = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) +
+                                                                 vertex * positionStride);
+    return glm::vec3(vertexPosition[0], vertexPosition[1], vertexPosition[2]);
+}
+}
+
+namespace vulkan {
+const uint32_t MeshOptimizer::sDefaultCacheSize;
+const uint32_t MeshOptimizer::sUnusedVertex;
+
+VertexCacheStatistics
+MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices,
+                                  const size_t vertexCount,
+                                  const uint32_t cacheSize) {
+    assert(indices.size() % 3 == 0);
+
+    VertexCacheStatistics statistics;
+    if (indices.empty() || vertexCount == 0) {
+        return statistics;
+    }
+
+    VertexCache cache(vertexCount,
+                      cacheSize);
+    size_t transformedVertexCount = 0;
+    for (const uint32_t index : indices) {
+        assert(index < vertexCount);
+        if (cache.access(index)) {
+            ++transformedVertexCount;
+        }
+    }
+
+    statistics.mAcmr = static_cast<float>(transformedVertexCount) / (indices.size() / 3);
+    statistics.mAtvr = static_cast<float>(transformedVertexCount) / vertexCount;
+    return statistics;
+}
+
+void
+MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices,
+                                   const size_t vertexCount,
+                                   const uint32_t cacheSize) {
+    assert(indices.size() % 3 == 0);
+
+    if (indices.empty()) {
+        return;
+    }
+
+    // Triangles of each vertex: vertexTriangles[triangleOffsets[v], triangleOffsets[v + 1]).
+    std::vector<uint32_t> liveTriangleCounts(vertexCount, 0);
+    for (const uint32_t index : indices) {
+        assert(index < vertexCount);
+        ++liveTriangleCounts[index];
+    }
+
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        triangleOffsets[vertex + 1] = triangleOffsets[vertex] + liveTriangleCounts[vertex];
+    }
+
+    std::vector<uint32_t> vertexTriangles(indices.size());
+    {
+        std::vector<uint32_t> nextTriangleOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            vertexTriangles[nextTriangleOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    // Tipsify: the triangles around a vertex (its fan) are emitted, and the next
+    // fanning vertex is the vertex of those triangles that is the oldest in the cache
+    // but will still be in it after emitting its fan.
+    // If there is none, it is the last emitted vertex that has triangles left,
+    // or the next vertex that has triangles left.
+    std::vector<uint32_t> optimizedIndices;
+    optimizedIndices.reserve(indices.size());
+    std::vector<bool> isTriangleEmitted(indices.size() / 3, false);
+    std::vector<uint32_t> deadEndVertices;
+    deadEndVertices.reserve(indices.size());
+    std::vector<uint32_t> candidateVertices;
+    VertexCache cache(vertexCount,
+                      cacheSize);
+    uint32_t nextVertex = 0;
+    uint32_t fanningVertex = indices[0];
+    while (fanningVertex != sUnusedVertex) {
+        candidateVertices.clear();
+        for (uint32_t i = triangleOffsets[fanningVertex]; i < triangleOffsets[fanningVertex + 1]; ++i) {
+            const uint32_t triangle = vertexTriangles[i];
+            if (isTriangleEmitted[triangle]) {
+                continue;
+            }
+
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                const uint32_t vertex = indices[3 * triangle + corner];
+                optimizedIndices.push_back(vertex);
+                deadEndVertices.push_back(vertex);
+                candidateVertices.push_back(vertex);
+                --liveTriangleCounts[vertex];
+                cache.access(vertex);
+            }
+            isTriangleEmitted[triangle] = true;
+        }
+
+        fanningVertex = sUnusedVertex;
+        int64_t bestPriority = -1;
+        for (const uint32_t vertex : candidateVertices) {
+            if (liveTriangleCounts[vertex] == 0) {
+                continue;
+            }
+
+            // A fan adds 2 vertices per triangle to the cache at most.
+            int64_t priority = 0;
+            if (cache.age(vertex) + 2 * liveTriangleCounts[vertex] <= cacheSize) {
+                priority = cache.age(vertex);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+
+        while (fanningVertex == sUnusedVertex && deadEndVertices.empty() == false) {
+            const uint32_t vertex = deadEndVertices.back();
+            deadEndVertices.pop_back();
+            if (liveTriangleCounts[vertex] > 0) {
+                fanningVertex = vertex;
+            }
+        }
+
+        while (fanningVertex == sUnusedVertex && nextVertex < vertexCount) {
+            if (liveTriangleCounts[nextVertex] > 0) {
+                fanningVertex = nextVertex;
+            }
+            ++nextVertex;
+        }
+    }
+
+    assert(optimizedIndices.size() == indices.size());
+    indices.swap(optimizedIndices);
+}
+
+void
+MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices,
+                                const float* positions,
+                                const size_t positionStride,
+                                const size_t vertexCount,
+                                const float threshold,
+                                const uint32_t cacheSize) {
+    assert(indices.size() % 3 == 0);
+    assert(positions != nullptr);
+
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Hard boundaries: the triangles whose vertices miss the cache
+    // (the clusters can be reordered without losing cache efficiency).
+    std::vector<size_t> hardClusterOffsets;
+    {
+        VertexCache cache(vertexCount,
+                          cacheSize);
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+            uint32_t misses = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                misses += cache.access(indices[3 * triangle + corner]) ? 1 : 0;
+            }
+
+            if (triangle == 0 || misses == 3) {
+                hardClusterOffsets.push_back(triangle);
+            }
+        }
+        hardClusterOffsets.push_back(triangleCount);
+    }
+
+    // Soft boundaries: each hard cluster is split where the ACMR of the split part
+    // (starting with a flushed cache) is not much worse than the ACMR of the hard cluster.
+    std::vector<size_t> clusterOffsets;
+    {
+        VertexCache cache(vertexCount,
+                          cacheSize);
+        for (size_t i = 0; i + 1 < hardClusterOffsets.size(); ++i) {
+            const size_t begin = hardClusterOffsets[i];
+            const size_t end = hardClusterOffsets[i + 1];
+
+            cache.flush();
+            size_t hardClusterMisses = 0;
+            for (size_t index = 3 * begin; index < 3 * end; ++index) {
+                hardClusterMisses += cache.access(indices[index]) ? 1 : 0;
+            }
+            const float hardClusterAcmr = static_cast<float>(hardClusterMisses) / (end - begin);
+
+            cache.flush();
+            clusterOffsets.push_back(begin);
+            size_t clusterBegin = begin;
+            size_t clusterMisses = 0;
+            for (size_t triangle = begin; triangle < end; ++triangle) {
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    clusterMisses += cache.access(indices[3 * triangle + corner]) ? 1 : 0;
+                }
+
+                const float clusterAcmr = static_cast<float>(clusterMisses) / (triangle + 1 - clusterBegin);
+                if (triangle + 1 < end && clusterAcmr <= threshold * hardClusterAcmr) {
+                    cache.flush();
+                    clusterBegin = triangle + 1;
+                    clusterMisses = 0;
+                    clusterOffsets.push_back(clusterBegin);
+                }
+            }
+        }
+        clusterOffsets.push_back(triangleCount);
+    }
+
+    // Centroid and normal of each cluster (weighted by the area of its triangles),
+    // and centroid of the mesh.
+    const size_t clusterCount = clusterOffsets.size() - 1;
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        float clusterArea = 0.0f;
+        for (size_t triangle = clusterOffsets[cluster]; triangle < clusterOffsets[cluster + 1]; ++triangle) {
+            const glm::vec3 position0 = position(positions, positionStride, indices[3 * triangle]);
+            const glm::vec3 position1 = position(positions, positionStride, indices[3 * triangle + 1]);
+            const glm::vec3 position2 = position(positions, positionStride, indices[3 * triangle + 2]);
+
+            // Its length is twice the area of the triangle.
+            const glm::vec3 normal = glm::cross(position1 - position0,
+                                                position2 - position0);
+            const float area = glm::length(normal);
+
+            clusterCentroids[cluster] += (position0 + position1 + position2) * (area / 3.0f);
+            clusterNormals[cluster] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f) {
+            clusterCentroids[cluster] /= clusterArea;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // The clusters that face away from the centroid of the mesh (the most visible
+    // ones from outside) are drawn first.
+    std::vector<float> clusterSortKeys(clusterCount, 0.0f);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        const float normalLength = glm::length(clusterNormals[cluster]);
+        if (normalLength > 0.0f) {
+            clusterSortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid,
+                                                clusterNormals[cluster] / normalLength);
+        }
+    }
+
+    std::vector<size_t> sortedClusters(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        sortedClusters[cluster] = cluster;
+    }
+    std::stable_sort(sortedClusters.begin(),
+                     sortedClusters.end(),
+                     [&clusterSortKeys](const size_t cluster0, const size_t cluster1) {
+                         return clusterSortKeys[cluster0] > clusterSortKeys[cluster1];
+                     });
+
+    std::vector<uint32_t> sortedIndices;
+    sortedIndices.reserve(indices.size());
+    for (const size_t cluster : sortedClusters) {
+        sortedIndices.insert(sortedIndices.end(),
+                             indices.begin() + 3 * clusterOffsets[cluster],
+                             indices.begin() + 3 * clusterOffsets[cluster + 1]);
+    }
+
+    indices.swap(sortedIndices);
+}
+
+size_t
+MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices,
+                                   const size_t vertexCount,
+                                   std::vector<uint32_t>& remap) {
+    remap.assign(vertexCount, sUnusedVertex);
+
+    uint32_t usedVertexCount = 0;
+    for (uint32_t& index : indices) {
+        assert(index < vertexCount);
+        if (remap[index] == sUnusedVertex) {
+            remap[index] = usedVertexCount++;
+        }
+        index = remap[index];
+    }
+
+    return usedVertexCount;
+}
+}
@@ -0,0 +1,90 @@
+#ifndef UTILS_RESOURCE_MESH_OPTIMIZER
+#define UTILS_RESOURCE_MESH_OPTIMIZER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vulkan {
+// Efficiency of the post-transform vertex cache for a list of triangles.
+struct VertexCacheStatistics {
+    // Average cache miss ratio: transformed vertices per triangle.
+    // It is 3 at worst, and close to 0.5 for large regular meshes.
+    float mAcmr = 0.0f;
+    // Average transformed vertex ratio: transformed vertices per vertex.
+    // It is 1 at best.
+    float mAtvr = 0.0f;
+};
+
+struct MeshOptimizationStatistics {
+    VertexCacheStatistics mBefore;
+    VertexCacheStatistics mAfter;
+};
+
+//
+// Reorders the triangles and the vertices of indexed triangle lists for the GPU
+// (Read Model::optimize()).
+//
+// - optimizeVertexCache(): triangles are reordered with Tipsify
+//   (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality
+//   and Reduced Overdraw"), so the vertices of the next triangles are still in
+//   the post-transform vertex cache, and fewer vertices are shaded more than once.
+//
+// - optimizeOverdraw(): the reordered triangles are split in clusters where
+//   the cache efficiency allows it, and the clusters that face away from the center
+//   of the mesh are drawn first, so they hide the ones behind them
+//   and fewer fragments are shaded more than once.
+//
+// - optimizeVertexFetch(): vertices are reordered by first use, so
+//   the vertex fetches are close to each other in memory.
+//
+// The cache is simulated as a FIFO of cacheSize vertices.
+//
+class MeshOptimizer {
+public:
+    static const uint32_t sDefaultCacheSize = 16;
+    static const uint32_t sUnusedVertex = UINT32_MAX;
+
+    static VertexCacheStatistics
+    analyzeVertexCache(const std::vector<uint32_t>& indices,
+                       const size_t vertexCount,
+                       const uint32_t cacheSize = sDefaultCacheSize);
+
+    static void
+    optimizeVertexCache(std::vector<uint32_t>& indices,
+                        const size_t vertexCount,
+                        const uint32_t cacheSize = sDefaultCacheSize);
+
+    // * indices should be optimized for the vertex cache first.
+    //
+    // * positions of the vertices (3 floats each), positionStride bytes apart.
+    //
+    // * threshold: maximum ACMR increase (1.05 is 5%) to split the triangles
+    //   in more clusters, that can be sorted to reduce overdraw.
+    static void
+    optimizeOverdraw(std::vector<uint32_t>& indices,
+                     const float* positions,
+                     const size_t positionStride,
+                     const size_t vertexCount,
+                     const float threshold = 1.05f,
+                     const uint32_t cacheSize = sDefaultCacheSize);
+
+    // Remaps indices, so vertices are numbered by first use.
+    // Returns the number of used vertices.
+    //
+    // * remap: new index of each vertex, or sUnusedVertex if no index uses it.
+    static size_t
+    optimizeVertexFetch(std::vector<uint32_t>& indices,
+                        const size_t vertexCount,
+                        std::vector<uint32_t>& remap);
+
+private:
+    MeshOptimizer() = delete;
+    ~MeshOptimizer() = delete;
+    MeshOptimizer(MeshOptimizer&&) noexcept = delete;
+    MeshOptimizer(const MeshOptimizer&) = delete;
+    const MeshOptimizer& operator=(const MeshOptimizer&) = delete;
+};
+}
+
+#endif
@@ -1,37 +1,79 @@
 #ifndef UTILS_RESOURCE_MODEL
 #define UTILS_RESOURCE_MODEL
 
+#include <glm/glm.hpp>
+#include <memory>
 #include <vector>
 
 #include "Buffer.h"
+#include "MeshOptimizer.h"
 
 namespace vulkan {
+class MappedFile;
+
 template<typename T>
 struct Model {
 
 // The client must free the returned Buffer.
+// The data is copied straight from the vertices and indices
+// (mapped or not) to the staging memory.
 Buffer* 
 createVertexBuffer() const;
 Buffer*
 createIndexBuffer() const;
 
+// The vertices and indices of the model, that are mapped
+// if mMappedFile is not nullptr, or in mVertices and mIndices otherwise.
+const T*
+vertexData() const;
+size_t
+vertexCount() const;
+const uint32_t*
+indexData() const;
+size_t
+indexCount() const;
+
+// Reorders the triangles for the post-transform vertex cache and to reduce overdraw,
+// and then the vertices by first use (Read MeshOptimizer).
+// Unused vertices are removed.
+// Returns the vertex cache statistics before and after.
+//
+// Preconditions:
+// - The model is not mapped (mMappedFile == nullptr).
+// - T has a glm::vec3 mPosition.
+MeshOptimizationStatistics
+optimize();
+
 std::vector<T> mVertices;
 std::vector<uint32_t> mIndices;
+
+// Axis aligned bounds of the vertex positions.
+glm::vec3 mBoundsMin = {0.0f, 0.0f, 0.0f};
+glm::vec3 mBoundsMax = {0.0f, 0.0f, 0.0f};
+
+// Binary cache of the model (Read ModelSystem), that is
+// unmapped when the last copy of the model is destroyed.
+// mVertices and mIndices are empty if it is not nullptr.
+std::shared_ptr<const MappedFile> mMappedFile;
+const T* mMappedVertices = nullptr;
+size_t mMappedVertexCount = 0;
+const uint32_t* mMappedIndices = nullptr;
+size_t mMappedIndexCount = 0;
 };
 
 template<typename T>
 Buffer*
 Model<T>::createVertexBuffer() const {
-    assert(mVertices.empty() == false);
+    assert(vertexCount() > 0);
 
-    const size_t verticesSize = sizeof(T) * mVertices.size();
+    const size_t verticesSize = sizeof(T) * vertexCount();
 
     Buffer* buffer = new Buffer(verticesSize,
                                 vk::BufferUsageFlagBits::eTransferDst |
                                 vk::BufferUsageFlagBits::eVertexBuffer,
                                 vk::MemoryPropertyFlagBits::eDeviceLocal);
 
-    buffer->copyFromDataToDeviceMemory(mVertices.data(),
+    buffer->copyFromDataToDeviceMemory(vertexData(),
                                        verticesSize);
 
     return buffer;
@@ -40,21 +82,81 @@ Model<T>::createVertexBuffer() const {
 template<typename T>
 Buffer*
 Model<T>::createIndexBuffer() const {
-    assert(mIndices.empty() == false);
+    assert(indexCount() > 0);
 
-    const size_t indicesSize = sizeof(uint32_t) * mIndices.size();
+    const size_t indicesSize = sizeof(uint32_t) * indexCount();
 
     Buffer* buffer = new Buffer(indicesSize,
                                 vk::BufferUsageFlagBits::eTransferDst |
                                 vk::BufferUsageFlagBits::eIndexBuffer,
                                 vk::MemoryPropertyFlagBits::eDeviceLocal);
 
-    buffer->copyFromDataToDeviceMemory(mIndices.data(),
+    buffer->copyFromDataToDeviceMemory(indexData(),
                                        indicesSize);
 
     return buffer;
 }
 
+template<typename T>
+MeshOptimizationStatistics
+Model<T>::optimize() {
+    assert(mMappedFile == nullptr);
+
+    MeshOptimizationStatistics statistics;
+    statistics.mBefore = MeshOptimizer::analyzeVertexCache(mIndices,
+                                                           mVertices.size());
+    if (mVertices.empty() || mIndices.empty()) {
+        statistics.mAfter = statistics.mBefore;
+        return statistics;
+    }
+
+    MeshOptimizer::optimizeVertexCache(mIndices,
+                                       mVertices.size());
+    MeshOptimizer::optimizeOverdraw(mIndices,
+                                    &mVertices[0].mPosition.x,
+                                    sizeof(T),
+                                    mVertices.size());
+
+    std::vector<uint32_t> remap;
+    std::vector<T> vertices(MeshOptimizer::optimizeVertexFetch(mIndices,
+                                                               mVertices.size(),
+                                                               remap));
+    for (size_t i = 0; i < mVertices.size(); ++i) {
+        if (remap[i] != MeshOptimizer::sUnusedVertex) {
+            vertices[remap[i]] = mVertices[i];
+        }
+    }
+    mVertices.swap(vertices);
+
+    statistics.mAfter = MeshOptimizer::analyzeVertexCache(mIndices,
+                                                          mVertices.size());
+    return statistics;
+}
+
+template<typename T>
+const T*
+Model<T>::vertexData() const {
+    return mMappedFile != nullptr ? mMappedVertices : mVertices.data();
+}
+
+template<typename T>
+size_t
+Model<T>::vertexCount() const {
+    return mMappedFile != nullptr ? mMappedVertexCount : mVertices.size();
+}
+
+template<typename T>
+const uint32_t*
+Model<T>::indexData() const {
+    return mMappedFile != nullptr ? mMappedIndices : mIndices.data();
+}
+
+template<typename T>
+size_t
+Model<T>::indexCount() const {
+    return mMappedFile != nullptr ? mMappedIndexCount : mIndices.size();
+}
+
 }
 
 #endif
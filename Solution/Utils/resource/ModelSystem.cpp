@@ -1,21 +1,269 @@
 #include "ModelSystem.h"
 
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#define TINYOBJ_LOADER_OPT_IMPLEMENTATION
+#include <experimental/tinyobj_loader_opt.h>
+
+#include "VertexWelder.h"
+#include "../FileSystem.h"
+#include "../MappedFile.h"
+
+namespace {
+const uint32_t sModelCacheMagic = 0x434D4B56; // "VKMC"
+// Version 2: the models are optimized (Read Model::optimize()).
+const uint32_t sModelCacheVersion = 2;
+// Alignment of the vertices and indices (a cache line).
+const uint64_t sModelCacheAlignment = 64;
+
+struct ModelCacheHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mVertexSize;
+    uint32_t mReserved;
+    uint64_t mSourceSize;
+    int64_t mSourceModificationTime;
+    uint64_t mSourceHash;
+    uint64_t mVertexCount;
+    uint64_t mVertexOffset;
+    uint64_t mIndexCount;
+    uint64_t mIndexOffset;
+    float mBoundsMin[3];
+    float mBoundsMax[3];
+};
+static_assert(sizeof(ModelCacheHeader) == 96, "ModelCacheHeader must not have padding");
+
+// Each vertex type has its own cache file.
+template<typename T>
+const char*
+modelCacheFileExtension();
+
+template<>
+const char*
+modelCacheFileExtension<vulkan::PosTexCoordVertex>() {
+    return ".meshcache";
+}
+
+template<>
+const char*
+modelCacheFileExtension<vulkan::QuantizedPosTexCoordVertex>() {
+    return ".quantized.meshcache";
+}
+
+template<typename T>
+std::string
+modelCacheFilePath(const std::string& modelFilePath) {
+    return modelFilePath + modelCacheFileExtension<T>();
+}
+
+uint64_t
+alignToModelCache(const uint64_t offset) {
+    return (offset + sModelCacheAlignment - 1) & ~(sModelCacheAlignment - 1);
+}
+
+// FNV-1a hash of the whole file, or 0 if it cannot be mapped.
+uint64_t
+hashFile(const std::string& filePath) {
+    const vulkan::MappedFile file(filePath);
+    if (file.isMapped() == false) {
+        return 0;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < file.size(); ++i) {
+        hash ^= file.data()[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Reads the header of a mapped model cache, and returns false if the cache
+// is not valid for the source file: wrong header, offsets or counts out of
+// the file, or indices of vertices that do not exist (a corrupted cache
+// must not make the device read vertices out of the vertex buffer).
+template<typename T>
+bool
+readModelCacheHeader(const vulkan::MappedFile& file,
+                     const uint64_t sourceSize,
+                     ModelCacheHeader& header) {
+    if (file.isMapped() == false || file.size() < sizeof(ModelCacheHeader)) {
+        return false;
+    }
+
+    std::memcpy(&header,
+                file.data(),
+                sizeof(ModelCacheHeader));
+    if (header.mMagic != sModelCacheMagic ||
+        header.mVersion != sModelCacheVersion ||
+        header.mVertexSize != sizeof(T) ||
+        header.mSourceSize != sourceSize) {
+        return false;
+    }
+
+    // The divisions avoid overflows with corrupted counts.
+    const uint64_t fileSize = file.size();
+    if (header.mVertexOffset % sModelCacheAlignment != 0 ||
+        header.mIndexOffset % sModelCacheAlignment != 0 ||
+        header.mVertexOffset > fileSize ||
+        header.mIndexOffset > fileSize ||
+        header.mVertexCount > (fileSize - header.mVertexOffset) / sizeof(T) ||
+        header.mIndexCount > (fileSize - header.mIndexOffset) / sizeof(uint32_t)) {
+        return false;
+    }
+
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(file.data() + header.mIndexOffset);
+    for (uint64_t i = 0; i < header.mIndexCount; ++i) {
+        if (indices[i] >= header.mVertexCount) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+void
+computeBounds(vulkan::Model<T>& model) {
+    const T* vertices = model.vertexData();
+    const size_t vertexCount = model.vertexCount();
+    if (vertexCount == 0) {
+        return;
+    }
+
+    model.mBoundsMin = vertices[0].mPosition;
+    model.mBoundsMax = vertices[0].mPosition;
+    for (size_t i = 1; i < vertexCount; ++i) {
+        model.mBoundsMin = glm::min(model.mBoundsMin, vertices[i].mPosition);
+        model.mBoundsMax = glm::max(model.mBoundsMax, vertices[i].mPosition);
+    }
+}
+
+// Adds a vertex per index (including the repeated ones)
+// of a model loaded by tinyobj or tinyobj_opt.
+template<typename Attrib, typename Indices>
+void
+addUnweldedVertices(const Attrib& attrib,
+                    const Indices& indices,
+                    const bool flipTexCoordV,
+                    std::vector<vulkan::PosTexCoordVertex>& unweldedVertices) {
+    unweldedVertices.reserve(unweldedVertices.size() + indices.size());
+
+    for (const auto& index : indices) {
+        vulkan::PosTexCoordVertex vertex;
+
+        const size_t basePosIndex = 3 * static_cast<size_t>(index.vertex_index);
+        vertex.mPosition.x = attrib.vertices[basePosIndex];
+        vertex.mPosition.y = attrib.vertices[basePosIndex + 1];
+        vertex.mPosition.z = attrib.vertices[basePosIndex + 2];
+
+        // Faces without texture coordinates have a negative index.
+        if (index.texcoord_index >= 0) {
+            const size_t baseTexCoordIndex = 2 * static_cast<size_t>(index.texcoord_index);
+            vertex.mTexCoord.x = attrib.texcoords[baseTexCoordIndex];
+            vertex.mTexCoord.y = flipTexCoordV ?
+                1.0f - attrib.texcoords[baseTexCoordIndex + 1] :
+                attrib.texcoords[baseTexCoordIndex + 1];
+        }
+
+        unweldedVertices.push_back(vertex);
+    }
+}
+}
+
 namespace vulkan {
 ModelSystem::ModelWithPosTexCoordVertexByPath
 ModelSystem::mModelWithPosTexCoordVertexByPath = {};
 
-const Model<PosTexCoordVertex>&
-ModelSystem::getOrLoadModelWithPosTexCoordVertex(const std::string& modelFilepath) {
-    Model<PosTexCoordVertex> model;
+ModelSystem::ModelWithQuantizedPosTexCoordVertexByPath
+ModelSystem::mModelWithQuantizedPosTexCoordVertexByPath = {};
 
+const Model<PosTexCoordVertex>&
+ModelSystem::getOrLoadModelWithPosTexCoordVertex(const std::string& modelFilepath,
+                                                 const uint32_t parserThreadCount) {
     ModelWithPosTexCoordVertexByPath::const_iterator findIt =
         mModelWithPosTexCoordVertexByPath.find(modelFilepath);
     if (findIt != mModelWithPosTexCoordVertexByPath.end()) {
         return findIt->second;
     } else {
+        Model<PosTexCoordVertex> model;
+        loadOptimizedModelWithPosTexCoordVertex(modelFilepath,
+                                                parserThreadCount,
+                                                model);
+
+        Model<PosTexCoordVertex>& containerModel = mModelWithPosTexCoordVertexByPath[modelFilepath];
+        containerModel = std::move(model);
+
+        return containerModel;
+    }
+}
+
+const Model<QuantizedPosTexCoordVertex>&
+ModelSystem::getOrLoadModelWithQuantizedPosTexCoordVertex(const std::string& modelFilePath,
+                                                          const uint32_t parserThreadCount) {
+    ModelWithQuantizedPosTexCoordVertexByPath::const_iterator findIt =
+        mModelWithQuantizedPosTexCoordVertexByPath.find(modelFilePath);
+    if (findIt != mModelWithQuantizedPosTexCoordVertexByPath.end()) {
+        return findIt->second;
+    }
+
+    Model<QuantizedPosTexCoordVertex> quantizedModel;
+    if (loadModelCache(modelFilePath, quantizedModel) == false) {
+        // The model with float vertices is only needed to quantize it, so it is not
+        // kept in the system (and its cache is unmapped), unless it was already there.
+        Model<PosTexCoordVertex> loadedModel;
+        ModelWithPosTexCoordVertexByPath::const_iterator modelIt =
+            mModelWithPosTexCoordVertexByPath.find(modelFilePath);
+        if (modelIt == mModelWithPosTexCoordVertexByPath.end()) {
+            loadOptimizedModelWithPosTexCoordVertex(modelFilePath,
+                                                    parserThreadCount,
+                                                    loadedModel);
+        }
+        const Model<PosTexCoordVertex>& model =
+            modelIt != mModelWithPosTexCoordVertexByPath.end() ? modelIt->second : loadedModel;
+
+        quantizedModel.mVertices.reserve(model.vertexCount());
+        for (size_t i = 0; i < model.vertexCount(); ++i) {
+            quantizedModel.mVertices.push_back(QuantizedPosTexCoordVertex::quantize(model.vertexData()[i],
+                                                                                    model.mBoundsMin,
+                                                                                    model.mBoundsMax));
+        }
+        quantizedModel.mIndices.assign(model.indexData(),
+                                       model.indexData() + model.indexCount());
+        quantizedModel.mBoundsMin = model.mBoundsMin;
+        quantizedModel.mBoundsMax = model.mBoundsMax;
+
+        writeModelCache(modelFilePath,
+                        quantizedModel);
+    }
+
+    Model<QuantizedPosTexCoordVertex>& containerModel = mModelWithQuantizedPosTexCoordVertexByPath[modelFilePath];
+    containerModel = std::move(quantizedModel);
+
+    return containerModel;
+}
+
+void
+ModelSystem::loadModelWithPosTexCoordVertex(const std::string& modelFilepath,
+                                            const uint32_t parserThreadCount,
+                                            Model<PosTexCoordVertex>& model) {
+    model = Model<PosTexCoordVertex>();
+
+    // The OBJ format assumes a coordinate system where a vertical coordinate of 0 means
+    // the bottom of the image, however weve uploaded our image into Vulkan in a
+    // top to bottom orientation where 0 means the top of the image.Solve this by
+    // flipping the vertical component of the texture coordinates
+    const bool flipTexCoordV = modelFilepath.substr(modelFilepath.find_last_of(".") + 1) == "obj";
+
+    std::vector<PosTexCoordVertex> unweldedVertices;
+
+    if (parserThreadCount == 1) {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -31,49 +279,182 @@ ModelSystem::getOrLoadModelWithPosTexCoordVertex(const std::string& modelFilepat
             throw std::runtime_error(warnings + errors);
         }
 
-        const bool objFile = modelFilepath.substr(modelFilepath.find_last_of(".") + 1) == "obj";
+        for (const tinyobj::shape_t& shape : shapes) {
+            addUnweldedVertices(attrib,
+                                shape.mesh.indices,
+                                flipTexCoordV,
+                                unweldedVertices);
+        }
+    } else {
+        // The file is parsed in place: it is neither read
+        // nor copied into a string.
+        const MappedFile file(modelFilepath);
+        if (file.isMapped() == false) {
+            throw std::runtime_error("Failed to map model file " + modelFilepath);
+        }
 
-        std::unordered_map<PosTexCoordVertex, uint32_t> uniqueVertices;
+        tinyobj_opt::LoadOption option;
+        // -1 means a thread per hardware thread.
+        option.req_num_threads = parserThreadCount == 0 ? -1 : static_cast<int>(parserThreadCount);
+        option.triangulate = true;
 
-        for (const tinyobj::shape_t& shape : shapes) {
-            for (const tinyobj::index_t index : shape.mesh.indices) {
-                PosTexCoordVertex vertex;
-
-                const size_t basePosIndex = 3 * index.vertex_index;
-                vertex.mPosition.x = attrib.vertices[basePosIndex];
-                vertex.mPosition.y = attrib.vertices[basePosIndex + 1];
-                vertex.mPosition.z = attrib.vertices[basePosIndex + 2];
-
-                const size_t baseTexCoordIndex = 2 * index.texcoord_index;
-                vertex.mTexCoord.x = attrib.texcoords[baseTexCoordIndex];
-
-                // The OBJ format assumes a coordinate system where a vertical coordinate of 0 means
-                // the bottom of the image, however weve uploaded our image into Vulkan in a
-                // top to bottom orientation where 0 means the top of the image.Solve this by
-                // flipping the vertical component of the texture coordinates
-                if (objFile) {
-                    vertex.mTexCoord.y = 1.0f - attrib.texcoords[baseTexCoordIndex + 1];
-                } else {
-                    vertex.mTexCoord.y = attrib.texcoords[baseTexCoordIndex + 1];
-                }                
-
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(model.mVertices.size());
-                    model.mVertices.push_back(vertex);
-                }
-                model.mIndices.push_back(uniqueVertices[vertex]); 
-            }
+        tinyobj_opt::attrib_t attrib;
+        std::vector<tinyobj_opt::shape_t> shapes;
+        std::vector<tinyobj_opt::material_t> materials;
+        if (tinyobj_opt::parseObj(&attrib,
+                                  &shapes,
+                                  &materials,
+                                  reinterpret_cast<const char*>(file.data()),
+                                  file.size(),
+                                  option) == false) {
+            throw std::runtime_error("Failed to parse model file " + modelFilepath);
         }
 
-        Model<PosTexCoordVertex>& containerModel = mModelWithPosTexCoordVertexByPath[modelFilepath];
-        containerModel = model;
+        // The indices of the shapes are consecutive and
+        // in the same order than in the file.
+        addUnweldedVertices(attrib,
+                            attrib.indices,
+                            flipTexCoordV,
+                            unweldedVertices);
+    }
 
-        return containerModel;
+    // The repeated vertices are removed with the same thread count.
+    VertexWelder<PosTexCoordVertex>::weldVertices(unweldedVertices,
+                                                  parserThreadCount,
+                                                  model.mVertices,
+                                                  model.mIndices);
+
+    computeBounds(model);
+}
+
+void
+ModelSystem::loadOptimizedModelWithPosTexCoordVertex(const std::string& modelFilePath,
+                                                     const uint32_t parserThreadCount,
+                                                     Model<PosTexCoordVertex>& model) {
+    if (loadModelCache(modelFilePath, model)) {
+        return;
     }
+
+    loadModelWithPosTexCoordVertex(modelFilePath,
+                                   parserThreadCount,
+                                   model);
+
+    // The cache stores the optimized model, so it is optimized once.
+    const MeshOptimizationStatistics statistics = model.optimize();
+    std::cout << "Model " << modelFilePath << " optimized: ACMR " << statistics.mBefore.mAcmr <<
+        " -> " << statistics.mAfter.mAcmr << ", ATVR " << statistics.mBefore.mAtvr <<
+        " -> " << statistics.mAfter.mAtvr << std::endl;
+
+    writeModelCache(modelFilePath,
+                    model);
+}
+
+template<typename T>
+bool
+ModelSystem::loadModelCache(const std::string& modelFilePath,
+                            Model<T>& model) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "The vertices are copied to and from the cache as bytes");
+
+    uint64_t sourceSize;
+    int64_t sourceModificationTime;
+    if (file_system::readFileStatus(modelFilePath, sourceSize, sourceModificationTime) == false) {
+        return false;
+    }
+
+    const std::string cacheFilePath = modelCacheFilePath<T>(modelFilePath);
+    std::shared_ptr<const MappedFile> file(new MappedFile(cacheFilePath));
+    ModelCacheHeader header;
+    if (readModelCacheHeader<T>(*file, sourceSize, header) == false) {
+        return false;
+    }
+
+    if (header.mSourceModificationTime != sourceModificationTime) {
+        if (header.mSourceHash != hashFile(modelFilePath)) {
+            return false;
+        }
+
+        // The source was touched (copied or checked out again) but its content
+        // did not change, so only the modification time of the header is refreshed.
+        // Otherwise, every load would hash the whole source again.
+        // The cache is written again atomically, and it must be unmapped first
+        // (a mapped file cannot be replaced on Windows).
+        header.mSourceModificationTime = sourceModificationTime;
+        std::vector<uint8_t> data(file->data(),
+                                  file->data() + file->size());
+        std::memcpy(data.data(),
+                    &header,
+                    sizeof(ModelCacheHeader));
+        file.reset();
+        file_system::writeFileAtomically(cacheFilePath,
+                                         data.data(),
+                                         data.size());
+
+        // If the write failed, then the previous cache is still valid.
+        file.reset(new MappedFile(cacheFilePath));
+        if (readModelCacheHeader<T>(*file, sourceSize, header) == false) {
+            return false;
+        }
+    }
+
+    // The mapping is page aligned, so the vertices and indices are aligned too.
+    model = Model<T>();
+    model.mMappedVertices = reinterpret_cast<const T*>(file->data() + header.mVertexOffset);
+    model.mMappedVertexCount = static_cast<size_t>(header.mVertexCount);
+    model.mMappedIndices = reinterpret_cast<const uint32_t*>(file->data() + header.mIndexOffset);
+    model.mMappedIndexCount = static_cast<size_t>(header.mIndexCount);
+    model.mBoundsMin = glm::vec3(header.mBoundsMin[0], header.mBoundsMin[1], header.mBoundsMin[2]);
+    model.mBoundsMax = glm::vec3(header.mBoundsMax[0], header.mBoundsMax[1], header.mBoundsMax[2]);
+    model.mMappedFile = std::move(file);
+
+    return true;
+}
+
+template<typename T>
+void
+ModelSystem::writeModelCache(const std::string& modelFilePath,
+                             const Model<T>& model) {
+    ModelCacheHeader header = {};
+    if (file_system::readFileStatus(modelFilePath, header.mSourceSize, header.mSourceModificationTime) == false) {
+        return;
+    }
+
+    header.mMagic = sModelCacheMagic;
+    header.mVersion = sModelCacheVersion;
+    header.mVertexSize = sizeof(T);
+    header.mSourceHash = hashFile(modelFilePath);
+    header.mVertexCount = model.vertexCount();
+    header.mVertexOffset = alignToModelCache(sizeof(ModelCacheHeader));
+    header.mIndexCount = model.indexCount();
+    header.mIndexOffset = alignToModelCache(header.mVertexOffset + header.mVertexCount * sizeof(T));
+    for (glm::length_t i = 0; i < 3; ++i) {
+        header.mBoundsMin[i] = model.mBoundsMin[i];
+        header.mBoundsMax[i] = model.mBoundsMax[i];
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.mIndexOffset + header.mIndexCount * sizeof(uint32_t)));
+    std::memcpy(data.data(),
+                &header,
+                sizeof(ModelCacheHeader));
+    if (header.mVertexCount > 0) {
+        std::memcpy(data.data() + header.mVertexOffset,
+                    model.vertexData(),
+                    static_cast<size_t>(header.mVertexCount * sizeof(T)));
+    }
+    if (header.mIndexCount > 0) {
+        std::memcpy(data.data() + header.mIndexOffset,
+                    model.indexData(),
+                    static_cast<size_t>(header.mIndexCount * sizeof(uint32_t)));
+    }
+
+    file_system::writeFileAtomically(modelCacheFilePath<T>(modelFilePath),
+                                     data.data(),
+                                     data.size());
 }
 
 void
 ModelSystem::clear() {
     mModelWithPosTexCoordVertexByPath.clear();
+    mModelWithQuantizedPosTexCoordVertexByPath.clear();
 }
 }
\ No newline at end of file
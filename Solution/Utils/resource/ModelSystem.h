@@ -7,9 +7,33 @@
 
 #include "Model.h"
 #include "../vertex/PosTexCoordVertex.h"
+#include "../vertex/QuantizedPosTexCoordVertex.h"
 
 namespace vulkan {
-
+//
+// Global cache of models, loaded from OBJ files.
+//
+// Parsing a large OBJ file and removing its repeated vertices takes seconds,
+// so the first load of a model writes a binary cache next to it
+// (model file path + ".meshcache"), with its vertices and indices ready to be used.
+// The model in the cache is optimized for the GPU (Read Model::optimize()).
+// The next loads map the cache and copy the vertices and indices straight from the mapping
+// to the staging memory (Read Model), without parsing anything.
+//
+// Cache file format (little endian):
+// - Header: magic "VKMC", version, vertex size, reserved, size, modification time and hash
+//   of the model file, vertex count and offset, index count and offset, and bounds.
+// - Vertices and indices, aligned to 64 bytes.
+//
+// The cache is rebuilt if its version or its vertex size do not match, if the size
+// of the model file changes, or if both its modification time and its hash change
+// (a file can be touched without being modified). It is also rebuilt if it is
+// truncated or any index is out of the vertices.
+//
+// Each vertex type has its own cache (model file path + ".quantized.meshcache" for
+// QuantizedPosTexCoordVertex), so the quantized vertices are mapped as well, instead of
+// being quantized from the float ones in every run.
+//
 class ModelSystem {
 public:
     ModelSystem() = delete;
@@ -18,15 +42,57 @@ public:
     ModelSystem(const ModelSystem&) = delete;
     const ModelSystem& operator=(const ModelSystem&) = delete;
 
+    // * parserThreadCount: 1 parses the file in the calling thread.
+    //   Otherwise, the file is memory mapped and parsed by parserThreadCount threads
+    //   (a thread per hardware thread if it is 0), which is much faster for large files.
+    //   Both ways produce the same model.
+    //   It is ignored if the model is loaded from its cache.
     static const Model<PosTexCoordVertex>&
-    getOrLoadModelWithPosTexCoordVertex(const std::string& modelFilePath);
+    getOrLoadModelWithPosTexCoordVertex(const std::string& modelFilePath,
+                                        const uint32_t parserThreadCount = 1);
+
+    // The model of getOrLoadModelWithPosTexCoordVertex(), with its vertices quantized
+    // within its bounds (Read QuantizedPosTexCoordVertex).
+    // The model matrix must include vertex_quantization::dequantizationMatrix()
+    // of the bounds of the model.
+    static const Model<QuantizedPosTexCoordVertex>&
+    getOrLoadModelWithQuantizedPosTexCoordVertex(const std::string& modelFilePath,
+                                                 const uint32_t parserThreadCount = 1);
+
+    // Same than getOrLoadModelWithPosTexCoordVertex(), but the model is always
+    // parsed, and it is not cached in the system nor in a file.
+    static void
+    loadModelWithPosTexCoordVertex(const std::string& modelFilePath,
+                                   const uint32_t parserThreadCount,
+                                   Model<PosTexCoordVertex>& model);
     
     static void
     clear();
 
 private:
+    // Loads the model from its cache. If there is no valid cache, then the model is
+    // parsed and optimized, and its cache is written.
+    static void
+    loadOptimizedModelWithPosTexCoordVertex(const std::string& modelFilePath,
+                                            const uint32_t parserThreadCount,
+                                            Model<PosTexCoordVertex>& model);
+
+    // Returns false if the cache of the model does not exist or it is not valid.
+    template<typename T>
+    static bool
+    loadModelCache(const std::string& modelFilePath,
+                   Model<T>& model);
+
+    template<typename T>
+    static void
+    writeModelCache(const std::string& modelFilePath,
+                    const Model<T>& model);
+
     using ModelWithPosTexCoordVertexByPath = std::unordered_map<std::string, Model<PosTexCoordVertex>>;
     static ModelWithPosTexCoordVertexByPath mModelWithPosTexCoordVertexByPath;
+
+    using ModelWithQuantizedPosTexCoordVertexByPath = std::unordered_map<std::string, Model<QuantizedPosTexCoordVertex>>;
+    static ModelWithQuantizedPosTexCoordVertexByPath mModelWithQuantizedPosTexCoordVertexByPath;
 };
 
 }
@@ -0,0 +1,174 @@
+#include "TransientImagePool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "Image.h"
+
+namespace {
+vk::DeviceSize
+alignUp(const vk::DeviceSize value,
+        const vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+namespace vulkan {
+TransientImagePool::TransientImagePool(const vk::MemoryPropertyFlags memoryPropertyFlags)
+    : mMemoryPropertyFlags(memoryPropertyFlags)
+{
+
+}
+
+TransientImagePool::~TransientImagePool() {
+    // Images must be destroyed before their memory.
+    mImages.clear();
+    DeviceMemoryAllocator::free(mAllocation);
+}
+
+uint32_t
+TransientImagePool::addImage(const uint32_t imageWidth,
+                             const uint32_t imageHeight,
+                             const vk::Format format,
+                             const vk::ImageUsageFlags imageUsageFlags,
+                             const uint32_t firstUse,
+                             const uint32_t lastUse,
+                             const vk::SampleCountFlagBits sampleCount) {
+    assert(mAllocation.isValid() == false);
+    assert(firstUse <= lastUse);
+
+    PoolImage poolImage;
+    poolImage.mImage.reset(new Image(imageWidth,
+                                     imageHeight,
+                                     format,
+                                     imageUsageFlags,
+                                     sampleCount));
+    poolImage.mMemoryRequirements = poolImage.mImage->memoryRequirements();
+    poolImage.mFirstUse = firstUse;
+    poolImage.mLastUse = lastUse;
+
+    mImages.emplace_back(std::move(poolImage));
+
+    return static_cast<uint32_t>(mImages.size() - 1);
+}
+
+void
+TransientImagePool::allocate() {
+    assert(mAllocation.isValid() == false);
+    assert(mImages.empty() == false);
+
+    // Bigger images are placed first, so smaller ones can fill the gaps.
+    std::vector<PoolImage*> sortedImages;
+    for (PoolImage& poolImage : mImages) {
+        sortedImages.push_back(&poolImage);
+    }
+    std::stable_sort(sortedImages.begin(),
+                     sortedImages.end(),
+                     [](const PoolImage* a, const PoolImage* b) {
+                         return a->mMemoryRequirements.size > b->mMemoryRequirements.size;
+                     });
+
+    // All the images share the same DeviceMemory, so its memory type must
+    // be supported by all of them, and its alignment must satisfy all of them.
+    vk::MemoryRequirements poolRequirements;
+    poolRequirements.memoryTypeBits = std::numeric_limits<uint32_t>::max();
+    poolRequirements.alignment = 1;
+
+    std::vector<const PoolImage*> placedImages;
+    mMemorySize = 0;
+    for (PoolImage* poolImage : sortedImages) {
+        poolImage->mOffset = findOffset(*poolImage,
+                                        placedImages);
+        placedImages.push_back(poolImage);
+
+        mMemorySize = std::max(mMemorySize,
+                               poolImage->mOffset + poolImage->mMemoryRequirements.size);
+
+        poolRequirements.memoryTypeBits &= poolImage->mMemoryRequirements.memoryTypeBits;
+        poolRequirements.alignment = std::max(poolRequirements.alignment,
+                                              poolImage->mMemoryRequirements.alignment);
+    }
+    assert(poolRequirements.memoryTypeBits != 0 && "Images do not share any memory type");
+    poolRequirements.size = mMemorySize;
+
+    mAllocation = DeviceMemoryAllocator::allocate(poolRequirements,
+                                                  mMemoryPropertyFlags,
+                                                  ResourceTiling::Optimal);
+
+    for (PoolImage& poolImage : mImages) {
+        poolImage.mImage->bindDeviceMemory(mAllocation.mDeviceMemory,
+                                           mAllocation.mOffset + poolImage.mOffset);
+    }
+}
+
+Image&
+TransientImagePool::image(const uint32_t imageIndex) {
+    assert(imageIndex < mImages.size());
+    assert(mAllocation.isValid());
+    return *mImages[imageIndex].mImage;
+}
+
+vk::DeviceSize
+TransientImagePool::memorySize() const {
+    assert(mAllocation.isValid());
+    return mMemorySize;
+}
+
+vk::DeviceSize
+TransientImagePool::unaliasedMemorySize() const {
+    vk::DeviceSize size = 0;
+    for (const PoolImage& poolImage : mImages) {
+        size = alignUp(size,
+                       poolImage.mMemoryRequirements.alignment);
+        size += poolImage.mMemoryRequirements.size;
+    }
+
+    return size;
+}
+
+bool
+TransientImagePool::areLifetimesOverlapped(const PoolImage& image,
+                                           const PoolImage& otherImage) {
+    return image.mFirstUse <= otherImage.mLastUse &&
+           otherImage.mFirstUse <= image.mLastUse;
+}
+
+vk::DeviceSize
+TransientImagePool::findOffset(const PoolImage& image,
+                               const std::vector<const PoolImage*>& placedImages) {
+    const vk::DeviceSize alignment = image.mMemoryRequirements.alignment;
+    const vk::DeviceSize size = image.mMemoryRequirements.size;
+
+    // Only images alive at the same time can collide.
+    // Candidate offsets are the beginning of the memory and
+    // the end of each of those images.
+    std::vector<const PoolImage*> aliveImages;
+    std::vector<vk::DeviceSize> candidateOffsets = {0};
+    for (const PoolImage* placedImage : placedImages) {
+        if (areLifetimesOverlapped(image, *placedImage)) {
+            aliveImages.push_back(placedImage);
+            candidateOffsets.push_back(alignUp(placedImage->mOffset + placedImage->mMemoryRequirements.size,
+                                               alignment));
+        }
+    }
+    std::sort(candidateOffsets.begin(),
+              candidateOffsets.end());
+
+    for (const vk::DeviceSize offset : candidateOffsets) {
+        const bool collides = std::any_of(aliveImages.begin(),
+                                          aliveImages.end(),
+                                          [offset, size](const PoolImage* aliveImage) {
+                                              return offset < aliveImage->mOffset + aliveImage->mMemoryRequirements.size &&
+                                                     aliveImage->mOffset < offset + size;
+                                          });
+        if (collides == false) {
+            return offset;
+        }
+    }
+
+    // The end of the last alive image is always a valid offset.
+    assert(false);
+    return candidateOffsets.back();
+}
+}
@@ -0,0 +1,99 @@
+#ifndef UTILS_RESOURCE_TRANSIENT_IMAGE_POOL
+#define UTILS_RESOURCE_TRANSIENT_IMAGE_POOL
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "../memory/DeviceMemoryAllocator.h"
+
+namespace vulkan {
+class Image;
+
+//
+// Pool of transient images (depth buffers, MSAA color buffers,
+// intermediate render targets) that share a single DeviceMemory allocation.
+//
+// Each image has a lifetime: the first and the last use inside the
+// frame (for example, the index of the render passes that use it).
+// Images whose lifetimes do not overlap alias the same memory, so the
+// pool only needs the memory of the images that are alive at the same time.
+//
+// As the memory is shared, the content of an aliased image is undefined
+// at its first use. It must be transitioned from VK_IMAGE_LAYOUT_UNDEFINED
+// (or cleared with VK_ATTACHMENT_LOAD_OP_CLEAR / DONT_CARE) every frame.
+//
+// By default, the memory is requested with VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+// so tiled GPUs can keep the attachments in on-chip memory.
+// Images must be created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT to use it.
+//
+class TransientImagePool {
+public:
+    // * memoryPropertyFlags is used to allocate the DeviceMemory of the pool.
+    TransientImagePool(const vk::MemoryPropertyFlags memoryPropertyFlags =
+                           vk::MemoryPropertyFlagBits::eDeviceLocal |
+                           vk::MemoryPropertyFlagBits::eLazilyAllocated);
+    ~TransientImagePool();
+    TransientImagePool(const TransientImagePool&) = delete;
+    const TransientImagePool& operator=(const TransientImagePool&) = delete;
+
+    // Returns the index of the new image in the pool.
+    // The image cannot be used until allocate() is called.
+    //
+    // * firstUse and lastUse are the first and last points of the frame
+    //   where the image is used (both included).
+    //
+    // Read Image to understand the rest of parameters.
+    uint32_t
+    addImage(const uint32_t imageWidth,
+             const uint32_t imageHeight,
+             const vk::Format format,
+             const vk::ImageUsageFlags imageUsageFlags,
+             const uint32_t firstUse,
+             const uint32_t lastUse,
+             const vk::SampleCountFlagBits sampleCount = vk::SampleCountFlagBits::e1);
+
+    // Places all the images inside the pool memory, aliasing the ones
+    // whose lifetimes do not overlap, and binds them.
+    // It can only be called once.
+    void
+    allocate();
+
+    Image&
+    image(const uint32_t imageIndex);
+
+    // Size of the DeviceMemory shared by all the images.
+    vk::DeviceSize
+    memorySize() const;
+
+    // Size that would be needed if every image had its own memory.
+    vk::DeviceSize
+    unaliasedMemorySize() const;
+
+private:
+    struct PoolImage {
+        std::unique_ptr<Image> mImage;
+        vk::MemoryRequirements mMemoryRequirements;
+        uint32_t mFirstUse = 0;
+        uint32_t mLastUse = 0;
+        vk::DeviceSize mOffset = 0;
+    };
+
+    static bool
+    areLifetimesOverlapped(const PoolImage& image,
+                           const PoolImage& otherImage);
+
+    // Returns the lowest offset where the image does not overlap the memory
+    // of any already placed image that is alive at the same time.
+    static vk::DeviceSize
+    findOffset(const PoolImage& image,
+               const std::vector<const PoolImage*>& placedImages);
+
+    const vk::MemoryPropertyFlags mMemoryPropertyFlags;
+    std::vector<PoolImage> mImages;
+    DeviceMemoryAllocation mAllocation;
+    vk::DeviceSize mMemorySize = 0;
+};
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "UniformRingBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#include "../device/PhysicalDevice.h"
+
+namespace {
+vk::DeviceSize
+alignUp(const vk::DeviceSize value,
+        const vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+namespace vulkan {
+UniformRingBuffer::UniformRingBuffer(const vk::DeviceSize frameSize,
+                                     const uint32_t frameCount)
+    : mAlignment(pushAlignment())
+    , mFrameSize(alignUp(frameSize, mAlignment))
+    , mFrameCount(frameCount)
+    // Host coherent is not requested, so the driver can give us
+    // cached memory. endFrame() flushes the written ranges.
+    , mBuffer(mFrameSize * frameCount,
+              vk::BufferUsageFlagBits::eUniformBuffer,
+              vk::MemoryPropertyFlagBits::eHostVisible)
+    , mMappedData(static_cast<char*>(mBuffer.mappedData()))
+{
+    assert(frameSize > 0);
+    assert(frameCount > 0);
+    assert(mMappedData != nullptr);
+    // Dynamic offsets are 32 bits.
+    assert(mFrameSize * frameCount <= std::numeric_limits<uint32_t>::max());
+}
+
+vk::Buffer
+UniformRingBuffer::vkBuffer() const {
+    return mBuffer.vkBuffer();
+}
+
+uint32_t
+UniformRingBuffer::frameCount() const {
+    return mFrameCount;
+}
+
+uint32_t
+UniformRingBuffer::frameOffset(const uint32_t frameIndex) const {
+    assert(frameIndex < mFrameCount);
+    return static_cast<uint32_t>(mFrameSize * frameIndex);
+}
+
+vk::DescriptorBufferInfo
+UniformRingBuffer::descriptorBufferInfo(const vk::DeviceSize range) const {
+    assert(range > 0);
+    assert(range <= mFrameSize);
+
+    vk::DescriptorBufferInfo info;
+    info.setBuffer(mBuffer.vkBuffer());
+    // The dynamic offset is added to this offset.
+    info.setOffset(0);
+    info.setRange(range);
+
+    return info;
+}
+
+void
+UniformRingBuffer::beginFrame(const uint32_t frameIndex) {
+    assert(mIsFrameBegun == false);
+    assert(frameIndex < mFrameCount);
+
+    mCurrentFrameIndex = frameIndex;
+    mWriteOffset = 0;
+    mIsFrameBegun = true;
+}
+
+uint32_t
+UniformRingBuffer::push(const void* data,
+                        const vk::DeviceSize size) {
+    assert(mIsFrameBegun);
+    assert(data != nullptr);
+    assert(size > 0);
+
+    const vk::DeviceSize offset = alignUp(mWriteOffset, mAlignment);
+    assert(offset + size <= mFrameSize && "Frame partition is full");
+
+    const vk::DeviceSize bufferOffset = frameOffset(mCurrentFrameIndex) + offset;
+    memcpy(mMappedData + bufferOffset,
+           data,
+           static_cast<size_t>(size));
+
+    mWriteOffset = offset + size;
+
+    return static_cast<uint32_t>(bufferOffset);
+}
+
+void
+UniformRingBuffer::endFrame() {
+    assert(mIsFrameBegun);
+
+    if (mWriteOffset > 0) {
+        mBuffer.flushMappedMemory(frameOffset(mCurrentFrameIndex),
+                                  mWriteOffset);
+    }
+
+    mIsFrameBegun = false;
+}
+
+vk::DeviceSize
+UniformRingBuffer::pushAlignment() {
+    const vk::PhysicalDeviceProperties properties = PhysicalDevice::device().getProperties();
+
+    // Partitions are also aligned to nonCoherentAtomSize, so flushing
+    // a frame never touches the partition of other frame.
+    return std::max(properties.limits.minUniformBufferOffsetAlignment,
+                    properties.limits.nonCoherentAtomSize);
+}
+}
@@ -0,0 +1,107 @@
+#ifndef UTILS_RESOURCE_UNIFORM_RING_BUFFER
+#define UTILS_RESOURCE_UNIFORM_RING_BUFFER
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+#include "Buffer.h"
+
+namespace vulkan {
+//
+// Persistently mapped uniform buffer split in one partition per frame.
+//
+// Instead of having a Buffer and a descriptor set for each swap chain image
+// (and calling vkMapMemory/vkUnmapMemory every time they are updated),
+// all the uniform data of a frame is pushed to the partition of that frame,
+// and a single descriptor set of type VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+// is used to read it.
+// Each push() returns the offset that must be passed as dynamic offset
+// to vkCmdBindDescriptorSets.
+//
+// The partition of a frame must not be written while the device can still
+// be reading it, so there must be (at least) one partition per frame in flight.
+//
+// As the data is pushed in the same order every frame, the offsets
+// returned by push() relative to frameOffset() do not change between frames.
+// That is what allows to pre-record command buffers with dynamic offsets.
+//
+// If the memory is not host coherent, then endFrame() flushes only the range
+// written during the frame.
+//
+// Usage:
+// - beginFrame(frameIndex)
+// - push() the uniform data of each object
+// - endFrame()
+// - submit the command buffers that read the frame partition.
+//
+class UniformRingBuffer {
+public:
+    // * frameSize in bytes that can be pushed in each frame.
+    //   Take into account that each push() is aligned to 
+    //   vk::PhysicalDeviceLimits::minUniformBufferOffsetAlignment
+    //
+    // * frameCount is the number of partitions (frames in flight).
+    UniformRingBuffer(const vk::DeviceSize frameSize,
+                      const uint32_t frameCount);
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    const UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    vk::Buffer
+    vkBuffer() const;
+
+    uint32_t
+    frameCount() const;
+
+    // Offset in the buffer where the partition of the frame begins.
+    uint32_t
+    frameOffset(const uint32_t frameIndex) const;
+
+    // Returns the buffer info to write a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+    // descriptor whose dynamic offset is the one returned by push()
+    //
+    // * range in bytes that the shader can read from the dynamic offset
+    //   (usually, the size of the uniform structure).
+    vk::DescriptorBufferInfo
+    descriptorBufferInfo(const vk::DeviceSize range) const;
+
+    // The previous frame must have been ended.
+    void
+    beginFrame(const uint32_t frameIndex);
+
+    // Copies the data in the current frame partition and returns 
+    // its offset in the buffer (to be used as dynamic offset).
+    uint32_t
+    push(const void* data,
+         const vk::DeviceSize size);
+
+    template<typename T>
+    uint32_t
+    push(const T& data) {
+        return push(&data,
+                    sizeof(T));
+    }
+
+    // Flushes the range written since beginFrame().
+    void
+    endFrame();
+
+private:
+    static vk::DeviceSize
+    pushAlignment();
+
+    const vk::DeviceSize mAlignment;
+    const vk::DeviceSize mFrameSize;
+    const uint32_t mFrameCount;
+    Buffer mBuffer;
+    char* mMappedData = nullptr;
+
+    uint32_t mCurrentFrameIndex = 0;
+
+    // Offset relative to the current frame partition
+    // where the next push() will be placed.
+    vk::DeviceSize mWriteOffset = 0;
+    bool mIsFrameBegun = false;
+};
+}
+
+#endif
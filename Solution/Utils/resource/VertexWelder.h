@@ -0,0 +1,296 @@
+#ifndef UTILS_RESOURCE_VERTEX_WELDER
+#define UTILS_RESOURCE_VERTEX_WELDER
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vulkan {
+//
+// Removes the repeated vertices of a mesh (welds them).
+//
+// It is a hash table with open addressing (linear probing) in a flat array
+// of slots (hash tag and vertex index). There is no allocation per vertex nor a pointer
+// to follow per probe, and the tags are compared before the vertices, so most
+// probes do not touch the vertices.
+//
+// Vertices are hashed and compared by their bytes:
+// - T must be trivially copyable, without padding.
+// - Coordinates that are equal but have different bits (0.0 and -0.0) are different.
+//
+template<typename T>
+class VertexWelder {
+public:
+    // * expectedVertexCount to size the table. It grows if it is exceeded.
+    explicit VertexWelder(const size_t expectedVertexCount);
+
+    // Returns the index of the vertex in vertices(), where it
+    // is added if it was not added before.
+    uint32_t
+    weld(const T& vertex);
+
+    // Same than weld(vertex), with the hash() of the vertex.
+    uint32_t
+    weld(const T& vertex,
+         const uint64_t vertexHash);
+
+    // The welded vertices, in the order they were added.
+    std::vector<T>&
+    vertices();
+
+    static uint64_t
+    hash(const T& vertex);
+
+    // Welds unweldedVertices (a vertex per index), so vertices are the unique ones,
+    // in the order of their first use, and indices the index of each unwelded vertex in them.
+    //
+    // * threadCount: 0 means a thread per hardware thread. With more than one thread,
+    //   the vertices are split in shards by hash and each shard is welded by its own thread.
+    //   The result does not depend on the thread count.
+    static void
+    weldVertices(const std::vector<T>& unweldedVertices,
+                 const uint32_t threadCount,
+                 std::vector<T>& vertices,
+                 std::vector<uint32_t>& indices);
+
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "Vertices are hashed and compared by their bytes");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Vertices are hashed by 32 bits words");
+
+    struct Slot {
+        uint32_t mHashTag;
+        uint32_t mVertexIndex;
+    };
+
+    static const uint32_t sEmptySlot = UINT32_MAX;
+    // Below this count, the threads cost more than they save.
+    static const size_t sMinVertexCountPerThread = 1 << 16;
+
+    // Shard of a hash, from its high bits (the low bits are used by the slot index).
+    static uint32_t
+    shard(const uint64_t vertexHash,
+          const uint32_t shardCount);
+
+    // Doubles the slots, so at most half of them are used.
+    void
+    grow();
+
+    std::vector<Slot> mSlots;
+    size_t mSlotMask = 0;
+    std::vector<T> mVertices;
+};
+
+template<typename T>
+const uint32_t VertexWelder<T>::sEmptySlot;
+
+template<typename T>
+const size_t VertexWelder<T>::sMinVertexCountPerThread;
+
+template<typename T>
+VertexWelder<T>::VertexWelder(const size_t expectedVertexCount) {
+    size_t slotCount = 16;
+    while (slotCount < 2 * expectedVertexCount) {
+        slotCount *= 2;
+    }
+
+    mSlots.resize(slotCount, Slot{0, sEmptySlot});
+    mSlotMask = slotCount - 1;
+    mVertices.reserve(expectedVertexCount);
+}
+
+template<typename T>
+uint32_t
+VertexWelder<T>::weld(const T& vertex) {
+    return weld(vertex,
+                hash(vertex));
+}
+
+template<typename T>
+uint32_t
+VertexWelder<T>::weld(const T& vertex,
+                      const uint64_t vertexHash) {
+    const uint32_t hashTag = static_cast<uint32_t>(vertexHash >> 32);
+    for (size_t slotIndex = static_cast<size_t>(vertexHash) & mSlotMask;; slotIndex = (slotIndex + 1) & mSlotMask) {
+        Slot& slot = mSlots[slotIndex];
+        if (slot.mVertexIndex == sEmptySlot) {
+            if (2 * (mVertices.size() + 1) > mSlots.size()) {
+                grow();
+                return weld(vertex,
+                            vertexHash);
+            }
+
+            assert(mVertices.size() < sEmptySlot);
+            slot.mHashTag = hashTag;
+            slot.mVertexIndex = static_cast<uint32_t>(mVertices.size());
+            mVertices.push_back(vertex);
+            return slot.mVertexIndex;
+        }
+
+        if (slot.mHashTag == hashTag &&
+            std::memcmp(&mVertices[slot.mVertexIndex], &vertex, sizeof(T)) == 0) {
+            return slot.mVertexIndex;
+        }
+    }
+}
+
+template<typename T>
+std::vector<T>&
+VertexWelder<T>::vertices() {
+    return mVertices;
+}
+
+template<typename T>
+uint64_t
+VertexWelder<T>::hash(const T& vertex) {
+    uint32_t words[sizeof(T) / sizeof(uint32_t)];
+    std::memcpy(words,
+                &vertex,
+                sizeof(T));
+
+    uint64_t vertexHash = 0x9E3779B97F4A7C15ull;
+    for (const uint32_t word : words) {
+        vertexHash = (vertexHash ^ word) * 0xFF51AFD7ED558CCDull;
+        vertexHash ^= vertexHash >> 32;
+    }
+
+    // Finalizer of MurmurHash3, so every bit of the vertex
+    // affects every bit of the hash.
+    vertexHash ^= vertexHash >> 33;
+    vertexHash *= 0xFF51AFD7ED558CCDull;
+    vertexHash ^= vertexHash >> 33;
+    vertexHash *= 0xC4CEB9FE1A85EC53ull;
+    vertexHash ^= vertexHash >> 33;
+
+    return vertexHash;
+}
+
+template<typename T>
+void
+VertexWelder<T>::weldVertices(const std::vector<T>& unweldedVertices,
+                              const uint32_t threadCount,
+                              std::vector<T>& vertices,
+                              std::vector<uint32_t>& indices) {
+    // Closed triangle meshes have about 6 indices per vertex, but texture
+    // coordinate seams split vertices, so the tables are sized for 4 indices
+    // per vertex (they grow if it is exceeded).
+    const size_t expectedVertexCount = unweldedVertices.size() / 4;
+
+    uint32_t shardCount = threadCount == 0 ? std::thread::hardware_concurrency() : threadCount;
+    shardCount = static_cast<uint32_t>(std::min(static_cast<size_t>(std::max(shardCount, 1u)),
+                                                unweldedVertices.size() / sMinVertexCountPerThread + 1));
+
+    indices.resize(unweldedVertices.size());
+
+    if (shardCount == 1) {
+        VertexWelder welder(expectedVertexCount);
+        for (size_t i = 0; i < unweldedVertices.size(); ++i) {
+            indices[i] = welder.weld(unweldedVertices[i]);
+        }
+        vertices.swap(welder.vertices());
+        return;
+    }
+
+    // Each thread hashes a range of the vertices, and buckets their positions
+    // by shard. Then, each thread welds the vertices of its shard, so the shards
+    // do not share anything, and each thread only visits the vertices of its shard.
+    // indices[i] is the index of the vertex in the vertices of its shard.
+    assert(unweldedVertices.size() <= UINT32_MAX);
+    std::vector<uint64_t> hashes(unweldedVertices.size());
+    // Positions of the vertices of a range (hashed by a thread) that are in a shard,
+    // at [rangeIndex * shardCount + shardIndex], in increasing order.
+    std::vector<std::vector<uint32_t>> positionsByRangeAndShard(shardCount * shardCount);
+    std::vector<std::vector<T>> shardVertices(shardCount);
+    {
+        std::vector<std::thread> threads;
+        for (uint32_t rangeIndex = 0; rangeIndex < shardCount; ++rangeIndex) {
+            const size_t begin = unweldedVertices.size() * rangeIndex / shardCount;
+            const size_t end = unweldedVertices.size() * (rangeIndex + 1) / shardCount;
+            threads.emplace_back([&unweldedVertices, &hashes, &positionsByRangeAndShard, rangeIndex, shardCount, begin, end]() {
+                std::vector<uint32_t>* positionsByShard = &positionsByRangeAndShard[rangeIndex * shardCount];
+                for (uint32_t shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+                    positionsByShard[shardIndex].reserve((end - begin) / shardCount + 1);
+                }
+
+                for (size_t i = begin; i < end; ++i) {
+                    hashes[i] = hash(unweldedVertices[i]);
+                    positionsByShard[shard(hashes[i], shardCount)].push_back(static_cast<uint32_t>(i));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        // The ranges are visited in order, so the vertices of a shard are
+        // welded in the same order than with a single thread.
+        threads.clear();
+        for (uint32_t shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+            threads.emplace_back([&unweldedVertices, &hashes, &positionsByRangeAndShard, &indices, &shardVertices, shardIndex, shardCount, expectedVertexCount]() {
+                VertexWelder welder(expectedVertexCount / shardCount);
+                for (uint32_t rangeIndex = 0; rangeIndex < shardCount; ++rangeIndex) {
+                    for (const uint32_t i : positionsByRangeAndShard[rangeIndex * shardCount + shardIndex]) {
+                        indices[i] = welder.weld(unweldedVertices[i],
+                                                 hashes[i]);
+                    }
+                }
+                shardVertices[shardIndex].swap(welder.vertices());
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // The vertices are sorted by first use, as if a single thread welded them.
+    std::vector<size_t> shardOffsets(shardCount, 0);
+    for (uint32_t shardIndex = 1; shardIndex < shardCount; ++shardIndex) {
+        shardOffsets[shardIndex] = shardOffsets[shardIndex - 1] + shardVertices[shardIndex - 1].size();
+    }
+
+    const size_t vertexCount = shardOffsets.back() + shardVertices.back().size();
+    std::vector<uint32_t> newIndexByShardIndex(vertexCount, sEmptySlot);
+    vertices.resize(vertexCount);
+    uint32_t newVertexCount = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        const uint32_t shardIndex = shard(hashes[i], shardCount);
+        uint32_t& newIndex = newIndexByShardIndex[shardOffsets[shardIndex] + indices[i]];
+        if (newIndex == sEmptySlot) {
+            newIndex = newVertexCount++;
+            vertices[newIndex] = shardVertices[shardIndex][indices[i]];
+        }
+        indices[i] = newIndex;
+    }
+}
+
+template<typename T>
+uint32_t
+VertexWelder<T>::shard(const uint64_t vertexHash,
+                       const uint32_t shardCount) {
+    return static_cast<uint32_t>(((vertexHash >> 32) * shardCount) >> 32);
+}
+
+template<typename T>
+void
+VertexWelder<T>::grow() {
+    std::vector<Slot> slots(2 * mSlots.size(), Slot{0, sEmptySlot});
+    const size_t slotMask = slots.size() - 1;
+    for (uint32_t vertexIndex = 0; vertexIndex < mVertices.size(); ++vertexIndex) {
+        const uint64_t vertexHash = hash(mVertices[vertexIndex]);
+        size_t slotIndex = static_cast<size_t>(vertexHash) & slotMask;
+        while (slots[slotIndex].mVertexIndex != sEmptySlot) {
+            slotIndex = (slotIndex + 1) & slotMask;
+        }
+        slots[slotIndex].mHashTag = static_cast<uint32_t>(vertexHash >> 32);
+        slots[slotIndex].mVertexIndex = vertexIndex;
+    }
+
+    mSlots.swap(slots);
+    mSlotMask = slotMask;
+}
+}
+
+#endif
@@ -0,0 +1,356 @@
+#include "ShaderArchive.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "../FileSystem.h"
+#include "../MappedFile.h"
+
+namespace {
+const uint32_t sArchiveMagic = 0x41534B56; // "VKSA"
+const uint32_t sArchiveVersion = 2;
+const uint32_t sSpirvMagicNumber = 0x07230203;
+const size_t sSpirvHeaderSize = 5 * sizeof(uint32_t);
+
+struct ArchiveHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mEntryCount;
+    uint32_t mReserved;
+};
+static_assert(sizeof(ArchiveHeader) == 16, "Unexpected archive header padding");
+
+struct ArchiveEntry {
+    uint64_t mPathHash;
+    uint32_t mPathOffset;
+    uint32_t mPathSize;
+    uint32_t mByteCodeOffset;
+    uint32_t mByteCodeSize;
+    // Status of the shader file when it was archived.
+    uint64_t mSourceSize;
+    int64_t mSourceModificationTime;
+};
+static_assert(sizeof(ArchiveEntry) == 40, "Unexpected archive entry padding");
+
+struct ArchivedShader {
+    uint64_t mPathHash;
+    std::string mPath;
+    std::vector<uint8_t> mByteCode;
+    uint64_t mSourceSize;
+    int64_t mSourceModificationTime;
+};
+
+// The archived byte code is stale if the shader file changed since it was archived.
+// If the file does not exist, then the archive is the only source of the shader.
+bool
+isSourceChanged(const std::string& shaderByteCodePath,
+                const ArchiveEntry& entry) {
+    uint64_t sourceSize = 0;
+    int64_t sourceModificationTime = 0;
+    if (vulkan::file_system::readFileStatus(shaderByteCodePath,
+                                            sourceSize,
+                                            sourceModificationTime) == false) {
+        return false;
+    }
+
+    return sourceSize != entry.mSourceSize ||
+           sourceModificationTime != entry.mSourceModificationTime;
+}
+
+// FNV-1a
+uint64_t
+pathHash(const char* path,
+         const size_t pathSize) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < pathSize; ++i) {
+        hash ^= static_cast<uint8_t>(path[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool
+isValidSpirv(const uint8_t* byteCode,
+             const size_t byteCodeSize) {
+    if (byteCodeSize < sSpirvHeaderSize || byteCodeSize % sizeof(uint32_t) != 0) {
+        return false;
+    }
+
+    uint32_t magic;
+    std::memcpy(&magic,
+                byteCode,
+                sizeof(magic));
+    return magic == sSpirvMagicNumber;
+}
+
+uint32_t
+alignTo4(const size_t size) {
+    return static_cast<uint32_t>((size + 3) & ~size_t(3));
+}
+}
+
+namespace vulkan {
+std::string
+ShaderArchive::mFilePath = {};
+
+bool
+ShaderArchive::mCheckShaderFiles = false;
+
+std::unique_ptr<MappedFile>
+ShaderArchive::mMappedFile;
+
+const uint8_t*
+ShaderArchive::mData = nullptr;
+
+size_t
+ShaderArchive::mSize = 0;
+
+std::vector<std::string>
+ShaderArchive::mAddedShaderByteCodePaths = {};
+
+void
+ShaderArchive::initialize(const std::string& filePath,
+                          const bool checkShaderFiles) {
+    assert(mData == nullptr);
+    assert(filePath.empty() == false);
+
+    mFilePath = filePath;
+    mCheckShaderFiles = checkShaderFiles;
+
+    if (map(filePath) && isValidArchive() == false) {
+        unmap();
+    }
+}
+
+void
+ShaderArchive::finalize() {
+    if (mAddedShaderByteCodePaths.empty() == false) {
+        // The archive is copied before it is unmapped, because
+        // a mapped file cannot be replaced on every platform.
+        const std::vector<uint8_t> data = buildArchive();
+        unmap();
+        file_system::writeFileAtomically(mFilePath,
+                                         data.data(),
+                                         data.size());
+    } else {
+        unmap();
+    }
+
+    mAddedShaderByteCodePaths.clear();
+    mFilePath.clear();
+    mCheckShaderFiles = false;
+}
+
+bool
+ShaderArchive::findByteCode(const std::string& shaderByteCodePath,
+                            const uint32_t*& byteCode,
+                            size_t& byteCodeSize) {
+    if (mData == nullptr) {
+        return false;
+    }
+
+    ArchiveHeader header;
+    std::memcpy(&header,
+                mData,
+                sizeof(header));
+    const ArchiveEntry* entriesBegin = reinterpret_cast<const ArchiveEntry*>(mData + sizeof(ArchiveHeader));
+    const ArchiveEntry* entriesEnd = entriesBegin + header.mEntryCount;
+
+    const uint64_t hash = pathHash(shaderByteCodePath.c_str(),
+                                   shaderByteCodePath.size());
+    const ArchiveEntry* entry = std::lower_bound(entriesBegin,
+                                                 entriesEnd,
+                                                 hash,
+                                                 [](const ArchiveEntry& entry, const uint64_t hash) {
+                                                     return entry.mPathHash < hash;
+                                                 });
+
+    // Paths with the same hash are consecutive.
+    for (; entry != entriesEnd && entry->mPathHash == hash; ++entry) {
+        if (entry->mPathSize == shaderByteCodePath.size() &&
+            std::memcmp(mData + entry->mPathOffset,
+                        shaderByteCodePath.data(),
+                        shaderByteCodePath.size()) == 0) {
+            if (isValidSpirv(mData + entry->mByteCodeOffset,
+                             entry->mByteCodeSize) == false ||
+                (mCheckShaderFiles && isSourceChanged(shaderByteCodePath,
+                                                      *entry))) {
+                return false;
+            }
+
+            // The mapping is page aligned and the byte code offset
+            // is aligned to 4 bytes (Read isValidArchive())
+            byteCode = reinterpret_cast<const uint32_t*>(mData + entry->mByteCodeOffset);
+            byteCodeSize = entry->mByteCodeSize;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+ShaderArchive::addShaderByteCodePath(const std::string& shaderByteCodePath) {
+    assert(mFilePath.empty() == false);
+    mAddedShaderByteCodePaths.push_back(shaderByteCodePath);
+}
+
+bool
+ShaderArchive::map(const std::string& filePath) {
+    assert(mData == nullptr);
+
+    std::unique_ptr<MappedFile> mappedFile(new MappedFile(filePath));
+    if (mappedFile->isMapped() == false || mappedFile->size() < sizeof(ArchiveHeader)) {
+        return false;
+    }
+
+    mMappedFile = std::move(mappedFile);
+    mData = mMappedFile->data();
+    mSize = mMappedFile->size();
+    return true;
+}
+
+void
+ShaderArchive::unmap() {
+    mMappedFile.reset();
+    mData = nullptr;
+    mSize = 0;
+}
+
+bool
+ShaderArchive::isValidArchive() {
+    assert(mData != nullptr);
+    assert(mSize >= sizeof(ArchiveHeader));
+
+    ArchiveHeader header;
+    std::memcpy(&header,
+                mData,
+                sizeof(header));
+    if (header.mMagic != sArchiveMagic ||
+        header.mVersion != sArchiveVersion ||
+        header.mEntryCount > (mSize - sizeof(ArchiveHeader)) / sizeof(ArchiveEntry)) {
+        return false;
+    }
+
+    const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(mData + sizeof(ArchiveHeader));
+    for (uint32_t i = 0; i < header.mEntryCount; ++i) {
+        const ArchiveEntry& entry = entries[i];
+        if (uint64_t(entry.mPathOffset) + entry.mPathSize > mSize ||
+            uint64_t(entry.mByteCodeOffset) + entry.mByteCodeSize > mSize ||
+            entry.mByteCodeOffset % sizeof(uint32_t) != 0 ||
+            (i > 0 && entries[i - 1].mPathHash > entry.mPathHash)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<uint8_t>
+ShaderArchive::buildArchive() {
+    std::vector<ArchivedShader> shaders;
+
+    if (mData != nullptr) {
+        ArchiveHeader header;
+        std::memcpy(&header,
+                    mData,
+                    sizeof(header));
+        const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(mData + sizeof(ArchiveHeader));
+        for (uint32_t i = 0; i < header.mEntryCount; ++i) {
+            const ArchiveEntry& entry = entries[i];
+            ArchivedShader shader;
+            shader.mPathHash = entry.mPathHash;
+            shader.mPath.assign(reinterpret_cast<const char*>(mData + entry.mPathOffset),
+                                entry.mPathSize);
+            shader.mByteCode.assign(mData + entry.mByteCodeOffset,
+                                    mData + entry.mByteCodeOffset + entry.mByteCodeSize);
+            shader.mSourceSize = entry.mSourceSize;
+            shader.mSourceModificationTime = entry.mSourceModificationTime;
+            shaders.emplace_back(std::move(shader));
+        }
+    }
+
+    // Added shaders replace the archived ones, as their
+    // files can be newer (Read ShaderWatcher).
+    for (const std::string& path : mAddedShaderByteCodePaths) {
+        ArchivedShader shader;
+        shader.mPathHash = pathHash(path.c_str(),
+                                    path.size());
+        shader.mPath = path;
+        // The status is read before the file, so a change during the read
+        // is detected in the next run.
+        if (file_system::readFileStatus(path,
+                                        shader.mSourceSize,
+                                        shader.mSourceModificationTime) == false) {
+            continue;
+        }
+        shader.mByteCode = file_system::readFile(path);
+        if (isValidSpirv(shader.mByteCode.data(),
+                         shader.mByteCode.size()) == false) {
+            continue;
+        }
+
+        std::vector<ArchivedShader>::iterator findIt =
+            std::find_if(shaders.begin(),
+                         shaders.end(),
+                         [&path](const ArchivedShader& archivedShader) {
+                             return archivedShader.mPath == path;
+                         });
+        if (findIt != shaders.end()) {
+            *findIt = std::move(shader);
+        } else {
+            shaders.emplace_back(std::move(shader));
+        }
+    }
+
+    std::sort(shaders.begin(),
+              shaders.end(),
+              [](const ArchivedShader& a, const ArchivedShader& b) {
+                  return a.mPathHash < b.mPathHash || (a.mPathHash == b.mPathHash && a.mPath < b.mPath);
+              });
+
+    // Layout: header, table of contents, paths and byte code.
+    uint32_t offset = static_cast<uint32_t>(sizeof(ArchiveHeader) + shaders.size() * sizeof(ArchiveEntry));
+    std::vector<ArchiveEntry> entries(shaders.size());
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        entries[i].mPathHash = shaders[i].mPathHash;
+        entries[i].mPathOffset = offset;
+        entries[i].mPathSize = static_cast<uint32_t>(shaders[i].mPath.size());
+        entries[i].mSourceSize = shaders[i].mSourceSize;
+        entries[i].mSourceModificationTime = shaders[i].mSourceModificationTime;
+        offset += entries[i].mPathSize;
+    }
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        offset = alignTo4(offset);
+        entries[i].mByteCodeOffset = offset;
+        entries[i].mByteCodeSize = static_cast<uint32_t>(shaders[i].mByteCode.size());
+        offset += entries[i].mByteCodeSize;
+    }
+
+    std::vector<uint8_t> data(offset, 0);
+
+    ArchiveHeader header;
+    header.mMagic = sArchiveMagic;
+    header.mVersion = sArchiveVersion;
+    header.mEntryCount = static_cast<uint32_t>(shaders.size());
+    header.mReserved = 0;
+    std::memcpy(data.data(),
+                &header,
+                sizeof(header));
+
+    for (size_t i = 0; i < shaders.size(); ++i) {
+        std::memcpy(data.data() + sizeof(ArchiveHeader) + i * sizeof(ArchiveEntry),
+                    &entries[i],
+                    sizeof(ArchiveEntry));
+        std::memcpy(data.data() + entries[i].mPathOffset,
+                    shaders[i].mPath.data(),
+                    entries[i].mPathSize);
+        std::memcpy(data.data() + entries[i].mByteCodeOffset,
+                    shaders[i].mByteCode.data(),
+                    entries[i].mByteCodeSize);
+    }
+
+    return data;
+}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef UTILS_SHADER_SHADER_ARCHIVE
+#define UTILS_SHADER_SHADER_ARCHIVE
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vulkan {
+class MappedFile;
+
+//
+// Global archive of SPIR-V byte code, in a single memory mapped file.
+//
+// Loading each shader from its own file costs an open, a read and a copy
+// per shader. The archive is mapped once, and the byte code of every shader is
+// used directly from the mapping (ShaderModuleSystem resolves the paths
+// with findByteCode()), so hundreds of shaders are loaded without
+// per file system calls nor copies.
+//
+// File format (little endian):
+// - Header: magic "VKSA", version, entry count, reserved.
+// - Table of contents: an entry per shader, sorted by the hash of its path
+//   (path hash, path offset and size, byte code offset and size, and size and
+//   modification time of the shader file), so a path is found with a binary search.
+// - Paths.
+// - Byte code of each shader, aligned to 4 bytes (SPIR-V is a stream of words).
+//
+// The archive is built by the application itself: the shaders that are
+// not in the archive are loaded from their files, and finalize() writes a new
+// archive with all of them (to a temporary file that then replaces the previous one).
+//
+// Shader files are only checked if it is initialized with checkShaderFiles
+// (with --hot-reload, when they are expected to change), because the check costs
+// a file system call per shader. Then, if the size or the modification time of
+// a shader file changed since it was archived, findByteCode() ignores the archived
+// byte code, so the shader is loaded from its file and its entry is rewritten in
+// finalize(). A shader whose file does not exist is always used from the archive.
+// Otherwise, the archive must be deleted when the shaders are rebuilt.
+//
+class ShaderArchive {
+public:
+    // * filePath of the archive. It does not need to exist.
+    //   If it is not valid, then it is ignored (and rebuilt in finalize()).
+    // * checkShaderFiles. If it is true, then archived shaders whose files
+    //   changed are not used.
+    static void
+    initialize(const std::string& filePath,
+               const bool checkShaderFiles = false);
+
+    // Unmaps the archive, and rewrites it if shaders were added.
+    static void
+    finalize();
+
+    // Returns true and sets byteCode (that lives until finalize()) and
+    // byteCodeSize (in bytes) if shaderByteCodePath is in the archive,
+    // its byte code is valid SPIR-V, and its file did not change since it was archived
+    // (only checked with checkShaderFiles).
+    static bool
+    findByteCode(const std::string& shaderByteCodePath,
+                 const uint32_t*& byteCode,
+                 size_t& byteCodeSize);
+
+    // The shader of shaderByteCodePath (loaded from its file)
+    // is added to the archive in finalize(), replacing the archived one.
+    static void
+    addShaderByteCodePath(const std::string& shaderByteCodePath);
+
+private:
+    ShaderArchive() = delete;
+    ~ShaderArchive() = delete;
+    ShaderArchive(ShaderArchive&&) noexcept = delete;
+    ShaderArchive(const ShaderArchive&) = delete;
+    const ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+    static bool
+    map(const std::string& filePath);
+
+    static void
+    unmap();
+
+    // Checks the header and the table of contents of the mapped archive.
+    static bool
+    isValidArchive();
+
+    // Serialized archive with the byte code of every shader in the mapped archive,
+    // plus the added ones.
+    static std::vector<uint8_t>
+    buildArchive();
+
+    static std::string mFilePath;
+    static bool mCheckShaderFiles;
+
+    static std::unique_ptr<MappedFile> mMappedFile;
+    // Data and size of mMappedFile (nullptr and 0 if the archive is not mapped).
+    static const uint8_t* mData;
+    static size_t mSize;
+
+    static std::vector<std::string> mAddedShaderByteCodePaths;
+};
+}
+
+#endif
@@ -17,11 +17,24 @@ ShaderModule::ShaderModule(const std::string& shaderByteCodePath,
     assert(entryPointName != nullptr);
 
     const std::vector<char> shaderByteCode = readFile(mShaderByteCodePath);
+    createShaderModule(reinterpret_cast<const uint32_t*>(shaderByteCode.data()),
+                       shaderByteCode.size());
+}
 
-    vk::ShaderModuleCreateInfo info;
-    info.setCodeSize(shaderByteCode.size());
-    info.setPCode(reinterpret_cast<const uint32_t*>(shaderByteCode.data()));
-    mShaderModule = LogicalDevice::device().createShaderModuleUnique(info);
+ShaderModule::ShaderModule(const std::string& shaderByteCodePath,
+                           const uint32_t* byteCode,
+                           const size_t byteCodeSize,
+                           const vk::ShaderStageFlagBits shaderStageFlag,
+                           const char* entryPointName)
+    : mShaderStageFlag(shaderStageFlag)
+    , mShaderByteCodePath(shaderByteCodePath)
+    , mEntryPointName(entryPointName)
+{
+    assert(byteCode != nullptr);
+    assert(entryPointName != nullptr);
+
+    createShaderModule(byteCode,
+                       byteCodeSize);
 }
 
 const std::string& 
@@ -45,7 +58,13 @@ ShaderModule::module() const {
 const char*
 ShaderModule::entryPointName() const {
     assert(mShaderModule.get() != VK_NULL_HANDLE);
-    return mEntryPointName;
+    return mEntryPointName.c_str();
+}
+
+const ShaderReflection&
+ShaderModule::reflection() const {
+    assert(mReflection != nullptr);
+    return *mReflection;
 }
 
 std::vector<char>
@@ -61,4 +80,20 @@ ShaderModule::readFile(const std::string& filename) {
 
     return buffer;
 }
+
+void
+ShaderModule::createShaderModule(const uint32_t* byteCode,
+                                 const size_t byteCodeSize) {
+    assert(mShaderModule.get() == VK_NULL_HANDLE);
+    assert(byteCodeSize > 0 && byteCodeSize % sizeof(uint32_t) == 0);
+
+    vk::ShaderModuleCreateInfo info;
+    info.setCodeSize(byteCodeSize);
+    info.setPCode(byteCode);
+    mShaderModule = LogicalDevice::device().createShaderModuleUnique(info);
+
+    mReflection.reset(new ShaderReflection(byteCode,
+                                           byteCodeSize,
+                                           mShaderStageFlag));
+}
 }
\ No newline at end of file
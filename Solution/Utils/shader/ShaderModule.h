@@ -1,10 +1,14 @@
 #ifndef UTILS_SHADER_SHADER_MODULE
 #define UTILS_SHADER_SHADER_MODULE
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "ShaderReflection.h"
+
 namespace vulkan {
 //
 // ShaderModule wrapper.
@@ -53,6 +57,16 @@ public:
     ShaderModule(const std::string& shaderByteCodePath,
                  const vk::ShaderStageFlagBits shaderStageFlag,
                  const char* entryPointName = "main");
+
+    // * byteCode in SPIR-V format (for example, from the ShaderArchive).
+    //   byteCodeSize is in bytes. It is not used after the constructor.
+    //
+    // * shaderByteCodePath identifies the shader, but it is not read.
+    ShaderModule(const std::string& shaderByteCodePath,
+                 const uint32_t* byteCode,
+                 const size_t byteCodeSize,
+                 const vk::ShaderStageFlagBits shaderStageFlag,
+                 const char* entryPointName = "main");
     ShaderModule(const ShaderModule&) = delete;
     const ShaderModule& operator=(const ShaderModule&) = delete;
 
@@ -68,14 +82,26 @@ public:
     const char* 
     entryPointName() const;
 
+    // Resources used by the shader, reflected from its byte code.
+    const ShaderReflection&
+    reflection() const;
+
 private:
     static std::vector<char> 
     readFile(const std::string& shaderByteCodePath);
 
+    void
+    createShaderModule(const uint32_t* byteCode,
+                       const size_t byteCodeSize);
+
     vk::ShaderStageFlagBits mShaderStageFlag;
     std::string mShaderByteCodePath;
     vk::UniqueShaderModule mShaderModule;
-    const char* mEntryPointName = nullptr;
+
+    // It is copied, so entryPointName does not need to outlive this instance.
+    std::string mEntryPointName;
+
+    std::unique_ptr<ShaderReflection> mReflection;
 };
 }
 
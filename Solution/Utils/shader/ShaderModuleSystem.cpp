@@ -2,11 +2,18 @@
 
 #include <cassert>
 #include <cstring>
+#include <iostream>
+
+#include "ShaderArchive.h"
+#include "ShaderWatcher.h"
 
 namespace vulkan {
 ShaderModuleSystem::ShaderModuleByPath 
 ShaderModuleSystem::mShaderModuleByPath = {};
 
+std::vector<const ShaderModule*>
+ShaderModuleSystem::mReplacedShaderModules = {};
+
 const ShaderModule&
 ShaderModuleSystem::getOrLoadShaderModule(const std::string& shaderByteCodePath,
                                           const vk::ShaderStageFlagBits shaderStageFlag,
@@ -21,9 +28,29 @@ ShaderModuleSystem::getOrLoadShaderModule(const std::string& shaderByteCodePath,
         assert(strcmp(entryPointName, shaderModule->entryPointName()) == 0);
         assert(shaderStageFlag == shaderModule->shaderStageFlag());
     } else {
-        shaderModule = new ShaderModule(shaderByteCodePath,
-                                        shaderStageFlag,
-                                        entryPointName);
+        // The byte code is used from the archive mapping if it is there (and
+        // its file did not change, with hot reload). Otherwise, it is read from
+        // its file, and added to the archive.
+        const uint32_t* byteCode = nullptr;
+        size_t byteCodeSize = 0;
+        if (ShaderArchive::findByteCode(shaderByteCodePath,
+                                        byteCode,
+                                        byteCodeSize)) {
+            shaderModule = new ShaderModule(shaderByteCodePath,
+                                            byteCode,
+                                            byteCodeSize,
+                                            shaderStageFlag,
+                                            entryPointName);
+        } else {
+            shaderModule = new ShaderModule(shaderByteCodePath,
+                                            shaderStageFlag,
+                                            entryPointName);
+            ShaderArchive::addShaderByteCodePath(shaderByteCodePath);
+        }
+
+        if (ShaderWatcher::isEnabled()) {
+            ShaderWatcher::watch(*shaderModule);
+        }
 
         mShaderModuleByPath[shaderByteCodePath] = shaderModule;
     }
@@ -44,10 +71,46 @@ ShaderModuleSystem::eraseShaderModule(const std::string& shaderByteCodePath) {
     }
 }
 
+std::vector<ShaderModuleSystem::ReloadedShaderModule>
+ShaderModuleSystem::reloadChangedShaderModules() {
+    std::vector<ReloadedShaderModule> reloadedShaderModules;
+    if (ShaderWatcher::isEnabled() == false) {
+        return reloadedShaderModules;
+    }
+
+    for (std::unique_ptr<ShaderModule>& shaderModule : ShaderWatcher::takeReloadedShaderModules()) {
+        // The shader module could have been erased while it was reloaded.
+        ShaderModuleByPath::iterator findIt = mShaderModuleByPath.find(shaderModule->shaderByteCodePath());
+        if (findIt == mShaderModuleByPath.end()) {
+            continue;
+        }
+
+        std::cout << "Shader " << shaderModule->shaderByteCodePath() << " reloaded" << std::endl;
+
+        ReloadedShaderModule reloadedShaderModule;
+        reloadedShaderModule.mOldShaderModule = findIt->second;
+        reloadedShaderModule.mNewShaderModule = shaderModule.release();
+        reloadedShaderModules.push_back(reloadedShaderModule);
+
+        mReplacedShaderModules.push_back(findIt->second);
+        findIt->second = reloadedShaderModule.mNewShaderModule;
+
+        // The archived byte code is outdated.
+        ShaderArchive::addShaderByteCodePath(findIt->first);
+    }
+
+    return reloadedShaderModules;
+}
+
 void 
 ShaderModuleSystem::clear() {
     for (const auto& pathAndShaderModule : mShaderModuleByPath) {
         delete pathAndShaderModule.second;
     }
+
+    for (const ShaderModule* shaderModule : mReplacedShaderModules) {
+        delete shaderModule;
+    }
+    mReplacedShaderModules.clear();
 }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define UTILS_SHADER_SHADER_MODULE_SYSTEM
 
 #include <unordered_map>
+#include <vector>
 
 #include "ShaderModule.h"
 
@@ -17,6 +18,19 @@ public:
     static void
     eraseShaderModule(const std::string& shaderByteCodePath);
 
+    struct ReloadedShaderModule {
+        const ShaderModule* mOldShaderModule;
+        const ShaderModule* mNewShaderModule;
+    };
+
+    // Replaces the shader modules whose files changed by the ones that
+    // the ShaderWatcher created, so the next getOrLoadShaderModule() calls
+    // return the new ones.
+    // The old ones are kept until clear(), because they can be used by
+    // pipelines that are being compiled.
+    static std::vector<ReloadedShaderModule>
+    reloadChangedShaderModules();
+
     static void 
     clear();
 
@@ -29,6 +43,8 @@ private:
 
     using ShaderModuleByPath = std::unordered_map<std::string, const ShaderModule*>;
     static ShaderModuleByPath mShaderModuleByPath;
+
+    static std::vector<const ShaderModule*> mReplacedShaderModules;
 };
 }
 
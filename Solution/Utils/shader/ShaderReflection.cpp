@@ -0,0 +1,428 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+// SPIR-V specification values used by the reflection
+// (they are not included, to avoid depending on the SPIR-V headers).
+const uint32_t sSpirvMagicNumber = 0x07230203;
+const uint32_t sSpirvHeaderWordCount = 5;
+
+const uint32_t sOpDecorate = 71;
+const uint32_t sOpMemberDecorate = 72;
+const uint32_t sOpTypeBool = 20;
+const uint32_t sOpTypeInt = 21;
+const uint32_t sOpTypeFloat = 22;
+const uint32_t sOpTypeVector = 23;
+const uint32_t sOpTypeMatrix = 24;
+const uint32_t sOpTypeImage = 25;
+const uint32_t sOpTypeSampler = 26;
+const uint32_t sOpTypeSampledImage = 27;
+const uint32_t sOpTypeArray = 28;
+const uint32_t sOpTypeRuntimeArray = 29;
+const uint32_t sOpTypeStruct = 30;
+const uint32_t sOpTypePointer = 32;
+const uint32_t sOpConstant = 43;
+const uint32_t sOpSpecConstantTrue = 48;
+const uint32_t sOpSpecConstantFalse = 49;
+const uint32_t sOpSpecConstant = 50;
+const uint32_t sOpVariable = 59;
+
+const uint32_t sDecorationSpecId = 1;
+const uint32_t sDecorationBlock = 2;
+const uint32_t sDecorationBufferBlock = 3;
+const uint32_t sDecorationArrayStride = 6;
+const uint32_t sDecorationMatrixStride = 7;
+const uint32_t sDecorationBuiltIn = 11;
+const uint32_t sDecorationLocation = 30;
+const uint32_t sDecorationBinding = 33;
+const uint32_t sDecorationDescriptorSet = 34;
+const uint32_t sDecorationOffset = 35;
+
+const uint32_t sStorageClassUniformConstant = 0;
+const uint32_t sStorageClassInput = 1;
+const uint32_t sStorageClassUniform = 2;
+const uint32_t sStorageClassPushConstant = 9;
+const uint32_t sStorageClassStorageBuffer = 12;
+
+const uint32_t sDimBuffer = 5;
+const uint32_t sDimSubpassData = 6;
+}
+
+namespace vulkan {
+ShaderReflection::ShaderReflection(const uint32_t* byteCode,
+                                   const size_t byteCodeSize,
+                                   const vk::ShaderStageFlagBits shaderStageFlag)
+    : mShaderStageFlag(shaderStageFlag)
+{
+    assert(byteCode != nullptr);
+    assert(byteCodeSize % sizeof(uint32_t) == 0);
+
+    parse(byteCode,
+          byteCodeSize / sizeof(uint32_t));
+
+    // The parsing state is not needed anymore.
+    mTypes.clear();
+    mDecorations.clear();
+    mMemberDecorations.clear();
+    mConstantValues.clear();
+}
+
+vk::ShaderStageFlagBits
+ShaderReflection::shaderStageFlag() const {
+    return mShaderStageFlag;
+}
+
+const std::vector<ShaderReflection::DescriptorBinding>&
+ShaderReflection::descriptorBindings() const {
+    return mDescriptorBindings;
+}
+
+uint32_t
+ShaderReflection::pushConstantSize() const {
+    return mPushConstantSize;
+}
+
+const std::vector<ShaderReflection::SpecializationConstant>&
+ShaderReflection::specializationConstants() const {
+    return mSpecializationConstants;
+}
+
+const std::vector<ShaderReflection::InputVariable>&
+ShaderReflection::inputVariables() const {
+    return mInputVariables;
+}
+
+void
+ShaderReflection::parse(const uint32_t* words,
+                        const size_t moduleWordCount) {
+    assert(moduleWordCount >= sSpirvHeaderWordCount);
+    assert(words[0] == sSpirvMagicNumber);
+
+    // In a SPIR-V module, decorations are declared before types, constants and
+    // variables, and types before the instructions that use them,
+    // so a single pass is enough.
+    size_t offset = sSpirvHeaderWordCount;
+    while (offset < moduleWordCount) {
+        const uint32_t wordCount = words[offset] >> 16;
+        const uint32_t opcode = words[offset] & 0xFFFF;
+        assert(wordCount > 0 && offset + wordCount <= moduleWordCount);
+        const uint32_t* operands = &words[offset + 1];
+        const uint32_t operandCount = wordCount - 1;
+
+        switch (opcode) {
+        case sOpDecorate:
+        {
+            assert(operandCount >= 2);
+            Decorations& decorations = mDecorations[operands[0]];
+            const uint32_t value = operandCount >= 3 ? operands[2] : 0;
+            switch (operands[1]) {
+            case sDecorationSpecId: decorations.mHasSpecId = true; decorations.mSpecId = value; break;
+            case sDecorationBlock: decorations.mIsBlock = true; break;
+            case sDecorationBufferBlock: decorations.mIsBufferBlock = true; break;
+            case sDecorationArrayStride: decorations.mArrayStride = value; break;
+            case sDecorationBuiltIn: decorations.mIsBuiltIn = true; break;
+            case sDecorationLocation: decorations.mHasLocation = true; decorations.mLocation = value; break;
+            case sDecorationBinding: decorations.mHasBinding = true; decorations.mBinding = value; break;
+            case sDecorationDescriptorSet: decorations.mSet = value; break;
+            default: break;
+            }
+            break;
+        }
+
+        case sOpMemberDecorate:
+        {
+            assert(operandCount >= 3);
+            std::vector<Decorations>& memberDecorations = mMemberDecorations[operands[0]];
+            if (memberDecorations.size() <= operands[1]) {
+                memberDecorations.resize(operands[1] + 1);
+            }
+            Decorations& decorations = memberDecorations[operands[1]];
+            const uint32_t value = operandCount >= 4 ? operands[3] : 0;
+            switch (operands[2]) {
+            case sDecorationOffset: decorations.mOffset = value; break;
+            case sDecorationMatrixStride: decorations.mMatrixStride = value; break;
+            case sDecorationBuiltIn: decorations.mIsBuiltIn = true; break;
+            default: break;
+            }
+            break;
+        }
+
+        case sOpTypeBool:
+        case sOpTypeInt:
+        case sOpTypeFloat:
+        case sOpTypeVector:
+        case sOpTypeMatrix:
+        case sOpTypeImage:
+        case sOpTypeSampler:
+        case sOpTypeSampledImage:
+        case sOpTypeArray:
+        case sOpTypeRuntimeArray:
+        case sOpTypeStruct:
+        case sOpTypePointer:
+        {
+            assert(operandCount >= 1);
+            Type& type = mTypes[operands[0]];
+            type.mOpcode = opcode;
+            type.mOperands.assign(operands + 1,
+                                  operands + operandCount);
+            break;
+        }
+
+        case sOpConstant:
+            // Array lengths are constants. Only 32 bits values are needed.
+            assert(operandCount >= 3);
+            mConstantValues[operands[1]] = operands[2];
+            break;
+
+        case sOpSpecConstantTrue:
+        case sOpSpecConstantFalse:
+        case sOpSpecConstant:
+        {
+            assert(operandCount >= 2);
+            const Decorations& decorations = mDecorations[operands[1]];
+            if (decorations.mHasSpecId) {
+                SpecializationConstant constant;
+                constant.mConstantId = decorations.mSpecId;
+                // Booleans are VkBool32 in the specialization data.
+                constant.mSize = opcode == sOpSpecConstant ? typeSize(operands[0]) : sizeof(vk::Bool32);
+                mSpecializationConstants.push_back(constant);
+            }
+            if (opcode == sOpSpecConstant) {
+                mConstantValues[operands[1]] = operands[2];
+            }
+            break;
+        }
+
+        case sOpVariable:
+            assert(operandCount >= 3);
+            addVariable(operands[1],
+                        operands[0],
+                        operands[2]);
+            break;
+
+        default:
+            break;
+        }
+
+        offset += wordCount;
+    }
+
+    std::sort(mInputVariables.begin(),
+              mInputVariables.end(),
+              [](const InputVariable& a, const InputVariable& b) {
+                  return a.mLocation < b.mLocation;
+              });
+}
+
+void
+ShaderReflection::addVariable(const uint32_t variableId,
+                              const uint32_t pointerTypeId,
+                              const uint32_t storageClass) {
+    const Type& pointerType = mTypes[pointerTypeId];
+    assert(pointerType.mOpcode == sOpTypePointer);
+    const uint32_t typeId = pointerType.mOperands[1];
+    const Decorations& decorations = mDecorations[variableId];
+
+    switch (storageClass) {
+    case sStorageClassUniformConstant:
+    case sStorageClassUniform:
+    case sStorageClassStorageBuffer:
+    {
+        if (decorations.mHasBinding == false) {
+            return;
+        }
+
+        DescriptorBinding binding;
+        binding.mSet = decorations.mSet;
+        binding.mBinding = decorations.mBinding;
+
+        // Arrays of descriptors
+        uint32_t elementTypeId = typeId;
+        const Type& type = mTypes[typeId];
+        if (type.mOpcode == sOpTypeArray) {
+            elementTypeId = type.mOperands[0];
+            binding.mCount = constantValue(type.mOperands[1]);
+        } else if (type.mOpcode == sOpTypeRuntimeArray) {
+            elementTypeId = type.mOperands[0];
+        }
+
+        binding.mType = descriptorType(elementTypeId,
+                                       storageClass);
+        mDescriptorBindings.push_back(binding);
+        break;
+    }
+
+    case sStorageClassPushConstant:
+        mPushConstantSize = std::max(mPushConstantSize,
+                                     typeSize(typeId));
+        break;
+
+    case sStorageClassInput:
+    {
+        // Built-in inputs (like gl_VertexIndex) are not vertex attributes.
+        if (mShaderStageFlag != vk::ShaderStageFlagBits::eVertex ||
+            decorations.mHasLocation == false ||
+            decorations.mIsBuiltIn) {
+            return;
+        }
+
+        InputVariable variable;
+        variable.mLocation = decorations.mLocation;
+        variable.mFormat = inputFormat(typeId);
+        variable.mSize = typeSize(typeId);
+        assert(variable.mFormat != vk::Format::eUndefined && "Unsupported vertex input type");
+        mInputVariables.push_back(variable);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+vk::DescriptorType
+ShaderReflection::descriptorType(const uint32_t typeId,
+                                 const uint32_t storageClass) const {
+    const Type& type = mTypes.at(typeId);
+
+    if (storageClass == sStorageClassStorageBuffer) {
+        return vk::DescriptorType::eStorageBuffer;
+    }
+
+    if (storageClass == sStorageClassUniform) {
+        // Before SPIR-V 1.3, storage buffers are uniform blocks decorated as BufferBlock.
+        std::unordered_map<uint32_t, Decorations>::const_iterator findIt = mDecorations.find(typeId);
+        const bool isBufferBlock = findIt != mDecorations.end() && findIt->second.mIsBufferBlock;
+        return isBufferBlock ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+    }
+
+    switch (type.mOpcode) {
+    case sOpTypeSampledImage:
+        return vk::DescriptorType::eCombinedImageSampler;
+
+    case sOpTypeSampler:
+        return vk::DescriptorType::eSampler;
+
+    case sOpTypeImage:
+    {
+        // Operands: sampled type, dim, depth, arrayed, multisampled, sampled, format
+        const uint32_t dim = type.mOperands[1];
+        const bool isSampled = type.mOperands[5] == 1;
+        if (dim == sDimBuffer) {
+            return isSampled ? vk::DescriptorType::eUniformTexelBuffer : vk::DescriptorType::eStorageTexelBuffer;
+        } else if (dim == sDimSubpassData) {
+            return vk::DescriptorType::eInputAttachment;
+        } else {
+            return isSampled ? vk::DescriptorType::eSampledImage : vk::DescriptorType::eStorageImage;
+        }
+    }
+
+    default:
+        assert(false && "Unsupported descriptor type");
+        return vk::DescriptorType::eUniformBuffer;
+    }
+}
+
+uint32_t
+ShaderReflection::typeSize(const uint32_t typeId) const {
+    const Type& type = mTypes.at(typeId);
+
+    switch (type.mOpcode) {
+    case sOpTypeBool:
+        return sizeof(vk::Bool32);
+
+    case sOpTypeInt:
+    case sOpTypeFloat:
+        return type.mOperands[0] / 8;
+
+    case sOpTypeVector:
+        return typeSize(type.mOperands[0]) * type.mOperands[1];
+
+    case sOpTypeMatrix:
+        return typeSize(type.mOperands[0]) * type.mOperands[1];
+
+    case sOpTypeArray:
+    {
+        std::unordered_map<uint32_t, Decorations>::const_iterator findIt = mDecorations.find(typeId);
+        const uint32_t arrayStride = findIt != mDecorations.end() ? findIt->second.mArrayStride : 0;
+        const uint32_t elementSize = arrayStride > 0 ? arrayStride : typeSize(type.mOperands[0]);
+        return elementSize * constantValue(type.mOperands[1]);
+    }
+
+    case sOpTypeStruct:
+    {
+        // The size of a block is the end of its last member.
+        std::unordered_map<uint32_t, std::vector<Decorations>>::const_iterator findIt = mMemberDecorations.find(typeId);
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < type.mOperands.size(); ++i) {
+            uint32_t memberOffset = 0;
+            uint32_t memberSize = typeSize(type.mOperands[i]);
+            if (findIt != mMemberDecorations.end() && i < findIt->second.size()) {
+                const Decorations& memberDecorations = findIt->second[i];
+                memberOffset = memberDecorations.mOffset;
+
+                // Matrix columns can be padded (for example, mat3 in std140).
+                const Type& memberType = mTypes.at(type.mOperands[i]);
+                if (memberType.mOpcode == sOpTypeMatrix && memberDecorations.mMatrixStride > 0) {
+                    memberSize = memberDecorations.mMatrixStride * memberType.mOperands[1];
+                }
+            }
+            size = std::max(size,
+                            memberOffset + memberSize);
+        }
+        return size;
+    }
+
+    default:
+        // Runtime arrays, images and samplers do not have a size.
+        return 0;
+    }
+}
+
+vk::Format
+ShaderReflection::inputFormat(const uint32_t typeId) const {
+    const Type& type = mTypes.at(typeId);
+
+    uint32_t componentTypeId = typeId;
+    uint32_t componentCount = 1;
+    if (type.mOpcode == sOpTypeVector) {
+        componentTypeId = type.mOperands[0];
+        componentCount = type.mOperands[1];
+    }
+
+    const Type& componentType = mTypes.at(componentTypeId);
+    if (componentType.mOperands.empty() || componentType.mOperands[0] != 32) {
+        return vk::Format::eUndefined;
+    }
+
+    if (componentType.mOpcode == sOpTypeFloat) {
+        const vk::Format formats[] = {vk::Format::eR32Sfloat,
+                                      vk::Format::eR32G32Sfloat,
+                                      vk::Format::eR32G32B32Sfloat,
+                                      vk::Format::eR32G32B32A32Sfloat};
+        return formats[componentCount - 1];
+    } else if (componentType.mOpcode == sOpTypeInt) {
+        const bool isSigned = componentType.mOperands[1] == 1;
+        const vk::Format signedFormats[] = {vk::Format::eR32Sint,
+                                            vk::Format::eR32G32Sint,
+                                            vk::Format::eR32G32B32Sint,
+                                            vk::Format::eR32G32B32A32Sint};
+        const vk::Format unsignedFormats[] = {vk::Format::eR32Uint,
+                                              vk::Format::eR32G32Uint,
+                                              vk::Format::eR32G32B32Uint,
+                                              vk::Format::eR32G32B32A32Uint};
+        return isSigned ? signedFormats[componentCount - 1] : unsignedFormats[componentCount - 1];
+    }
+
+    return vk::Format::eUndefined;
+}
+
+uint32_t
+ShaderReflection::constantValue(const uint32_t constantId) const {
+    std::unordered_map<uint32_t, uint32_t>::const_iterator findIt = mConstantValues.find(constantId);
+    assert(findIt != mConstantValues.end());
+    return findIt->second;
+}
+}
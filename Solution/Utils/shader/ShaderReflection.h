@@ -0,0 +1,134 @@
+#ifndef UTILS_SHADER_SHADER_REFLECTION
+#define UTILS_SHADER_SHADER_REFLECTION
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+//
+// Reflection of the resources that a SPIR-V shader uses.
+//
+// The SPIR-V byte code contains the type, descriptor set, binding and location
+// of every variable of the shader interface, so the descriptor set layouts,
+// push constant ranges and vertex input attributes can be built
+// from the shaders instead of writing them by hand
+// (Read PipelineSystem::getOrCreatePipelineLayout(const ShaderStages&)).
+//
+// It extracts:
+// - Descriptor bindings (set, binding, type, count).
+// - Push constant block size.
+// - Specialization constants (constant id and size).
+// - Input variables of vertex shaders (location and format).
+//
+// Notes:
+// - SPIR-V does not distinguish dynamic uniform/storage buffers, so they are
+//   reflected as non-dynamic buffers.
+// - Runtime arrays of descriptors are reflected with a count of 1.
+//
+class ShaderReflection {
+public:
+    struct DescriptorBinding {
+        uint32_t mSet = 0;
+        uint32_t mBinding = 0;
+        vk::DescriptorType mType = vk::DescriptorType::eUniformBuffer;
+        uint32_t mCount = 1;
+    };
+
+    struct SpecializationConstant {
+        uint32_t mConstantId = 0;
+        uint32_t mSize = 0;
+    };
+
+    struct InputVariable {
+        uint32_t mLocation = 0;
+        vk::Format mFormat = vk::Format::eUndefined;
+        uint32_t mSize = 0;
+    };
+
+    // * byteCode in SPIR-V format. byteCodeSize is in bytes.
+    //   It is not used after the constructor.
+    ShaderReflection(const uint32_t* byteCode,
+                     const size_t byteCodeSize,
+                     const vk::ShaderStageFlagBits shaderStageFlag);
+
+    vk::ShaderStageFlagBits
+    shaderStageFlag() const;
+
+    const std::vector<DescriptorBinding>&
+    descriptorBindings() const;
+
+    // 0 if the shader does not have a push constant block.
+    uint32_t
+    pushConstantSize() const;
+
+    const std::vector<SpecializationConstant>&
+    specializationConstants() const;
+
+    // Sorted by location. Only for vertex shaders.
+    const std::vector<InputVariable>&
+    inputVariables() const;
+
+private:
+    // Type declared by an OpType* instruction
+    struct Type {
+        uint32_t mOpcode = 0;
+        std::vector<uint32_t> mOperands;
+    };
+
+    // Decorations of an id (or of a struct member)
+    struct Decorations {
+        bool mHasBinding = false;
+        uint32_t mBinding = 0;
+        uint32_t mSet = 0;
+        bool mHasLocation = false;
+        uint32_t mLocation = 0;
+        bool mIsBuiltIn = false;
+        bool mIsBlock = false;
+        bool mIsBufferBlock = false;
+        bool mHasSpecId = false;
+        uint32_t mSpecId = 0;
+        uint32_t mOffset = 0;
+        uint32_t mArrayStride = 0;
+        uint32_t mMatrixStride = 0;
+    };
+
+    void
+    parse(const uint32_t* words,
+          const size_t moduleWordCount);
+
+    void
+    addVariable(const uint32_t variableId,
+                const uint32_t pointerTypeId,
+                const uint32_t storageClass);
+
+    vk::DescriptorType
+    descriptorType(const uint32_t typeId,
+                   const uint32_t storageClass) const;
+
+    uint32_t
+    typeSize(const uint32_t typeId) const;
+
+    vk::Format
+    inputFormat(const uint32_t typeId) const;
+
+    uint32_t
+    constantValue(const uint32_t constantId) const;
+
+    vk::ShaderStageFlagBits mShaderStageFlag;
+
+    std::vector<DescriptorBinding> mDescriptorBindings;
+    uint32_t mPushConstantSize = 0;
+    std::vector<SpecializationConstant> mSpecializationConstants;
+    std::vector<InputVariable> mInputVariables;
+
+    // Parsing state, by result id
+    std::unordered_map<uint32_t, Type> mTypes;
+    std::unordered_map<uint32_t, Decorations> mDecorations;
+    std::unordered_map<uint32_t, std::vector<Decorations>> mMemberDecorations;
+    std::unordered_map<uint32_t, uint32_t> mConstantValues;
+};
+}
+
+#endif
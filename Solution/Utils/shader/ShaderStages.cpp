@@ -1,8 +1,34 @@
 #include "ShaderStages.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 #include "ShaderModule.h"
 
 namespace vulkan {
+ShaderStages::ShaderStages(const ShaderStages& shaderStages)
+    : mCreateInfoVec(shaderStages.mCreateInfoVec)
+    , mShaderModules(shaderStages.mShaderModules)
+    , mSpecializations(shaderStages.mSpecializations)
+{
+    updateSpecializationInfos();
+}
+
+const ShaderStages&
+ShaderStages::operator=(const ShaderStages& shaderStages) {
+    if (this == &shaderStages) {
+        return *this;
+    }
+
+    mCreateInfoVec = shaderStages.mCreateInfoVec;
+    mShaderModules = shaderStages.mShaderModules;
+    mSpecializations = shaderStages.mSpecializations;
+    updateSpecializationInfos();
+
+    return *this;
+}
+
 void
 ShaderStages::addShaderModule(const ShaderModule& shaderModule) {
     vk::PipelineShaderStageCreateInfo info;
@@ -10,10 +36,209 @@ ShaderStages::addShaderModule(const ShaderModule& shaderModule) {
     info.setPName(shaderModule.entryPointName());
     info.setStage(shaderModule.shaderStageFlag());
     mCreateInfoVec.emplace_back(info);
+    mShaderModules.emplace_back(&shaderModule);
+    mSpecializations.emplace_back();
+    updateSpecializationInfos();
+}
+
+void
+ShaderStages::setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                                        const uint32_t constantId,
+                                        const bool value) {
+    const VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+    setSpecializationData(shaderStageFlag,
+                          constantId,
+                          &boolValue,
+                          sizeof(boolValue));
+}
+
+void
+ShaderStages::setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                                        const uint32_t constantId,
+                                        const int32_t value) {
+    setSpecializationData(shaderStageFlag,
+                          constantId,
+                          &value,
+                          sizeof(value));
+}
+
+void
+ShaderStages::setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                                        const uint32_t constantId,
+                                        const uint32_t value) {
+    setSpecializationData(shaderStageFlag,
+                          constantId,
+                          &value,
+                          sizeof(value));
+}
+
+void
+ShaderStages::setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                                        const uint32_t constantId,
+                                        const float value) {
+    setSpecializationData(shaderStageFlag,
+                          constantId,
+                          &value,
+                          sizeof(value));
+}
+
+bool
+ShaderStages::replaceShaderModule(const ShaderModule& oldShaderModule,
+                                  const ShaderModule& newShaderModule) {
+    assert(oldShaderModule.shaderStageFlag() == newShaderModule.shaderStageFlag());
+
+    bool isReplaced = false;
+    for (size_t i = 0; i < mShaderModules.size(); ++i) {
+        if (mShaderModules[i] == &oldShaderModule) {
+            mShaderModules[i] = &newShaderModule;
+            mCreateInfoVec[i].setModule(newShaderModule.module());
+            mCreateInfoVec[i].setPName(newShaderModule.entryPointName());
+            isReplaced = true;
+        }
+    }
+
+    return isReplaced;
+}
+
+ShaderStages
+ShaderStages::stagesOf(const vk::ShaderStageFlags shaderStageFlags) const {
+    ShaderStages shaderStages;
+    for (size_t i = 0; i < mShaderModules.size(); ++i) {
+        if (shaderStageFlags & mShaderModules[i]->shaderStageFlag()) {
+            shaderStages.mCreateInfoVec.emplace_back(mCreateInfoVec[i]);
+            shaderStages.mShaderModules.emplace_back(mShaderModules[i]);
+            shaderStages.mSpecializations.emplace_back(mSpecializations[i]);
+        }
+    }
+    shaderStages.updateSpecializationInfos();
+
+    return shaderStages;
 }
 
 const std::vector<vk::PipelineShaderStageCreateInfo>&
 ShaderStages::stages() const {
     return mCreateInfoVec;
 }
+
+const std::vector<const ShaderModule*>&
+ShaderStages::shaderModules() const {
+    return mShaderModules;
+}
+
+void
+ShaderStages::vertexInputDescriptions(std::vector<vk::VertexInputBindingDescription>& bindingDescriptions,
+                                      std::vector<vk::VertexInputAttributeDescription>& attributeDescriptions) const {
+    bindingDescriptions.clear();
+    attributeDescriptions.clear();
+
+    for (const ShaderModule* shaderModule : mShaderModules) {
+        if (shaderModule->shaderStageFlag() != vk::ShaderStageFlagBits::eVertex) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (const ShaderReflection::InputVariable& inputVariable : shaderModule->reflection().inputVariables()) {
+            vk::VertexInputAttributeDescription attributeDescription;
+            attributeDescription.setBinding(0);
+            attributeDescription.setLocation(inputVariable.mLocation);
+            attributeDescription.setFormat(inputVariable.mFormat);
+            attributeDescription.setOffset(offset);
+            attributeDescriptions.emplace_back(attributeDescription);
+
+            offset += inputVariable.mSize;
+        }
+
+        if (attributeDescriptions.empty() == false) {
+            vk::VertexInputBindingDescription bindingDescription;
+            bindingDescription.setBinding(0);
+            bindingDescription.setStride(offset);
+            bindingDescription.setInputRate(vk::VertexInputRate::eVertex);
+            bindingDescriptions.emplace_back(bindingDescription);
+        }
+    }
+}
+
+void
+ShaderStages::setSpecializationData(const vk::ShaderStageFlagBits shaderStageFlag,
+                                    const uint32_t constantId,
+                                    const void* data,
+                                    const uint32_t dataSize) {
+    assert(data != nullptr);
+    assert(dataSize > 0);
+
+    std::vector<const ShaderModule*>::const_iterator moduleIt =
+        std::find_if(mShaderModules.begin(),
+                     mShaderModules.end(),
+                     [shaderStageFlag](const ShaderModule* shaderModule) {
+                         return shaderModule->shaderStageFlag() == shaderStageFlag;
+                     });
+    assert(moduleIt != mShaderModules.end() && "The stage was not added");
+
+#ifdef _DEBUG
+    const std::vector<ShaderReflection::SpecializationConstant>& constants =
+        (*moduleIt)->reflection().specializationConstants();
+    assert(std::any_of(constants.begin(),
+                       constants.end(),
+                       [constantId, dataSize](const ShaderReflection::SpecializationConstant& constant) {
+                           return constant.mConstantId == constantId && constant.mSize == dataSize;
+                       }) && "The shader does not declare the specialization constant with this size");
+#endif
+
+    Specialization& specialization = mSpecializations[moduleIt - mShaderModules.begin()];
+    std::vector<vk::SpecializationMapEntry>& mapEntries = specialization.mMapEntries;
+
+    std::vector<vk::SpecializationMapEntry>::iterator entryIt =
+        std::lower_bound(mapEntries.begin(),
+                         mapEntries.end(),
+                         constantId,
+                         [](const vk::SpecializationMapEntry& entry, const uint32_t constantId) {
+                             return entry.constantID < constantId;
+                         });
+
+    if (entryIt != mapEntries.end() && entryIt->constantID == constantId) {
+        assert(entryIt->size == dataSize);
+        std::memcpy(specialization.mData.data() + entryIt->offset,
+                    data,
+                    dataSize);
+    } else {
+        // The data of the constant is inserted after the data of
+        // the previous constant, and the following constants are moved.
+        const uint32_t offset = entryIt == mapEntries.end() ?
+            static_cast<uint32_t>(specialization.mData.size()) :
+            entryIt->offset;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        specialization.mData.insert(specialization.mData.begin() + offset,
+                                    bytes,
+                                    bytes + dataSize);
+
+        entryIt = mapEntries.insert(entryIt,
+                                    vk::SpecializationMapEntry(constantId,
+                                                               offset,
+                                                               dataSize));
+        for (++entryIt; entryIt != mapEntries.end(); ++entryIt) {
+            entryIt->offset += dataSize;
+        }
+    }
+
+    updateSpecializationInfos();
+}
+
+void
+ShaderStages::updateSpecializationInfos() {
+    assert(mCreateInfoVec.size() == mSpecializations.size());
+
+    for (size_t i = 0; i < mSpecializations.size(); ++i) {
+        Specialization& specialization = mSpecializations[i];
+        if (specialization.mMapEntries.empty()) {
+            mCreateInfoVec[i].setPSpecializationInfo(nullptr);
+            continue;
+        }
+
+        specialization.mInfo.setMapEntryCount(static_cast<uint32_t>(specialization.mMapEntries.size()));
+        specialization.mInfo.setPMapEntries(specialization.mMapEntries.data());
+        specialization.mInfo.setDataSize(specialization.mData.size());
+        specialization.mInfo.setPData(specialization.mData.data());
+        mCreateInfoVec[i].setPSpecializationInfo(&specialization.mInfo);
+    }
+}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#ifndef UTILS_SHADER_SHADER_STAGES
 #define UTILS_SHADER_SHADER_STAGES
 
+#include <cstdint>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
@@ -26,20 +27,100 @@ class ShaderModule;
 // (vertex, tessellation control, tessellation evaluation, geometry, fragment, or compute) 
 // do you specify the shader module plus the name of the entry point function (like “main”).
 //
+// Specialization constants (constant_id in GLSL) are set per stage, so
+// compile time variants (for example, with or without texture sampling) use
+// the same shader module, and the driver folds the constants when
+// it creates the pipeline (instead of branching at runtime).
+// They are part of the pipeline hash (Read PipelineSystem).
+//
 // You need this class to:
 // - Create the GraphicsPipeline
 //
 class ShaderStages {
 public:
+    ShaderStages() = default;
+    ShaderStages(const ShaderStages& shaderStages);
+    const ShaderStages& operator=(const ShaderStages& shaderStages);
+
     // * shaderModule (Read ShaderModule comments to understand this parameter)
     void 
     addShaderModule(const ShaderModule& shaderModule);
 
+    // Sets the value of the specialization constant with constantId
+    // of the stage of shaderStageFlag (that must have been added).
+    // Booleans are 32 bits (VkBool32) in SPIR-V.
+    //
+    // The constant must be declared by the shader, with the same size.
+    void
+    setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                              const uint32_t constantId,
+                              const bool value);
+
+    void
+    setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                              const uint32_t constantId,
+                              const int32_t value);
+
+    void
+    setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                              const uint32_t constantId,
+                              const uint32_t value);
+
+    void
+    setSpecializationConstant(const vk::ShaderStageFlagBits shaderStageFlag,
+                              const uint32_t constantId,
+                              const float value);
+
+    // Replaces oldShaderModule by newShaderModule (of the same stage),
+    // keeping its specialization constants.
+    // Returns false if oldShaderModule is not used.
+    bool
+    replaceShaderModule(const ShaderModule& oldShaderModule,
+                        const ShaderModule& newShaderModule);
+
+    // Stages of shaderStageFlags, with their specialization constants.
+    ShaderStages
+    stagesOf(const vk::ShaderStageFlags shaderStageFlags) const;
+
     const std::vector<vk::PipelineShaderStageCreateInfo>&
     stages() const;
 
+    // Shader module of each stage (in the same order)
+    const std::vector<const ShaderModule*>&
+    shaderModules() const;
+
+    // Vertex input descriptions reflected from the vertex shader inputs.
+    // Attributes are in a single binding, packed in location order
+    // (the vertex struct must have its members in the same order, without padding).
+    void
+    vertexInputDescriptions(std::vector<vk::VertexInputBindingDescription>& bindingDescriptions,
+                            std::vector<vk::VertexInputAttributeDescription>& attributeDescriptions) const;
+
 private:
+    // Specialization constants of a stage.
+    // Map entries are sorted by constant id, and their data is
+    // in the same order, so the same constants have the same
+    // specialization data (and pipeline hash) regardless of the order they were set.
+    struct Specialization {
+        std::vector<vk::SpecializationMapEntry> mMapEntries;
+        std::vector<uint8_t> mData;
+        vk::SpecializationInfo mInfo;
+    };
+
+    void
+    setSpecializationData(const vk::ShaderStageFlagBits shaderStageFlag,
+                          const uint32_t constantId,
+                          const void* data,
+                          const uint32_t dataSize);
+
+    // The create infos point to the specializations, so they
+    // must be updated when the specializations are copied or reallocated.
+    void
+    updateSpecializationInfos();
+
     std::vector<vk::PipelineShaderStageCreateInfo> mCreateInfoVec;
+    std::vector<const ShaderModule*> mShaderModules;
+    std::vector<Specialization> mSpecializations;
 };
 }
 
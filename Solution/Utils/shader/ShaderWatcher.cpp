@@ -0,0 +1,276 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "ShaderModule.h"
+
+namespace {
+const uint32_t sSpirvMagicNumber = 0x07230203;
+const size_t sSpirvHeaderWordCount = 5;
+
+// Returns an empty vector if the file does not exist or
+// it is not a SPIR-V module.
+std::vector<uint32_t>
+readSpirvFile(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+    if (file.is_open() == false) {
+        return {};
+    }
+
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize < sSpirvHeaderWordCount * sizeof(uint32_t) || fileSize % sizeof(uint32_t) != 0) {
+        return {};
+    }
+
+    std::vector<uint32_t> words(fileSize / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(words.data()), fileSize);
+    if (file.good() == false || words[0] != sSpirvMagicNumber) {
+        return {};
+    }
+
+    return words;
+}
+}
+
+namespace vulkan {
+std::thread
+ShaderWatcher::mWatcherThread;
+
+std::atomic<bool>
+ShaderWatcher::mIsFinalizing(false);
+
+std::mutex
+ShaderWatcher::mMutex;
+
+ShaderWatcher::WatchedShaderByPath
+ShaderWatcher::mWatchedShaderByPath = {};
+
+std::vector<std::unique_ptr<ShaderModule>>
+ShaderWatcher::mReloadedShaderModules;
+
+#ifdef __linux__
+int
+ShaderWatcher::mInotifyFileDescriptor = -1;
+
+ShaderWatcher::DirectoryByWatch
+ShaderWatcher::mDirectoryByWatch = {};
+#endif
+
+void
+ShaderWatcher::initialize() {
+    assert(mWatcherThread.joinable() == false);
+
+#ifdef __linux__
+    mInotifyFileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFileDescriptor == -1) {
+        std::cout << "Shader hot reload is disabled: inotify is not available" << std::endl;
+        return;
+    }
+#endif
+
+    mIsFinalizing = false;
+    mWatcherThread = std::thread(&ShaderWatcher::watcherThreadMain);
+}
+
+void
+ShaderWatcher::finalize() {
+    if (mWatcherThread.joinable()) {
+        mIsFinalizing = true;
+        mWatcherThread.join();
+    }
+
+#ifdef __linux__
+    if (mInotifyFileDescriptor != -1) {
+        close(mInotifyFileDescriptor);
+        mInotifyFileDescriptor = -1;
+    }
+    mDirectoryByWatch.clear();
+#endif
+
+    mWatchedShaderByPath.clear();
+    mReloadedShaderModules.clear();
+}
+
+bool
+ShaderWatcher::isEnabled() {
+    return mWatcherThread.joinable();
+}
+
+void
+ShaderWatcher::watch(const ShaderModule& shaderModule) {
+    assert(isEnabled());
+
+    const std::string& path = shaderModule.shaderByteCodePath();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mWatchedShaderByPath.find(path) != mWatchedShaderByPath.end()) {
+        return;
+    }
+
+    WatchedShader& watchedShader = mWatchedShaderByPath[path];
+    watchedShader.mShaderStageFlag = shaderModule.shaderStageFlag();
+    watchedShader.mEntryPointName = shaderModule.entryPointName();
+
+#ifdef __linux__
+    // The directory is watched (instead of the file), so files that are
+    // replaced (written to a new file that is renamed) are noticed too.
+    const size_t separatorPosition = path.find_last_of('/');
+    const std::string directory = separatorPosition == std::string::npos ?
+        std::string() :
+        path.substr(0, separatorPosition + 1);
+    const bool isDirectoryWatched = std::any_of(mDirectoryByWatch.begin(),
+                                                mDirectoryByWatch.end(),
+                                                [&directory](const DirectoryByWatch::value_type& watchAndDirectory) {
+                                                    return watchAndDirectory.second == directory;
+                                                });
+    if (isDirectoryWatched == false) {
+        const int watchDescriptor = inotify_add_watch(mInotifyFileDescriptor,
+                                                      directory.empty() ? "." : directory.c_str(),
+                                                      IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watchDescriptor != -1) {
+            mDirectoryByWatch[watchDescriptor] = directory;
+        }
+    }
+#else
+    struct stat fileStatus;
+    if (stat(path.c_str(), &fileStatus) == 0) {
+        watchedShader.mModificationTime = static_cast<int64_t>(fileStatus.st_mtime);
+    }
+#endif
+}
+
+std::vector<std::unique_ptr<ShaderModule>>
+ShaderWatcher::takeReloadedShaderModules() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::unique_ptr<ShaderModule>> reloadedShaderModules;
+    reloadedShaderModules.swap(mReloadedShaderModules);
+    return reloadedShaderModules;
+}
+
+void
+ShaderWatcher::watcherThreadMain() {
+    while (mIsFinalizing == false) {
+        std::vector<std::string> shaderByteCodePaths;
+#ifdef __linux__
+        readInotifyEvents(shaderByteCodePaths);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        pollModificationTimes(shaderByteCodePaths);
+#endif
+
+        // A file can be written many times in a row.
+        std::sort(shaderByteCodePaths.begin(),
+                  shaderByteCodePaths.end());
+        shaderByteCodePaths.erase(std::unique(shaderByteCodePaths.begin(),
+                                              shaderByteCodePaths.end()),
+                                  shaderByteCodePaths.end());
+
+        for (const std::string& path : shaderByteCodePaths) {
+            reloadShaderModule(path);
+        }
+    }
+}
+
+void
+ShaderWatcher::reloadShaderModule(const std::string& shaderByteCodePath) {
+    WatchedShader watchedShader;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        WatchedShaderByPath::const_iterator findIt = mWatchedShaderByPath.find(shaderByteCodePath);
+        assert(findIt != mWatchedShaderByPath.end());
+        watchedShader = findIt->second;
+    }
+
+    const std::vector<uint32_t> byteCode = readSpirvFile(shaderByteCodePath);
+    if (byteCode.empty()) {
+        std::cout << "Shader " << shaderByteCodePath << " is not valid SPIR-V, it is not reloaded" << std::endl;
+        return;
+    }
+
+    // vkCreateShaderModule can be called from any thread.
+    std::unique_ptr<ShaderModule> shaderModule(new ShaderModule(shaderByteCodePath,
+                                                                byteCode.data(),
+                                                                byteCode.size() * sizeof(uint32_t),
+                                                                watchedShader.mShaderStageFlag,
+                                                                watchedShader.mEntryPointName.c_str()));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReloadedShaderModules.emplace_back(std::move(shaderModule));
+}
+
+#ifdef __linux__
+void
+ShaderWatcher::readInotifyEvents(std::vector<std::string>& shaderByteCodePaths) {
+    // The timeout lets the thread check if it is finalizing.
+    pollfd pollDescriptor;
+    pollDescriptor.fd = mInotifyFileDescriptor;
+    pollDescriptor.events = POLLIN;
+    pollDescriptor.revents = 0;
+    if (poll(&pollDescriptor, 1, 100) <= 0) {
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    const ssize_t size = read(mInotifyFileDescriptor,
+                              buffer,
+                              sizeof(buffer));
+    if (size <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (ssize_t offset = 0; offset < size;) {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += sizeof(inotify_event) + event->len;
+
+        DirectoryByWatch::const_iterator findIt = mDirectoryByWatch.find(event->wd);
+        if (event->len == 0 || findIt == mDirectoryByWatch.end()) {
+            continue;
+        }
+
+        // Other files of the directory are not watched.
+        const std::string path = findIt->second + event->name;
+        if (mWatchedShaderByPath.find(path) != mWatchedShaderByPath.end()) {
+            shaderByteCodePaths.push_back(path);
+        }
+    }
+}
+#else
+void
+ShaderWatcher::pollModificationTimes(std::vector<std::string>& shaderByteCodePaths) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& pathAndWatchedShader : mWatchedShaderByPath) {
+        struct stat fileStatus;
+        if (stat(pathAndWatchedShader.first.c_str(), &fileStatus) != 0) {
+            continue;
+        }
+
+        // The file is reloaded in the first poll that sees the same
+        // modification time again, so its writing is probably completed.
+        WatchedShader& watchedShader = pathAndWatchedShader.second;
+        const int64_t modificationTime = static_cast<int64_t>(fileStatus.st_mtime);
+        if (modificationTime != watchedShader.mModificationTime) {
+            watchedShader.mModificationTime = modificationTime;
+            watchedShader.mIsModified = true;
+        } else if (watchedShader.mIsModified) {
+            watchedShader.mIsModified = false;
+            shaderByteCodePaths.push_back(pathAndWatchedShader.first);
+        }
+    }
+}
+#endif
+}
@@ -0,0 +1,120 @@
+#ifndef UTILS_SHADER_SHADER_WATCHER
+#define UTILS_SHADER_SHADER_WATCHER
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+class ShaderModule;
+
+//
+// File watch service for shader hot reload.
+//
+// Tuning shaders usually means editing GLSL, recompiling it to SPIR-V and
+// restarting the application, that reloads the whole scene.
+// With the watcher, a background thread notices the SPIR-V files
+// that changed, and creates their new shader modules (reading the file,
+// creating the module and reflecting it), so the main thread only swaps them
+// at a frame boundary (Read ShaderModuleSystem::reloadChangedShaderModules() and
+// PipelineSystem::updateHotReload()). Scene and asset state stay loaded.
+//
+// On Linux, the directories of the watched files are watched with inotify
+// (a file is reloaded when it is closed after writing, or moved into
+// the directory). On other platforms, the modification time of
+// each watched file is polled, and a file is reloaded once its time
+// stops changing (so files that are being written are not read).
+//
+// Opt-in: it is only initialized with the --hot-reload command line option
+// (Read system_initializer::initialize()).
+//
+// Preconditions:
+// - The global logical device must be initialized first.
+//
+class ShaderWatcher {
+public:
+    // Starts the watcher thread.
+    static void
+    initialize();
+
+    // Stops the watcher thread. Reloaded shader modules that were not
+    // taken are destroyed.
+    static void
+    finalize();
+
+    static bool
+    isEnabled();
+
+    // The file of shaderModule is watched. Its reloaded module has
+    // the same path, stage and entry point.
+    static void
+    watch(const ShaderModule& shaderModule);
+
+    // Shader modules created from the files that changed since the previous call.
+    static std::vector<std::unique_ptr<ShaderModule>>
+    takeReloadedShaderModules();
+
+private:
+    ShaderWatcher() = delete;
+    ~ShaderWatcher() = delete;
+    ShaderWatcher(ShaderWatcher&&) noexcept = delete;
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    const ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    struct WatchedShader {
+        vk::ShaderStageFlagBits mShaderStageFlag;
+        std::string mEntryPointName;
+
+        // Modification time of the last poll (only used without inotify)
+        int64_t mModificationTime = 0;
+        bool mIsModified = false;
+    };
+
+    static void
+    watcherThreadMain();
+
+    // Called by the watcher thread.
+    // It does nothing if the file is not a valid SPIR-V module.
+    static void
+    reloadShaderModule(const std::string& shaderByteCodePath);
+
+#ifdef __linux__
+    // Adds the watched shader files that changed to shaderByteCodePaths.
+    // It waits for inotify events up to 100 ms.
+    static void
+    readInotifyEvents(std::vector<std::string>& shaderByteCodePaths);
+#else
+    // Adds the shader files whose modification time
+    // changed to shaderByteCodePaths.
+    static void
+    pollModificationTimes(std::vector<std::string>& shaderByteCodePaths);
+#endif
+
+    static std::thread mWatcherThread;
+    static std::atomic<bool> mIsFinalizing;
+
+    // It protects the members below
+    static std::mutex mMutex;
+
+    using WatchedShaderByPath = std::unordered_map<std::string, WatchedShader>;
+    static WatchedShaderByPath mWatchedShaderByPath;
+
+    static std::vector<std::unique_ptr<ShaderModule>> mReloadedShaderModules;
+
+#ifdef __linux__
+    static int mInotifyFileDescriptor;
+
+    // Directory path of each inotify watch descriptor
+    using DirectoryByWatch = std::unordered_map<int, std::string>;
+    static DirectoryByWatch mDirectoryByWatch;
+#endif
+};
+}
+
+#endif
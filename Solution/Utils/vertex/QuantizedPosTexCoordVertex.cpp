@@ -0,0 +1,51 @@
+#include "QuantizedPosTexCoordVertex.h"
+
+#include "PosTexCoordVertex.h"
+#include "VertexQuantization.h"
+
+namespace vulkan {
+void
+QuantizedPosTexCoordVertex::vertexInputBindingDescriptions(std::vector<vk::VertexInputBindingDescription>& descriptions) {
+    descriptions.resize(1);
+
+    descriptions[0].binding = 0;
+    descriptions[0].stride = sizeof(QuantizedPosTexCoordVertex);
+    descriptions[0].inputRate = vk::VertexInputRate::eVertex;
+}
+
+void
+QuantizedPosTexCoordVertex::vertexInputAttributeDescriptions(std::vector<vk::VertexInputAttributeDescription>& descriptions) {
+    descriptions.resize(2);
+
+    // UNORM formats are read as floats in [0, 1] by the vertex shader.
+    descriptions[0].binding = 0;
+    descriptions[0].location = 0;
+    descriptions[0].format = vk::Format::eR16G16B16A16Unorm;
+    descriptions[0].offset = offsetof(QuantizedPosTexCoordVertex,
+                                      mPosition);
+
+    descriptions[1].binding = 0;
+    descriptions[1].location = 1;
+    descriptions[1].format = vk::Format::eR16G16Unorm;
+    descriptions[1].offset = offsetof(QuantizedPosTexCoordVertex,
+                                      mTexCoord);
+}
+
+QuantizedPosTexCoordVertex
+QuantizedPosTexCoordVertex::quantize(const PosTexCoordVertex& vertex,
+                                     const glm::vec3& boundsMin,
+                                     const glm::vec3& boundsMax) {
+    QuantizedPosTexCoordVertex quantizedVertex;
+    quantizedVertex.mPosition = vertex_quantization::quantizePosition(vertex.mPosition,
+                                                                      boundsMin,
+                                                                      boundsMax);
+    quantizedVertex.mTexCoord = vertex_quantization::quantizeTexCoord(vertex.mTexCoord);
+    return quantizedVertex;
+}
+
+bool
+QuantizedPosTexCoordVertex::operator==(const QuantizedPosTexCoordVertex& other) const {
+    return mPosition == other.mPosition &&
+           mTexCoord == other.mTexCoord;
+}
+}
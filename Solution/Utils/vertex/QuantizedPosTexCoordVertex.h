@@ -0,0 +1,38 @@
+#ifndef UTILS_VERTEX_QUANTIZED_POS_TEX_COORD_VERTEX
+#define UTILS_VERTEX_QUANTIZED_POS_TEX_COORD_VERTEX
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace vulkan {
+struct PosTexCoordVertex;
+
+// PosTexCoordVertex with quantized position and texture coordinates
+// in that order (Read vertex_quantization): 12 bytes instead of 20.
+// The vertex shader inputs are the same than with PosTexCoordVertex
+// (floats), but the positions are in [0, 1] within the bounds of the mesh.
+struct QuantizedPosTexCoordVertex {
+    // Read PosTexCoordVertex.
+    static void
+    vertexInputBindingDescriptions(std::vector<vk::VertexInputBindingDescription>& descriptions);
+
+    // Read PosTexCoordVertex.
+    static void
+    vertexInputAttributeDescriptions(std::vector<vk::VertexInputAttributeDescription>& descriptions);
+
+    static QuantizedPosTexCoordVertex
+    quantize(const PosTexCoordVertex& vertex,
+             const glm::vec3& boundsMin,
+             const glm::vec3& boundsMax);
+
+    bool
+    operator==(const QuantizedPosTexCoordVertex& other) const;
+
+    glm::u16vec4 mPosition = {0, 0, 0, 0};
+    glm::u16vec2 mTexCoord = {0, 0};
+};
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "VertexQuantization.h"
+
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+int16_t
+quantizeSnorm16(const float value) {
+    return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float
+dequantizeSnorm16(const int16_t value) {
+    return glm::max(value / 32767.0f, -1.0f);
+}
+
+// Every axis of the bounds has a non zero size,
+// so the dequantization matrix is invertible.
+glm::vec3
+boundsSize(const glm::vec3& boundsMin,
+           const glm::vec3& boundsMax) {
+    const glm::vec3 size = boundsMax - boundsMin;
+    return glm::vec3(size.x > 0.0f ? size.x : 1.0f,
+                     size.y > 0.0f ? size.y : 1.0f,
+                     size.z > 0.0f ? size.z : 1.0f);
+}
+}
+
+namespace vulkan {
+namespace vertex_quantization {
+uint16_t
+quantizeUnorm16(const float value) {
+    return static_cast<uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+glm::u16vec4
+quantizePosition(const glm::vec3& position,
+                 const glm::vec3& boundsMin,
+                 const glm::vec3& boundsMax) {
+    const glm::vec3 normalizedPosition = (position - boundsMin) / boundsSize(boundsMin, boundsMax);
+    return glm::u16vec4(quantizeUnorm16(normalizedPosition.x),
+                        quantizeUnorm16(normalizedPosition.y),
+                        quantizeUnorm16(normalizedPosition.z),
+                        0);
+}
+
+glm::u16vec2
+quantizeTexCoord(const glm::vec2& texCoord) {
+    return glm::u16vec2(quantizeUnorm16(texCoord.x),
+                        quantizeUnorm16(texCoord.y));
+}
+
+glm::i16vec2
+encodeOctahedralNormal(const glm::vec3& normal) {
+    // Projection on the octahedron |x| + |y| + |z| = 1.
+    const glm::vec3 octahedronNormal = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+    glm::vec2 encodedNormal(octahedronNormal.x, octahedronNormal.y);
+
+    // The lower half of the octahedron is folded over the upper half.
+    if (octahedronNormal.z < 0.0f) {
+        encodedNormal = glm::vec2((1.0f - std::abs(octahedronNormal.y)) * (octahedronNormal.x >= 0.0f ? 1.0f : -1.0f),
+                                  (1.0f - std::abs(octahedronNormal.x)) * (octahedronNormal.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    return glm::i16vec2(quantizeSnorm16(encodedNormal.x),
+                        quantizeSnorm16(encodedNormal.y));
+}
+
+glm::vec3
+decodeOctahedralNormal(const glm::i16vec2& encodedNormal) {
+    const glm::vec2 octahedronNormal(dequantizeSnorm16(encodedNormal.x),
+                                     dequantizeSnorm16(encodedNormal.y));
+    glm::vec3 normal(octahedronNormal.x,
+                     octahedronNormal.y,
+                     1.0f - std::abs(octahedronNormal.x) - std::abs(octahedronNormal.y));
+
+    // Unfolds the lower half of the octahedron.
+    if (normal.z < 0.0f) {
+        normal.x = (1.0f - std::abs(octahedronNormal.y)) * (octahedronNormal.x >= 0.0f ? 1.0f : -1.0f);
+        normal.y = (1.0f - std::abs(octahedronNormal.x)) * (octahedronNormal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return glm::normalize(normal);
+}
+
+glm::mat4
+dequantizationMatrix(const glm::vec3& boundsMin,
+                     const glm::vec3& boundsMax) {
+    return glm::scale(glm::translate(glm::mat4(1.0f),
+                                     boundsMin),
+                      boundsSize(boundsMin, boundsMax));
+}
+}
+}
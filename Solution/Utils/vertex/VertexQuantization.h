@@ -0,0 +1,54 @@
+#ifndef UTILS_VERTEX_VERTEX_QUANTIZATION
+#define UTILS_VERTEX_VERTEX_QUANTIZATION
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+namespace vulkan {
+//
+// Compression of vertex attributes in fewer bits, that the vertex input
+// of the pipeline expands to floats (with normalized formats like VK_FORMAT_R16G16_UNORM),
+// so the vertex shaders do not change.
+//
+// - Positions: 16 bits UNORM per coordinate, relative to the bounds of the mesh.
+//   The vertex shader gets positions in [0, 1], so the dequantization matrix
+//   (from [0, 1] to the bounds) must be folded into the model matrix.
+//   The precision is the size of the bounds / 65535 in every axis.
+//
+// - Texture coordinates: 16 bits UNORM per coordinate. They must be in [0, 1]
+//   (they are clamped otherwise).
+//
+// - Normals: 16 bits SNORM per coordinate of the octahedral encoding
+//   (the unit sphere is mapped to an octahedron, and then unfolded in a square),
+//   so a normal needs 2 coordinates instead of 3. They must be decoded in the
+//   vertex shader (Read decodeOctahedralNormal()).
+//
+namespace vertex_quantization {
+uint16_t
+quantizeUnorm16(const float value);
+
+// The fourth coordinate is 0: 3 components formats are not
+// required to be supported for vertex buffers.
+glm::u16vec4
+quantizePosition(const glm::vec3& position,
+                 const glm::vec3& boundsMin,
+                 const glm::vec3& boundsMax);
+
+glm::u16vec2
+quantizeTexCoord(const glm::vec2& texCoord);
+
+// * normal must be normalized.
+glm::i16vec2
+encodeOctahedralNormal(const glm::vec3& normal);
+
+glm::vec3
+decodeOctahedralNormal(const glm::i16vec2& encodedNormal);
+
+// Transforms the quantized positions (in [0, 1]) to the bounds.
+glm::mat4
+dequantizationMatrix(const glm::vec3& boundsMin,
+                     const glm::vec3& boundsMax);
+}
+}
+
+#endif